@@ -9,6 +9,11 @@ layout(location = 0) in vec2 v_device_coord;
 layout(location = 0) out vec4 out_color;
 
 
+// Set by ShaderConfig at pipeline creation, so toggling them doesn't need recompiling GLSL
+layout(constant_id = 0) const bool SPEC_VOLUMETRIC_ATMOS = true;
+layout(constant_id = 1) const bool SPEC_ATMOS_DITHERING = true;
+
+
 layout(input_attachment_index = 0, binding = 0) uniform subpassInput input_depth;
 layout(input_attachment_index = 1, binding = 1) uniform subpassInput input_albedo;
 layout(input_attachment_index = 2, binding = 2) uniform subpassInput input_material;
@@ -249,51 +254,41 @@ vec3 calculate_dlight_scattering(
     const float phase_ray = 3.0 / (16.0 * DAL_PI) * (1.0 + mumu);
 
     // prevent the mie glow from appearing if there's an object in front of the camera
-#ifdef DAL_VOLUMETRIC_ATMOS
-    const float phase_mie = 3.0 / (8.0 * DAL_PI) * ((1.0 - gg) * (mumu + 1.0)) / (pow(1.0 + gg - 2.0 * mu * g, 1.5) * (2.0 + gg));
-#else
-    const float phase_mie = (max_dist > ray_length.y) ? 3.0 / (8.0 * DAL_PI) * ((1.0 - gg) * (mumu + 1.0)) / (pow(1.0 + gg - 2.0 * mu * g, 1.5) * (2.0 + gg)) : 0.0;
-#endif
+    const float phase_mie = (SPEC_VOLUMETRIC_ATMOS || max_dist > ray_length.y) ? 3.0 / (8.0 * DAL_PI) * ((1.0 - gg) * (mumu + 1.0)) / (pow(1.0 + gg - 2.0 * mu * g, 1.5) * (2.0 + gg)) : 0.0;
 
-#ifdef DAL_ATMOS_DITHERING
-    const float dither_value = get_dither_value();
-#endif
+    const float dither_value = SPEC_ATMOS_DITHERING ? get_dither_value() : 0.0;
 
     // now we need to sample the 'primary' ray. this ray gathers the light that gets scattered onto it
     for (int i = 0; i < steps_i; ++i) {
 
         // calculate where we are along this ray
-#ifdef DAL_ATMOS_DITHERING
         const vec3 sample_offset = dir * (ray_length.x + step_size_i * (float(i) + dither_value + 0.5));
-#else
-        const vec3 sample_offset = dir * (ray_length.x + step_size_i * (float(i) + 0.5));
-#endif
         const vec3 world_pos_i   = view_pos + sample_offset;
         const vec3 pos_i         = start + sample_offset;
 
-#ifdef DAL_VOLUMETRIC_ATMOS
         bool in_shadow_i = false;
-        const float depth_i = calc_depth_of_z(calc_view_z_of(world_pos_i), u_camera_transform.m_near, u_camera_transform.m_far);
+        if (SPEC_VOLUMETRIC_ATMOS) {
+            const float depth_i = calc_depth_of_z(calc_view_z_of(world_pos_i), u_camera_transform.m_near, u_camera_transform.m_far);
 
-        uint selected_dlight = u_global_light.m_dlight_count - 1;
-        for (uint i = 0; i < u_global_light.m_dlight_count; ++i) {
-            if (u_global_light.m_dlight_clip_dist[i] > depth_i) {
-                selected_dlight = i;
-                break;
+            uint selected_dlight = u_global_light.m_dlight_count - 1;
+            for (uint i = 0; i < u_global_light.m_dlight_count; ++i) {
+                if (u_global_light.m_dlight_clip_dist[i] > depth_i) {
+                    selected_dlight = i;
+                    break;
+                }
             }
-        }
 
-        const vec4 sample_pos_in_dlight = u_global_light.m_dlight_mat[selected_dlight] * vec4(world_pos_i, 1);
-        const vec3 proj_coords = sample_pos_in_dlight.xyz / sample_pos_in_dlight.w;
-        if (proj_coords.z > 1.0) {
-            in_shadow_i = true;
-        }
-        else {
-            if (proj_coords.z >= texture(u_dlight_shadow_maps[selected_dlight], proj_coords.xy * 0.5 + 0.5).r) {
+            const vec4 sample_pos_in_dlight = u_global_light.m_dlight_mat[selected_dlight] * vec4(world_pos_i, 1);
+            const vec3 proj_coords = sample_pos_in_dlight.xyz / sample_pos_in_dlight.w;
+            if (proj_coords.z > 1.0) {
                 in_shadow_i = true;
             }
+            else {
+                if (proj_coords.z >= texture(u_dlight_shadow_maps[selected_dlight], proj_coords.xy * 0.5 + 0.5).r) {
+                    in_shadow_i = true;
+                }
+            }
         }
-#endif
 
         // and how high we are above the surface
         const float height_i = length(pos_i) - planet_radius;
@@ -318,9 +313,7 @@ vec3 calculate_dlight_scattering(
         // and update the previous density
         prev_density = density;
 
-#ifdef DAL_VOLUMETRIC_ATMOS
         if (!in_shadow_i) {
-#endif
             // Calculate the step size of the light ray.
             // again with a ray sphere intersect
             // a, b, c and d are already defined
@@ -380,9 +373,7 @@ vec3 calculate_dlight_scattering(
             // accumulate the scattered light (how much will be scattered towards the camera)
             total_ray += density.x * attn;
             total_mie += density.y * attn;
-#ifdef DAL_VOLUMETRIC_ATMOS
         }
-#endif
 
     }
 
@@ -0,0 +1,273 @@
+import os
+import struct
+import argparse
+from typing import List
+
+import local_tools.path_tools as ptt
+
+
+# Must match source/lib/util/src/asset_pack.cpp
+PACK_MAGIC = b"DPAK"
+PACK_VERSION = 1
+HEADER_FORMAT = "<4sIIIQQ"
+ENTRY_FORMAT = "<QQQQIHBB"
+DATA_ALIGNMENT = 16
+
+COMPRESSION_NONE = 0
+COMPRESSION_LZ4 = 1
+
+# These are compressed already so LZ4 would only cost decoding time
+EXTENSIONS_NOT_TO_COMPRESS = {
+    ".png", ".jpg", ".jpeg", ".tga", ".dtex", ".ogg", ".mp3",
+}
+
+ASSET_DIR = os.path.join(ptt.find_repo_root_path(), "asset")
+DEFAULT_OUTPUT_PATH = os.path.join(ptt.find_repo_root_path(), "asset.dpak")
+
+
+# xxHash64, same as dal::hash_xx64
+#-------------------------------------------------------------------------------
+
+_PRIME64_1 = 11400714785074694791
+_PRIME64_2 = 14029467366897019727
+_PRIME64_3 = 1609587929392839161
+_PRIME64_4 = 9650029242287828579
+_PRIME64_5 = 2870177450012600261
+_MASK64 = 0xFFFFFFFFFFFFFFFF
+
+
+def _rotl64(x: int, r: int) -> int:
+    return ((x << r) | (x >> (64 - r))) & _MASK64
+
+
+def _xx_round(acc: int, value: int) -> int:
+    acc = (acc + value * _PRIME64_2) & _MASK64
+    acc = _rotl64(acc, 31)
+    return (acc * _PRIME64_1) & _MASK64
+
+
+def _xx_merge_round(acc: int, value: int) -> int:
+    acc ^= _xx_round(0, value)
+    return (acc * _PRIME64_1 + _PRIME64_4) & _MASK64
+
+
+def hash_xx64(data: bytes, seed: int = 0) -> int:
+    size = len(data)
+    pos = 0
+
+    if size >= 32:
+        v1 = (seed + _PRIME64_1 + _PRIME64_2) & _MASK64
+        v2 = (seed + _PRIME64_2) & _MASK64
+        v3 = seed
+        v4 = (seed - _PRIME64_1) & _MASK64
+
+        while pos + 32 <= size:
+            a, b, c, d = struct.unpack_from("<QQQQ", data, pos)
+            v1 = _xx_round(v1, a)
+            v2 = _xx_round(v2, b)
+            v3 = _xx_round(v3, c)
+            v4 = _xx_round(v4, d)
+            pos += 32
+
+        h = (_rotl64(v1, 1) + _rotl64(v2, 7) + _rotl64(v3, 12) + _rotl64(v4, 18)) & _MASK64
+        h = _xx_merge_round(h, v1)
+        h = _xx_merge_round(h, v2)
+        h = _xx_merge_round(h, v3)
+        h = _xx_merge_round(h, v4)
+    else:
+        h = (seed + _PRIME64_5) & _MASK64
+
+    h = (h + size) & _MASK64
+
+    while pos + 8 <= size:
+        (k,) = struct.unpack_from("<Q", data, pos)
+        h ^= _xx_round(0, k)
+        h = (_rotl64(h, 27) * _PRIME64_1 + _PRIME64_4) & _MASK64
+        pos += 8
+
+    if pos + 4 <= size:
+        (k,) = struct.unpack_from("<I", data, pos)
+        h ^= (k * _PRIME64_1) & _MASK64
+        h = (_rotl64(h, 23) * _PRIME64_2 + _PRIME64_3) & _MASK64
+        pos += 4
+
+    while pos < size:
+        h ^= (data[pos] * _PRIME64_5) & _MASK64
+        h = (_rotl64(h, 11) * _PRIME64_1) & _MASK64
+        pos += 1
+
+    h ^= h >> 33
+    h = (h * _PRIME64_2) & _MASK64
+    h ^= h >> 29
+    h = (h * _PRIME64_3) & _MASK64
+    h ^= h >> 32
+    return h
+
+
+# LZ4 block format, decoded by dal::decompress_lz4_block
+#-------------------------------------------------------------------------------
+
+_LZ4_MIN_MATCH = 4
+_LZ4_LAST_LITERALS = 5
+_LZ4_MATCH_START_LIMIT = 12
+_LZ4_MAX_OFFSET = 65535
+
+
+def _lz4_write_length(output: bytearray, length: int):
+    length -= 15
+    while length >= 255:
+        output.append(255)
+        length -= 255
+    output.append(length)
+
+
+def _lz4_write_sequence(output: bytearray, literals: bytes, offset: int, match_length: int):
+    literal_length = len(literals)
+    match_code = match_length - _LZ4_MIN_MATCH
+
+    output.append((min(literal_length, 15) << 4) | min(match_code, 15))
+    if literal_length >= 15:
+        _lz4_write_length(output, literal_length)
+    output += literals
+    output += struct.pack("<H", offset)
+    if match_code >= 15:
+        _lz4_write_length(output, match_code)
+
+
+def _lz4_write_last_literals(output: bytearray, literals: bytes):
+    literal_length = len(literals)
+
+    output.append(min(literal_length, 15) << 4)
+    if literal_length >= 15:
+        _lz4_write_length(output, literal_length)
+    output += literals
+
+
+# Greedy single probe matcher. Slower and weaker than liblz4 but output is valid LZ4.
+def compress_lz4_block(data: bytes) -> bytes:
+    size = len(data)
+    output = bytearray()
+    table = {}
+    anchor = 0
+    pos = 0
+
+    while pos < size - _LZ4_MATCH_START_LIMIT:
+        key = data[pos:pos + _LZ4_MIN_MATCH]
+        candidate = table.get(key)
+        table[key] = pos
+
+        if candidate is None or pos - candidate > _LZ4_MAX_OFFSET:
+            pos += 1
+            continue
+
+        match_end = pos + _LZ4_MIN_MATCH
+        match_limit = size - _LZ4_LAST_LITERALS
+        while match_end < match_limit and data[match_end] == data[candidate + match_end - pos]:
+            match_end += 1
+
+        _lz4_write_sequence(output, data[anchor:pos], pos - candidate, match_end - pos)
+        pos = match_end
+        anchor = pos
+
+    _lz4_write_last_literals(output, data[anchor:])
+    return bytes(output)
+
+
+# Pack
+#-------------------------------------------------------------------------------
+
+class PackEntry:
+    def __init__(self, path: str, content: bytes, compression: int, stored: bytes) -> None:
+        self.m_path = path
+        self.m_path_bytes = path.encode("utf8")
+        self.m_path_hash = hash_xx64(self.m_path_bytes)
+        self.m_size = len(content)
+        self.m_compression = compression
+        self.m_stored = stored
+        self.m_data_offset = 0
+        self.m_name_offset = 0
+
+
+def _align(value: int, alignment: int) -> int:
+    return (value + alignment - 1) // alignment * alignment
+
+
+def _collect_files(asset_dir: str) -> List[str]:
+    output = []
+
+    for folder_path, _, file_names in os.walk(asset_dir):
+        for file_name in file_names:
+            file_path = os.path.join(folder_path, file_name)
+            output.append(os.path.relpath(file_path, asset_dir).replace(os.sep, "/"))
+
+    output.sort()
+    return output
+
+
+def _make_entry(asset_dir: str, path: str, use_lz4: bool) -> PackEntry:
+    with open(os.path.join(asset_dir, path), "rb") as file:
+        content = file.read()
+
+    extension = os.path.splitext(path)[1].lower()
+    if use_lz4 and extension not in EXTENSIONS_NOT_TO_COMPRESS and len(content) > _LZ4_MATCH_START_LIMIT:
+        compressed = compress_lz4_block(content)
+        # Mapping uncompressed entry costs nothing, so compression must be worth it
+        if len(compressed) < len(content) * 0.9:
+            return PackEntry(path, content, COMPRESSION_LZ4, compressed)
+
+    return PackEntry(path, content, COMPRESSION_NONE, content)
+
+
+def build_pack(asset_dir: str, output_path: str, use_lz4: bool):
+    entries = [_make_entry(asset_dir, x, use_lz4) for x in _collect_files(asset_dir)]
+    entries.sort(key=lambda x: (x.m_path_hash, x.m_path))
+
+    names = bytearray()
+    for e in entries:
+        e.m_name_offset = len(names)
+        names += e.m_path_bytes
+
+    # Header, entries and names come first so that they are read in one go
+    header_size = struct.calcsize(HEADER_FORMAT)
+    toc_size = struct.calcsize(ENTRY_FORMAT) * len(entries)
+    cur_offset = _align(header_size + toc_size + len(names), DATA_ALIGNMENT)
+
+    # Data is laid out in path order so that files in same folder are close to each other
+    for e in sorted(entries, key=lambda x: x.m_path):
+        e.m_data_offset = cur_offset
+        cur_offset = _align(cur_offset + len(e.m_stored), DATA_ALIGNMENT)
+
+    output = bytearray(cur_offset)
+    struct.pack_into(HEADER_FORMAT, output, 0, PACK_MAGIC, PACK_VERSION, len(entries), len(names), header_size, 0)
+
+    for i, e in enumerate(entries):
+        struct.pack_into(
+            ENTRY_FORMAT, output, header_size + i * struct.calcsize(ENTRY_FORMAT),
+            e.m_path_hash, e.m_data_offset, len(e.m_stored), e.m_size,
+            e.m_name_offset, len(e.m_path_bytes), e.m_compression, 0,
+        )
+        output[e.m_data_offset:e.m_data_offset + len(e.m_stored)] = e.m_stored
+
+    names_offset = header_size + toc_size
+    output[names_offset:names_offset + len(names)] = names
+
+    with open(output_path, "wb") as file:
+        file.write(output)
+
+    compressed_count = sum(1 for x in entries if COMPRESSION_LZ4 == x.m_compression)
+    print("Packed {} files ({} compressed) into {} ({} bytes)".format(len(entries), compressed_count, output_path, len(output)))
+    print("Engine uses it only when started with --asset-pack or DAL_ASSET_PACK=1")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Packs asset folder into single file which engine maps at start")
+    parser.add_argument("-o", "--output", default=DEFAULT_OUTPUT_PATH)
+    parser.add_argument("--asset-dir", default=ASSET_DIR)
+    parser.add_argument("--lz4", action="store_true", help="compress entries which get smaller with LZ4")
+    args = parser.parse_args()
+
+    build_pack(args.asset_dir, args.output, args.lz4)
+
+
+if "__main__" == __name__:
+    main()
@@ -6,6 +6,8 @@
 #include <fmt/format.h>
 
 #include <dal/util/konsts.h>
+#include <dal/util/logger.h>
+#include <dal/util/asset_pack.h>
 
 
 namespace fs = std::filesystem;
@@ -125,6 +127,46 @@ namespace {
     };
 
 
+    // Uncompressed assets are mapped straight out of APK. Compressed ones are inflated once by AAsset.
+    class FileMapping_AndroidAsset : public dal::IFileMapping {
+
+    private:
+        AAsset* m_asset = nullptr;
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+
+    public:
+        FileMapping_AndroidAsset() = default;
+
+        FileMapping_AndroidAsset(const FileMapping_AndroidAsset&) = delete;
+        FileMapping_AndroidAsset& operator=(const FileMapping_AndroidAsset&) = delete;
+
+        ~FileMapping_AndroidAsset() override {
+            if (nullptr != this->m_asset)
+                AAsset_close(this->m_asset);
+        }
+
+        bool open(const char* const path, AAssetManager* const asset_mgr) {
+            this->m_asset = AAssetManager_open(asset_mgr, path, AASSET_MODE_BUFFER);
+            if (nullptr == this->m_asset)
+                return false;
+
+            this->m_data = reinterpret_cast<const uint8_t*>(AAsset_getBuffer(this->m_asset));
+            this->m_size = static_cast<size_t>(AAsset_getLength64(this->m_asset));
+            return nullptr != this->m_data;
+        }
+
+        const uint8_t* data() const override {
+            return this->m_data;
+        }
+
+        size_t size() const override {
+            return this->m_size;
+        }
+
+    };
+
+
     class AssetFileIterator {
 
     private:
@@ -499,6 +541,20 @@ namespace dal {
             return file;
     }
 
+    std::unique_ptr<IFileMapping> AssetManagerAndroid::map(const dal::ResPath& path) {
+        if (path.dir_list().front() != dal::SPECIAL_NAMESPACE_ASSET)
+            return make_file_mapping_null();
+        if (path.dir_list().size() < 2)
+            return make_file_mapping_null();
+
+        const auto asset_path = ::make_asset_path(path);
+        auto mapping = std::make_unique<::FileMapping_AndroidAsset>();
+        if (mapping->open(asset_path.c_str(), this->m_asset_mgr_ptr))
+            return mapping;
+
+        return IAssetManager::map(path);
+    }
+
 }
 
 
@@ -541,6 +597,10 @@ namespace dal {
 
     }
 
+    void InternalManagerAndroid::refresh() {
+        this->m_name_index.reset();
+    }
+
     bool InternalManagerAndroid::is_file(const dal::ResPath& path) {
         const auto normal_path = ::convert_to_internal_path(path, this->m_domain_dir);
         if (!normal_path.has_value())
@@ -589,13 +649,17 @@ namespace dal {
         if (path.dir_list().front() != dal::SPECIAL_NAMESPACE_INTERNAL)
             return std::nullopt;
 
-        const auto result = dal::resolve_path(path, this->m_domain_dir, 1);
+        const auto result = dal::resolve_path(path, this->m_domain_dir, 1, this->m_name_index);
         if (!result.has_value())
             return std::nullopt;
 
         return dal::ResPath{ fmt::format("{}/{}", dal::SPECIAL_NAMESPACE_INTERNAL, *result) };
     }
 
+    std::optional<std::filesystem::path> InternalManagerAndroid::native_path(const ResPath& path) {
+        return ::convert_to_internal_path(path, this->m_domain_dir);
+    }
+
     std::unique_ptr<FileReadOnly> InternalManagerAndroid::open_read(const ResPath& path) {
         const auto path_converted = ::convert_to_internal_path(path, this->m_domain_dir);
         if (!path_converted.has_value())
@@ -626,4 +690,43 @@ namespace dal {
             return file;
     }
 
+    bool InternalManagerAndroid::remove(const ResPath& path) {
+        const auto path_converted = ::convert_to_internal_path(path, this->m_domain_dir);
+        if (!path_converted.has_value())
+            return false;
+
+        std::error_code err;
+        return fs::remove(*path_converted, err);
+    }
+
+    std::unique_ptr<IFileMapping> InternalManagerAndroid::map(const ResPath& path) {
+        const auto path_converted = ::convert_to_internal_path(path, this->m_domain_dir);
+        if (!path_converted.has_value())
+            return make_file_mapping_null();
+
+        return dal::map_file(*path_converted);
+    }
+
+}
+
+
+// Functions
+namespace dal {
+
+    std::unique_ptr<IAssetManager> make_asset_manager_android(AAssetManager* const asset_mgr_ptr) {
+        auto asset_mgr = std::make_unique<AssetManagerAndroid>(asset_mgr_ptr);
+
+        // Pack must be stored uncompressed in APK, see noCompress in build.gradle
+        const dal::ResPath pack_path{ fmt::format("{}/{}", dal::SPECIAL_NAMESPACE_ASSET, dal::FILE_NAME_ASSET_PACK) };
+        if (!asset_mgr->is_file(pack_path))
+            return asset_mgr;
+
+        auto pack_mgr = std::make_unique<AssetManagerPack>(asset_mgr->map(pack_path));
+        if (pack_mgr->is_ready())
+            return pack_mgr;
+
+        dalWarn("Asset pack is invalid, using loose assets instead");
+        return asset_mgr;
+    }
+
 }
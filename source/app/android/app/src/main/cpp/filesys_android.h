@@ -28,6 +28,8 @@ namespace dal {
 
         std::unique_ptr<FileReadOnly> open(const dal::ResPath& path) override;
 
+        std::unique_ptr<IFileMapping> map(const dal::ResPath& path) override;
+
     };
 
 
@@ -53,10 +55,13 @@ namespace dal {
 
     private:
         std::string m_domain_dir;
+        FilenameIndex m_name_index;
 
     public:
         InternalManagerAndroid(const char* const domain_dir);
 
+        void refresh() override;
+
         bool is_file(const dal::ResPath& path) override;
 
         bool is_folder(const dal::ResPath& path) override;
@@ -67,10 +72,20 @@ namespace dal {
 
         std::optional<ResPath> resolve(const ResPath& path) override;
 
+        std::optional<std::filesystem::path> native_path(const ResPath& path) override;
+
         std::unique_ptr<FileReadOnly> open_read(const ResPath& path) override;
 
         std::unique_ptr<IFileWriteOnly> open_write(const ResPath& path) override;
 
+        bool remove(const ResPath& path) override;
+
+        std::unique_ptr<IFileMapping> map(const ResPath& path) override;
+
     };
 
+
+    // Serves assets out of asset pack if APK has one, or out of loose APK assets otherwise
+    std::unique_ptr<IAssetManager> make_asset_manager_android(AAssetManager* const asset_mgr_ptr);
+
 }
@@ -70,7 +70,7 @@ namespace {
 
     void init(android_app* const state) {
         g_filesys.init(
-            std::make_unique<dal::AssetManagerAndroid>(state->activity->assetManager),
+            dal::make_asset_manager_android(state->activity->assetManager),
             std::make_unique<dal::UserDataManagerAndroid>(),
             std::make_unique<dal::InternalManagerAndroid>(state->activity->internalDataPath)
         );
@@ -16,14 +16,16 @@ int main(int argc, char** argv) {
         std::cout << "Argument[" << i << "] " << argv[i] << std::endl;
     }
 
+    // Added before filesystem so that which asset source is chosen gets printed
+    dal::LoggerSingleton::inst().add_channel(dal::get_log_channel_cout());
+
     dal::Filesystem filesys;
     filesys.init(
-        std::make_unique<dal::AssetManagerSTD>(),
+        dal::make_asset_manager_std(dal::is_asset_pack_requested(argc, argv)),
         std::make_unique<dal::UserDataManagerSTD>(),
         std::make_unique<dal::InternalManagerSTD>()
     );
 
-    dal::LoggerSingleton::inst().add_channel(dal::get_log_channel_cout());
     dal::LoggerSingleton::inst().add_channel(std::make_shared<dal::LogChannel_FileOutput>(filesys));
 
     dal::EngineCreateInfo engine_info;
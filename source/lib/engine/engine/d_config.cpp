@@ -38,6 +38,11 @@ namespace {
 
     const char* const KEY_VOLUMETRIC_ATMOS = "volumetric_atmos";
     const char* const KEY_ATMOS_DITHERING = "m_atmos_dithering";
+    const char* const KEY_STAGING_BUFFER_MB = "staging_buffer_mb";
+    const char* const KEY_TEXTURE_BUDGET_MB = "texture_budget_mb";
+    const char* const KEY_MESH_BUDGET_MB = "mesh_budget_mb";
+    const char* const KEY_LOD_BIAS = "lod_bias";
+    const char* const KEY_SHADOW_LOD_BIAS = "shadow_lod_bias";
 
 }
 namespace dal {
@@ -45,6 +50,11 @@ namespace dal {
     void ConfigGroup_Renderer::import_json(const nlohmann::json& json_data) {
         try_set_json_value(this->m_volumetric_atmos, KEY_VOLUMETRIC_ATMOS, json_data);
         try_set_json_value(this->m_atmos_dithering, KEY_ATMOS_DITHERING, json_data);
+        try_set_json_value(this->m_staging_buffer_mb, KEY_STAGING_BUFFER_MB, json_data);
+        try_set_json_value(this->m_texture_budget_mb, KEY_TEXTURE_BUDGET_MB, json_data);
+        try_set_json_value(this->m_mesh_budget_mb, KEY_MESH_BUDGET_MB, json_data);
+        try_set_json_value(this->m_lod_bias, KEY_LOD_BIAS, json_data);
+        try_set_json_value(this->m_shadow_lod_bias, KEY_SHADOW_LOD_BIAS, json_data);
     }
 
     nlohmann::json ConfigGroup_Renderer::export_json() const {
@@ -52,6 +62,11 @@ namespace dal {
 
         output[KEY_VOLUMETRIC_ATMOS] = this->m_volumetric_atmos;
         output[KEY_ATMOS_DITHERING] = this->m_atmos_dithering;
+        output[KEY_STAGING_BUFFER_MB] = this->m_staging_buffer_mb;
+        output[KEY_TEXTURE_BUDGET_MB] = this->m_texture_budget_mb;
+        output[KEY_MESH_BUDGET_MB] = this->m_mesh_budget_mb;
+        output[KEY_LOD_BIAS] = this->m_lod_bias;
+        output[KEY_SHADOW_LOD_BIAS] = this->m_shadow_lod_bias;
 
         return output;
     }
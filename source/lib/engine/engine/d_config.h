@@ -46,6 +46,11 @@ namespace dal {
     public:
         bool m_volumetric_atmos = true;
         bool m_atmos_dithering = true;
+        uint32_t m_staging_buffer_mb = 32;
+        uint32_t m_texture_budget_mb = 512;
+        uint32_t m_mesh_budget_mb = 256;
+        float m_lod_bias = 0;
+        float m_shadow_lod_bias = 1;
 
     public:
         virtual std::string key_name() const {
@@ -345,6 +345,18 @@ namespace dal {
         {
             this->m_render_config.m_shader.m_atmos_dithering = this->m_config.m_renderer.m_atmos_dithering;
             this->m_render_config.m_shader.m_volumetric_atmos = this->m_config.m_renderer.m_volumetric_atmos;
+            this->m_render_config.m_staging_buffer_mb = this->m_config.m_renderer.m_staging_buffer_mb;
+            this->m_render_config.m_texture_budget_mb = this->m_config.m_renderer.m_texture_budget_mb;
+            this->m_render_config.m_lod_bias = this->m_config.m_renderer.m_lod_bias;
+            this->m_render_config.m_shadow_lod_bias = this->m_config.m_renderer.m_shadow_lod_bias;
+        }
+
+        // Update resource budget
+        {
+            ResourceBudget budget;
+            budget.m_texture_bytes = static_cast<size_t>(this->m_config.m_renderer.m_texture_budget_mb) * 1024 * 1024;
+            budget.m_mesh_bytes = static_cast<size_t>(this->m_config.m_renderer.m_mesh_budget_mb) * 1024 * 1024;
+            this->m_res_man.set_budget(budget);
         }
 
         this->m_lua.give_dependencies(this->m_scene, this->m_res_man);
@@ -420,7 +432,7 @@ namespace dal {
         }
 
         this->m_task_man.update();
-        this->m_res_man.update();
+        this->m_res_man.update(delta_time);
         this->m_scene.update();
 
         this->m_lua.call_void_func("before_rendering_every_frame");
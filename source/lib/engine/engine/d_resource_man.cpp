@@ -1,5 +1,7 @@
 #include "d_resource_man.h"
 
+#include <algorithm>
+
 #include <fmt/format.h>
 
 #include <daltools/dmd/parser.h>
@@ -7,14 +9,26 @@
 #include <daltools/common/util.h>
 #include <daltools/common/crypto.h>
 
+#include "dal/util/hash.h"
+#include "dal/util/konsts.h"
 #include "dal/util/logger.h"
+#include "dal/util/mipmap.h"
+#include "dal/util/model_cook.h"
 #include "dal/util/image_parser.h"
+#include "dal/util/texture_cook.h"
+#include "dal/util/mesh_simplify.h"
+#include "dal/util/async_file_io.h"
+#include "dal/util/derived_data_cache.h"
 
 
 namespace {
 
     const char* const MISSING_TEX_PATH = "_asset/image/missing_tex.png";
     const char* const MISSING_MODEL_PATH = "_asset/model/missing_model.dmd";
+    const char* const COOKED_TEXTURE_EXTENSION = ".dtex";
+
+    const char* const CACHE_CATEGORY_TEXTURE = "tex";
+    const char* const CACHE_CATEGORY_MODEL = "model";
 
 
     auto get_asset_public_key() {
@@ -33,27 +47,6 @@ namespace {
     const auto ASSET_PUBLIC_KEY = ::get_asset_public_key();
 
 
-    template <typename _VertType>
-    glm::vec3 calc_weight_center(const std::vector<_VertType>& vertices) {
-        double x_sum = 0.0;
-        double y_sum = 0.0;
-        double z_sum = 0.0;
-
-        for (const auto& v : vertices) {
-            x_sum += v.m_pos.x;
-            y_sum += v.m_pos.y;
-            z_sum += v.m_pos.z;
-        }
-
-        const double vert_count = static_cast<double>(vertices.size());
-
-        return glm::vec3{
-            x_sum / vert_count,
-            y_sum / vert_count,
-            z_sum / vert_count,
-        };
-    }
-
     void copy_material(dal::Material& dst, const dal::parser::Material& src) {
         dst.m_roughness = src.roughness_;
         dst.m_metallic = src.metallic_;
@@ -62,13 +55,47 @@ namespace {
     }
 
 
+    bool is_cooked_texture_path(const std::string& path) {
+        const std::string extension = ::COOKED_TEXTURE_EXTENSION;
+
+        if (path.size() < extension.size())
+            return false;
+
+        return 0 == path.compare(path.size() - extension.size(), extension.size(), extension);
+    }
+
+    dal::DerivedDataKey make_texture_cache_key(const dal::IFileMapping& source_file, const dal::ImageFormat format) {
+        dal::DerivedDataKey output;
+        output.m_content_hash = dal::hash_xx64(source_file.data(), source_file.size());
+        output.m_version = dal::TEXTURE_COOK_VERSION;
+        output.m_options_hash = static_cast<uint64_t>(format);
+        return output;
+    }
+
+    dal::DerivedDataKey make_model_cache_key(const dal::IFileMapping& source_file, const bool skinned) {
+        dal::DerivedDataKey output;
+        output.m_content_hash = dal::hash_xx64(source_file.data(), source_file.size());
+        output.m_version = dal::MODEL_COOK_VERSION;
+        output.m_options_hash = skinned ? 1 : 0;
+        return output;
+    }
+
+    // Returned pointer keeps the mapping alive, so images can refer into it without copying
+    std::shared_ptr<const uint8_t> share_mapping(const std::shared_ptr<dal::IFileMapping>& mapping) {
+        return std::shared_ptr<const uint8_t>(mapping, mapping->data());
+    }
+
+
     class Task_LoadImage : public dal::IPriorityTask {
 
     public:
         dal::Filesystem& m_filesys;
         dal::ResPath m_respath;
+        dal::ImageFormat m_cook_format;
 
-        std::vector<uint8_t> m_file_data;
+        dal::HAsyncRead m_read;
+        std::shared_ptr<dal::IFileMapping> m_file;
+        std::optional<dal::DerivedDataKey> m_cache_key;
         std::string m_result_msg;
         std::optional<dal::ImageData> out_image;
 
@@ -76,10 +103,11 @@ namespace {
         int m_stage = 0;
 
     public:
-        Task_LoadImage(const dal::ResPath& respath, dal::Filesystem& filesys)
+        Task_LoadImage(const dal::ResPath& respath, const dal::ImageFormat cook_format, dal::Filesystem& filesys)
             : dal::IPriorityTask(dal::PriorityClass::can_be_delayed)
             , m_filesys(filesys)
             , m_respath(respath)
+            , m_cook_format(cook_format)
             , out_image(std::nullopt)
         {
 
@@ -91,21 +119,30 @@ namespace {
                     return this->stage_0();
                 case 1:
                     return this->stage_1();
+                case 2:
+                    return this->stage_2();
                 default:
                     return true;
             }
         }
 
+        bool is_waiting() const override {
+            return nullptr != this->m_read && !this->m_read->is_done();
+        }
+
     private:
+        // Worker is released while file is being read
         bool stage_0() {
-            auto file = this->m_filesys.open(this->m_respath);
-            if (!file->is_ready()) {
-                this->m_result_msg = fmt::format("Failed to open image file: {}", this->m_respath.make_str());
-                return true;
+            if (!this->m_read) {
+                this->m_read = this->m_filesys.read_async(this->m_respath);
+                return false;
             }
 
-            if (!file->read_stl<std::vector<uint8_t>>(this->m_file_data)) {
-                this->m_result_msg = fmt::format("Failed to read image file: {}", this->m_respath.make_str());
+            this->m_file = this->m_read->take();
+            this->m_read.reset();
+
+            if (!this->m_file->is_ready()) {
+                this->m_result_msg = fmt::format("Failed to open image file: {}", this->m_respath.make_str());
                 return true;
             }
 
@@ -113,13 +150,67 @@ namespace {
             return false;
         }
 
+        // Looks for already cooked data
         bool stage_1() {
-            this->out_image = dal::parse_image_stb(this->m_file_data.data(), this->m_file_data.size());
+            if (::is_cooked_texture_path(this->m_respath.make_str())) {
+                this->out_image = dal::parse_cooked_texture(::share_mapping(this->m_file), this->m_file->size());
+                if (!this->out_image.has_value()) {
+                    this->m_result_msg = fmt::format("Failed to parse cooked texture file: {}", this->m_respath.make_str());
+                }
+
+                this->m_stage = 3;
+                return true;
+            }
+
+            if (!dal::can_cook_to(this->m_cook_format)) {
+                this->m_stage = 2;
+                return false;
+            }
+
+            this->m_cache_key = ::make_texture_cache_key(*this->m_file, this->m_cook_format);
+            std::shared_ptr<dal::IFileMapping> cache_file = this->m_filesys.derived_data().get(::CACHE_CATEGORY_TEXTURE, *this->m_cache_key);
+            if (cache_file->is_ready()) {
+                this->out_image = dal::parse_cooked_texture(::share_mapping(cache_file), cache_file->size());
+                if (this->out_image.has_value()) {
+                    this->m_file.reset();
+                    this->m_stage = 3;
+                    return true;
+                }
+
+                dalWarn(fmt::format("Cooked texture cache is corrupted, cooking again: {}", this->m_respath.make_str()).c_str());
+            }
+
+            this->m_stage = 2;
+            return false;
+        }
+
+        bool stage_2() {
+            this->m_stage = 3;
+
+            this->out_image = dal::parse_image_stb(this->m_file->data(), this->m_file->size());
+            this->m_file.reset();
+
             if (!this->out_image.has_value()) {
                 this->m_result_msg = fmt::format("Failed to parse image file: {}", this->m_respath.make_str());
+                return true;
             }
 
-            this->m_stage = 2;
+            // Built here on a worker thread so that upload needs no blits on graphics queue
+            if (!this->m_cache_key.has_value()) {
+                this->out_image = dal::build_mip_chain(*this->out_image);
+                return true;
+            }
+
+            auto cooked = dal::cook_texture(*this->out_image, this->m_cook_format);
+            if (!cooked.has_value()) {
+                dalWarn(fmt::format("Failed to cook texture, uploading it uncompressed: {}", this->m_respath.make_str()).c_str());
+                this->out_image = dal::build_mip_chain(*this->out_image);
+                return true;
+            }
+
+            this->m_filesys.derived_data().put(::CACHE_CATEGORY_TEXTURE, *this->m_cache_key, dal::serialize_cooked_texture(*cooked));
+
+            this->out_image = std::move(cooked);
             return true;
         }
 
@@ -133,7 +224,9 @@ namespace {
         dal::Filesystem& m_filesys;
         dal::ResPath m_respath;
 
+        dal::HAsyncRead m_read;
         dal::parser::Model m_parsed_model;
+        dal::DerivedDataKey m_cache_key;
         std::optional<dal::ModelStatic> out_model;
         std::string out_result_msg;
 
@@ -167,20 +260,36 @@ namespace {
             }
         }
 
+        bool is_waiting() const override {
+            return nullptr != this->m_read && !this->m_read->is_done();
+        }
+
     private:
         bool stage_0() {
-            auto file = this->m_filesys.open(this->m_respath);
-            if (!file->is_ready()) {
+            if (!this->m_read) {
+                this->m_read = this->m_filesys.read_async(this->m_respath);
+                return false;
+            }
+
+            const auto model_content = this->m_read->take();
+            this->m_read.reset();
+
+            if (!model_content->is_ready()) {
                 out_model = std::nullopt;
                 out_result_msg = "Failed to open file";
                 return true;
             }
 
-            const auto model_content = file->read_stl<std::vector<uint8_t>>();
-            if (!model_content.has_value()) {
-                out_model = std::nullopt;
-                out_result_msg = "Failed to load file contents";
-                return true;
+            this->m_cache_key = ::make_model_cache_key(*model_content, false);
+            const auto cache_file = this->m_filesys.derived_data().get(::CACHE_CATEGORY_MODEL, this->m_cache_key);
+            if (cache_file->is_ready()) {
+                this->out_model = dal::parse_cooked_model_static(cache_file->data(), cache_file->size());
+                if (this->out_model.has_value()) {
+                    this->m_stage = 5;
+                    return true;
+                }
+
+                dalWarn(fmt::format("Cooked model cache is corrupted, parsing source again: {}", this->m_respath.make_str()).c_str());
             }
 
             auto parse_result = dal::parser::parse_dmd(
@@ -215,7 +324,7 @@ namespace {
 
                 dst_unit.m_indices.assign(src_unit.mesh_.indices_.begin(), src_unit.mesh_.indices_.end());
                 ::copy_material(dst_unit.m_material, src_unit.material_);
-                dst_unit.m_weight_center = ::calc_weight_center(dst_unit.m_vertices);
+                dal::calc_unit_bounds(dst_unit);
             }
 
             this->m_stage = 2;
@@ -238,7 +347,7 @@ namespace {
 
                 dst_unit.m_indices.assign(src_unit.mesh_.indices_.begin(), src_unit.mesh_.indices_.end());
                 ::copy_material(dst_unit.m_material, src_unit.material_);
-                dst_unit.m_weight_center = ::calc_weight_center(dst_unit.m_vertices);
+                dal::calc_unit_bounds(dst_unit);
             }
 
             this->m_stage = 3;
@@ -257,6 +366,12 @@ namespace {
             if (!this->m_parsed_model.units_straight_joint_.empty())
                 dalWarn("Not supported vertex data: straight joint");
 
+            // Cached along with the model so that simplification runs only once per source file
+            for (auto& unit : this->out_model->m_units)
+                dal::build_lods(unit);
+
+            this->m_filesys.derived_data().put(::CACHE_CATEGORY_MODEL, this->m_cache_key, dal::serialize_cooked_model(*this->out_model));
+
             this->m_stage = 5;
             return true;
         }
@@ -271,7 +386,9 @@ namespace {
         dal::Filesystem& m_filesys;
         dal::ResPath m_respath;
 
+        dal::HAsyncRead m_read;
         dal::parser::Model m_parsed_model;
+        dal::DerivedDataKey m_cache_key;
         std::optional<dal::ModelSkinned> out_model;
 
     private:
@@ -306,20 +423,37 @@ namespace {
             }
         }
 
+        bool is_waiting() const override {
+            return nullptr != this->m_read && !this->m_read->is_done();
+        }
+
     private:
         bool stage_0() {
-            auto file = this->m_filesys.open(this->m_respath);
-            if (!file->is_ready()) {
-                out_model = std::nullopt;
-                return true;
+            if (!this->m_read) {
+                this->m_read = this->m_filesys.read_async(this->m_respath);
+                return false;
             }
 
-            const auto model_content = file->read_stl<std::vector<uint8_t>>();
-            if (!model_content.has_value()) {
+            const auto model_content = this->m_read->take();
+            this->m_read.reset();
+
+            if (!model_content->is_ready()) {
                 out_model = std::nullopt;
                 return true;
             }
 
+            this->m_cache_key = ::make_model_cache_key(*model_content, true);
+            const auto cache_file = this->m_filesys.derived_data().get(::CACHE_CATEGORY_MODEL, this->m_cache_key);
+            if (cache_file->is_ready()) {
+                this->out_model = dal::parse_cooked_model_skinned(cache_file->data(), cache_file->size());
+                if (this->out_model.has_value()) {
+                    this->m_stage = 6;
+                    return true;
+                }
+
+                dalWarn(fmt::format("Cooked model cache is corrupted, parsing source again: {}", this->m_respath.make_str()).c_str());
+            }
+
             const auto parse_result = dal::parser::parse_dmd(
                 this->m_parsed_model,
                 model_content->data(),
@@ -355,7 +489,7 @@ namespace {
 
                 dst_unit.m_indices.assign(src_unit.mesh_.indices_.begin(), src_unit.mesh_.indices_.end());
                 ::copy_material(dst_unit.m_material, src_unit.material_);
-                dst_unit.m_weight_center = ::calc_weight_center(dst_unit.m_vertices);
+                dal::calc_unit_bounds(dst_unit);
             }
 
             this->m_stage = 2;
@@ -380,7 +514,7 @@ namespace {
 
                 dst_unit.m_indices.assign(src_unit.mesh_.indices_.begin(), src_unit.mesh_.indices_.end());
                 ::copy_material(dst_unit.m_material, src_unit.material_);
-                dst_unit.m_weight_center = ::calc_weight_center(dst_unit.m_vertices);
+                dal::calc_unit_bounds(dst_unit);
             }
 
             this->m_stage = 3;
@@ -417,22 +551,15 @@ namespace {
         }
 
         bool stage_5() {
-            if (this->out_model->m_skeleton.size() > 0) {
-                // Character lies on ground without this line.
-                this->out_model->m_skeleton.at(0).set_parent_mat(this->out_model->m_skeleton.at(0).offset());
-
-                for ( int i = 1; i < this->out_model->m_skeleton.size(); ++i ) {
-                    auto& thisInfo = this->out_model->m_skeleton.at(i);
-                    const auto& parentInfo = this->out_model->m_skeleton.at(thisInfo.parent_index());
-                    thisInfo.set_parent_mat(parentInfo);
-                }
-            }
+            this->out_model->m_skeleton.update_parent_mats();
 
             if (!this->m_parsed_model.units_straight_.empty())
                 dalWarn("Not supported vertex data: straight");
             if (!this->m_parsed_model.units_straight_joint_.empty())
                 dalWarn("Not supported vertex data: straight joint");
 
+            this->m_filesys.derived_data().put(::CACHE_CATEGORY_MODEL, this->m_cache_key, dal::serialize_cooked_model(*this->out_model));
+
             this->m_stage = 6;
             return true;
         }
@@ -486,12 +613,20 @@ namespace dal {
             return;
         }
 
-        found->second.get()->set_image(task_result.out_image.value());
+        if (!found->second.get()->set_image(task_result.out_image.value())) {
+            dalError(fmt::format("Failed to create texture: {}", task_result.m_respath.make_str()).c_str());
+        }
         this->m_waiting_file.erase(found);
     }
 
-    void TextureBuilder::start(const ResPath& respath, HTexture h_texture, Filesystem& filesys, TaskManager& task_man) {
-        auto task = std::make_shared<::Task_LoadImage>(respath, filesys);
+    void TextureBuilder::start(
+        const ResPath& respath,
+        const ImageFormat cook_format,
+        HTexture h_texture,
+        Filesystem& filesys,
+        TaskManager& task_man
+    ) {
+        auto task = std::make_shared<::Task_LoadImage>(respath, cook_format, filesys);
         auto [iter, success] = this->m_waiting_file.emplace(respath.make_str(), h_texture);
         //task_man.order_task(std::make_shared<::Task_SlowTest>(), nullptr);
         task_man.order_task(task, this);
@@ -635,6 +770,89 @@ namespace dal {
 }
 
 
+// Unloading unused resources
+namespace {
+
+    constexpr double UNLOAD_CHECK_INTERVAL_SEC = 1;
+    // So that something dropped for a moment, like while swapping a model of an actor, is not unloaded right away.
+    // GPU safety does not rely on this, unloaded handles are destroyed only after frames in flight are done with them.
+    constexpr double MIN_UNUSED_SEC_TO_UNLOAD = 1;
+
+
+    enum class ResourceKind {
+        texture,
+        model,
+        model_skinned,
+    };
+
+
+    struct UnloadCandidate {
+        std::string m_respath;
+        ::ResourceKind m_kind;
+        double m_unused_sec;
+        size_t m_bytes;
+    };
+
+
+    // Returns resident bytes of all resources in the map. Ones only the manager holds are added to candidates.
+    template <typename _Map>
+    size_t scan_resources(_Map& resources, const double elapsed_sec, const ::ResourceKind kind, std::vector<::UnloadCandidate>& candidates) {
+        size_t resident_bytes = 0;
+
+        for (auto& [respath, res] : resources) {
+            if (!res.m_handle)
+                continue;
+
+            const auto bytes = res.m_handle->resident_bytes();
+            resident_bytes += bytes;
+
+            // Builders hold handles while loading, so resources being loaded are never unloaded
+            if (res.m_handle.use_count() > 1) {
+                res.m_unused_sec = 0;
+                res.m_seen_unused = false;
+                continue;
+            }
+
+            // It might have become unused just before this check, so the interval is not counted the first time
+            if (res.m_seen_unused)
+                res.m_unused_sec += elapsed_sec;
+            else
+                res.m_seen_unused = true;
+
+            candidates.push_back(::UnloadCandidate{ respath, kind, res.m_unused_sec, bytes });
+        }
+
+        return resident_bytes;
+    }
+
+    // Handle is moved to retired list rather than destroyed, since command buffers of frames in flight may still use it
+    template <typename _Map, typename _Retired>
+    bool unload_resource(_Map& resources, const std::string& respath, _Retired& retired, const uint64_t frame_count) {
+        const auto found = resources.find(respath);
+        if (resources.end() == found)
+            return false;
+
+        retired.push_back({ std::move(found->second.m_handle), frame_count });
+        resources.erase(found);
+        return true;
+    }
+
+    template <typename _Retired>
+    void destroy_retired_handles(_Retired& retired, const uint64_t frame_count, const bool force) {
+        const auto is_done = [frame_count, force](auto& x) {
+            if (!force && frame_count < x.m_retired_frame + dal::MAX_FRAMES_IN_FLIGHT)
+                return false;
+
+            x.m_handle->destroy();
+            return true;
+        };
+
+        retired.erase(std::remove_if(retired.begin(), retired.end(), is_done), retired.end());
+    }
+
+}
+
+
 // ResourceManager::MeshBuildData
 namespace dal {
 
@@ -649,28 +867,41 @@ namespace dal {
 // ResourceManager
 namespace dal {
 
-    void ResourceManager::update() {
+    void ResourceManager::update(const double delta_time) {
+        // Called once a frame, right before renderer records the frame
+        ++this->m_frame_count;
+        this->destroy_retired(false);
+
         this->m_tex_builder.update();
         this->m_model_builder.update();
         this->m_model_skinned_builder.update();
+
+        if (nullptr == this->m_renderer)
+            return;
+
+        this->m_since_unload_check += delta_time;
+        if (this->m_since_unload_check >= ::UNLOAD_CHECK_INTERVAL_SEC) {
+            this->unload_unused(this->m_since_unload_check);
+            this->m_since_unload_check = 0;
+        }
     }
 
     void ResourceManager::set_renderer(IRenderer& renderer) {
         this->m_renderer = &renderer;
 
         for (auto& [respath, texture] : this->m_textures) {
-            renderer.register_handle(texture);
-            this->m_tex_builder.start(respath, texture, this->m_filesys, this->m_task_man);
+            renderer.register_handle(texture.m_handle);
+            this->m_tex_builder.start(respath, renderer.texture_cook_format(), texture.m_handle, this->m_filesys, this->m_task_man);
         }
 
         for (auto& [respath, model] : this->m_models) {
-            renderer.register_handle(model);
-            this->m_model_builder.start(respath, model, this->m_filesys, this->m_task_man, this->m_sign_mgr);
+            renderer.register_handle(model.m_handle);
+            this->m_model_builder.start(respath, model.m_handle, this->m_filesys, this->m_task_man, this->m_sign_mgr);
         }
 
         for (auto& [respath, model] : this->m_skinned_models) {
-            renderer.register_handle(model);
-            this->m_model_skinned_builder.start(respath, model, this->m_filesys, this->m_task_man, this->m_sign_mgr);
+            renderer.register_handle(model.m_handle);
+            this->m_model_skinned_builder.start(respath, model.m_handle, this->m_filesys, this->m_task_man, this->m_sign_mgr);
         }
 
         for (auto& actor : this->m_actors) {
@@ -705,14 +936,16 @@ namespace dal {
         this->m_model_builder.invalidate_renderer();
         this->m_tex_builder.invalidate_renderer();
 
+        this->destroy_retired(true);
+
         for (auto& x : this->m_textures)
-            x.second->destroy();
+            x.second.m_handle->destroy();
 
         for (auto& x : this->m_models)
-            x.second->destroy();
+            x.second.m_handle->destroy();
 
         for (auto& x : this->m_skinned_models)
-            x.second->destroy();
+            x.second.m_handle->destroy();
 
         for (auto& x : this->m_actors)
             x->destroy();
@@ -723,75 +956,78 @@ namespace dal {
         for (auto& x : this->m_meshes)
             x.m_mesh->destroy();
 
+        this->m_resolved_paths.clear();
         this->m_renderer = nullptr;
     }
 
     HTexture ResourceManager::request_texture(const ResPath& respath) {
-        const auto resolved_respath = this->m_filesys.resolve(respath);
-        if (!resolved_respath.has_value()) {
+        const auto path_str = this->resolve_path(respath);
+        if (!path_str.has_value()) {
             dalError(fmt::format("Failed to find texture file: {}", respath.make_str()).c_str());
             dalAssert(!!this->m_missing_tex);
             return this->m_missing_tex;
         }
 
-        const auto path_str = resolved_respath->make_str();
-        const auto result = this->m_textures.find(path_str);
+        const auto result = this->m_textures.find(*path_str);
 
         if (this->m_textures.end() != result) {
-            return result->second;
+            return result->second.m_handle;
         }
         else {
-            auto [iter, result] = this->m_textures.emplace(path_str, this->m_renderer->create_texture());
+            auto [iter, result] = this->m_textures.emplace(*path_str, LoadedResource<HTexture>{ this->m_renderer->create_texture() });
             dalAssert(result);
-            this->m_tex_builder.start(*resolved_respath, iter->second, this->m_filesys, this->m_task_man);
+            this->m_tex_builder.start(
+                *path_str,
+                this->m_renderer->texture_cook_format(),
+                iter->second.m_handle,
+                this->m_filesys,
+                this->m_task_man
+            );
 
-            return iter->second;
+            return iter->second.m_handle;
         }
     }
 
     HRenModel ResourceManager::request_model(const ResPath& respath) {
-        const auto resolved_respath = this->m_filesys.resolve(respath);
-        if (!resolved_respath.has_value()) {
+        const auto path_str = this->resolve_path(respath);
+        if (!path_str.has_value()) {
             dalError(fmt::format("Failed to find model file: {}", respath.make_str()).c_str());
             dalAssert(!!this->m_missing_model);
             return this->m_missing_model;
         }
 
-        const auto path_str = resolved_respath->make_str();
-        const auto result = this->m_models.find(path_str);
+        const auto result = this->m_models.find(*path_str);
 
         if (this->m_models.end() != result) {
-            return result->second;
+            return result->second.m_handle;
         }
         else {
-            auto [iter, result] = this->m_models.emplace(path_str, this->m_renderer->create_model());
+            auto [iter, result] = this->m_models.emplace(*path_str, LoadedResource<HRenModel>{ this->m_renderer->create_model() });
             dalAssert(result);
-            this->m_model_builder.start(*resolved_respath, iter->second, this->m_filesys, this->m_task_man, this->m_sign_mgr);
+            this->m_model_builder.start(*path_str, iter->second.m_handle, this->m_filesys, this->m_task_man, this->m_sign_mgr);
 
-            return iter->second;
+            return iter->second.m_handle;
         }
     }
 
     HRenModelSkinned ResourceManager::request_model_skinned(const ResPath& respath) {
-        const auto resolved_respath = this->m_filesys.resolve(respath);
-        if (!resolved_respath.has_value()) {
+        const auto path_str = this->resolve_path(respath);
+        if (!path_str.has_value()) {
             dalError(fmt::format("Failed to find skinned model file: {}", respath.make_str()).c_str());
             dalAssert(!!this->m_missing_model_skinned);
             return this->m_missing_model_skinned;
         }
 
-        const auto path_str = resolved_respath->make_str();
-        const auto result = this->m_skinned_models.find(path_str);
+        const auto result = this->m_skinned_models.find(*path_str);
 
         if (this->m_skinned_models.end() != result) {
-            return result->second;
+            return result->second.m_handle;
         }
         else {
-            auto [iter, result] = this->m_skinned_models.emplace(path_str, this->m_renderer->create_model_skinned());
-            auto task = std::make_unique<::Task_LoadModelSkinned>(respath, this->m_filesys, this->m_sign_mgr);
-            this->m_model_skinned_builder.start(*resolved_respath, iter->second, this->m_filesys, this->m_task_man, this->m_sign_mgr);
+            auto [iter, result] = this->m_skinned_models.emplace(*path_str, LoadedResource<HRenModelSkinned>{ this->m_renderer->create_model_skinned() });
+            this->m_model_skinned_builder.start(*path_str, iter->second.m_handle, this->m_filesys, this->m_task_man, this->m_sign_mgr);
 
-            return iter->second;
+            return iter->second.m_handle;
         }
     }
 
@@ -823,4 +1059,86 @@ namespace dal {
         return mesh_data.m_mesh;
     }
 
+    // Private
+
+    std::optional<std::string> ResourceManager::resolve_path(const ResPath& respath) {
+        auto requested = respath.make_str();
+
+        const auto found = this->m_resolved_paths.find(requested);
+        if (this->m_resolved_paths.end() != found)
+            return found->second;
+
+        const auto resolved = this->m_filesys.resolve(respath);
+        if (!resolved.has_value())
+            return std::nullopt;
+
+        const auto [iter, success] = this->m_resolved_paths.emplace(std::move(requested), resolved->make_str());
+        return iter->second;
+    }
+
+    void ResourceManager::destroy_retired(const bool force) {
+        ::destroy_retired_handles(this->m_retired_textures, this->m_frame_count, force);
+        ::destroy_retired_handles(this->m_retired_models, this->m_frame_count, force);
+        ::destroy_retired_handles(this->m_retired_skinned_models, this->m_frame_count, force);
+    }
+
+    void ResourceManager::unload_unused(const double elapsed_sec) {
+        ResidentStats stats;
+        std::vector<::UnloadCandidate> tex_candidates;
+        std::vector<::UnloadCandidate> mesh_candidates;
+
+        stats.m_texture_bytes = ::scan_resources(this->m_textures, elapsed_sec, ::ResourceKind::texture, tex_candidates);
+        stats.m_model_bytes = ::scan_resources(this->m_models, elapsed_sec, ::ResourceKind::model, mesh_candidates);
+        stats.m_model_skinned_bytes = ::scan_resources(this->m_skinned_models, elapsed_sec, ::ResourceKind::model_skinned, mesh_candidates);
+
+        // Generated meshes can't be loaded again, so they only count towards the budget
+        for (auto& x : this->m_meshes) {
+            if (x.m_mesh)
+                stats.m_mesh_bytes += x.m_mesh->resident_bytes();
+        }
+
+        const auto unload = [this, &stats](const ::UnloadCandidate& candidate) {
+            switch (candidate.m_kind) {
+                case ::ResourceKind::texture:
+                    if (::unload_resource(this->m_textures, candidate.m_respath, this->m_retired_textures, this->m_frame_count))
+                        stats.m_texture_bytes -= candidate.m_bytes;
+                    break;
+                case ::ResourceKind::model:
+                    if (::unload_resource(this->m_models, candidate.m_respath, this->m_retired_models, this->m_frame_count))
+                        stats.m_model_bytes -= candidate.m_bytes;
+                    break;
+                case ::ResourceKind::model_skinned:
+                    if (::unload_resource(this->m_skinned_models, candidate.m_respath, this->m_retired_skinned_models, this->m_frame_count))
+                        stats.m_model_skinned_bytes -= candidate.m_bytes;
+                    break;
+            }
+        };
+
+        // Longest unused ones go first when over budget
+        const auto unload_over = [this, &unload](std::vector<::UnloadCandidate>& candidates, size_t resident_bytes, const size_t budget_bytes) {
+            std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+                return a.m_unused_sec > b.m_unused_sec;
+            });
+
+            for (const auto& x : candidates) {
+                const bool grace_over = x.m_unused_sec >= this->m_budget.m_grace_period_sec;
+                const bool budget_over = resident_bytes > budget_bytes && x.m_unused_sec >= ::MIN_UNUSED_SEC_TO_UNLOAD;
+                if (!grace_over && !budget_over)
+                    continue;
+
+                unload(x);
+                resident_bytes -= x.m_bytes;
+            }
+        };
+
+        unload_over(tex_candidates, stats.m_texture_bytes, this->m_budget.m_texture_bytes);
+        unload_over(mesh_candidates, stats.m_model_bytes + stats.m_model_skinned_bytes + stats.m_mesh_bytes, this->m_budget.m_mesh_bytes);
+
+        stats.m_texture_count = this->m_textures.size();
+        stats.m_model_count = this->m_models.size();
+        stats.m_model_skinned_count = this->m_skinned_models.size();
+        stats.m_mesh_count = this->m_meshes.size();
+        this->m_stats = stats;
+    }
+
 }
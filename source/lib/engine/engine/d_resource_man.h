@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <unordered_map>
 
 #include <daltools/common/crypto.h>
@@ -25,7 +26,13 @@ namespace dal {
 
         void notify_task_done(HTask& task) override;
 
-        void start(const ResPath& respath, HTexture h_texture, Filesystem& filesys, TaskManager& task_man);
+        void start(
+            const ResPath& respath,
+            const ImageFormat cook_format,
+            HTexture h_texture,
+            Filesystem& filesys,
+            TaskManager& task_man
+        );
 
     };
 
@@ -78,6 +85,29 @@ namespace dal {
     };
 
 
+    struct ResourceBudget {
+        // Unused resources are unloaded before their grace period ends while resident bytes exceed these
+        size_t m_texture_bytes = 512 * 1024 * 1024;
+        // Shared by static models, skinned models and generated meshes
+        size_t m_mesh_bytes = 256 * 1024 * 1024;
+        // Resources nothing but the manager holds are unloaded after this long
+        double m_grace_period_sec = 10;
+    };
+
+
+    struct ResidentStats {
+        size_t m_texture_bytes = 0;
+        size_t m_model_bytes = 0;
+        size_t m_model_skinned_bytes = 0;
+        size_t m_mesh_bytes = 0;
+
+        size_t m_texture_count = 0;
+        size_t m_model_count = 0;
+        size_t m_model_skinned_count = 0;
+        size_t m_mesh_count = 0;
+    };
+
+
     class ResourceManager : public ITextureManager {
 
     private:
@@ -88,14 +118,35 @@ namespace dal {
             void init_gen_mesh();
         };
 
+        template <typename _Handle>
+        struct LoadedResource {
+            _Handle m_handle;
+            // Time since only the manager holds the handle, counted from the first check that saw it unused
+            double m_unused_sec = 0;
+            bool m_seen_unused = false;
+        };
+
+        // Unloaded but frames in flight may still be drawing it
+        template <typename _Handle>
+        struct RetiredResource {
+            _Handle m_handle;
+            uint64_t m_retired_frame = 0;
+        };
+
+        template <typename _Handle>
+        using ResourceMap = std::unordered_map<std::string, LoadedResource<_Handle>>;
+
     private:
-        std::unordered_map<std::string, HTexture> m_textures;
-        std::unordered_map<std::string, HRenModel> m_models;
-        std::unordered_map<std::string, HRenModelSkinned> m_skinned_models;
+        ResourceMap<HTexture> m_textures;
+        ResourceMap<HRenModel> m_models;
+        ResourceMap<HRenModelSkinned> m_skinned_models;
         std::vector<HActor> m_actors;
         std::vector<HActorSkinned> m_skinned_actors;
         std::vector<MeshBuildData> m_meshes;
 
+        // Requested path to resolved one, so that materials sharing a texture skip resolving wildcards
+        std::unordered_map<std::string, std::string> m_resolved_paths;
+
         HTexture m_missing_tex;
         HRenModel m_missing_model;
         HRenModelSkinned m_missing_model_skinned;
@@ -104,6 +155,15 @@ namespace dal {
         ModelBuilder m_model_builder;
         ModelSkinnedBuilder m_model_skinned_builder;
 
+        std::vector<RetiredResource<HTexture>> m_retired_textures;
+        std::vector<RetiredResource<HRenModel>> m_retired_models;
+        std::vector<RetiredResource<HRenModelSkinned>> m_retired_skinned_models;
+
+        ResourceBudget m_budget;
+        ResidentStats m_stats;
+        double m_since_unload_check = 0;
+        uint64_t m_frame_count = 0;
+
         TaskManager& m_task_man;
         Filesystem& m_filesys;
         crypto::PublicKeySignature& m_sign_mgr;
@@ -119,12 +179,21 @@ namespace dal {
 
         }
 
-        void update();
+        void update(const double delta_time);
 
         void set_renderer(IRenderer& renderer);
 
         void invalidate_renderer();
 
+        void set_budget(const ResourceBudget& budget) {
+            this->m_budget = budget;
+        }
+
+        // As of the last unload check, which runs about once a second
+        auto& resident_stats() const {
+            return this->m_stats;
+        }
+
         HTexture request_texture(const ResPath& respath) override;
 
         HRenModel request_model(const ResPath& respath);
@@ -137,6 +206,14 @@ namespace dal {
 
         HMesh request_mesh(std::unique_ptr<IStaticMeshGenerator>&& mesh_gen);
 
+    private:
+        std::optional<std::string> resolve_path(const ResPath& respath);
+
+        void unload_unused(const double elapsed_sec);
+
+        // Destroys everything if force is true, which must only be done once device is idle
+        void destroy_retired(const bool force);
+
     };
 
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 
 namespace dal {
 
@@ -11,6 +13,12 @@ namespace dal {
 
     struct RendererConfig {
         ShaderConfig m_shader;
+        uint32_t m_staging_buffer_mb = 32;
+        // Streamed textures drop their finer mips to fit in it
+        uint32_t m_texture_budget_mb = 512;
+        // Each step doubles geometric error of levels of detail allowed on screen. Shadow passes can bear coarser ones.
+        float m_lod_bias = 0;
+        float m_shadow_lod_bias = 1;
     };
 
 }
@@ -121,6 +121,9 @@ namespace dal {
 
         virtual bool is_ready() const = 0;
 
+        // GPU memory it holds
+        virtual size_t resident_bytes() const = 0;
+
     };
 
 
@@ -135,6 +138,9 @@ namespace dal {
 
         virtual bool is_ready() const = 0;
 
+        // GPU memory it holds
+        virtual size_t resident_bytes() const = 0;
+
     };
 
 
@@ -153,6 +159,9 @@ namespace dal {
 
         virtual bool is_ready() const = 0;
 
+        // GPU memory of vertices and indices. Textures are not counted, they are resources of their own.
+        virtual size_t resident_bytes() const = 0;
+
     };
 
 
@@ -171,6 +180,9 @@ namespace dal {
 
         virtual bool is_ready() const = 0;
 
+        // GPU memory of vertices and indices. Textures are not counted, they are resources of their own.
+        virtual size_t resident_bytes() const = 0;
+
         virtual std::vector<Animation>& animations() = 0;
 
         virtual const std::vector<Animation>& animations() const = 0;
@@ -38,6 +38,9 @@ namespace dal {
 
         virtual void apply_config(const RendererConfig& config) {};
 
+        // Textures are cooked into this format before upload. r8g8b8a8_srgb means no cooking.
+        virtual ImageFormat texture_cook_format() const { return ImageFormat::r8g8b8a8_srgb; }
+
         virtual HTexture create_texture() { return nullptr; }
 
         virtual HMesh create_mesh() { return nullptr; }
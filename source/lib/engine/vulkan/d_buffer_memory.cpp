@@ -9,42 +9,45 @@
 
 namespace {
 
-    std::pair<VkBuffer, VkDeviceMemory> create_buffer(
+    std::pair<VkBuffer, dal::MemoryAllocation> create_buffer(
         const VkDeviceSize size,
         const VkBufferUsageFlags usage,
         const VkMemoryPropertyFlags properties,
-        const VkPhysicalDevice phys_device,
+        const std::vector<uint32_t>& queue_families,
         const VkDevice logi_device
     ) {
-        std::pair<VkBuffer, VkDeviceMemory> output{ VK_NULL_HANDLE, VK_NULL_HANDLE };
+        std::pair<VkBuffer, dal::MemoryAllocation> output{ VK_NULL_HANDLE, dal::MemoryAllocation{} };
 
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
         bufferInfo.usage = usage;
-        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (queue_families.size() > 1) {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = queue_families.size();
+            bufferInfo.pQueueFamilyIndices = queue_families.data();
+        }
+        else {
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        }
 
         if (vkCreateBuffer(logi_device, &bufferInfo, nullptr, &output.first) != VK_SUCCESS) {
             dalError("failed to create buffer!");
-            return { VK_NULL_HANDLE, VK_NULL_HANDLE };
+            return { VK_NULL_HANDLE, dal::MemoryAllocation{} };
         }
 
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(logi_device, output.first, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = dal::find_memory_type(
-            memRequirements.memoryTypeBits, properties, phys_device
-        );
-
-        if (vkAllocateMemory(logi_device, &allocInfo, nullptr, &output.second) != VK_SUCCESS) {
+        output.second = dal::MemoryAllocatorSingleton::inst().allocate(memRequirements, properties, true);
+        if (!output.second.is_ready()) {
             dalError("failed to allocate buffer memory!");
-            return { VK_NULL_HANDLE, VK_NULL_HANDLE };
+            vkDestroyBuffer(logi_device, output.first, nullptr);
+            return { VK_NULL_HANDLE, dal::MemoryAllocation{} };
         }
 
-        vkBindBufferMemory(logi_device, output.first, output.second, 0);
+        vkBindBufferMemory(logi_device, output.first, output.second.memory(), output.second.offset());
         return output;
     }
 
@@ -100,13 +103,13 @@ namespace dal {
 
     BufferMemory::BufferMemory(BufferMemory&& other) noexcept {
         std::swap(this->m_buffer, other.m_buffer);
-        std::swap(this->m_memory, other.m_memory);
+        std::swap(this->m_alloc, other.m_alloc);
         std::swap(this->m_size, other.m_size);
     }
 
     BufferMemory& BufferMemory::operator=(BufferMemory&& other) noexcept {
         std::swap(this->m_buffer, other.m_buffer);
-        std::swap(this->m_memory, other.m_memory);
+        std::swap(this->m_alloc, other.m_alloc);
         std::swap(this->m_size, other.m_size);
 
         return *this;
@@ -118,12 +121,23 @@ namespace dal {
         const VkMemoryPropertyFlags properties,
         const VkPhysicalDevice phys_device,
         const VkDevice logi_device
+    ) {
+        return this->init(size, usage, properties, std::vector<uint32_t>{}, phys_device, logi_device);
+    }
+
+    bool BufferMemory::init(
+        const VkDeviceSize size,
+        const VkBufferUsageFlags usage,
+        const VkMemoryPropertyFlags properties,
+        const std::vector<uint32_t>& queue_families,
+        const VkPhysicalDevice phys_device,
+        const VkDevice logi_device
     ) {
         this->destroy(logi_device);
 
         this->m_size = size;
-        std::tie(this->m_buffer, this->m_memory) = ::create_buffer(
-            size, usage, properties, phys_device, logi_device
+        std::tie(this->m_buffer, this->m_alloc) = ::create_buffer(
+            size, usage, properties, queue_families, logi_device
         );
 
         return this->is_ready();
@@ -135,16 +149,13 @@ namespace dal {
             this->m_buffer = VK_NULL_HANDLE;
         }
 
-        if (VK_NULL_HANDLE != this->m_memory) {
-            vkFreeMemory(logi_device, this->m_memory, nullptr);
-            this->m_memory = VK_NULL_HANDLE;
-        }
+        MemoryAllocatorSingleton::inst().free(this->m_alloc);
 
         this->m_size = 0;
     }
 
     bool BufferMemory::is_ready() const {
-        return this->m_buffer != VK_NULL_HANDLE && this->m_memory != VK_NULL_HANDLE;
+        return this->m_buffer != VK_NULL_HANDLE && this->m_alloc.is_ready();
     }
 
     void BufferMemory::copy_from_mem(
@@ -162,10 +173,30 @@ namespace dal {
             ).c_str()
         );
 
-        void* ptr = nullptr;
-        vkMapMemory(logi_device, this->m_memory, 0, this->size(), 0, &ptr);
-        memcpy(ptr, src, size);
-        vkUnmapMemory(logi_device, this->m_memory);
+        // Blocks are shared between buffers so they stay mapped for their whole lifetime
+        dalAssertm(nullptr != this->m_alloc.mapped_ptr(), "Tried to copy into a buffer which is not host visible");
+        memcpy(this->m_alloc.mapped_ptr(), src, size);
+        MemoryAllocatorSingleton::inst().flush(this->m_alloc, 0, size);
+    }
+
+    void BufferMemory::copy_from_mem_at(
+        const VkDeviceSize dst_offset,
+        const void* src,
+        const size_t size
+    ) {
+        dalAssert(this->is_ready());
+
+        dalAssertm(
+            this->size() >= dst_offset + size,
+            fmt::format(
+                "Requested copy range exceeds buffer size: offset: {}, req: {}, this: {}",
+                dst_offset, size, this->size()
+            ).c_str()
+        );
+
+        dalAssertm(nullptr != this->m_alloc.mapped_ptr(), "Tried to copy into a buffer which is not host visible");
+        memcpy(this->m_alloc.mapped_ptr() + dst_offset, src, size);
+        MemoryAllocatorSingleton::inst().flush(this->m_alloc, dst_offset, size);
     }
 
     void BufferMemory::copy_from_buf(
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <vector>
+
 #include "d_vulkan_header.h"
 #include "d_command.h"
+#include "d_memory_alloc.h"
 
 
 namespace dal {
@@ -17,7 +20,7 @@ namespace dal {
 
     private:
         VkBuffer m_buffer = VK_NULL_HANDLE;
-        VkDeviceMemory m_memory = VK_NULL_HANDLE;
+        MemoryAllocation m_alloc;
         VkDeviceSize m_size = 0;
 
     public:
@@ -42,6 +45,17 @@ namespace dal {
             const VkDevice logi_device
         );
 
+        // Shared by all the queue families if more than one is given
+        [[nodiscard]]
+        bool init(
+            const VkDeviceSize size,
+            const VkBufferUsageFlags usage,
+            const VkMemoryPropertyFlags properties,
+            const std::vector<uint32_t>& queue_families,
+            const VkPhysicalDevice phys_device,
+            const VkDevice logi_device
+        );
+
         void destroy(const VkDevice logi_device);
 
         bool is_ready() const;
@@ -63,6 +77,13 @@ namespace dal {
             const VkDevice logi_device
         );
 
+        // Writes into persistently mapped memory, no Vulkan call is made unless memory is not coherent
+        void copy_from_mem_at(
+            const VkDeviceSize dst_offset,
+            const void* src,
+            const size_t size
+        );
+
         void copy_from_buf(
             const BufferMemory& other,
             const VkDeviceSize size,
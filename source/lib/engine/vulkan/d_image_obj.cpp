@@ -1,19 +1,33 @@
 #include "d_image_obj.h"
 
+#include <vector>
 #include <cstdint>
+#include <algorithm>
 
 #include <fmt/format.h>
 
+#include "dal/util/konsts.h"
 #include "dal/util/logger.h"
+#include "dal/util/mipmap.h"
 #include "d_buffer_memory.h"
 
 
 namespace {
 
+    // Streamed textures never go coarser than the mip of this size
+    constexpr uint32_t STREAMING_MIN_SIZE = 64;
+
+
     VkFormat map_to_vk_format(const dal::ImageFormat format) {
         switch (format) {
             case dal::ImageFormat::r8g8b8a8_srgb:
                 return VK_FORMAT_R8G8B8A8_SRGB;
+            case dal::ImageFormat::bc7_srgb:
+                return VK_FORMAT_BC7_SRGB_BLOCK;
+            case dal::ImageFormat::etc2_rgba8_srgb:
+                return VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;
+            case dal::ImageFormat::astc_4x4_srgb:
+                return VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
             default:
                 dalAbort(fmt::format("Unkown dal::ImageFormat value: {}", static_cast<int>(format)).c_str());
         }
@@ -27,14 +41,14 @@ namespace {
         return mem_requirements;
     }
 
-    bool has_stencil_component(VkFormat depth_format) {
-        return depth_format == VK_FORMAT_D32_SFLOAT_S8_UINT || depth_format == VK_FORMAT_D24_UNORM_S8_UINT;
+    bool is_format_sampleable(const VkFormat format, const VkPhysicalDevice phys_device) {
+        VkFormatProperties properties{};
+        vkGetPhysicalDeviceFormatProperties(phys_device, format, &properties);
+        return 0 != (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
     }
 
-    template <typename T>
-    uint32_t calc_mip_levels(const T texture_width, const T texture_height) {
-        const auto a = std::floor(std::log2(std::max<double>(texture_width, texture_height)));
-        return static_cast<uint32_t>(a);
+    bool has_stencil_component(VkFormat depth_format) {
+        return depth_format == VK_FORMAT_D32_SFLOAT_S8_UINT || depth_format == VK_FORMAT_D24_UNORM_S8_UINT;
     }
 
 
@@ -50,7 +64,6 @@ namespace {
         const VkDevice logi_device
     ) {
         VkImage image = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
 
         VkImageCreateInfo image_info{};
         image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -74,17 +87,14 @@ namespace {
 
         const auto mem_req = ::get_image_mem_requirements(image, logi_device);
 
-        VkMemoryAllocateInfo alloc_info{};
-        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        alloc_info.allocationSize = mem_req.size;
-        alloc_info.memoryTypeIndex = dal::find_memory_type(
-            mem_req.memoryTypeBits, properties, phys_device
+        auto memory = dal::MemoryAllocatorSingleton::inst().allocate(
+            mem_req, properties, VK_IMAGE_TILING_LINEAR == tiling
         );
 
-        if (VK_SUCCESS != vkAllocateMemory(logi_device, &alloc_info, nullptr, &memory)) {
+        if (!memory.is_ready()) {
             dalAbort("failed to allocate image memory!");
         }
-        if (VK_SUCCESS != vkBindImageMemory(logi_device, image, memory, 0)) {
+        if (VK_SUCCESS != vkBindImageMemory(logi_device, image, memory.memory(), memory.offset())) {
             dalAbort("failed to bind image and memory!");
         }
 
@@ -97,12 +107,8 @@ namespace {
         const VkFormat format,
         const VkImageLayout old_layout,
         const VkImageLayout new_layout,
-        dal::CommandPool& cmd_pool,
-        const VkQueue graphics_queue,
-        const VkDevice logi_device
+        const VkCommandBuffer cmd_buf
     ) {
-        auto cmd_buf = cmd_pool.begin_single_time_cmd(logi_device);
-
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.oldLayout = old_layout;
@@ -147,24 +153,18 @@ namespace {
             0, nullptr,
             1, &barrier
         );
-
-        cmd_pool.end_single_time_cmd(cmd_buf, graphics_queue, logi_device);
     }
 
     void copy_buffer_to_image(
         const VkImage dst_image,
-        const VkBuffer src_buffer,
+        const dal::StagingSpan& src,
         const uint32_t width,
         const uint32_t height,
         const uint32_t mip_level,
-        dal::CommandPool& cmd_pool,
-        const VkQueue graphics_queue,
-        const VkDevice logi_device
+        const VkCommandBuffer cmd_buf
     ) {
-        auto cmd_buf = cmd_pool.begin_single_time_cmd(logi_device);
-
         VkBufferImageCopy region{};
-        region.bufferOffset = 0;
+        region.bufferOffset = src.m_offset;
         region.bufferRowLength = 0;
         region.bufferImageHeight = 0;
 
@@ -178,14 +178,48 @@ namespace {
 
         vkCmdCopyBufferToImage(
             cmd_buf,
-            src_buffer,
+            src.m_buffer,
             dst_image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             1,
             &region
         );
+    }
+
+    // All levels from base_mip go in one command with a region for each.
+    // Staging memory starts at base_mip of img, which becomes level 0 of the image.
+    void copy_mip_chain_to_image(
+        const VkImage dst_image,
+        const dal::StagingSpan& src,
+        const dal::ImageData& img,
+        const uint32_t base_mip,
+        const VkCommandBuffer cmd_buf
+    ) {
+        std::vector<VkBufferImageCopy> regions(img.mip_levels() - base_mip);
+
+        for (uint32_t i = 0; i < regions.size(); ++i) {
+            auto& region = regions[i];
+            region.bufferOffset = src.m_offset + img.mip_offset(base_mip + i) - img.mip_offset(base_mip);
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
 
-        cmd_pool.end_single_time_cmd(cmd_buf, graphics_queue, logi_device);
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = i;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+
+            region.imageOffset = { 0, 0, 0 };
+            region.imageExtent = { img.mip_width(base_mip + i), img.mip_height(base_mip + i), 1 };
+        }
+
+        vkCmdCopyBufferToImage(
+            cmd_buf,
+            src.m_buffer,
+            dst_image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(regions.size()),
+            regions.data()
+        );
     }
 
     void generate_mipmaps(
@@ -193,11 +227,8 @@ namespace {
         const int32_t tex_width,
         const int32_t tex_height,
         const uint32_t mip_levels,
-        dal::CommandPool& cmdPool,
-        const VkQueue graphicsQ,
-        const VkDevice logiDevice
+        const VkCommandBuffer cmdBuffer
     ) {
-        const auto cmdBuffer = cmdPool.begin_single_time_cmd(logiDevice);
         {
             VkImageMemoryBarrier barrier{};
             barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -280,7 +311,6 @@ namespace {
                 1, &barrier
             );
         }
-        cmdPool.end_single_time_cmd(cmdBuffer, graphicsQ, logiDevice);
     }
 
 }
@@ -361,61 +391,43 @@ namespace dal {
 // TextureImage
 namespace dal {
 
-    void TextureImage::init_texture(
+    UploadTicket TextureImage::init_texture(
         const ImageData& img,
-        dal::CommandPool& cmd_pool,
-        const VkQueue graphics_queue,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
+        const uint32_t base_mip,
+        dal::UploadManager& upload_man
     ) {
+        dalAssert(base_mip < img.mip_levels());
+        const auto logi_device = upload_man.logi_device();
+
         this->destory(logi_device);
         this->m_format = ::map_to_vk_format(img.format());
-        this->m_mip_levels = 1;
+        this->m_mip_levels = img.mip_levels() - base_mip;
 
-        BufferMemory staging_buffer;
-        const auto staging_result = staging_buffer.init(
-            img.data_size(),
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            phys_device, logi_device
-        );
-        dalAssert(staging_result);
-        staging_buffer.copy_from_mem(img.data(), img.data_size(), logi_device);
-
-        std::tie(this->m_image, this->m_memory) = ::create_image(
-            img.width(),
-            img.height(),
+        std::tie(this->m_image, this->m_alloc) = ::create_image(
+            img.mip_width(base_mip),
+            img.mip_height(base_mip),
             this->m_mip_levels,
             this->m_format,
             VK_IMAGE_TILING_OPTIMAL,
             VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            phys_device, logi_device
+            upload_man.phys_device(), logi_device
         );
 
+        const auto base_offset = img.mip_offset(base_mip);
+        const auto [cmd_buf, staging] = upload_man.begin_image_upload(img.data() + base_offset, img.data_size() - base_offset);
+
         ::transition_image_layout(
             this->m_image,
             this->m_mip_levels,
             this->m_format,
             VK_IMAGE_LAYOUT_UNDEFINED,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            cmd_pool,
-            graphics_queue,
-            logi_device
-        );
-
-        ::copy_buffer_to_image(
-            this->m_image,
-            staging_buffer.buffer(),
-            img.width(),
-            img.height(),
-            0,
-            cmd_pool,
-            graphics_queue,
-            logi_device
+            cmd_buf
         );
 
-        staging_buffer.destroy(logi_device);
+        // Every mip level is in the staging memory already so no blit is needed
+        ::copy_mip_chain_to_image(this->m_image, staging, img, base_mip, cmd_buf);
 
         ::transition_image_layout(
             this->m_image,
@@ -423,34 +435,23 @@ namespace dal {
             this->m_format,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            cmd_pool,
-            graphics_queue,
-            logi_device
+            cmd_buf
         );
+
+        return upload_man.end_image_upload();
     }
 
-    void TextureImage::init_texture_gen_mipmaps(
+    UploadTicket TextureImage::init_texture_gen_mipmaps(
         const ImageData& img,
-        dal::CommandPool& cmd_pool,
-        const VkQueue graphics_queue,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
+        dal::UploadManager& upload_man
     ) {
+        const auto logi_device = upload_man.logi_device();
+
         this->destory(logi_device);
         this->m_format = ::map_to_vk_format(img.format());
-        this->m_mip_levels = ::calc_mip_levels(img.width(), img.height());
+        this->m_mip_levels = dal::calc_mip_levels(img.width(), img.height());
 
-        BufferMemory staging_buffer;
-        const auto staging_result = staging_buffer.init(
-            img.data_size(),
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            phys_device, logi_device
-        );
-        dalAssert(staging_result);
-        staging_buffer.copy_from_mem(img.data(), img.data_size(), logi_device);
-
-        std::tie(this->m_image, this->m_memory) = ::create_image(
+        std::tie(this->m_image, this->m_alloc) = ::create_image(
             img.width(),
             img.height(),
             this->m_mip_levels,
@@ -458,42 +459,38 @@ namespace dal {
             VK_IMAGE_TILING_OPTIMAL,
             VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            phys_device, logi_device
+            upload_man.phys_device(), logi_device
         );
 
+        const auto [cmd_buf, staging] = upload_man.begin_image_upload(img.data(), img.data_size());
+
         ::transition_image_layout(
             this->m_image,
             this->m_mip_levels,
             this->m_format,
             VK_IMAGE_LAYOUT_UNDEFINED,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            cmd_pool,
-            graphics_queue,
-            logi_device
+            cmd_buf
         );
 
         ::copy_buffer_to_image(
             this->m_image,
-            staging_buffer.buffer(),
+            staging,
             img.width(),
             img.height(),
             0,
-            cmd_pool,
-            graphics_queue,
-            logi_device
+            cmd_buf
         );
 
-        staging_buffer.destroy(logi_device);
-
         ::generate_mipmaps(
             this->image(),
             img.width(),
             img.height(),
             this->m_mip_levels,
-            cmd_pool,
-            graphics_queue,
-            logi_device
+            cmd_buf
         );
+
+        return upload_man.end_image_upload();
     }
 
     void TextureImage::init_attachment(
@@ -508,7 +505,7 @@ namespace dal {
         this->m_format = format;
         this->m_mip_levels = 1;
 
-        std::tie(this->m_image, this->m_memory) = ::create_image(
+        std::tie(this->m_image, this->m_alloc) = ::create_image(
             width, height,
             this->m_mip_levels,
             this->m_format,
@@ -525,14 +522,11 @@ namespace dal {
             this->m_image = VK_NULL_HANDLE;
         }
 
-        if (VK_NULL_HANDLE != this->m_memory) {
-            vkFreeMemory(logi_device, this->m_memory, nullptr);
-            this->m_memory = VK_NULL_HANDLE;
-        }
+        MemoryAllocatorSingleton::inst().free(this->m_alloc);
     }
 
     bool TextureImage::is_ready() const {
-        return (VK_NULL_HANDLE != this->m_image) && (VK_NULL_HANDLE != this->m_memory);
+        return (VK_NULL_HANDLE != this->m_image) && this->m_alloc.is_ready();
     }
 
 }
@@ -626,19 +620,24 @@ namespace dal {
     }
 
     bool TextureUnit::init(
-        dal::CommandPool& cmd_pool,
         const dal::ImageData& img_data,
-        const VkQueue graphics_queue,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
+        const uint32_t base_mip,
+        dal::UploadManager& upload_man
     ) {
-        this->m_image.init_texture_gen_mipmaps(
-            img_data,
-            cmd_pool,
-            graphics_queue,
-            phys_device,
-            logi_device
-        );
+        const auto logi_device = upload_man.logi_device();
+
+        this->destroy(upload_man);
+
+        if (!::is_format_sampleable(::map_to_vk_format(img_data.format()), upload_man.phys_device())) {
+            dalError(fmt::format("Texture format is not supported by device: {}", static_cast<int>(img_data.format())).c_str());
+            return false;
+        }
+
+        // Compressed images cannot be blitted so they must come with their mip chain
+        if (img_data.mip_levels() > 1 || dal::is_format_compressed(img_data.format()))
+            this->m_upload_ticket = this->m_image.init_texture(img_data, base_mip, upload_man);
+        else
+            this->m_upload_ticket = this->m_image.init_texture_gen_mipmaps(img_data, upload_man);
 
         const auto result_view = this->m_view.init(
             this->m_image.image(),
@@ -651,9 +650,13 @@ namespace dal {
         return result_view;
     }
 
-    void TextureUnit::destroy(const VkDevice logi_device) {
-        this->m_image.destory(logi_device);
-        this->m_view.destroy(logi_device);
+    void TextureUnit::destroy(dal::UploadManager& upload_man) {
+        if (this->m_image.is_ready())
+            upload_man.wait(this->m_upload_ticket);
+
+        this->m_image.destory(upload_man.logi_device());
+        this->m_view.destroy(upload_man.logi_device());
+        this->m_upload_ticket = UploadTicket{};
     }
 
     bool TextureUnit::is_ready() const {
@@ -666,50 +669,141 @@ namespace dal {
 // TextureProxy
 namespace dal {
 
-    void TextureProxy::give_dependencies(
-        dal::CommandPool& cmd_pool,
-        const VkQueue graphics_queue,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
-    ) {
-        this->m_cmd_pool       = &cmd_pool;
-        this->m_graphics_queue = graphics_queue;
-        this->m_phys_device    = phys_device;
-        this->m_logi_devic     = logi_device;
+    TextureProxy::~TextureProxy() {
+        this->destroy();
+        this->clear_dependencies();
+    }
+
+    void TextureProxy::give_dependencies(dal::UploadManager& upload_man) {
+        this->m_upload_man = &upload_man;
     }
 
     void TextureProxy::clear_dependencies() {
-        this->m_cmd_pool       = nullptr;
-        this->m_graphics_queue = VK_NULL_HANDLE;
-        this->m_phys_device    = VK_NULL_HANDLE;
-        this->m_logi_devic     = VK_NULL_HANDLE;
+        this->m_upload_man = nullptr;
     }
 
     bool TextureProxy::are_dependencies_ready() const {
-        return (
-            this->m_cmd_pool != nullptr &&
-            this->m_graphics_queue != VK_NULL_HANDLE &&
-            this->m_phys_device != VK_NULL_HANDLE &&
-            this->m_logi_devic != VK_NULL_HANDLE
-            );
+        return this->m_upload_man != nullptr;
+    }
+
+    uint32_t TextureProxy::coarsest_mip() const {
+        if (!this->is_streamable())
+            return 0;
+
+        for (uint32_t i = 0; i < this->m_source.mip_levels(); ++i) {
+            if (std::max(this->m_source.mip_width(i), this->m_source.mip_height(i)) <= ::STREAMING_MIN_SIZE)
+                return i;
+        }
+
+        return this->m_source.mip_levels() - 1;
+    }
+
+    size_t TextureProxy::mip_chain_size(const uint32_t base_mip) const {
+        if (!this->is_streamable())
+            return this->resident_bytes();
+
+        return this->m_source.data_size() - this->m_source.mip_offset(base_mip);
+    }
+
+    void TextureProxy::request_mip(const uint32_t mip_level, const uint64_t frame_count) {
+        this->m_requested_mip = std::min(this->m_requested_mip, mip_level);
+        this->m_last_request_frame = frame_count;
+    }
+
+    uint32_t TextureProxy::take_requested_mip() {
+        const auto output = this->m_requested_mip;
+        this->m_requested_mip = NO_MIP_REQUEST;
+        return output;
+    }
+
+    bool TextureProxy::stream_to(const uint32_t base_mip) {
+        if (nullptr == this->m_upload_man || !this->is_streamable() || this->is_streaming())
+            return false;
+
+        const auto new_base_mip = std::min(base_mip, this->coarsest_mip());
+        if (new_base_mip == this->m_resident_mip)
+            return false;
+
+        // Any unit but current one is free while nothing is streaming
+        const auto index = (this->m_current + 1) % this->m_units.size();
+        if (!this->m_units[index].init(this->m_source, new_base_mip, *this->m_upload_man)) {
+            this->m_units[index].destroy(*this->m_upload_man);
+            return false;
+        }
+
+        this->m_pending = index;
+        this->m_pending_mip = new_base_mip;
+        return true;
+    }
+
+    void TextureProxy::update_streaming(const uint64_t frame_count) {
+        if (nullptr == this->m_upload_man)
+            return;
+
+        if (this->m_retired.has_value() && frame_count >= this->m_retired_frame + MAX_FRAMES_IN_FLIGHT) {
+            this->m_units[*this->m_retired].destroy(*this->m_upload_man);
+            this->m_retired.reset();
+        }
+
+        if (!this->m_pending.has_value() || this->m_retired.has_value())
+            return;
+        if (!this->m_upload_man->is_done(this->m_units[*this->m_pending].upload_ticket()))
+            return;
+
+        // Frames recorded before this one may still sample old one
+        this->m_retired = this->m_current;
+        this->m_retired_frame = frame_count;
+        this->m_current = *this->m_pending;
+        this->m_resident_mip = this->m_pending_mip;
+        this->m_pending.reset();
+        ++this->m_generation;
     }
 
     bool TextureProxy::set_image(const dal::ImageData& img_data) {
-        return this->m_texture.init(
-            *this->m_cmd_pool,
-            img_data,
-            this->m_graphics_queue,
-            this->m_phys_device,
-            this->m_logi_devic
-        );
+        this->destroy();
+
+        // Single level images get their mips generated on GPU, and borrowed memory is gone after this returns
+        if (img_data.mip_levels() > 1 && !img_data.is_borrowed())
+            this->m_source = img_data;
+
+        // Coarse mips come first so that it shows up quickly, finer ones are streamed in once it is seen
+        this->m_resident_mip = this->coarsest_mip();
+        ++this->m_generation;
+
+        return this->m_units[this->m_current].init(img_data, this->m_resident_mip, *this->m_upload_man);
     }
 
     void TextureProxy::destroy() {
-        this->m_texture.destroy(this->m_logi_devic);
+        if (nullptr == this->m_upload_man)
+            return;
+
+        for (auto& x : this->m_units)
+            x.destroy(*this->m_upload_man);
+
+        this->m_pending.reset();
+        this->m_retired.reset();
+        this->m_source = ImageData{};
+        this->m_resident_mip = 0;
+        this->m_requested_mip = NO_MIP_REQUEST;
     }
 
     bool TextureProxy::is_ready() const {
-        return this->m_texture.is_ready();
+        auto& texture = this->m_units[this->m_current];
+
+        if (!texture.is_ready())
+            return false;
+
+        // Image may not be sampled until GPU finished copying into it
+        return this->m_upload_man->is_done(texture.upload_ticket());
+    }
+
+    size_t TextureProxy::resident_bytes() const {
+        size_t output = 0;
+
+        for (auto& x : this->m_units)
+            output += static_cast<size_t>(x.memory_size());
+
+        return output;
     }
 
 }
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
 #include <queue>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <algorithm>
 #include <unordered_map>
 
 #include "dal/util/image_parser.h"
@@ -9,7 +13,8 @@
 #include "dal/util/task_thread.h"
 #include "d_renderer.h"
 #include "d_vulkan_header.h"
-#include "d_command.h"
+#include "d_upload.h"
+#include "d_memory_alloc.h"
 
 
 namespace dal {
@@ -63,26 +68,23 @@ namespace dal {
 
     private:
         VkImage m_image = VK_NULL_HANDLE;
-        VkDeviceMemory m_memory = VK_NULL_HANDLE;
+        MemoryAllocation m_alloc;
 
         VkFormat m_format;
         uint32_t m_mip_levels = 1;
 
     public:
-        void init_texture(
+        // Image is usable once returned ticket is done.
+        // Uploads every mip level img has from base_mip, in one staging copy. base_mip becomes level 0.
+        UploadTicket init_texture(
             const ImageData& img,
-            dal::CommandPool& cmd_pool,
-            const VkQueue graphics_queue,
-            const VkPhysicalDevice phys_device,
-            const VkDevice logi_device
+            const uint32_t base_mip,
+            dal::UploadManager& upload_man
         );
 
-        void init_texture_gen_mipmaps(
+        UploadTicket init_texture_gen_mipmaps(
             const ImageData& img,
-            dal::CommandPool& cmd_pool,
-            const VkQueue graphics_queue,
-            const VkPhysicalDevice phys_device,
-            const VkDevice logi_device
+            dal::UploadManager& upload_man
         );
 
         void init_attachment(
@@ -102,6 +104,10 @@ namespace dal {
             return this->m_image;
         }
 
+        auto memory_size() const {
+            return this->m_alloc.size();
+        }
+
         auto format() const {
             return this->m_format;
         }
@@ -158,22 +164,31 @@ namespace dal {
     private:
         TextureImage m_image;
         ImageView m_view;
+        UploadTicket m_upload_ticket;
 
     public:
         ~TextureUnit();
 
+        // base_mip is ignored for single level images, which get all of their mips generated
         bool init(
-            dal::CommandPool& cmd_pool,
             const dal::ImageData& img_data,
-            const VkQueue graphics_queue,
-            const VkPhysicalDevice phys_device,
-            const VkDevice logi_device
+            const uint32_t base_mip,
+            dal::UploadManager& upload_man
         );
 
-        void destroy(const VkDevice logi_device);
+        // Waits if upload is still in progress
+        void destroy(dal::UploadManager& upload_man);
 
         bool is_ready() const;
 
+        auto memory_size() const {
+            return this->m_image.memory_size();
+        }
+
+        auto& upload_ticket() const {
+            return this->m_upload_ticket;
+        }
+
         auto& view() const {
             return this->m_view;
         }
@@ -181,38 +196,102 @@ namespace dal {
     };
 
 
+    // Textures with mip chain are streamed. Only coarse mips are uploaded at first,
+    // and TextureStreamer replaces the image with one starting from finer or coarser mip as needed.
     class TextureProxy : public ITexture {
 
-    private:
-        TextureUnit m_texture;
+    public:
+        static constexpr uint32_t NO_MIP_REQUEST = std::numeric_limits<uint32_t>::max();
 
-        dal::CommandPool* m_cmd_pool       = nullptr;
-        VkQueue           m_graphics_queue = VK_NULL_HANDLE;
-        VkPhysicalDevice  m_phys_device    = VK_NULL_HANDLE;
-        VkDevice          m_logi_devic     = VK_NULL_HANDLE;
+    private:
+        // Current one is sampled, pending one is being uploaded and retired one may still be sampled by frames in flight.
+        // Roles rotate among them so that none of them needs to be moved.
+        std::array<TextureUnit, 3> m_units;
+        size_t m_current = 0;
+        std::optional<size_t> m_pending;
+        std::optional<size_t> m_retired;
+        uint64_t m_retired_frame = 0;
+
+        // Kept to upload finer mips later. Mostly it shares memory with cache file mapping.
+        ImageData m_source;
+        // Mip level of source that is level 0 of current image
+        uint32_t m_resident_mip = 0;
+        uint32_t m_pending_mip = 0;
+        // Finest one requested since last taken
+        uint32_t m_requested_mip = NO_MIP_REQUEST;
+        uint64_t m_last_request_frame = 0;
+        // Increased whenever current image changes so that descriptor sets can be recorded again
+        uint32_t m_generation = 0;
+
+        dal::UploadManager* m_upload_man = nullptr;
 
     public:
-        void give_dependencies(
-            dal::CommandPool& cmd_pool,
-            const VkQueue graphics_queue,
-            const VkPhysicalDevice phys_device,
-            const VkDevice logi_device
-        );
+        ~TextureProxy();
+
+        void give_dependencies(dal::UploadManager& upload_man);
 
         void clear_dependencies();
 
         bool are_dependencies_ready() const;
 
         auto raw_view() const {
-            return this->m_texture.view().get();
+            return this->m_units[this->m_current].view().get();
         }
 
+        auto generation() const {
+            return this->m_generation;
+        }
+
+        // Streaming
+
+        bool is_streamable() const {
+            return this->m_source.mip_levels() > 1;
+        }
+
+        bool is_streaming() const {
+            return this->m_pending.has_value() || this->m_retired.has_value();
+        }
+
+        auto resident_mip() const {
+            return this->m_resident_mip;
+        }
+
+        // Streaming never goes coarser than this
+        uint32_t coarsest_mip() const;
+
+        // Width or height of the finest mip, whichever is bigger
+        auto full_size() const {
+            return std::max(this->m_source.width(), this->m_source.height());
+        }
+
+        // Bytes of mips from base_mip to the end
+        size_t mip_chain_size(const uint32_t base_mip) const;
+
+        auto last_request_frame() const {
+            return this->m_last_request_frame;
+        }
+
+        void request_mip(const uint32_t mip_level, const uint64_t frame_count);
+
+        // NO_MIP_REQUEST if none since last call
+        uint32_t take_requested_mip();
+
+        // Starts uploading image from base_mip. False if it's not needed or previous one is still in progress.
+        bool stream_to(const uint32_t base_mip);
+
+        // Call once a frame after fence of frame in flight is waited on
+        void update_streaming(const uint64_t frame_count);
+
+        // Overridings
+
         bool set_image(const dal::ImageData& img_data) override;
 
         void destroy() override;
 
         bool is_ready() const override;
 
+        size_t resident_bytes() const override;
+
     };
 
 
@@ -0,0 +1,37 @@
+#include "d_indirect_draw.h"
+
+#include "dal/util/logger.h"
+
+
+namespace dal {
+
+    void IndirectDrawBuilder::clear() {
+        this->m_cmds.clear();
+        this->m_batch_begin = 0;
+    }
+
+    void IndirectDrawBuilder::begin_batch() {
+        this->m_batch_begin = this->m_cmds.size();
+    }
+
+    void IndirectDrawBuilder::push(const uint32_t index_count, const uint32_t first_index, const int32_t vertex_offset) {
+        auto& cmd = this->m_cmds.emplace_back();
+        cmd.m_index_count = index_count;
+        cmd.m_instance_count = 1;
+        cmd.m_first_index = first_index;
+        cmd.m_vertex_offset = vertex_offset;
+        cmd.m_first_instance = 0;
+    }
+
+    IndirectBatch IndirectDrawBuilder::end_batch() {
+        dalAssert(this->m_batch_begin <= this->m_cmds.size());
+
+        IndirectBatch output;
+        output.m_first_cmd = this->m_batch_begin;
+        output.m_cmd_count = this->m_cmds.size() - this->m_batch_begin;
+
+        this->m_batch_begin = this->m_cmds.size();
+        return output;
+    }
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+// Nothing here needs Vulkan so command building can be tested without a device
+namespace dal {
+
+    // Same memory layout as VkDrawIndexedIndirectCommand
+    struct DrawIndexedCmd {
+        uint32_t m_index_count = 0;
+        uint32_t m_instance_count = 1;
+        uint32_t m_first_index = 0;
+        int32_t m_vertex_offset = 0;
+        uint32_t m_first_instance = 0;
+    };
+
+
+    // Consecutive commands which are drawn with same pipeline states
+    struct IndirectBatch {
+        uint32_t m_first_cmd = 0;
+        uint32_t m_cmd_count = 0;
+
+        bool is_empty() const {
+            return 0 == this->m_cmd_count;
+        }
+    };
+
+
+    class IndirectDrawBuilder {
+
+    private:
+        std::vector<DrawIndexedCmd> m_cmds;
+        uint32_t m_batch_begin = 0;
+
+    public:
+        void clear();
+
+        void begin_batch();
+
+        void push(const uint32_t index_count, const uint32_t first_index, const int32_t vertex_offset);
+
+        IndirectBatch end_batch();
+
+        auto& commands() const {
+            return this->m_cmds;
+        }
+
+        size_t data_size() const {
+            return this->m_cmds.size() * sizeof(DrawIndexedCmd);
+        }
+
+    };
+
+}
@@ -0,0 +1,360 @@
+#include "d_memory_alloc.h"
+
+#include <limits>
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "dal/util/logger.h"
+
+
+namespace {
+
+    constexpr VkDeviceSize BLOCK_SIZE_DEVICE_LOCAL = 64 * 1024 * 1024;
+    constexpr VkDeviceSize BLOCK_SIZE_HOST_VISIBLE = 16 * 1024 * 1024;
+
+
+    VkDeviceSize align_up(const VkDeviceSize value, const VkDeviceSize alignment) {
+        if (alignment <= 1)
+            return value;
+        else
+            return (value + alignment - 1) / alignment * alignment;
+    }
+
+    VkDeviceSize align_down(const VkDeviceSize value, const VkDeviceSize alignment) {
+        if (alignment <= 1)
+            return value;
+        else
+            return value / alignment * alignment;
+    }
+
+    uint32_t make_pool_index(const uint32_t memory_type_index, const bool is_linear_resource) {
+        return memory_type_index * 2 + (is_linear_resource ? 0 : 1);
+    }
+
+    uint32_t pool_to_memory_type_index(const uint32_t pool_index) {
+        return pool_index / 2;
+    }
+
+    VkDeviceSize calc_block_size(const VkPhysicalDeviceMemoryProperties& mem_props, const uint32_t memory_type_index) {
+        const auto& mem_type = mem_props.memoryTypes[memory_type_index];
+        const auto heap_size = mem_props.memoryHeaps[mem_type.heapIndex].size;
+
+        const auto preferred = (mem_type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ? ::BLOCK_SIZE_HOST_VISIBLE : ::BLOCK_SIZE_DEVICE_LOCAL;
+
+        // Small heaps (e.g. 256 MB BAR memory) must not be eaten up by a handful of blocks
+        return std::max<VkDeviceSize>(std::min<VkDeviceSize>(preferred, heap_size / 8), 1024 * 1024);
+    }
+
+}
+
+
+// MemoryBlock
+namespace dal {
+
+    MemoryBlock::~MemoryBlock() {
+        dalAssert(!this->is_ready());
+    }
+
+    bool MemoryBlock::init(
+        const VkDeviceSize size,
+        const uint32_t memory_type_index,
+        const bool map_memory,
+        const bool dedicated,
+        const VkDevice logi_device
+    ) {
+        this->destroy(logi_device);
+
+        VkMemoryAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = size;
+        alloc_info.memoryTypeIndex = memory_type_index;
+
+        if (VK_SUCCESS != vkAllocateMemory(logi_device, &alloc_info, nullptr, &this->m_memory)) {
+            dalError(fmt::format("Failed to allocate memory block of {} bytes", size).c_str());
+            this->m_memory = VK_NULL_HANDLE;
+            return false;
+        }
+
+        if (map_memory) {
+            void* ptr = nullptr;
+            if (VK_SUCCESS != vkMapMemory(logi_device, this->m_memory, 0, VK_WHOLE_SIZE, 0, &ptr)) {
+                dalError("Failed to map memory block");
+                this->destroy(logi_device);
+                return false;
+            }
+            this->m_mapped_ptr = reinterpret_cast<uint8_t*>(ptr);
+        }
+
+        this->m_dedicated = dedicated;
+        this->m_ranges.init(size);
+
+        return true;
+    }
+
+    void MemoryBlock::destroy(const VkDevice logi_device) {
+        if (VK_NULL_HANDLE != this->m_memory) {
+            if (nullptr != this->m_mapped_ptr)
+                vkUnmapMemory(logi_device, this->m_memory);
+
+            vkFreeMemory(logi_device, this->m_memory, nullptr);
+            this->m_memory = VK_NULL_HANDLE;
+        }
+
+        this->m_mapped_ptr = nullptr;
+        this->m_ranges.clear();
+    }
+
+}
+
+
+// MemoryAllocatorSingleton
+namespace dal {
+
+    void MemoryAllocatorSingleton::init(const VkPhysicalDevice phys_device, const VkDevice logi_device) {
+        this->destroy();
+
+        std::unique_lock lck{ this->m_mut };
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(phys_device, &properties);
+        vkGetPhysicalDeviceMemoryProperties(phys_device, &this->m_mem_props);
+
+        this->m_non_coherent_atom_size = std::max<VkDeviceSize>(1, properties.limits.nonCoherentAtomSize);
+        this->m_logi_device = logi_device;
+    }
+
+    void MemoryAllocatorSingleton::destroy() {
+        std::unique_lock lck{ this->m_mut };
+
+        if (VK_NULL_HANDLE == this->m_logi_device)
+            return;
+
+        for (auto& pool : this->m_pools) {
+            for (auto& block : pool.m_blocks) {
+                if (block->alloc_count() > 0) {
+                    dalWarn(fmt::format("Memory block destroyed with {} live allocations", block->alloc_count()).c_str());
+                }
+
+                block->destroy(this->m_logi_device);
+            }
+
+            pool.m_blocks.clear();
+        }
+
+        this->m_logi_device = VK_NULL_HANDLE;
+    }
+
+    MemoryAllocation MemoryAllocatorSingleton::allocate(
+        const VkMemoryRequirements& requirements,
+        const VkMemoryPropertyFlags properties,
+        const bool is_linear_resource
+    ) {
+        std::unique_lock lck{ this->m_mut };
+        dalAssert(this->is_ready());
+
+        const auto type_index = this->find_memory_type(requirements.memoryTypeBits, properties);
+        const auto type_flags = this->m_mem_props.memoryTypes[type_index].propertyFlags;
+        const bool host_visible = 0 != (type_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        const bool host_coherent = 0 != (type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        auto alignment = std::max<VkDeviceSize>(1, requirements.alignment);
+        auto size = requirements.size;
+        if (host_visible && !host_coherent) {
+            // So that flushing one allocation never touches a neighbour's atom
+            alignment = std::max(alignment, this->m_non_coherent_atom_size);
+            size = ::align_up(size, this->m_non_coherent_atom_size);
+        }
+
+        const auto pool_index = ::make_pool_index(type_index, is_linear_resource);
+        auto& pool = this->m_pools[pool_index];
+        const auto block_size = ::calc_block_size(this->m_mem_props, type_index);
+
+        MemoryBlock* found_block = nullptr;
+        std::optional<VkDeviceSize> found_offset;
+
+        if (size > block_size / 2) {
+            auto& block = pool.m_blocks.emplace_back(std::make_unique<MemoryBlock>());
+            if (!block->init(size, type_index, host_visible, true, this->m_logi_device)) {
+                pool.m_blocks.pop_back();
+                return MemoryAllocation{};
+            }
+
+            found_block = block.get();
+            found_offset = block->allocate(size, alignment);
+        }
+        else {
+            for (auto& block : pool.m_blocks) {
+                if (block->is_dedicated())
+                    continue;
+
+                found_offset = block->allocate(size, alignment);
+                if (found_offset.has_value()) {
+                    found_block = block.get();
+                    break;
+                }
+            }
+
+            if (nullptr == found_block) {
+                auto& block = pool.m_blocks.emplace_back(std::make_unique<MemoryBlock>());
+                if (!block->init(block_size, type_index, host_visible, false, this->m_logi_device)) {
+                    pool.m_blocks.pop_back();
+                    return MemoryAllocation{};
+                }
+
+                found_block = block.get();
+                found_offset = block->allocate(size, alignment);
+            }
+        }
+
+        dalAssert(nullptr != found_block && found_offset.has_value());
+
+        MemoryAllocation output;
+        output.m_memory = found_block->memory();
+        output.m_offset = *found_offset;
+        output.m_size = size;
+        output.m_block = found_block;
+        output.m_pool_index = pool_index;
+        if (nullptr != found_block->mapped_ptr())
+            output.m_mapped_ptr = found_block->mapped_ptr() + *found_offset;
+
+        return output;
+    }
+
+    void MemoryAllocatorSingleton::free(MemoryAllocation& allocation) {
+        if (!allocation.is_ready())
+            return;
+
+        std::unique_lock lck{ this->m_mut };
+        dalAssert(this->is_ready());
+
+        auto& pool = this->m_pools[allocation.m_pool_index];
+        auto block = allocation.m_block;
+        block->free(allocation.m_offset, allocation.m_size);
+        allocation = MemoryAllocation{};
+
+        if (block->alloc_count() > 0)
+            return;
+
+        // Keep one empty shared block around so that create/destroy churn does not hit vkAllocateMemory every time
+        if (!block->is_dedicated()) {
+            const auto empty_count = std::count_if(pool.m_blocks.begin(), pool.m_blocks.end(), [](auto& x) {
+                return !x->is_dedicated() && 0 == x->alloc_count();
+            });
+
+            if (empty_count < 2)
+                return;
+        }
+
+        const auto found = std::find_if(pool.m_blocks.begin(), pool.m_blocks.end(), [block](auto& x) { return x.get() == block; });
+        dalAssert(found != pool.m_blocks.end());
+        (*found)->destroy(this->m_logi_device);
+        pool.m_blocks.erase(found);
+    }
+
+    void MemoryAllocatorSingleton::flush(const MemoryAllocation& allocation, const VkDeviceSize offset, const VkDeviceSize size) {
+        dalAssert(allocation.is_ready());
+
+        const auto type_index = ::pool_to_memory_type_index(allocation.m_pool_index);
+        const auto type_flags = this->m_mem_props.memoryTypes[type_index].propertyFlags;
+        if (type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+            return;
+
+        const auto begin = ::align_down(allocation.m_offset + offset, this->m_non_coherent_atom_size);
+        const auto end = std::min(
+            ::align_up(allocation.m_offset + offset + size, this->m_non_coherent_atom_size),
+            allocation.m_block->size()
+        );
+
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.m_memory;
+        range.offset = begin;
+        range.size = end - begin;
+
+        vkFlushMappedMemoryRanges(this->m_logi_device, 1, &range);
+    }
+
+    MemoryAllocStats MemoryAllocatorSingleton::calc_stats() const {
+        std::unique_lock lck{ this->m_mut };
+        MemoryAllocStats output;
+
+        for (uint32_t i = 0; i < this->m_pools.size(); ++i)
+            output.add(this->calc_stats_no_lock(i));
+
+        return output;
+    }
+
+    MemoryAllocStats MemoryAllocatorSingleton::calc_stats(const uint32_t memory_type_index) const {
+        std::unique_lock lck{ this->m_mut };
+        MemoryAllocStats output;
+
+        output.add(this->calc_stats_no_lock(::make_pool_index(memory_type_index, true)));
+        output.add(this->calc_stats_no_lock(::make_pool_index(memory_type_index, false)));
+
+        return output;
+    }
+
+    std::string MemoryAllocatorSingleton::make_stats_str() const {
+        std::string output = "GPU memory allocator stats\n";
+        MemoryAllocStats total;
+
+        for (uint32_t i = 0; i < this->m_mem_props.memoryTypeCount; ++i) {
+            const auto stats = this->calc_stats(i);
+            if (0 == stats.m_block_count)
+                continue;
+
+            total.add(stats);
+
+            output += fmt::format(
+                "    type {:2} (flags {:#06x}): blocks {} ({} dedicated), allocations {}, used {:.2f} / {:.2f} MB, free ranges {}, fragmentation {:.3f}\n",
+                i,
+                this->m_mem_props.memoryTypes[i].propertyFlags,
+                stats.m_block_count,
+                stats.m_dedicated_block_count,
+                stats.m_allocation_count,
+                static_cast<double>(stats.m_bytes_used) / (1024.0 * 1024.0),
+                static_cast<double>(stats.m_bytes_reserved) / (1024.0 * 1024.0),
+                stats.m_free_range_count,
+                stats.fragmentation()
+            );
+        }
+
+        output += fmt::format(
+            "    total: blocks {}, allocations {}, used {:.2f} / {:.2f} MB",
+            total.m_block_count,
+            total.m_allocation_count,
+            static_cast<double>(total.m_bytes_used) / (1024.0 * 1024.0),
+            static_cast<double>(total.m_bytes_reserved) / (1024.0 * 1024.0)
+        );
+
+        return output;
+    }
+
+    void MemoryAllocatorSingleton::dump_stats() const {
+        dalInfo(this->make_stats_str().c_str());
+    }
+
+    // Private
+
+    uint32_t MemoryAllocatorSingleton::find_memory_type(const uint32_t type_filter, const VkMemoryPropertyFlags props) const {
+        for (uint32_t i = 0; i < this->m_mem_props.memoryTypeCount; ++i) {
+            if (type_filter & (1 << i) && (this->m_mem_props.memoryTypes[i].propertyFlags & props) == props) {
+                return i;
+            }
+        }
+
+        dalAbort("failed to find suitable memory type!");
+        return (std::numeric_limits<uint32_t>::max)();
+    }
+
+    MemoryAllocStats MemoryAllocatorSingleton::calc_stats_no_lock(const uint32_t pool_index) const {
+        MemoryAllocStats output;
+
+        for (auto& block : this->m_pools[pool_index].m_blocks)
+            output.add_block(block->ranges(), block->is_dedicated());
+
+        return output;
+    }
+
+}
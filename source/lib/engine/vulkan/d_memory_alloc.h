@@ -0,0 +1,185 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+
+#include "d_memory_range.h"
+#include "d_vulkan_header.h"
+
+
+namespace dal {
+
+    class MemoryBlock;
+
+
+    class MemoryAllocation {
+
+    private:
+        VkDeviceMemory m_memory = VK_NULL_HANDLE;
+        VkDeviceSize m_offset = 0;
+        VkDeviceSize m_size = 0;
+        uint8_t* m_mapped_ptr = nullptr;
+        MemoryBlock* m_block = nullptr;
+        uint32_t m_pool_index = 0;
+
+    public:
+        bool is_ready() const {
+            return VK_NULL_HANDLE != this->m_memory;
+        }
+
+        auto memory() const {
+            return this->m_memory;
+        }
+
+        auto offset() const {
+            return this->m_offset;
+        }
+
+        auto size() const {
+            return this->m_size;
+        }
+
+        // nullptr if memory is not host visible
+        auto mapped_ptr() const {
+            return this->m_mapped_ptr;
+        }
+
+        friend class MemoryAllocatorSingleton;
+
+    };
+
+
+    // A single VkDeviceMemory which is carved into smaller ranges with first-fit free list.
+    class MemoryBlock {
+
+    private:
+        FreeRangeList m_ranges;
+        VkDeviceMemory m_memory = VK_NULL_HANDLE;
+        uint8_t* m_mapped_ptr = nullptr;
+        bool m_dedicated = false;
+
+    public:
+        MemoryBlock() = default;
+
+        MemoryBlock(const MemoryBlock&) = delete;
+        MemoryBlock& operator=(const MemoryBlock&) = delete;
+
+    public:
+        ~MemoryBlock();
+
+        [[nodiscard]]
+        bool init(
+            const VkDeviceSize size,
+            const uint32_t memory_type_index,
+            const bool map_memory,
+            const bool dedicated,
+            const VkDevice logi_device
+        );
+
+        void destroy(const VkDevice logi_device);
+
+        bool is_ready() const {
+            return VK_NULL_HANDLE != this->m_memory;
+        }
+
+        std::optional<VkDeviceSize> allocate(const VkDeviceSize size, const VkDeviceSize alignment) {
+            return this->m_ranges.allocate(size, alignment);
+        }
+
+        void free(const VkDeviceSize offset, const VkDeviceSize size) {
+            this->m_ranges.free(offset, size);
+        }
+
+        auto memory() const {
+            return this->m_memory;
+        }
+
+        auto mapped_ptr() const {
+            return this->m_mapped_ptr;
+        }
+
+        auto size() const {
+            return this->m_ranges.size();
+        }
+
+        auto& ranges() const {
+            return this->m_ranges;
+        }
+
+        auto alloc_count() const {
+            return this->m_ranges.alloc_count();
+        }
+
+        auto is_dedicated() const {
+            return this->m_dedicated;
+        }
+
+    };
+
+
+    // Every BufferMemory and TextureImage get their memory from here instead of calling vkAllocateMemory.
+    // Owned by VulkanState between logical device creation and destruction.
+    class MemoryAllocatorSingleton {
+
+    private:
+        struct Pool {
+            std::vector<std::unique_ptr<MemoryBlock>> m_blocks;
+        };
+
+    private:
+        // Linear resources (buffers) and optimal-tiling images never share a block so
+        // bufferImageGranularity never has to be considered.
+        std::array<Pool, VK_MAX_MEMORY_TYPES * 2> m_pools;
+        VkPhysicalDeviceMemoryProperties m_mem_props{};
+        VkDeviceSize m_non_coherent_atom_size = 1;
+        VkDevice m_logi_device = VK_NULL_HANDLE;
+        mutable std::mutex m_mut;
+
+    private:
+        MemoryAllocatorSingleton() = default;
+
+    public:
+        static auto& inst() noexcept {
+            static MemoryAllocatorSingleton inst;
+            return inst;
+        }
+
+        void init(const VkPhysicalDevice phys_device, const VkDevice logi_device);
+
+        void destroy();
+
+        bool is_ready() const {
+            return VK_NULL_HANDLE != this->m_logi_device;
+        }
+
+        MemoryAllocation allocate(
+            const VkMemoryRequirements& requirements,
+            const VkMemoryPropertyFlags properties,
+            const bool is_linear_resource
+        );
+
+        void free(MemoryAllocation& allocation);
+
+        // Needed only for memory types without VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        void flush(const MemoryAllocation& allocation, const VkDeviceSize offset, const VkDeviceSize size);
+
+        MemoryAllocStats calc_stats() const;
+
+        MemoryAllocStats calc_stats(const uint32_t memory_type_index) const;
+
+        std::string make_stats_str() const;
+
+        void dump_stats() const;
+
+    private:
+        uint32_t find_memory_type(const uint32_t type_filter, const VkMemoryPropertyFlags props) const;
+
+        MemoryAllocStats calc_stats_no_lock(const uint32_t pool_index) const;
+
+    };
+
+}
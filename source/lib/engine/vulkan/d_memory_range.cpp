@@ -0,0 +1,130 @@
+#include "d_memory_range.h"
+
+#include <algorithm>
+
+#include "dal/util/logger.h"
+
+
+namespace {
+
+    uint64_t align_up(const uint64_t value, const uint64_t alignment) {
+        if (alignment <= 1)
+            return value;
+        else
+            return (value + alignment - 1) / alignment * alignment;
+    }
+
+}
+
+
+// FreeRangeList
+namespace dal {
+
+    void FreeRangeList::init(const uint64_t size) {
+        this->clear();
+        this->m_size = size;
+        this->m_free_ranges.emplace(0, size);
+    }
+
+    void FreeRangeList::clear() {
+        this->m_free_ranges.clear();
+        this->m_size = 0;
+        this->m_used = 0;
+        this->m_alloc_count = 0;
+    }
+
+    std::optional<uint64_t> FreeRangeList::allocate(const uint64_t size, const uint64_t alignment) {
+        for (auto iter = this->m_free_ranges.begin(); iter != this->m_free_ranges.end(); ++iter) {
+            const auto range_offset = iter->first;
+            const auto range_size = iter->second;
+            const auto aligned_offset = ::align_up(range_offset, alignment);
+            const auto padding = aligned_offset - range_offset;
+
+            if (range_size < padding + size)
+                continue;
+
+            const auto tail_size = range_size - padding - size;
+
+            this->m_free_ranges.erase(iter);
+            if (padding > 0)
+                this->m_free_ranges.emplace(range_offset, padding);
+            if (tail_size > 0)
+                this->m_free_ranges.emplace(aligned_offset + size, tail_size);
+
+            this->m_used += size;
+            ++this->m_alloc_count;
+            return aligned_offset;
+        }
+
+        return std::nullopt;
+    }
+
+    void FreeRangeList::free(const uint64_t offset, const uint64_t size) {
+        dalAssert(this->m_alloc_count > 0);
+        dalAssert(this->m_used >= size);
+
+        this->m_used -= size;
+        --this->m_alloc_count;
+
+        auto [iter, inserted] = this->m_free_ranges.emplace(offset, size);
+        dalAssertm(inserted, "Double free detected in FreeRangeList");
+
+        const auto next = std::next(iter);
+        if (next != this->m_free_ranges.end() && iter->first + iter->second == next->first) {
+            iter->second += next->second;
+            this->m_free_ranges.erase(next);
+        }
+
+        if (iter != this->m_free_ranges.begin()) {
+            const auto prev = std::prev(iter);
+            if (prev->first + prev->second == iter->first) {
+                prev->second += iter->second;
+                this->m_free_ranges.erase(iter);
+            }
+        }
+    }
+
+    uint64_t FreeRangeList::largest_free_range() const {
+        uint64_t output = 0;
+
+        for (auto& [offset, size] : this->m_free_ranges)
+            output = std::max(output, size);
+
+        return output;
+    }
+
+}
+
+
+// MemoryAllocStats
+namespace dal {
+
+    void MemoryAllocStats::add(const MemoryAllocStats& other) {
+        this->m_block_count += other.m_block_count;
+        this->m_dedicated_block_count += other.m_dedicated_block_count;
+        this->m_allocation_count += other.m_allocation_count;
+        this->m_free_range_count += other.m_free_range_count;
+        this->m_bytes_reserved += other.m_bytes_reserved;
+        this->m_bytes_used += other.m_bytes_used;
+        this->m_largest_free_range = std::max(this->m_largest_free_range, other.m_largest_free_range);
+    }
+
+    void MemoryAllocStats::add_block(const FreeRangeList& ranges, const bool dedicated) {
+        this->m_block_count += 1;
+        this->m_dedicated_block_count += dedicated ? 1 : 0;
+        this->m_allocation_count += ranges.alloc_count();
+        this->m_free_range_count += ranges.free_range_count();
+        this->m_bytes_reserved += ranges.size();
+        this->m_bytes_used += ranges.used();
+        this->m_largest_free_range = std::max(this->m_largest_free_range, ranges.largest_free_range());
+    }
+
+    double MemoryAllocStats::fragmentation() const {
+        const auto free_bytes = this->m_bytes_reserved - this->m_bytes_used;
+        if (0 == free_bytes)
+            return 0;
+
+        return 1.0 - static_cast<double>(this->m_largest_free_range) / static_cast<double>(free_bytes);
+    }
+
+}
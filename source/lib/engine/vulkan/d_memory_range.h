@@ -0,0 +1,69 @@
+#pragma once
+
+#include <map>
+#include <cstdint>
+#include <optional>
+
+
+// Nothing here needs Vulkan so sub-allocation can be tested without a device.
+// Sizes and offsets are uint64_t, which is what VkDeviceSize is.
+namespace dal {
+
+    // Carves [0, size) into smaller ranges with first-fit free list
+    class FreeRangeList {
+
+    private:
+        std::map<uint64_t, uint64_t> m_free_ranges;  // Offset -> size, adjacent ranges are always merged
+        uint64_t m_size = 0;
+        uint64_t m_used = 0;
+        uint32_t m_alloc_count = 0;
+
+    public:
+        void init(const uint64_t size);
+
+        void clear();
+
+        std::optional<uint64_t> allocate(const uint64_t size, const uint64_t alignment);
+
+        void free(const uint64_t offset, const uint64_t size);
+
+        auto size() const {
+            return this->m_size;
+        }
+
+        auto used() const {
+            return this->m_used;
+        }
+
+        auto alloc_count() const {
+            return this->m_alloc_count;
+        }
+
+        auto free_range_count() const {
+            return this->m_free_ranges.size();
+        }
+
+        uint64_t largest_free_range() const;
+
+    };
+
+
+    struct MemoryAllocStats {
+        size_t m_block_count = 0;
+        size_t m_dedicated_block_count = 0;
+        size_t m_allocation_count = 0;
+        size_t m_free_range_count = 0;
+        uint64_t m_bytes_reserved = 0;
+        uint64_t m_bytes_used = 0;
+        uint64_t m_largest_free_range = 0;
+
+        void add(const MemoryAllocStats& other);
+
+        void add_block(const FreeRangeList& ranges, const bool dedicated);
+
+        // 0 means every free byte is in one contiguous range, approaches 1 as free space gets scattered.
+        double fragmentation() const;
+
+    };
+
+}
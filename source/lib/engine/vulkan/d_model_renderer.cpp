@@ -5,55 +5,73 @@
 #include "dal/util/indices.h"
 
 
-// ActorVK
-namespace dal {
+namespace {
+
+    template <typename _VertType>
+    dal::MeshRange append_mesh(
+        std::vector<_VertType>& dst_vertices,
+        std::vector<dal::index_data_t>& dst_indices,
+        const std::vector<_VertType>& vertices,
+        const std::vector<dal::index_data_t>& indices
+    ) {
+        dal::MeshRange output;
+        output.m_index_count = indices.size();
+        output.m_first_index = dst_indices.size();
+        output.m_vertex_offset = dst_vertices.size();
 
-    void ActorVK::init(
-        DescAllocator& desc_allocator,
-        const dal::DescLayout_PerActor& layout_per_actor,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
+        dst_vertices.insert(dst_vertices.end(), vertices.begin(), vertices.end());
+        dst_indices.insert(dst_indices.end(), indices.begin(), indices.end());
+
+        return output;
+    }
+
+    // Levels share vertices with the mesh at mesh_range, so only indices are appended
+    std::vector<dal::RenderUnit::Lod> append_lods(
+        std::vector<dal::index_data_t>& dst_indices,
+        const std::vector<dal::MeshLod>& lods,
+        const dal::MeshRange& mesh_range
     ) {
-        this->destroy(desc_allocator, logi_device);
+        std::vector<dal::RenderUnit::Lod> output;
 
-        this->m_ubuf_per_actor.init(dal::MAX_FRAMES_IN_FLIGHT, phys_device, logi_device);
+        for (auto& lod : lods) {
+            auto& dst = output.emplace_back();
+            dst.m_mesh.m_index_count = lod.m_indices.size();
+            dst.m_mesh.m_first_index = dst_indices.size();
+            dst.m_mesh.m_vertex_offset = mesh_range.m_vertex_offset;
+            dst.m_error = lod.m_error;
 
-        for (int i = 0; i < dal::MAX_FRAMES_IN_FLIGHT; ++i) {
-            this->m_desc.push_back(desc_allocator.allocate(layout_per_actor, logi_device));
-            this->m_desc.back().record_per_actor(
-                this->m_ubuf_per_actor.at(i),
-                logi_device
-            );
+            dst_indices.insert(dst_indices.end(), lod.m_indices.begin(), lod.m_indices.end());
         }
 
-        this->m_transform_update_needed = dal::MAX_FRAMES_IN_FLIGHT;
+        return output;
     }
 
-    void ActorVK::destroy(DescAllocator& desc_allocator, const VkDevice logi_device) {
-        for (auto& d : this->m_desc)
-            desc_allocator.free(std::move(d));
-        this->m_desc.clear();
+}
+
+
+// ActorVK
+namespace dal {
+
+    void ActorVK::init() {
+        this->m_ubuf_offsets.fill(0);
+        this->m_ready = true;
+    }
 
-        this->m_ubuf_per_actor.destroy(logi_device);
+    void ActorVK::destroy() {
+        this->m_ready = false;
     }
 
     bool ActorVK::is_ready() const {
-        for (auto& d : this->m_desc) {
-            if (!d.is_ready()) {
-                return false;
-            }
-        }
-
-        return this->m_ubuf_per_actor.is_ready();
+        return this->m_ready;
     }
 
-    void ActorVK::apply_transform(const FrameInFlightIndex& index, const dal::Transform& transform, const VkDevice logi_device) {
+    void ActorVK::apply_transform(const FrameInFlightIndex& index, const dal::Transform& transform, UniformRingBuffer& ubuf_ring) {
         if (!this->is_ready())
             return;
 
         U_PerActor ubuf_data_per_actor;
         ubuf_data_per_actor.m_model = transform.make_mat4();
-        this->m_ubuf_per_actor.copy_to_buffer(index.get(), ubuf_data_per_actor, logi_device);
+        this->m_ubuf_offsets.at(index.get()) = ubuf_ring.push(index, ubuf_data_per_actor).value_or(0);
     }
 
 }
@@ -67,36 +85,20 @@ namespace dal {
         this->clear_dependencies();
     }
 
-    void ActorProxy::give_dependencies(
-        DescAllocator& desc_allocator,
-        const DescLayout_PerActor& desc_layout,
-        VkPhysicalDevice phys_device,
-        VkDevice logi_device
-    ) {
-        m_desc_allocator = &desc_allocator;
-        m_desc_layout = &desc_layout;
-        m_phys_device = phys_device;
-        m_logi_device = logi_device;
+    void ActorProxy::give_dependencies(UniformRingBuffer& ubuf_ring) {
+        m_ubuf_ring = &ubuf_ring;
     }
 
     void ActorProxy::clear_dependencies() {
-        m_desc_allocator = nullptr;
-        m_desc_layout = nullptr;
-        m_phys_device = VK_NULL_HANDLE;;
-        m_logi_device = VK_NULL_HANDLE;
+        m_ubuf_ring = nullptr;
     }
 
     bool ActorProxy::are_dependencies_ready() const {
-        return (
-            m_desc_allocator != nullptr &&
-            m_desc_layout != nullptr &&
-            m_phys_device != VK_NULL_HANDLE &&
-            m_logi_device != VK_NULL_HANDLE
-        );
+        return m_ubuf_ring != nullptr;
     }
 
     void ActorProxy::apply_transform(const FrameInFlightIndex& index) {
-        this->get().apply_transform(index, this->m_transform, this->m_logi_device);
+        this->get().apply_transform(index, this->m_transform, *this->m_ubuf_ring);
     }
 
     // Overridings
@@ -105,18 +107,12 @@ namespace dal {
         if (!this->are_dependencies_ready())
             return false;
 
-        this->m_actor.init(
-            *this->m_desc_allocator,
-            *this->m_desc_layout,
-            this->m_phys_device,
-            this->m_logi_device
-        );
-
+        this->m_actor.init();
         return true;
     }
 
     void ActorProxy::destroy() {
-        this->m_actor.destroy(*this->m_desc_allocator, this->m_logi_device);
+        this->m_actor.destroy();
     }
 
     bool ActorProxy::is_ready() const {
@@ -124,7 +120,7 @@ namespace dal {
     }
 
     void ActorProxy::notify_transform_change() {
-        this->m_actor.notify_transform_change();
+        // Transform of every actor in render list is uploaded to the uniform ring every frame
     }
 
 }
@@ -133,54 +129,31 @@ namespace dal {
 // ActorSkinnedVK
 namespace dal {
 
-    void ActorSkinnedVK::init(
-        DescAllocator& desc_allocator,
-        const dal::DescLayout_ActorAnimated& layout_per_actor,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
-    ) {
-        this->destroy(desc_allocator, logi_device);
-
-        this->m_ubuf_per_actor.init(dal::MAX_FRAMES_IN_FLIGHT, phys_device, logi_device);
-        this->m_ubuf_anim.init(dal::MAX_FRAMES_IN_FLIGHT, phys_device, logi_device);
-
-        for (int i = 0; i < dal::MAX_FRAMES_IN_FLIGHT; ++i) {
-            this->m_desc.push_back(desc_allocator.allocate(layout_per_actor, logi_device));
+    void ActorSkinnedVK::init() {
+        for (auto& x : this->m_ubuf_offsets)
+            x.fill(0);
 
-            this->m_desc.back().record_actor_animated(
-                this->m_ubuf_per_actor.at(i),
-                this->m_ubuf_anim.at(i),
-                logi_device
-            );
-        }
+        this->m_ready = true;
     }
 
-    void ActorSkinnedVK::destroy(DescAllocator& desc_allocator, const VkDevice logi_device) {
-        for (auto& d : this->m_desc)
-            desc_allocator.free(std::move(d));
-        this->m_desc.clear();
-
-        this->m_ubuf_per_actor.destroy(logi_device);
-        this->m_ubuf_anim.destroy(logi_device);
+    void ActorSkinnedVK::destroy() {
+        this->m_ready = false;
     }
 
     bool ActorSkinnedVK::is_ready() const {
-        return (
-            this->m_ubuf_per_actor.is_ready() &&
-            this->m_ubuf_anim.is_ready()
-        );
+        return this->m_ready;
     }
 
-    void ActorSkinnedVK::apply_transform(const FrameInFlightIndex& index, const dal::Transform& transform, const VkDevice logi_device) {
+    void ActorSkinnedVK::apply_transform(const FrameInFlightIndex& index, const dal::Transform& transform, UniformRingBuffer& ubuf_ring) {
         if (!this->is_ready())
             return;
 
         U_PerActor ubuf_data_per_actor;
         ubuf_data_per_actor.m_model = transform.make_mat4();
-        this->m_ubuf_per_actor.copy_to_buffer(index.get(), ubuf_data_per_actor, logi_device);
+        this->m_ubuf_offsets.at(index.get())[0] = ubuf_ring.push(index, ubuf_data_per_actor).value_or(0);
     }
 
-    void ActorSkinnedVK::apply_animation(const FrameInFlightIndex& index, const dal::AnimationState& anim_state, const VkDevice logi_device) {
+    void ActorSkinnedVK::apply_animation(const FrameInFlightIndex& index, const dal::AnimationState& anim_state, UniformRingBuffer& ubuf_ring) {
         if (!this->is_ready())
             return;
 
@@ -190,7 +163,7 @@ namespace dal {
         for (uint32_t i = 0; i < size; ++i)
             ubuf_data.m_transforms[i] = anim_state.transform_array()[i];
 
-        this->m_ubuf_anim.copy_to_buffer(index.get(), ubuf_data, logi_device);
+        this->m_ubuf_offsets.at(index.get())[1] = ubuf_ring.push(index, ubuf_data).value_or(0);
     }
 
 }
@@ -204,40 +177,24 @@ namespace dal {
         this->clear_dependencies();
     }
 
-    void ActorSkinnedProxy::give_dependencies(
-        DescAllocator& desc_allocator,
-        const DescLayout_ActorAnimated& desc_layout,
-        VkPhysicalDevice phys_device,
-        VkDevice logi_device
-    ) {
-        m_desc_allocator = &desc_allocator;
-        m_desc_layout = &desc_layout;
-        m_phys_device = phys_device;
-        m_logi_device = logi_device;
+    void ActorSkinnedProxy::give_dependencies(UniformRingBuffer& ubuf_ring) {
+        m_ubuf_ring = &ubuf_ring;
     }
 
     void ActorSkinnedProxy::clear_dependencies() {
-        m_desc_allocator = nullptr;
-        m_desc_layout = nullptr;
-        m_phys_device = VK_NULL_HANDLE;;
-        m_logi_device = VK_NULL_HANDLE;
+        m_ubuf_ring = nullptr;
     }
 
     bool ActorSkinnedProxy::are_dependencies_ready() const {
-        return (
-            m_desc_allocator != nullptr &&
-            m_desc_layout != nullptr &&
-            m_phys_device != VK_NULL_HANDLE &&
-            m_logi_device != VK_NULL_HANDLE
-        );
+        return m_ubuf_ring != nullptr;
     }
 
     void ActorSkinnedProxy::apply_transform(const FrameInFlightIndex& index) {
-        this->m_actor.apply_transform(index, this->m_transform, this->m_logi_device);
+        this->m_actor.apply_transform(index, this->m_transform, *this->m_ubuf_ring);
     }
 
     void ActorSkinnedProxy::apply_animation(const FrameInFlightIndex& index) {
-        this->m_actor.apply_animation(index, this->m_anim_state, this->m_logi_device);
+        this->m_actor.apply_animation(index, this->m_anim_state, *this->m_ubuf_ring);
     }
 
     // Overridings
@@ -246,18 +203,12 @@ namespace dal {
         if (!this->are_dependencies_ready())
             return false;
 
-        this->m_actor.init(
-            *this->m_desc_allocator,
-            *this->m_desc_layout,
-            this->m_phys_device,
-            this->m_logi_device
-        );
-
+        this->m_actor.init();
         return true;
     }
 
     void ActorSkinnedProxy::destroy() {
-        this->m_actor.destroy(*this->m_desc_allocator, this->m_logi_device);
+        this->m_actor.destroy();
     }
 
     bool ActorSkinnedProxy::is_ready() const {
@@ -265,7 +216,7 @@ namespace dal {
     }
 
     void ActorSkinnedProxy::notify_transform_change() {
-        this->m_actor.notify_transform_change();
+        // Transform of every actor in render list is uploaded to the uniform ring every frame
     }
 
 }
@@ -277,22 +228,17 @@ namespace dal {
     void MeshVK::init(
         const std::vector<VertexStatic>& vertices,
         const std::vector<uint32_t>& indices,
-        dal::CommandPool& cmd_pool,
-        const VkPhysicalDevice phys_device,
-        const dal::LogicalDevice& logi_device
+        dal::UploadManager& upload_man
     ) {
         this->m_vertices.init_static(
             vertices,
             indices,
-            cmd_pool,
-            logi_device.queue_graphics(),
-            phys_device,
-            logi_device.get()
+            upload_man
         );
     }
 
-    void MeshVK::destroy(const VkDevice logi_device) {
-        this->m_vertices.destroy(logi_device);
+    void MeshVK::destroy(dal::UploadManager& upload_man) {
+        this->m_vertices.destroy(upload_man);
     }
 
 }
@@ -302,24 +248,24 @@ namespace dal {
 namespace dal {
 
     void MeshProxy::give_dependencies(
-        dal::CommandPool& cmd_pool,
+        dal::UploadManager& upload_man,
         const VkPhysicalDevice phys_device,
         const dal::LogicalDevice& logi_device
     ) {
-        this->m_cmd_pool    = &cmd_pool;
+        this->m_upload_man  = &upload_man;
         this->m_phys_device = phys_device;
         this->m_logi_device = &logi_device;
     }
 
     void MeshProxy::clear_dependencies() {
-        this->m_cmd_pool    = nullptr;
+        this->m_upload_man  = nullptr;
         this->m_phys_device = VK_NULL_HANDLE;
         this->m_logi_device = nullptr;
     }
 
     bool MeshProxy::are_dependencies_ready() const {
         return (
-            this->m_cmd_pool    != nullptr        &&
+            this->m_upload_man  != nullptr        &&
             this->m_phys_device != VK_NULL_HANDLE &&
             this->m_logi_device != nullptr
         );
@@ -331,16 +277,20 @@ namespace dal {
         if (!this->are_dependencies_ready())
             return false;
 
-        this->m_mesh.init(vertices, indices, *this->m_cmd_pool, this->m_phys_device, *this->m_logi_device);
+        this->m_mesh.init(vertices, indices, *this->m_upload_man);
         return true;
     }
 
     void MeshProxy::destroy() {
-        this->m_mesh.destroy(this->m_logi_device->get());
+        if (nullptr != this->m_upload_man)
+            this->m_mesh.destroy(*this->m_upload_man);
     }
 
     bool MeshProxy::is_ready() const {
-        return this->m_mesh.is_ready();
+        if (!this->m_mesh.is_ready())
+            return false;
+
+        return nullptr != this->m_upload_man && this->m_upload_man->is_done(this->m_mesh.upload_ticket());
     }
 
 }
@@ -351,25 +301,21 @@ namespace dal {
 
     void RenderUnit::init_static(
         const dal::RenderUnitStatic& unit_data,
-        dal::CommandPool& cmd_pool,
+        const MeshRange& mesh,
+        const VertexBuffer& vert_buffer,
         ITextureManager& tex_man,
         const char* const fallback_file_namespace,
-        const VkQueue graphics_queue,
         const VkPhysicalDevice phys_device,
         const VkDevice logi_device
     ) {
         auto& unit = *this;
 
         unit.m_weight_center = unit_data.m_weight_center;
-
-        unit.m_vert_buffer.init_static(
-            unit_data.m_vertices,
-            unit_data.m_indices,
-            cmd_pool,
-            graphics_queue,
-            phys_device,
-            logi_device
-        );
+        unit.m_aabb_min = unit_data.m_aabb_min;
+        unit.m_aabb_max = unit_data.m_aabb_max;
+        unit.m_uv_density = dal::calc_uv_density(unit_data);
+        unit.m_mesh = mesh;
+        unit.m_vert_buffer = &vert_buffer;
 
         unit.m_material.m_alpha_blend = unit_data.m_material.m_alpha_blending;
         unit.m_material.m_data.m_roughness = unit_data.m_material.m_roughness;
@@ -383,25 +329,21 @@ namespace dal {
 
     void RenderUnit::init_skinned(
         const dal::RenderUnitSkinned& unit_data,
-        dal::CommandPool& cmd_pool,
+        const MeshRange& mesh,
+        const VertexBuffer& vert_buffer,
         ITextureManager& tex_man,
         const char* const fallback_file_namespace,
-        const VkQueue graphics_queue,
         const VkPhysicalDevice phys_device,
         const VkDevice logi_device
     ) {
         auto& unit = *this;
 
         unit.m_weight_center = unit_data.m_weight_center;
-
-        unit.m_vert_buffer.init_skinned(
-            unit_data.m_vertices,
-            unit_data.m_indices,
-            cmd_pool,
-            graphics_queue,
-            phys_device,
-            logi_device
-        );
+        unit.m_aabb_min = unit_data.m_aabb_min;
+        unit.m_aabb_max = unit_data.m_aabb_max;
+        unit.m_uv_density = dal::calc_uv_density(unit_data);
+        unit.m_mesh = mesh;
+        unit.m_vert_buffer = &vert_buffer;
 
         unit.m_material.m_alpha_blend = unit_data.m_material.m_alpha_blending;
         unit.m_material.m_data.m_roughness = unit_data.m_material.m_roughness;
@@ -415,37 +357,73 @@ namespace dal {
 
     void RenderUnit::destroy(const VkDevice logi_device) {
         this->m_material.m_ubuf.destroy(logi_device);
-        this->m_vert_buffer.destroy(logi_device);
+        this->m_vert_buffer = nullptr;
+        this->m_mesh = MeshRange{};
+        this->m_lods.clear();
     }
 
     bool RenderUnit::prepare(
         DescPool& desc_pool,
         const SamplerTexture& sampler,
         const dal::DescLayout_PerMaterial& layout_per_material,
+        const dal::UploadManager& upload_man,
         const VkDevice logi_device
     ) {
         if (this->is_ready())
             return true;
+        if (!upload_man.is_done(this->m_vert_buffer->upload_ticket()))
+            return false;
         if (!this->m_material.m_albedo_map->is_ready())
             return false;
 
-        this->m_material.m_descset = desc_pool.allocate(layout_per_material, logi_device);
+        auto desc_sets = desc_pool.allocate(MAX_FRAMES_IN_FLIGHT, layout_per_material, logi_device);
+        auto& albedo_map = dal::handle_cast(this->m_material.m_albedo_map);
+
+        for (size_t i = 0; i < desc_sets.size(); ++i) {
+            desc_sets[i].record_material(
+                this->m_material.m_ubuf,
+                albedo_map.raw_view(),
+                sampler,
+                logi_device
+            );
+
+            this->m_material.m_descsets[i] = std::move(desc_sets[i]);
+            this->m_material.m_descset_generations[i] = albedo_map.generation();
+        }
+
+        return true;
+    }
 
+    void RenderUnit::update_descset(
+        const FrameInFlightIndex& index,
+        const SamplerTexture& sampler,
+        const VkDevice logi_device
+    ) {
+        auto& desc_set = this->m_material.m_descsets.at(index.get());
+        auto& generation = this->m_material.m_descset_generations.at(index.get());
         auto& albedo_map = dal::handle_cast(this->m_material.m_albedo_map);
 
-        this->m_material.m_descset.record_material(
+        if (!desc_set.is_ready() || albedo_map.generation() == generation)
+            return;
+        if (!albedo_map.is_ready())
+            return;
+
+        // GPU is done with the frame this one was last used in, so it can be recorded again
+        desc_set.record_material(
             this->m_material.m_ubuf,
             albedo_map.raw_view(),
             sampler,
             logi_device
         );
 
-        return true;
+        generation = albedo_map.generation();
     }
 
     bool RenderUnit::is_ready() const {
-        if (!this->m_material.m_descset.is_ready())
-            return false;
+        for (auto& x : this->m_material.m_descsets) {
+            if (!x.is_ready())
+                return false;
+        }
 
         return true;
     }
@@ -458,68 +436,95 @@ namespace dal {
 
     void ModelRenderer::init(
         const dal::ModelStatic& model_data,
-        dal::CommandPool& cmd_pool,
+        dal::UploadManager& upload_man,
         ITextureManager& tex_man,
         const char* const fallback_file_namespace,
         const dal::DescLayout_PerActor& layout_per_actor,
         const dal::DescLayout_PerMaterial& layout_per_material,
-        const VkQueue graphics_queue,
         const VkPhysicalDevice phys_device,
         const VkDevice logi_device
     ) {
         this->m_desc_pool.init(
-            1 * model_data.m_units.size() + 5,
-            1 * model_data.m_units.size() + 5,
+            MAX_FRAMES_IN_FLIGHT * model_data.m_units.size() + 5,
+            MAX_FRAMES_IN_FLIGHT * model_data.m_units.size() + 5,
             5,
-            1 * model_data.m_units.size() + 5,
+            MAX_FRAMES_IN_FLIGHT * model_data.m_units.size() + 5,
             logi_device
         );
 
+        std::vector<VertexStatic> vertices;
+        std::vector<index_data_t> indices;
+
         for (auto& unit_data : model_data.m_units) {
             auto& unit = unit_data.m_material.m_alpha_blending ? this->m_units_alpha.emplace_back() : this->m_units.emplace_back();
 
             unit.init_static(
                 unit_data,
-                cmd_pool,
+                ::append_mesh(vertices, indices, unit_data.m_vertices, unit_data.m_indices),
+                this->m_vert_buffer,
                 tex_man,
                 fallback_file_namespace,
-                graphics_queue,
                 phys_device,
                 logi_device
             );
+
+            unit.m_lods = ::append_lods(indices, unit_data.m_lods, unit.m_mesh);
         }
+
+        // All render units are drawn from one vertex buffer and one index buffer
+        if (!indices.empty())
+            this->m_vert_buffer.init_static(vertices, indices, upload_man);
     }
 
-    void ModelRenderer::destroy(const VkDevice logi_device) {
+    void ModelRenderer::destroy(dal::UploadManager& upload_man) {
         for (auto& x : this->m_units)
-            x.destroy(logi_device);
+            x.destroy(upload_man.logi_device());
         this->m_units.clear();
 
         for (auto& x : this->m_units_alpha)
-            x.destroy(logi_device);
+            x.destroy(upload_man.logi_device());
         this->m_units_alpha.clear();
 
-        this->m_desc_pool.destroy(logi_device);
+        this->m_vert_buffer.destroy(upload_man);
+
+        this->m_desc_pool.destroy(upload_man.logi_device());
     }
 
-    bool ModelRenderer::fetch_one_resource(const dal::DescLayout_PerMaterial& layout_per_material, const SamplerTexture& sampler, const VkDevice logi_device) {
+    bool ModelRenderer::fetch_one_resource(
+        const dal::DescLayout_PerMaterial& layout_per_material,
+        const SamplerTexture& sampler,
+        const dal::UploadManager& upload_man,
+        const VkDevice logi_device
+    ) {
         for (auto& unit : this->m_units) {
             if (unit.is_ready())
                 continue;
-            if (unit.prepare(this->m_desc_pool, sampler, layout_per_material, logi_device))
+            if (unit.prepare(this->m_desc_pool, sampler, layout_per_material, upload_man, logi_device))
                 return true;
         }
 
         for (auto& unit : this->m_units_alpha) {
             if (unit.is_ready())
                 continue;
-            if (unit.prepare(this->m_desc_pool, sampler, layout_per_material, logi_device))
+            if (unit.prepare(this->m_desc_pool, sampler, layout_per_material, upload_man, logi_device))
                 return true;
         }
 
         return false;
     }
 
+    void ModelRenderer::update_descsets(
+        const FrameInFlightIndex& index,
+        const SamplerTexture& sampler,
+        const VkDevice logi_device
+    ) {
+        for (auto& unit : this->m_units)
+            unit.update_descset(index, sampler, logi_device);
+
+        for (auto& unit : this->m_units_alpha)
+            unit.update_descset(index, sampler, logi_device);
+    }
+
     bool ModelRenderer::is_ready() const {
         if (this->m_units.empty() && this->m_units_alpha.empty())
             return false;
@@ -549,49 +554,50 @@ namespace dal {
     }
 
     void ModelProxy::give_dependencies(
-        CommandPool&                  cmd_pool,
+        UploadManager&                upload_man,
         ITextureManager&              tex_man,
         DescLayout_PerActor const&    layout_per_actor,
         DescLayout_PerMaterial const& layout_per_material,
         SamplerTexture const&         sampler,
-        VkQueue                       graphics_queue,
         VkPhysicalDevice              phys_device,
         VkDevice                      logi_device
     ) {
-        m_cmd_pool = &cmd_pool;
+        m_upload_man = &upload_man;
         m_tex_man = &tex_man;
         m_layout_per_actor = &layout_per_actor;
         m_layout_per_material = &layout_per_material;
         m_sampler = &sampler;
-        m_graphics_queue = graphics_queue;
         m_phys_device = phys_device;
         m_logi_device = logi_device;
     }
 
     void ModelProxy::clear_dependencies() {
-        m_cmd_pool = nullptr;
+        m_upload_man = nullptr;
         m_tex_man = nullptr;
         m_layout_per_actor = nullptr;
         m_layout_per_material = nullptr;
         m_sampler = nullptr;
-        m_graphics_queue = VK_NULL_HANDLE;
         m_phys_device = VK_NULL_HANDLE;
         m_logi_device = VK_NULL_HANDLE;
     }
 
     bool ModelProxy::are_dependencies_ready() const {
         return (
-            m_cmd_pool != nullptr &&
+            m_upload_man != nullptr &&
             m_tex_man != nullptr &&
             m_layout_per_actor != nullptr &&
             m_layout_per_material != nullptr &&
             m_sampler != nullptr &&
-            m_graphics_queue != VK_NULL_HANDLE &&
             m_phys_device != VK_NULL_HANDLE &&
             m_logi_device != VK_NULL_HANDLE
         );
     }
 
+    void ModelProxy::update_descsets(const FrameInFlightIndex& index) {
+        if (this->m_model.is_ready())
+            this->m_model.update_descsets(index, *this->m_sampler, this->m_logi_device);
+    }
+
     const char* ModelProxy::name() const {
         return this->m_name.c_str();
     }
@@ -604,12 +610,11 @@ namespace dal {
 
         this->m_model.init(
             model_data,
-            *this->m_cmd_pool,
+            *this->m_upload_man,
             *this->m_tex_man,
             fallback_namespace,
             *this->m_layout_per_actor,
             *this->m_layout_per_material,
-            this->m_graphics_queue,
             this->m_phys_device,
             this->m_logi_device
         );
@@ -621,12 +626,14 @@ namespace dal {
         return this->m_model.fetch_one_resource(
             *this->m_layout_per_material,
             *this->m_sampler,
+            *this->m_upload_man,
             this->m_logi_device
         );
     }
 
     void ModelProxy::destroy() {
-        this->m_model.destroy(this->m_logi_device);
+        if (nullptr != this->m_upload_man)
+            this->m_model.destroy(*this->m_upload_man);
     }
 
     bool ModelProxy::is_ready() const {
@@ -641,73 +648,100 @@ namespace dal {
 
     void ModelSkinnedRenderer::upload_meshes(
         const dal::ModelSkinned& model_data,
-        dal::CommandPool& cmd_pool,
+        dal::UploadManager& upload_man,
         ITextureManager& tex_man,
         const char* const fallback_file_namespace,
         const dal::DescLayout_PerActor& layout_per_actor,
         const dal::DescLayout_PerMaterial& layout_per_material,
-        const VkQueue graphics_queue,
         const VkPhysicalDevice phys_device,
         const VkDevice logi_device
     ) {
-        this->destroy(logi_device);
+        this->destroy(upload_man);
 
         this->m_desc_pool.init(
-            1 * model_data.m_units.size() + 5,
-            1 * model_data.m_units.size() + 5,
+            MAX_FRAMES_IN_FLIGHT * model_data.m_units.size() + 5,
+            MAX_FRAMES_IN_FLIGHT * model_data.m_units.size() + 5,
             5,
-            1 * model_data.m_units.size() + 5,
+            MAX_FRAMES_IN_FLIGHT * model_data.m_units.size() + 5,
             logi_device
         );
 
+        std::vector<VertexSkinned> vertices;
+        std::vector<index_data_t> indices;
+
         for (auto& unit_data : model_data.m_units) {
             auto& unit = unit_data.m_material.m_alpha_blending ? this->m_units_alpha.emplace_back() : this->m_units.emplace_back();
 
             unit.init_skinned(
                 unit_data,
-                cmd_pool,
+                ::append_mesh(vertices, indices, unit_data.m_vertices, unit_data.m_indices),
+                this->m_vert_buffer,
                 tex_man,
                 fallback_file_namespace,
-                graphics_queue,
                 phys_device,
                 logi_device
             );
+
+            unit.m_lods = ::append_lods(indices, unit_data.m_lods, unit.m_mesh);
         }
 
+        // All render units are drawn from one vertex buffer and one index buffer
+        if (!indices.empty())
+            this->m_vert_buffer.init_skinned(vertices, indices, upload_man);
+
         this->m_animations = model_data.m_animations;
         this->m_skeleton_interf = model_data.m_skeleton;
     }
 
-    void ModelSkinnedRenderer::destroy(const VkDevice logi_device) {
+    void ModelSkinnedRenderer::destroy(dal::UploadManager& upload_man) {
         for (auto& x : this->m_units)
-            x.destroy(logi_device);
+            x.destroy(upload_man.logi_device());
         this->m_units.clear();
 
         for (auto& x : this->m_units_alpha)
-            x.destroy(logi_device);
+            x.destroy(upload_man.logi_device());
         this->m_units_alpha.clear();
 
-        this->m_desc_pool.destroy(logi_device);
+        this->m_vert_buffer.destroy(upload_man);
+
+        this->m_desc_pool.destroy(upload_man.logi_device());
     }
 
-    bool ModelSkinnedRenderer::fetch_one_resource(const dal::DescLayout_PerMaterial& layout_per_material, const SamplerTexture& sampler, const VkDevice logi_device) {
+    bool ModelSkinnedRenderer::fetch_one_resource(
+        const dal::DescLayout_PerMaterial& layout_per_material,
+        const SamplerTexture& sampler,
+        const dal::UploadManager& upload_man,
+        const VkDevice logi_device
+    ) {
         for (auto& unit : this->m_units) {
             if (unit.is_ready())
                 continue;
-            if (unit.prepare(this->m_desc_pool, sampler, layout_per_material, logi_device))
+            if (unit.prepare(this->m_desc_pool, sampler, layout_per_material, upload_man, logi_device))
                 return true;
         }
 
         for (auto& unit : this->m_units_alpha) {
             if (unit.is_ready())
                 continue;
-            if (unit.prepare(this->m_desc_pool, sampler, layout_per_material, logi_device))
+            if (unit.prepare(this->m_desc_pool, sampler, layout_per_material, upload_man, logi_device))
                 return true;
         }
 
         return false;
     }
 
+    void ModelSkinnedRenderer::update_descsets(
+        const FrameInFlightIndex& index,
+        const SamplerTexture& sampler,
+        const VkDevice logi_device
+    ) {
+        for (auto& unit : this->m_units)
+            unit.update_descset(index, sampler, logi_device);
+
+        for (auto& unit : this->m_units_alpha)
+            unit.update_descset(index, sampler, logi_device);
+    }
+
     bool ModelSkinnedRenderer::is_ready() const {
         if (this->m_units.empty() && this->m_units_alpha.empty())
             return false;
@@ -741,44 +775,40 @@ namespace dal {
     }
 
     void ModelSkinnedProxy::give_dependencies(
-        CommandPool&                  cmd_pool,
+        UploadManager&                upload_man,
         ITextureManager&              tex_man,
         DescLayout_PerActor const&    layout_per_actor,
         DescLayout_PerMaterial const& layout_per_material,
         SamplerTexture const&         sampler,
-        VkQueue                       graphics_queue,
         VkPhysicalDevice              phys_device,
         VkDevice                      logi_device
     ) {
-        m_cmd_pool = &cmd_pool;
+        m_upload_man = &upload_man;
         m_tex_man = &tex_man;
         m_layout_per_actor = &layout_per_actor;
         m_layout_per_material = &layout_per_material;
         m_sampler = &sampler;
-        m_graphics_queue = graphics_queue;
         m_phys_device = phys_device;
         m_logi_device = logi_device;
     }
 
     void ModelSkinnedProxy::clear_dependencies() {
-        m_cmd_pool = nullptr;
+        m_upload_man = nullptr;
         m_tex_man = nullptr;
         m_layout_per_actor = nullptr;
         m_layout_per_material = nullptr;
         m_sampler = nullptr;
-        m_graphics_queue = VK_NULL_HANDLE;
         m_phys_device = VK_NULL_HANDLE;
         m_logi_device = VK_NULL_HANDLE;
     }
 
     bool ModelSkinnedProxy::are_dependencies_ready() const {
         return (
-            m_cmd_pool != nullptr &&
+            m_upload_man != nullptr &&
             m_tex_man != nullptr &&
             m_layout_per_actor != nullptr &&
             m_layout_per_material != nullptr &&
             m_sampler != nullptr &&
-            m_graphics_queue != VK_NULL_HANDLE &&
             m_phys_device != VK_NULL_HANDLE &&
             m_logi_device != VK_NULL_HANDLE
         );
@@ -786,6 +816,11 @@ namespace dal {
 
     // Overridings
 
+    void ModelSkinnedProxy::update_descsets(const FrameInFlightIndex& index) {
+        if (this->m_model.is_ready())
+            this->m_model.update_descsets(index, *this->m_sampler, this->m_logi_device);
+    }
+
     const char* ModelSkinnedProxy::name() const {
         return this->m_name.c_str();
     }
@@ -798,12 +833,11 @@ namespace dal {
 
         this->m_model.upload_meshes(
             model_data,
-            *this->m_cmd_pool,
+            *this->m_upload_man,
             *this->m_tex_man,
             fallback_namespace,
             *this->m_layout_per_actor,
             *this->m_layout_per_material,
-            this->m_graphics_queue,
             this->m_phys_device,
             this->m_logi_device
         );
@@ -815,12 +849,14 @@ namespace dal {
         return this->m_model.fetch_one_resource(
             *this->m_layout_per_material,
             *this->m_sampler,
+            *this->m_upload_man,
             this->m_logi_device
         );
     }
 
     void ModelSkinnedProxy::destroy() {
-        this->m_model.destroy(this->m_logi_device);
+        if (nullptr != this->m_upload_man)
+            this->m_model.destroy(*this->m_upload_man);
     }
 
 }
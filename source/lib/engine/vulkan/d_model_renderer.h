@@ -13,32 +13,21 @@ namespace dal {
     class ActorVK {
 
     private:
-        std::vector<DescSet> m_desc;
-        dal::UniformBufferArray<dal::U_PerActor> m_ubuf_per_actor;
+        std::array<uint32_t, MAX_FRAMES_IN_FLIGHT> m_ubuf_offsets{};
+        bool m_ready = false;
 
     public:
-        size_t m_transform_update_needed = 0;
+        void init();
 
-    public:
-        void init(
-            DescAllocator& desc_allocator,
-            const DescLayout_PerActor& layout_per_actor,
-            const VkPhysicalDevice phys_device,
-            const VkDevice logi_device
-        );
-
-        void destroy(DescAllocator& desc_allocator, const VkDevice logi_device);
+        void destroy();
 
         bool is_ready() const;
 
-        void notify_transform_change() {
-            this->m_transform_update_needed = MAX_FRAMES_IN_FLIGHT;
-        }
+        void apply_transform(const FrameInFlightIndex& index, const dal::Transform& transform, UniformRingBuffer& ubuf_ring);
 
-        void apply_transform(const FrameInFlightIndex& index, const dal::Transform& transform, const VkDevice logi_device);
-
-        auto& desc_set_at(const FrameInFlightIndex& index) const {
-            return this->m_desc.at(index.get()).get();
+        // Dynamic offset of U_PerActor in the uniform ring of the given frame
+        auto ubuf_offset_at(const FrameInFlightIndex& index) const {
+            return this->m_ubuf_offsets.at(index.get());
         }
 
     };
@@ -49,20 +38,12 @@ namespace dal {
     private:
         ActorVK m_actor;
 
-        DescAllocator*             m_desc_allocator = nullptr;
-        DescLayout_PerActor const* m_desc_layout    = nullptr;
-        VkPhysicalDevice           m_phys_device    = VK_NULL_HANDLE;
-        VkDevice                   m_logi_device    = VK_NULL_HANDLE;
+        UniformRingBuffer* m_ubuf_ring = nullptr;
 
     public:
         ~ActorProxy();
 
-        void give_dependencies(
-            DescAllocator& desc_allocator,
-            const DescLayout_PerActor& desc_layout,
-            VkPhysicalDevice phys_device,
-            VkDevice logi_device
-        );
+        void give_dependencies(UniformRingBuffer& ubuf_ring);
 
         void clear_dependencies();
 
@@ -78,8 +59,8 @@ namespace dal {
 
         void apply_transform(const FrameInFlightIndex& index);
 
-        auto& desc_set_at(const FrameInFlightIndex& index) const {
-            return this->get().desc_set_at(index);
+        auto ubuf_offset_at(const FrameInFlightIndex& index) const {
+            return this->get().ubuf_offset_at(index);
         }
 
         // Overridings
@@ -115,35 +96,24 @@ namespace dal {
     class ActorSkinnedVK {
 
     private:
-        std::vector<DescSet> m_desc;
-        dal::UniformBufferArray<dal::U_PerActor> m_ubuf_per_actor;
-        dal::UniformBufferArray<dal::U_AnimTransform> m_ubuf_anim;
+        // U_PerActor and U_AnimTransform
+        std::array<std::array<uint32_t, 2>, MAX_FRAMES_IN_FLIGHT> m_ubuf_offsets{};
+        bool m_ready = false;
 
     public:
-        size_t m_transform_update_needed = 0;
+        void init();
 
-    public:
-        void init(
-            DescAllocator& desc_allocator,
-            const DescLayout_ActorAnimated& layout_actor,
-            const VkPhysicalDevice phys_device,
-            const VkDevice logi_device
-        );
-
-        void destroy(DescAllocator& desc_allocator, const VkDevice logi_device);
+        void destroy();
 
         bool is_ready() const;
 
-        void notify_transform_change() {
-            this->m_transform_update_needed = MAX_FRAMES_IN_FLIGHT;
-        }
-
-        void apply_transform(const FrameInFlightIndex& index, const dal::Transform& transform, const VkDevice logi_device);
+        void apply_transform(const FrameInFlightIndex& index, const dal::Transform& transform, UniformRingBuffer& ubuf_ring);
 
-        void apply_animation(const FrameInFlightIndex& index, const dal::AnimationState& anim_state, const VkDevice logi_device);
+        void apply_animation(const FrameInFlightIndex& index, const dal::AnimationState& anim_state, UniformRingBuffer& ubuf_ring);
 
-        auto& desc_set_at(const FrameInFlightIndex& index) const {
-            return this->m_desc.at(index.get()).get();
+        // In binding order of DescLayout_ActorAnimated
+        auto& ubuf_offsets_at(const FrameInFlightIndex& index) const {
+            return this->m_ubuf_offsets.at(index.get());
         }
 
     };
@@ -154,20 +124,12 @@ namespace dal {
     private:
         ActorSkinnedVK m_actor;
 
-        DescAllocator*                  m_desc_allocator = nullptr;
-        DescLayout_ActorAnimated const* m_desc_layout    = nullptr;
-        VkPhysicalDevice                m_phys_device    = VK_NULL_HANDLE;
-        VkDevice                        m_logi_device    = VK_NULL_HANDLE;
+        UniformRingBuffer* m_ubuf_ring = nullptr;
 
     public:
         ~ActorSkinnedProxy();
 
-        void give_dependencies(
-            DescAllocator& desc_allocator,
-            const DescLayout_ActorAnimated& desc_layout,
-            VkPhysicalDevice phys_device,
-            VkDevice logi_device
-        );
+        void give_dependencies(UniformRingBuffer& ubuf_ring);
 
         void clear_dependencies();
 
@@ -181,8 +143,8 @@ namespace dal {
             return this->m_actor;
         }
 
-        auto& desc_set_at(const FrameInFlightIndex& index) const {
-            return this->get().desc_set_at(index);
+        auto& ubuf_offsets_at(const FrameInFlightIndex& index) const {
+            return this->get().ubuf_offsets_at(index);
         }
 
         void apply_transform(const FrameInFlightIndex& index);
@@ -228,17 +190,23 @@ namespace dal {
         void init(
             const std::vector<VertexStatic>& vertices,
             const std::vector<uint32_t>& indices,
-            dal::CommandPool& cmd_pool,
-            const VkPhysicalDevice phys_device,
-            const dal::LogicalDevice& logi_device
+            dal::UploadManager& upload_man
         );
 
-        void destroy(const VkDevice logi_device);
+        void destroy(dal::UploadManager& upload_man);
 
         bool is_ready() const {
             return this->m_vertices.is_ready();
         }
 
+        auto memory_size() const {
+            return this->m_vertices.memory_size();
+        }
+
+        auto& upload_ticket() const {
+            return this->m_vertices.upload_ticket();
+        }
+
         auto index_size() const {
             return this->m_vertices.index_size();
         }
@@ -259,13 +227,13 @@ namespace dal {
     private:
         MeshVK m_mesh;
 
-        dal::CommandPool*         m_cmd_pool    = nullptr;
+        dal::UploadManager*       m_upload_man  = nullptr;
         VkPhysicalDevice          m_phys_device = VK_NULL_HANDLE;
         dal::LogicalDevice const* m_logi_device = nullptr;
 
     public:
         void give_dependencies(
-            dal::CommandPool& cmd_pool,
+            dal::UploadManager& upload_man,
             const VkPhysicalDevice phys_device,
             const dal::LogicalDevice& logi_device
         );
@@ -290,6 +258,10 @@ namespace dal {
 
         bool is_ready() const override;
 
+        size_t resident_bytes() const override {
+            return this->m_mesh.memory_size();
+        }
+
     };
 
 
@@ -316,48 +288,94 @@ namespace dal {
         struct Material {
             U_PerMaterial m_data;
             UniformBuffer<U_PerMaterial> m_ubuf;
-            DescSet m_descset;
+            // One per frame in flight so that the one of current frame can be recorded again when albedo map is streamed
+            std::array<DescSet, MAX_FRAMES_IN_FLIGHT> m_descsets;
+            // Albedo map generation each descriptor set was recorded with
+            std::array<uint32_t, MAX_FRAMES_IN_FLIGHT> m_descset_generations{};
             std::shared_ptr<ITexture> m_albedo_map;
             bool m_alpha_blend = false;
+
+            auto& descset_at(const FrameInFlightIndex& index) const {
+                return this->m_descsets.at(index.get());
+            }
+        };
+
+    public:
+        struct Lod {
+            MeshRange m_mesh;
+            // Relative to bounding sphere radius
+            float m_error = 0;
         };
 
     public:
         Material m_material;
-        VertexBuffer m_vert_buffer;
+        MeshRange m_mesh;
+        // Coarser than m_mesh, from finer to coarser. They draw from the same vertices as m_mesh.
+        std::vector<Lod> m_lods;
+        // Owned by the model, shared by all of its render units
+        const VertexBuffer* m_vert_buffer = nullptr;
         glm::vec3 m_weight_center{ 0 };
+        // Bounding box in model space
+        glm::vec3 m_aabb_min{ 0 };
+        glm::vec3 m_aabb_max{ 0 };
+        // Texture coordinate units per model space unit
+        float m_uv_density = 0;
 
     public:
         void init_static(
             const dal::RenderUnitStatic& unit_data,
-            dal::CommandPool& cmd_pool,
+            const MeshRange& mesh,
+            const VertexBuffer& vert_buffer,
             ITextureManager& tex_man,
             const char* const fallback_file_namespace,
-            const VkQueue graphics_queue,
             const VkPhysicalDevice phys_device,
             const VkDevice logi_device
         );
 
         void init_skinned(
             const dal::RenderUnitSkinned& unit_data,
-            dal::CommandPool& cmd_pool,
+            const MeshRange& mesh,
+            const VertexBuffer& vert_buffer,
             ITextureManager& tex_man,
             const char* const fallback_file_namespace,
-            const VkQueue graphics_queue,
             const VkPhysicalDevice phys_device,
             const VkDevice logi_device
         );
 
         void destroy(const VkDevice logi_device);
 
+        // Returns false until vertices are uploaded and albedo map is ready
         bool prepare(
             DescPool& desc_pool,
             const SamplerTexture& sampler,
             const DescLayout_PerMaterial& layout_per_material,
+            const dal::UploadManager& upload_man,
+            const VkDevice logi_device
+        );
+
+        // Records descriptor set of the frame again if albedo map image has changed since
+        void update_descset(
+            const FrameInFlightIndex& index,
+            const SamplerTexture& sampler,
             const VkDevice logi_device
         );
 
         bool is_ready() const;
 
+        // Zero is m_mesh
+        uint32_t lod_count() const {
+            return static_cast<uint32_t>(this->m_lods.size()) + 1;
+        }
+
+        const MeshRange& mesh_at_lod(const uint32_t lod) const {
+            return 0 == lod ? this->m_mesh : this->m_lods.at(lod - 1).m_mesh;
+        }
+
+        // Geometric error of the level relative to bounding sphere radius
+        float error_at_lod(const uint32_t lod) const {
+            return 0 == lod ? 0.f : this->m_lods.at(lod - 1).m_error;
+        }
+
     };
 
 
@@ -366,6 +384,7 @@ namespace dal {
     private:
         std::vector<RenderUnit> m_units;
         std::vector<RenderUnit> m_units_alpha;
+        VertexBuffer m_vert_buffer;
         DescPool m_desc_pool;
 
     public:
@@ -373,19 +392,29 @@ namespace dal {
 
         void init(
             const dal::ModelStatic& model_data,
-            dal::CommandPool& cmd_pool,
+            dal::UploadManager& upload_man,
             ITextureManager& tex_man,
             const char* const fallback_file_namespace,
             const DescLayout_PerActor& layout_per_actor,
             const DescLayout_PerMaterial& layout_per_material,
-            const VkQueue graphics_queue,
             const VkPhysicalDevice phys_device,
             const VkDevice logi_device
         );
 
-        void destroy(const VkDevice logi_device);
+        void destroy(dal::UploadManager& upload_man);
 
-        bool fetch_one_resource(const DescLayout_PerMaterial& layout_per_material, const SamplerTexture& sampler, const VkDevice logi_device);
+        bool fetch_one_resource(
+            const DescLayout_PerMaterial& layout_per_material,
+            const SamplerTexture& sampler,
+            const dal::UploadManager& upload_man,
+            const VkDevice logi_device
+        );
+
+        void update_descsets(
+            const FrameInFlightIndex& index,
+            const SamplerTexture& sampler,
+            const VkDevice logi_device
+        );
 
         bool is_ready() const;
 
@@ -393,6 +422,10 @@ namespace dal {
             return this->m_units;
         }
 
+        auto& vertex_buffer() const {
+            return this->m_vert_buffer;
+        }
+
         auto& render_units_alpha() const {
             return this->m_units_alpha;
         }
@@ -406,12 +439,11 @@ namespace dal {
         ModelRenderer m_model;
         std::string m_name;
 
-        CommandPool*                  m_cmd_pool;
+        UploadManager*                m_upload_man;
         ITextureManager*              m_tex_man;
         DescLayout_PerActor const*    m_layout_per_actor;
         DescLayout_PerMaterial const* m_layout_per_material;
         SamplerTexture const*         m_sampler;
-        VkQueue                       m_graphics_queue;
         VkPhysicalDevice              m_phys_device;
         VkDevice                      m_logi_device;
 
@@ -423,12 +455,11 @@ namespace dal {
         ~ModelProxy();
 
         void give_dependencies(
-            CommandPool&                  cmd_pool,
+            UploadManager&                upload_man,
             ITextureManager&              tex_man,
             DescLayout_PerActor const&    layout_per_actor,
             DescLayout_PerMaterial const& layout_per_material,
             SamplerTexture const&         sampler,
-            VkQueue                       graphics_queue,
             VkPhysicalDevice              phys_device,
             VkDevice                      logi_device
         );
@@ -445,6 +476,9 @@ namespace dal {
             return this->m_model;
         }
 
+        // Call once a frame for models to be drawn, after fence of frame in flight is waited on
+        void update_descsets(const FrameInFlightIndex& index);
+
         // Overridings
 
         const char* name() const override;
@@ -457,6 +491,10 @@ namespace dal {
 
         bool is_ready() const override;
 
+        size_t resident_bytes() const override {
+            return this->m_model.vertex_buffer().memory_size();
+        }
+
     };
 
 
@@ -482,6 +520,7 @@ namespace dal {
     private:
         std::vector<RenderUnit> m_units;
         std::vector<RenderUnit> m_units_alpha;
+        VertexBuffer m_vert_buffer;
         std::vector<Animation> m_animations;
         SkeletonInterface m_skeleton_interf;
         DescPool m_desc_pool;
@@ -489,19 +528,29 @@ namespace dal {
     public:
         void upload_meshes(
             const dal::ModelSkinned& model_data,
-            dal::CommandPool& cmd_pool,
+            dal::UploadManager& upload_man,
             ITextureManager& tex_man,
             const char* const fallback_file_namespace,
             const DescLayout_PerActor& layout_per_actor,
             const DescLayout_PerMaterial& layout_per_material,
-            const VkQueue graphics_queue,
             const VkPhysicalDevice phys_device,
             const VkDevice logi_device
         );
 
-        void destroy(const VkDevice logi_device);
+        void destroy(dal::UploadManager& upload_man);
+
+        bool fetch_one_resource(
+            const DescLayout_PerMaterial& layout_per_material,
+            const SamplerTexture& sampler,
+            const dal::UploadManager& upload_man,
+            const VkDevice logi_device
+        );
 
-        bool fetch_one_resource(const DescLayout_PerMaterial& layout_per_material, const SamplerTexture& sampler, const VkDevice logi_device);
+        void update_descsets(
+            const FrameInFlightIndex& index,
+            const SamplerTexture& sampler,
+            const VkDevice logi_device
+        );
 
         bool is_ready() const;
 
@@ -521,6 +570,10 @@ namespace dal {
             return this->m_units;
         }
 
+        auto& vertex_buffer() const {
+            return this->m_vert_buffer;
+        }
+
         auto& render_units_alpha() const {
             return this->m_units_alpha;
         }
@@ -534,12 +587,11 @@ namespace dal {
         ModelSkinnedRenderer m_model;
         std::string m_name;
 
-        CommandPool*                  m_cmd_pool;
+        UploadManager*                m_upload_man;
         ITextureManager*              m_tex_man;
         DescLayout_PerActor const*    m_layout_per_actor;
         DescLayout_PerMaterial const* m_layout_per_material;
         SamplerTexture const*         m_sampler;
-        VkQueue                       m_graphics_queue;
         VkPhysicalDevice              m_phys_device;
         VkDevice                      m_logi_device;
 
@@ -549,12 +601,11 @@ namespace dal {
         ~ModelSkinnedProxy() override;
 
         void give_dependencies(
-            CommandPool&                  cmd_pool,
+            UploadManager&                upload_man,
             ITextureManager&              tex_man,
             DescLayout_PerActor const&    layout_per_actor,
             DescLayout_PerMaterial const& layout_per_material,
             SamplerTexture const&         sampler,
-            VkQueue                       graphics_queue,
             VkPhysicalDevice              phys_device,
             VkDevice                      logi_device
         );
@@ -571,6 +622,9 @@ namespace dal {
             return this->m_model;
         }
 
+        // Call once a frame for models to be drawn, after fence of frame in flight is waited on
+        void update_descsets(const FrameInFlightIndex& index);
+
         // Overridings
 
         const char* name() const override;
@@ -585,6 +639,10 @@ namespace dal {
             return this->m_model.is_ready();
         }
 
+        size_t resident_bytes() const override {
+            return this->m_model.vertex_buffer().memory_size();
+        }
+
         std::vector<Animation>& animations() override {
             return this->m_model.animations();
         }
@@ -1,26 +1,31 @@
 #include "d_shader.h"
 
+#include <map>
 #include <set>
 #include <list>
 #include <array>
+#include <mutex>
+#include <future>
+#include <cstddef>
+#include <cstring>
 
 #include <fmt/format.h>
 #include <shaderc/shaderc.hpp>
 
+#include "dal/util/hash.h"
 #include "dal/util/logger.h"
 #include "dal/util/filesystem.h"
-#include "dal/util/json_util.h"
+#include "dal/util/derived_data_cache.h"
 #include "d_uniform.h"
 #include "d_vert_data.h"
 
 
-#define DAL_HASH_SHADER_CACHE_NAME false
-
-
 // Shader module tools
 namespace {
 
-    const std::filesystem::path SHADER_CACHE_DIR = "_internal/spv";
+    const char* const SHADER_CACHE_CATEGORY = "spv";
+    // Bump it whenever compile options or cache blob layout change
+    constexpr uint32_t SHADER_CACHE_VERSION = 1;
 
 
     enum class ShaderKind {
@@ -28,88 +33,163 @@ namespace {
         frag,
     };
 
+    const char* get_shader_kind_str(const ShaderKind shader_kind) {
+        switch (shader_kind) {
+            case ::ShaderKind::vert:
+                return "vert";
+            case ::ShaderKind::frag:
+                return "frag";
+            default:
+                dalAbort("Unknown shader kind");
+                return "";
+        }
+    }
 
-    class ShaderSourceFileDB {
 
-    private:
-        const char* const KEY_FILE_SIZE = "file_size";
-        const char* const KEY_CONTENT_HASH = "file_content_hash";
+    struct SourceFileInfo {
+        size_t m_file_size = 0;
+        uint64_t m_content_hash = 0;
 
-        struct SourceFileInfo {
-            size_t m_file_size = 0;
-            size_t m_content_hash = 0;
-        };
+        static SourceFileInfo from_content(const std::string& content) {
+            SourceFileInfo output;
+            output.m_file_size = content.size();
+            output.m_content_hash = dal::hash_xx64(content);
+            return output;
+        }
 
-        std::unordered_map<std::string, SourceFileInfo> m_records;
+        bool operator==(const SourceFileInfo& other) const {
+            return this->m_file_size == other.m_file_size && this->m_content_hash == other.m_content_hash;
+        }
 
-    public:
-        SourceFileInfo& get_record(const std::string& src_file_path) {
-            auto iter = this->m_records.find(src_file_path);
-            if (this->m_records.end() != iter) {
-                return iter->second;
-            }
-            else {
-                return this->m_records.emplace(src_file_path, SourceFileInfo{}).first->second;
-            }
+        bool operator!=(const SourceFileInfo& other) const {
+            return !(*this == other);
         }
+    };
 
-        bool import_check_shader_cache_info_valid(const std::string& cache_dir_path, dal::Filesystem& filesys) {
-            const auto file_content = filesys.open(cache_dir_path + "/source_info.json")->read_stl<std::string>();
-            if (!file_content.has_value())
-                return false;
+    // Every source file one .spv was compiled from, including the root file and nested includes
+    using ShaderDependencies = std::map<std::string, ::SourceFileInfo>;
 
-            const auto json_data = dal::try_parse_json(*file_content);
-            if (!json_data.has_value()) {
-                dalWarn("Cache file corrupted");
-                return false;
-            }
 
-            bool result = true;
+    // Source files on disk are read once per session no matter how many outputs depend on them
+    class ShaderSourceFiles {
 
-            for (const auto& x : json_data->items()) {
-                const size_t file_size    = dal::get_json_number_or<size_t>(this->KEY_FILE_SIZE,    0, x.value());
-                const size_t content_hash = dal::get_json_number_or<size_t>(this->KEY_CONTENT_HASH, 0, x.value());
+    private:
+        dal::Filesystem& m_filesys;
+        std::unordered_map<std::string, std::optional<::SourceFileInfo>> m_current_files;
+        std::mutex m_mut;
 
-                if (this->is_file_info_correct(x.key(), file_size, content_hash, filesys)) {
-                    auto& record = this->get_record(x.key());
-                    record.m_file_size = file_size;
-                    record.m_content_hash = content_hash;
-                }
-                else {
-                    dalInfo(fmt::format("A shader file modification detected: {}", x.key()).c_str());
-                    result = false;
+    public:
+        ShaderSourceFiles(dal::Filesystem& filesys)
+            : m_filesys(filesys)
+        {
+
+        }
+
+        // True if every source file the output was compiled from is unchanged
+        bool are_up_to_date(const ::ShaderDependencies& deps, const std::string& output_name) {
+            for (auto& [src_path, info] : deps) {
+                const auto current = this->current_file_info(src_path);
+
+                if (!current.has_value() || *current != info) {
+                    dalInfo(fmt::format("A shader file modification detected: {} (used by {})", src_path, output_name).c_str());
+                    return false;
                 }
             }
 
-            return result;
+            return true;
+        }
+
+        void set_current(const ::ShaderDependencies& deps) {
+            std::unique_lock<std::mutex> lck{ this->m_mut };
+
+            for (auto& [src_path, info] : deps)
+                this->m_current_files[src_path] = info;
         }
 
-        std::string export_json() const {
-            nlohmann::json json_data;
-            for (auto& [path, info] : this->m_records) {
-                json_data[path][this->KEY_FILE_SIZE] = info.m_file_size;
-                json_data[path][this->KEY_CONTENT_HASH] = info.m_content_hash;
+    private:
+        std::optional<::SourceFileInfo> current_file_info(const std::string& src_path) {
+            {
+                std::unique_lock<std::mutex> lck{ this->m_mut };
+
+                const auto iter = this->m_current_files.find(src_path);
+                if (this->m_current_files.end() != iter)
+                    return iter->second;
             }
 
-            return json_data.dump(4);
+            // File is read without lock so other threads are not blocked on I/O
+            std::optional<::SourceFileInfo> output;
+            const auto content = this->m_filesys.open(src_path)->read_stl<std::string>();
+            if (content.has_value())
+                output = ::SourceFileInfo::from_content(*content);
+
+            std::unique_lock<std::mutex> lck{ this->m_mut };
+            this->m_current_files.emplace(src_path, output);
+            return output;
+        }
+
+    };
+
+
+    // Cached blob is dependency list followed by SPIR-V. Dependencies are needed because cache key covers only root source file.
+    std::vector<uint8_t> serialize_shader_cache(const ::ShaderDependencies& deps, const std::vector<uint8_t>& spirv) {
+        std::vector<uint8_t> output;
+
+        const auto append = [&output](const void* const data, const size_t size) {
+            const auto ptr = reinterpret_cast<const uint8_t*>(data);
+            output.insert(output.end(), ptr, ptr + size);
         };
 
-    private:
-        static bool is_file_info_correct(const std::string& path, const size_t file_size, const size_t content_hash, dal::Filesystem& filesys) {
-            auto file = filesys.open(path);
-            auto content = file->read_stl<std::string>();
+        const auto dep_count = static_cast<uint32_t>(deps.size());
+        append(&dep_count, sizeof(dep_count));
+
+        for (auto& [src_path, info] : deps) {
+            const auto path_size = static_cast<uint32_t>(src_path.size());
+            const auto file_size = static_cast<uint64_t>(info.m_file_size);
+            append(&path_size, sizeof(path_size));
+            append(src_path.data(), src_path.size());
+            append(&file_size, sizeof(file_size));
+            append(&info.m_content_hash, sizeof(info.m_content_hash));
+        }
+
+        append(spirv.data(), spirv.size());
+        return output;
+    }
 
-            if (!content.has_value())
+    bool parse_shader_cache(const uint8_t* const buf, const size_t buf_size, ::ShaderDependencies& out_deps, std::vector<uint8_t>& out_spirv) {
+        size_t pos = 0;
+
+        const auto read = [&](void* const dst, const size_t size) {
+            if (size > buf_size - pos)
                 return false;
-            if (file_size != file->size())
+
+            memcpy(dst, buf + pos, size);
+            pos += size;
+            return true;
+        };
+
+        uint32_t dep_count = 0;
+        if (!read(&dep_count, sizeof(dep_count)))
+            return false;
+
+        for (uint32_t i = 0; i < dep_count; ++i) {
+            uint32_t path_size = 0;
+            if (!read(&path_size, sizeof(path_size)))
                 return false;
-            if (content_hash != std::hash<std::string>{}(content.value()))
+
+            std::string src_path(path_size, '\0');
+            uint64_t file_size = 0;
+            uint64_t content_hash = 0;
+            if (!read(src_path.data(), src_path.size()) || !read(&file_size, sizeof(file_size)) || !read(&content_hash, sizeof(content_hash)))
                 return false;
 
-            return true;
+            auto& info = out_deps[src_path];
+            info.m_file_size = static_cast<size_t>(file_size);
+            info.m_content_hash = content_hash;
         }
 
-    };
+        out_spirv.assign(buf + pos, buf + buf_size);
+        return !out_spirv.empty();
+    }
 
 
     class ShaderCompileOption {
@@ -141,17 +221,18 @@ namespace {
         };
 
 
+        // One instance per compilation so includes are recorded as dependencies of that output only
         class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface {
 
         private:
             dal::Filesystem& m_filesys;
-            ::ShaderSourceFileDB& m_src_db;
+            ::ShaderDependencies& m_deps;
             std::list<ResultData> m_list_result;
 
         public:
-            ShaderIncluder(dal::Filesystem& filesys, ::ShaderSourceFileDB& src_db)
+            ShaderIncluder(dal::Filesystem& filesys, ::ShaderDependencies& deps)
                 : m_filesys(filesys)
-                , m_src_db(src_db)
+                , m_deps(deps)
             {
 
             }
@@ -176,9 +257,7 @@ namespace {
                         output.m_content = fmt::format("Failed to read shader file: {}", output.m_source_name);
                     }
                     else {
-                        auto& file_info = this->m_src_db.get_record(output.m_source_name);
-                        file_info.m_file_size = file->size();
-                        file_info.m_content_hash = std::hash<std::string>{}(output.m_content);
+                        this->m_deps[output.m_source_name] = ::SourceFileInfo::from_content(output.m_content);
                     }
                 }
 
@@ -193,28 +272,31 @@ namespace {
 
 
     private:
-        shaderc::CompileOptions m_options;
         std::set<std::string> m_macro_def;
 
-        size_t m_hash;
+        uint64_t m_hash;
 
     public:
-        ShaderCompileOption(dal::Filesystem& filesys, ::ShaderSourceFileDB& src_db) {
-            this->m_options.SetIncluder(std::make_unique<ShaderIncluder>(filesys, src_db));
-            this->m_options.SetOptimizationLevel(shaderc_optimization_level_performance);
-
+        ShaderCompileOption() {
             this->update_hash();
         }
 
         void add_macro_def(const std::string& def) {
             this->m_macro_def.insert(def);
-            this->m_options.AddMacroDefinition(def);
-
             this->update_hash();
         }
 
-        auto& get() const {
-            return this->m_options;
+        // Returned options write every included file into deps while compiling
+        shaderc::CompileOptions make_options(dal::Filesystem& filesys, ::ShaderDependencies& deps) const {
+            shaderc::CompileOptions output;
+
+            output.SetIncluder(std::make_unique<ShaderIncluder>(filesys, deps));
+            output.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+            for (auto& x : this->m_macro_def)
+                output.AddMacroDefinition(x);
+
+            return output;
         }
 
         auto& hash_value() const {
@@ -230,7 +312,7 @@ namespace {
                 accum += ' ';
             }
 
-            this->m_hash = std::hash<std::string>{}(accum);
+            this->m_hash = dal::hash_xx64(accum);
         }
 
     };
@@ -248,7 +330,7 @@ namespace {
             const size_t src_size,
             const ::ShaderKind shader_kind,
             const char* const src_path,
-            const ::ShaderCompileOption& options,
+            const shaderc::CompileOptions& options,
             std::vector<T>& output
         ) const {
             static_assert(sizeof(T) == 4 || sizeof(T) == 2 || sizeof(T) == 1);
@@ -259,7 +341,7 @@ namespace {
                 src_size,
                 this->convert_shader_kind(shader_kind),
                 src_path,
-                options.get()
+                options
             );
 
             if (shaderc_compilation_status_success != result_data.GetCompilationStatus()) {
@@ -376,121 +458,109 @@ namespace {
     private:
         dal::Filesystem& m_filesys;
         ::ShaderCompiler m_compiler;
-        ::ShaderSourceFileDB m_src_db;
+        ::ShaderSourceFiles m_src_files;
         ::ShaderCompileOption m_options;
 
-        bool m_need_recompile = false;
+        // Same stage is used by multiple pipelines which are built in parallel
+        std::unordered_map<std::string, std::shared_future<std::vector<uint8_t>>> m_loaded;
+        std::mutex m_mut;
 
     public:
         ShaderSrcManager(const std::vector<std::string>& macro_definitions, dal::Filesystem& filesys)
             : m_filesys(filesys)
-            , m_options(filesys, this->m_src_db)
+            , m_src_files(filesys)
         {
             for (auto& x : macro_definitions)
                 this->m_options.add_macro_def(x);
-
-            this->m_need_recompile = !this->m_src_db.import_check_shader_cache_info_valid(this->make_shader_cache_dir_path(), this->m_filesys);
-        }
-
-        ~ShaderSrcManager() {
-            const auto output_str = this->m_src_db.export_json();
-            auto file = this->m_filesys.open_write(this->make_shader_cache_dir_path() + "/source_info.json");
-            file->write(output_str.data(), output_str.size());
         }
 
+        // Thread safe. Each stage is compiled only once even if requested by multiple threads at once.
         std::vector<uint8_t> load(const dal::ResPath& path, const ::ShaderKind shader_kind) {
-            std::vector<uint8_t> output;
-            const auto cache_path = this->make_shader_cache_file_path(path, shader_kind);
+            const auto output_name = fmt::format("{}:{}", path.make_str(), ::get_shader_kind_str(shader_kind));
 
-            if (!this->need_to_compile(cache_path)) {
-                auto file = this->m_filesys.open(cache_path);
-                const auto read_result = file->read_stl(output);
-                dalAssert(read_result);
-            }
-            else {
-                auto& file_info = this->m_src_db.get_record(path.make_str());
-                std::tie(file_info.m_file_size, file_info.m_content_hash) = this->load_compile_shader(path, shader_kind, output);
+            std::promise<std::vector<uint8_t>> promise;
+            std::shared_future<std::vector<uint8_t>> future;
+            bool is_owner = false;
+            {
+                std::unique_lock<std::mutex> lck{ this->m_mut };
 
-                auto file = this->m_filesys.open_write(cache_path);
-                if (file->is_ready()) {
-                    file->write(output.data(), output.size());
+                auto iter = this->m_loaded.find(output_name);
+                if (this->m_loaded.end() != iter) {
+                    future = iter->second;
+                }
+                else {
+                    future = promise.get_future().share();
+                    this->m_loaded.emplace(output_name, future);
+                    is_owner = true;
                 }
             }
 
-            return output;
+            if (is_owner)
+                promise.set_value(this->load_or_compile(path, shader_kind, output_name));
+
+            return future.get();
         }
 
     private:
-        std::pair<size_t, size_t> load_compile_shader(const dal::ResPath& path, const ::ShaderKind shader_kind, std::vector<uint8_t>& output) const {
-            std::pair<size_t, size_t> result;
+        std::vector<uint8_t> load_or_compile(const dal::ResPath& path, const ::ShaderKind shader_kind, const std::string& output_name) {
             const auto path_str = path.make_str();
 
             auto file = this->m_filesys.open(path);
             if (!file->is_ready())
                 dalAbort(fmt::format("Failed to open shader file: {}", path_str).c_str());
 
-            const auto data = file->read_stl<std::string>();
-            if (!data.has_value())
+            const auto source = file->read_stl<std::string>();
+            if (!source.has_value())
                 dalAbort(fmt::format("Failed to read shader file: {}", path_str).c_str());
 
+            const auto cache_key = this->make_cache_key(*source, output_name);
+            std::vector<uint8_t> output;
+
+            const auto cache_file = this->m_filesys.derived_data().get(::SHADER_CACHE_CATEGORY, cache_key);
+            if (cache_file->is_ready()) {
+                ::ShaderDependencies deps;
+                if (::parse_shader_cache(cache_file->data(), cache_file->size(), deps, output) && this->m_src_files.are_up_to_date(deps, output_name))
+                    return output;
+
+                output.clear();
+            }
+
+            const auto deps = this->compile_shader(path_str, *source, shader_kind, output);
+            this->m_src_files.set_current(deps);
+            this->m_filesys.derived_data().put(::SHADER_CACHE_CATEGORY, cache_key, ::serialize_shader_cache(deps, output));
+
+            return output;
+        }
+
+        ::ShaderDependencies compile_shader(const std::string& path_str, const std::string& source, const ::ShaderKind shader_kind, std::vector<uint8_t>& output) const {
+            ::ShaderDependencies deps;
+
+            const auto options = this->m_options.make_options(this->m_filesys, deps);
             const auto [compile_result, compile_err_msg] = this->m_compiler.compile(
-                data->data(),
-                data->size(),
+                source.data(),
+                source.size(),
                 shader_kind,
                 path_str.c_str(),
-                this->m_options,
+                options,
                 output
             );
 
             if (!compile_result)
                 dalAbort(fmt::format("Failed to compile shader: {}\n{}", path_str, compile_err_msg).c_str());
 
-            result.first = file->size();
-            result.second = std::hash<std::string>{}(*data);
+            deps[path_str] = ::SourceFileInfo::from_content(source);
 
             dalInfo(fmt::format("Shader compiled: {}", path_str).c_str());
-            return result;
-        }
-
-        std::string make_shader_cache_dir_path() const {
-            return fmt::format("{}/{}", ::SHADER_CACHE_DIR.u8string(), this->m_options.hash_value());
-        }
-
-        std::string make_shader_cache_file_path(const dal::ResPath& path, const ::ShaderKind shader_kind) const {
-            std::string accum;
-
-            for (auto& x : path.dir_list()) {
-                accum += x;
-                accum += '-';
-            }
-
-            switch (shader_kind) {
-                case ::ShaderKind::vert:
-                    accum += "vert";
-                    break;
-                case ::ShaderKind::frag:
-                    accum += "frag";
-                    break;
-                default:
-                    dalAbort("Unknown shader kind");
-            }
-
-#if DAL_HASH_SHADER_CACHE_NAME
-            const auto hashed = std::hash<std::string>{}(accum);
-#else
-            const auto& hashed = accum;
-#endif
-            return fmt::format("{}/{}.spv", this->make_shader_cache_dir_path(), hashed);
+            return deps;
         }
 
-        bool need_to_compile(const std::string& cache_path) const {
-            if (this->m_need_recompile)
-                return true;
-
-            if (!this->m_filesys.is_file(cache_path))
-                return true;
-
-            return false;
+        // Includes are resolved relative to source path, so path is part of options along with macros
+        dal::DerivedDataKey make_cache_key(const std::string& source, const std::string& output_name) const {
+            dal::DerivedDataKey output;
+            output.m_content_hash = dal::hash_xx64(source);
+            output.m_version = ::SHADER_CACHE_VERSION;
+            output.m_options_hash = dal::hash_xx64(output_name, this->m_options.hash_value());
+            return output;
         }
 
     };
@@ -535,6 +605,154 @@ namespace dal {
 }
 
 
+// PipelineCache
+namespace {
+
+    const char* const PIPELINE_CACHE_PATH = "_internal/vk_pipeline_cache.bin";
+    constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x48435044;  // "DPCH"
+    constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+
+    // Written in front of the driver blob. Drivers are supposed to reject foreign data themselves
+    // but some mobile drivers crash instead, so mismatching data never reaches them.
+    struct PipelineCacheHeader {
+        uint32_t m_magic = 0;
+        uint32_t m_version = 0;
+        uint32_t m_vendor_id = 0;
+        uint32_t m_device_id = 0;
+        uint32_t m_driver_version = 0;
+        uint8_t m_cache_uuid[VK_UUID_SIZE]{};
+        uint64_t m_data_size = 0;
+    };
+
+
+    PipelineCacheHeader make_pipeline_cache_header(const VkPhysicalDevice phys_device, const size_t data_size) {
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(phys_device, &properties);
+
+        PipelineCacheHeader output;
+        output.m_magic = ::PIPELINE_CACHE_MAGIC;
+        output.m_version = ::PIPELINE_CACHE_VERSION;
+        output.m_vendor_id = properties.vendorID;
+        output.m_device_id = properties.deviceID;
+        output.m_driver_version = properties.driverVersion;
+        std::memcpy(output.m_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        output.m_data_size = data_size;
+        return output;
+    }
+
+    // Returns empty vector if there is no file or it was made by other device or driver
+    std::vector<uint8_t> load_pipeline_cache_data(dal::Filesystem& filesys, const VkPhysicalDevice phys_device) {
+        if (!filesys.is_file(::PIPELINE_CACHE_PATH))
+            return {};
+
+        auto file = filesys.open(::PIPELINE_CACHE_PATH);
+        if (!file->is_ready())
+            return {};
+
+        const auto content = file->read_stl<std::vector<uint8_t>>();
+        if (!content.has_value() || content->size() < sizeof(::PipelineCacheHeader)) {
+            dalWarn("Pipeline cache file is corrupted");
+            return {};
+        }
+
+        ::PipelineCacheHeader header;
+        std::memcpy(&header, content->data(), sizeof(::PipelineCacheHeader));
+        const auto expected = ::make_pipeline_cache_header(phys_device, header.m_data_size);
+
+        const auto is_same_device = (
+            header.m_magic == expected.m_magic &&
+            header.m_version == expected.m_version &&
+            header.m_vendor_id == expected.m_vendor_id &&
+            header.m_device_id == expected.m_device_id &&
+            header.m_driver_version == expected.m_driver_version &&
+            0 == std::memcmp(header.m_cache_uuid, expected.m_cache_uuid, VK_UUID_SIZE)
+        );
+
+        if (!is_same_device) {
+            dalInfo("Pipeline cache was made by other device or driver, discarded");
+            return {};
+        }
+
+        if (content->size() - sizeof(::PipelineCacheHeader) != header.m_data_size) {
+            dalWarn("Pipeline cache file is truncated");
+            return {};
+        }
+
+        return std::vector<uint8_t>(content->begin() + sizeof(::PipelineCacheHeader), content->end());
+    }
+
+}
+namespace dal {
+
+    PipelineCache::~PipelineCache() {
+        dalAssert(VK_NULL_HANDLE == this->m_handle);
+    }
+
+    void PipelineCache::init(dal::Filesystem& filesys, const VkPhysicalDevice phys_device, const VkDevice logi_device) {
+        this->destroy(logi_device);
+
+        const auto data = ::load_pipeline_cache_data(filesys, phys_device);
+
+        VkPipelineCacheCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        create_info.initialDataSize = data.size();
+        create_info.pInitialData = data.empty() ? nullptr : data.data();
+
+        if (VK_SUCCESS != vkCreatePipelineCache(logi_device, &create_info, nullptr, &this->m_handle)) {
+            // Driver may still refuse the data even after header check
+            dalWarn("Failed to create pipeline cache with saved data, starting empty");
+            create_info.initialDataSize = 0;
+            create_info.pInitialData = nullptr;
+
+            if (VK_SUCCESS != vkCreatePipelineCache(logi_device, &create_info, nullptr, &this->m_handle))
+                dalAbort("Failed to create pipeline cache");
+        }
+        else {
+            this->m_loaded_size = data.size();
+        }
+
+        dalInfo(fmt::format("Pipeline cache loaded: {} bytes", this->m_loaded_size).c_str());
+    }
+
+    void PipelineCache::destroy(const VkDevice logi_device) {
+        if (VK_NULL_HANDLE != this->m_handle) {
+            vkDestroyPipelineCache(logi_device, this->m_handle, nullptr);
+            this->m_handle = VK_NULL_HANDLE;
+        }
+
+        this->m_loaded_size = 0;
+    }
+
+    bool PipelineCache::save(dal::Filesystem& filesys, const VkPhysicalDevice phys_device, const VkDevice logi_device) const {
+        if (VK_NULL_HANDLE == this->m_handle)
+            return false;
+
+        size_t data_size = 0;
+        if (VK_SUCCESS != vkGetPipelineCacheData(logi_device, this->m_handle, &data_size, nullptr))
+            return false;
+
+        std::vector<uint8_t> content(sizeof(::PipelineCacheHeader) + data_size);
+        if (VK_SUCCESS != vkGetPipelineCacheData(logi_device, this->m_handle, &data_size, content.data() + sizeof(::PipelineCacheHeader)))
+            return false;
+
+        // Size may shrink between two calls
+        content.resize(sizeof(::PipelineCacheHeader) + data_size);
+        const auto header = ::make_pipeline_cache_header(phys_device, data_size);
+        std::memcpy(content.data(), &header, sizeof(::PipelineCacheHeader));
+
+        auto file = filesys.open_write(::PIPELINE_CACHE_PATH);
+        if (!file->is_ready()) {
+            dalWarn("Failed to open pipeline cache file for writing");
+            return false;
+        }
+
+        return file->write(content.data(), content.size());
+    }
+
+}
+
+
 // Pipeline creating functions
 namespace {
 
@@ -772,10 +990,10 @@ namespace {
         const dal::RenderPass_Gbuf& renderpass,
         const uint32_t subpass_index,
         const bool need_gamma_correction,
-        const VkExtent2D& swapchain_extent,
         const dal::DescLayout_PerGlobal& desc_layout_simple,
         const dal::DescLayout_PerMaterial& desc_layout_per_material,
         const dal::DescLayout_PerActor& desc_layout_per_actor,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/gbuf.vert", ::ShaderKind::vert);
@@ -794,9 +1012,8 @@ namespace {
         // Input assembly
         const VkPipelineInputAssemblyStateCreateInfo input_assembly = ::create_info_input_assembly();
 
-        // Viewports and scissors
-        const auto [viewport, scissor] = ::create_info_viewport_scissor(swapchain_extent);
-        const auto viewport_state = ::create_info_viewport_state(&viewport, 1, &scissor, 1);
+        // Viewports and scissors are dynamic so resizing doesn't need pipelines rebuilt
+        const auto viewport_state = ::create_info_viewport_state(nullptr, 1, nullptr, 1);
 
         // Rasterizer
         const auto rasterizer = ::create_info_rasterizer(VK_CULL_MODE_BACK_BIT, false, 0, 0);
@@ -812,8 +1029,8 @@ namespace {
         const auto depth_stencil = ::create_info_depth_stencil(true);
 
         // Dynamic state
-        //constexpr std::array<VkDynamicState, 0> dynamic_states{};
-        //const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
+        const std::vector<VkDynamicState> dynamic_states{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
 
         // Pipeline layout
         const std::array<VkDescriptorSetLayout, 3> desc_layouts{ desc_layout_simple.get(), desc_layout_per_material.get(), desc_layout_per_actor.get() };
@@ -831,7 +1048,7 @@ namespace {
         pipeline_info.pMultisampleState = &multisampling;
         pipeline_info.pDepthStencilState = &depth_stencil;
         pipeline_info.pColorBlendState = &color_blending;
-        pipeline_info.pDynamicState = nullptr;
+        pipeline_info.pDynamicState = &dynamic_state_info;
         pipeline_info.layout = pipeline_layout;
         pipeline_info.renderPass = renderpass.get();
         pipeline_info.subpass = subpass_index;
@@ -839,7 +1056,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
             dalAbort("failed to create graphics pipeline!");
         }
 
@@ -851,10 +1068,10 @@ namespace {
         const dal::RenderPass_Gbuf& renderpass,
         const uint32_t subpass_index,
         const bool need_gamma_correction,
-        const VkExtent2D& swapchain_extent,
         const dal::DescLayout_PerGlobal& desc_layout_simple,
         const dal::DescLayout_PerMaterial& desc_layout_per_material,
         const dal::DescLayout_ActorAnimated& desc_layout_per_actor,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/gbuf_animated.vert", ::ShaderKind::vert);
@@ -873,9 +1090,8 @@ namespace {
         // Input assembly
         const VkPipelineInputAssemblyStateCreateInfo input_assembly = ::create_info_input_assembly();
 
-        // Viewports and scissors
-        const auto [viewport, scissor] = ::create_info_viewport_scissor(swapchain_extent);
-        const auto viewport_state = ::create_info_viewport_state(&viewport, 1, &scissor, 1);
+        // Viewports and scissors are dynamic so resizing doesn't need pipelines rebuilt
+        const auto viewport_state = ::create_info_viewport_state(nullptr, 1, nullptr, 1);
 
         // Rasterizer
         const auto rasterizer = ::create_info_rasterizer(VK_CULL_MODE_BACK_BIT, false, 0, 0);
@@ -891,8 +1107,8 @@ namespace {
         const auto depth_stencil = ::create_info_depth_stencil(true);
 
         // Dynamic state
-        //constexpr std::array<VkDynamicState, 0> dynamic_states{};
-        //const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
+        const std::vector<VkDynamicState> dynamic_states{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
 
         // Pipeline layout
         const std::vector<VkDescriptorSetLayout> desc_layouts{
@@ -914,7 +1130,7 @@ namespace {
         pipeline_info.pMultisampleState = &multisampling;
         pipeline_info.pDepthStencilState = &depth_stencil;
         pipeline_info.pColorBlendState = &color_blending;
-        pipeline_info.pDynamicState = nullptr;
+        pipeline_info.pDynamicState = &dynamic_state_info;
         pipeline_info.layout = pipeline_layout;
         pipeline_info.renderPass = renderpass.get();
         pipeline_info.subpass = subpass_index;
@@ -922,39 +1138,74 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
             dalAbort("failed to create graphics pipeline!");
         }
 
         return dal::ShaderPipeline{ graphics_pipeline, pipeline_layout, logi_device };
     }
 
+    // Matches constant_id of composition.frag
+    struct SpecConst_Composition {
+        VkBool32 m_volumetric_atmos = VK_TRUE;
+        VkBool32 m_atmos_dithering = VK_TRUE;
+    };
+
+    uint32_t make_composition_variant_key(const dal::ShaderConfig& config) {
+        uint32_t output = 0;
+
+        if (config.m_volumetric_atmos)
+            output |= 1 << 0;
+        if (config.m_atmos_dithering)
+            output |= 1 << 1;
+
+        return output;
+    }
+
     dal::ShaderPipeline make_pipeline_composition(
-        ::ShaderSrcManager& shader_mgr,
+        const std::vector<uint8_t>& vert_src,
+        const std::vector<uint8_t>& frag_src,
+        const dal::ShaderConfig& config,
         const dal::RenderPass_Gbuf& renderpass,
         const uint32_t subpass_index,
-        const bool need_gamma_correction,
-        const VkExtent2D& extent,
         const dal::DescLayout_Composition& desc_layout_composition,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
-        const auto vert_src = shader_mgr.load("_asset/glsl/composition.vert", ::ShaderKind::vert);
-        const auto frag_src = shader_mgr.load("_asset/glsl/composition.frag", ::ShaderKind::frag);
-
         // Shaders
         const ShaderModule vert_shader_module(logi_device, vert_src);
         const ShaderModule frag_shader_module(logi_device, frag_src);
         std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages = ::create_info_shader_stage(vert_shader_module, frag_shader_module);
 
+        // Specialization constants
+        ::SpecConst_Composition spec_data;
+        spec_data.m_volumetric_atmos = config.m_volumetric_atmos ? VK_TRUE : VK_FALSE;
+        spec_data.m_atmos_dithering = config.m_atmos_dithering ? VK_TRUE : VK_FALSE;
+
+        std::array<VkSpecializationMapEntry, 2> spec_entries{};
+        spec_entries[0].constantID = 0;
+        spec_entries[0].offset = offsetof(::SpecConst_Composition, m_volumetric_atmos);
+        spec_entries[0].size = sizeof(VkBool32);
+        spec_entries[1].constantID = 1;
+        spec_entries[1].offset = offsetof(::SpecConst_Composition, m_atmos_dithering);
+        spec_entries[1].size = sizeof(VkBool32);
+
+        VkSpecializationInfo spec_info{};
+        spec_info.mapEntryCount = spec_entries.size();
+        spec_info.pMapEntries = spec_entries.data();
+        spec_info.dataSize = sizeof(::SpecConst_Composition);
+        spec_info.pData = &spec_data;
+
+        shaderStages[1].pSpecializationInfo = &spec_info;
+
         // Vertex input state
         const auto vertex_input_state = ::create_vertex_input_state(nullptr, 0, nullptr, 0);
 
         // Input assembly
         const VkPipelineInputAssemblyStateCreateInfo input_assembly = ::create_info_input_assembly();
 
-        // Viewports and scissors
-        const auto [viewport, scissor] = ::create_info_viewport_scissor(extent);
-        const auto viewport_state = ::create_info_viewport_state(&viewport, 1, &scissor, 1);
+        // Viewports and scissors are dynamic so resizing doesn't need pipelines rebuilt
+        const auto viewport_state = ::create_info_viewport_state(nullptr, 1, nullptr, 1);
 
         // Rasterizer
         const auto rasterizer = ::create_info_rasterizer(VK_CULL_MODE_BACK_BIT, false, 0, 0);
@@ -970,8 +1221,8 @@ namespace {
         const auto depth_stencil = ::create_info_depth_stencil(true);
 
         // Dynamic state
-        //constexpr std::array<VkDynamicState, 0> dynamic_states{};
-        //const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
+        const std::vector<VkDynamicState> dynamic_states{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
 
         // Pipeline layout
         const std::vector<VkDescriptorSetLayout> desc_layouts{ desc_layout_composition.get() };
@@ -989,7 +1240,7 @@ namespace {
         pipeline_info.pMultisampleState = &multisampling;
         pipeline_info.pDepthStencilState = &depth_stencil;
         pipeline_info.pColorBlendState = &color_blending;
-        pipeline_info.pDynamicState = nullptr;
+        pipeline_info.pDynamicState = &dynamic_state_info;
         pipeline_info.layout = pipeline_layout;
         pipeline_info.renderPass = renderpass.get();
         pipeline_info.subpass = subpass_index;
@@ -997,7 +1248,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
             dalAbort("failed to create graphics pipeline!");
         }
 
@@ -1008,8 +1259,8 @@ namespace {
         ::ShaderSrcManager& shader_mgr,
         const dal::RenderPass_Final& renderpass,
         const bool need_gamma_correction,
-        const VkExtent2D& extent,
         const dal::DescLayout_Final& desc_layout_final,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/fill_screen.vert", ::ShaderKind::vert);
@@ -1026,9 +1277,8 @@ namespace {
         // Input assembly
         const VkPipelineInputAssemblyStateCreateInfo input_assembly = ::create_info_input_assembly();
 
-        // Viewports and scissors
-        const auto [viewport, scissor] = ::create_info_viewport_scissor(extent);
-        const auto viewport_state = ::create_info_viewport_state(&viewport, 1, &scissor, 1);
+        // Viewports and scissors are dynamic so resizing doesn't need pipelines rebuilt
+        const auto viewport_state = ::create_info_viewport_state(nullptr, 1, nullptr, 1);
 
         // Rasterizer
         const auto rasterizer = ::create_info_rasterizer(VK_CULL_MODE_NONE, false, 0, 0);
@@ -1043,6 +1293,10 @@ namespace {
         // Depth, stencil
         const auto depth_stencil = ::create_info_depth_stencil(true);
 
+        // Dynamic state
+        const std::vector<VkDynamicState> dynamic_states{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
+
         // Pipeline layout
         const std::vector<VkDescriptorSetLayout> desc_layouts{ desc_layout_final.get() };
         const auto pipeline_layout = ::create_pipeline_layout(desc_layouts.data(), desc_layouts.size(), nullptr, 0, logi_device);
@@ -1059,7 +1313,7 @@ namespace {
         pipeline_info.pMultisampleState = &multisampling;
         pipeline_info.pDepthStencilState = &depth_stencil;
         pipeline_info.pColorBlendState = &color_blending;
-        pipeline_info.pDynamicState = nullptr;
+        pipeline_info.pDynamicState = &dynamic_state_info;
         pipeline_info.layout = pipeline_layout;
         pipeline_info.renderPass = renderpass.get();
         pipeline_info.subpass = 0;
@@ -1067,7 +1321,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
             dalAbort("failed to create graphics pipeline!");
         }
 
@@ -1078,10 +1332,10 @@ namespace {
         ::ShaderSrcManager& shader_mgr,
         const dal::RenderPass_Alpha& renderpass,
         const bool need_gamma_correction,
-        const VkExtent2D& swapchain_extent,
         const dal::DescLayout_Alpha& desc_layout_alpha,
         const dal::DescLayout_PerMaterial& desc_layout_per_material,
         const dal::DescLayout_PerActor& desc_layout_per_actor,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/alpha.vert", ::ShaderKind::vert);
@@ -1100,9 +1354,8 @@ namespace {
         // Input assembly
         const VkPipelineInputAssemblyStateCreateInfo input_assembly = ::create_info_input_assembly();
 
-        // Viewports and scissors
-        const auto [viewport, scissor] = ::create_info_viewport_scissor(swapchain_extent);
-        const auto viewport_state = ::create_info_viewport_state(&viewport, 1, &scissor, 1);
+        // Viewports and scissors are dynamic so resizing doesn't need pipelines rebuilt
+        const auto viewport_state = ::create_info_viewport_state(nullptr, 1, nullptr, 1);
 
         // Rasterizer
         const auto rasterizer = ::create_info_rasterizer(VK_CULL_MODE_BACK_BIT, false, 0, 0);
@@ -1118,8 +1371,8 @@ namespace {
         const auto depth_stencil = ::create_info_depth_stencil(false);
 
         // Dynamic state
-        //constexpr std::array<VkDynamicState, 0> dynamic_states{};
-        //const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
+        const std::vector<VkDynamicState> dynamic_states{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
 
         // Pipeline layout
         const std::vector<VkDescriptorSetLayout> desc_layouts{
@@ -1141,7 +1394,7 @@ namespace {
         pipeline_info.pMultisampleState = &multisampling;
         pipeline_info.pDepthStencilState = &depth_stencil;
         pipeline_info.pColorBlendState = &color_blending;
-        pipeline_info.pDynamicState = nullptr;
+        pipeline_info.pDynamicState = &dynamic_state_info;
         pipeline_info.layout = pipeline_layout;
         pipeline_info.renderPass = renderpass.get();
         pipeline_info.subpass = 0;
@@ -1149,7 +1402,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
             dalAbort("failed to create graphics pipeline!");
         }
 
@@ -1160,10 +1413,10 @@ namespace {
         ::ShaderSrcManager& shader_mgr,
         const dal::RenderPass_Alpha& renderpass,
         const bool need_gamma_correction,
-        const VkExtent2D& swapchain_extent,
         const dal::DescLayout_Alpha& desc_layout_alpha,
         const dal::DescLayout_PerMaterial& desc_layout_per_material,
         const dal::DescLayout_ActorAnimated& desc_layout_per_actor,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/alpha_animated.vert", ::ShaderKind::vert);
@@ -1182,9 +1435,8 @@ namespace {
         // Input assembly
         const VkPipelineInputAssemblyStateCreateInfo input_assembly = ::create_info_input_assembly();
 
-        // Viewports and scissors
-        const auto [viewport, scissor] = ::create_info_viewport_scissor(swapchain_extent);
-        const auto viewport_state = ::create_info_viewport_state(&viewport, 1, &scissor, 1);
+        // Viewports and scissors are dynamic so resizing doesn't need pipelines rebuilt
+        const auto viewport_state = ::create_info_viewport_state(nullptr, 1, nullptr, 1);
 
         // Rasterizer
         const auto rasterizer = ::create_info_rasterizer(VK_CULL_MODE_BACK_BIT, false, 0, 0);
@@ -1200,8 +1452,8 @@ namespace {
         const auto depth_stencil = ::create_info_depth_stencil(false);
 
         // Dynamic state
-        //constexpr std::array<VkDynamicState, 0> dynamic_states{};
-        //const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
+        const std::vector<VkDynamicState> dynamic_states{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
 
         // Pipeline layout
         const std::vector<VkDescriptorSetLayout> desc_layouts{
@@ -1223,7 +1475,7 @@ namespace {
         pipeline_info.pMultisampleState = &multisampling;
         pipeline_info.pDepthStencilState = &depth_stencil;
         pipeline_info.pColorBlendState = &color_blending;
-        pipeline_info.pDynamicState = nullptr;
+        pipeline_info.pDynamicState = &dynamic_state_info;
         pipeline_info.layout = pipeline_layout;
         pipeline_info.renderPass = renderpass.get();
         pipeline_info.subpass = 0;
@@ -1231,7 +1483,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
             dalAbort("failed to create graphics pipeline!");
         }
 
@@ -1242,6 +1494,7 @@ namespace {
         ::ShaderSrcManager& shader_mgr,
         const dal::RenderPass_ShadowMap& renderpass,
         const bool does_support_depth_clamp,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/shadow.vert", ::ShaderKind::vert);
@@ -1306,7 +1559,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline))
+        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline))
             dalAbort("failed to create graphics pipeline!");
 
         return dal::ShaderPipeline{ graphics_pipeline, pipeline_layout, logi_device };
@@ -1317,6 +1570,7 @@ namespace {
         const dal::RenderPass_ShadowMap& renderpass,
         const bool does_support_depth_clamp,
         const dal::DescLayout_ActorAnimated& desc_layout_animation,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/shadow_animated.vert", ::ShaderKind::vert);
@@ -1381,7 +1635,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline))
+        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline))
             dalAbort("failed to create graphics pipeline!");
 
         return dal::ShaderPipeline{ graphics_pipeline, pipeline_layout, logi_device };
@@ -1392,6 +1646,7 @@ namespace {
         const dal::DescLayout_PerMaterial& desc_layout_material,
         const dal::DescLayout_PerActor& desc_layout_actor,
         const dal::RenderPass_Simple& renderpass,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/on_mirror.vert", ::ShaderKind::vert);
@@ -1459,7 +1714,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline))
+        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline))
             dalAbort("failed to create graphics pipeline!");
 
         return dal::ShaderPipeline{ graphics_pipeline, pipeline_layout, logi_device };
@@ -1470,6 +1725,7 @@ namespace {
         const dal::DescLayout_PerMaterial& desc_layout_material,
         const dal::DescLayout_ActorAnimated& desc_layout_actor,
         const dal::RenderPass_Simple& renderpass,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/on_mirror_animated.vert", ::ShaderKind::vert);
@@ -1537,7 +1793,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline))
+        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline))
             dalAbort("failed to create graphics pipeline!");
 
         return dal::ShaderPipeline{ graphics_pipeline, pipeline_layout, logi_device };
@@ -1547,8 +1803,8 @@ namespace {
         ::ShaderSrcManager& shader_mgr,
         const dal::RenderPass_Gbuf& renderpass,
         const uint32_t subpass_index,
-        const VkExtent2D& extent,
         const dal::DescLayout_Mirror& desc_layout_mirror,
+        const VkPipelineCache pipeline_cache,
         const VkDevice logi_device
     ) {
         const auto vert_src = shader_mgr.load("_asset/glsl/mirror.vert", ::ShaderKind::vert);
@@ -1567,9 +1823,8 @@ namespace {
         // Input assembly
         const VkPipelineInputAssemblyStateCreateInfo input_assembly = ::create_info_input_assembly();
 
-        // Viewports and scissors
-        const auto [viewport, scissor] = ::create_info_viewport_scissor(extent);
-        const auto viewport_state = ::create_info_viewport_state(&viewport, 1, &scissor, 1);
+        // Viewports and scissors are dynamic so resizing doesn't need pipelines rebuilt
+        const auto viewport_state = ::create_info_viewport_state(nullptr, 1, nullptr, 1);
 
         // Rasterizer
         const auto rasterizer = ::create_info_rasterizer(VK_CULL_MODE_BACK_BIT, false, 0, 0, true);
@@ -1585,7 +1840,7 @@ namespace {
         const auto depth_stencil = ::create_info_depth_stencil(true);
 
         // Dynamic state
-        const std::vector<VkDynamicState> dynamic_states;
+        const std::vector<VkDynamicState> dynamic_states{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
         const auto dynamic_state_info = ::create_info_dynamic_state(dynamic_states.data(), dynamic_states.size());
 
         // Pipeline layout
@@ -1613,7 +1868,7 @@ namespace {
         pipeline_info.basePipelineIndex = -1;
 
         VkPipeline graphics_pipeline;
-        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline))
+        if (VK_SUCCESS != vkCreateGraphicsPipelines(logi_device, pipeline_cache, 1, &pipeline_info, nullptr, &graphics_pipeline))
             dalAbort("failed to create graphics pipeline!");
 
         return dal::ShaderPipeline{ graphics_pipeline, pipeline_layout, logi_device };
@@ -1630,23 +1885,18 @@ namespace dal {
         const dal::ShaderConfig& config,
         const bool need_gamma_correction,
         const bool does_support_depth_clamp,
-        const VkExtent2D& swapchain_extent,
-        const VkExtent2D& gbuf_extent,
         const dal::DescSetLayoutManager& desc_layouts,
         const dal::RenderPassManager& render_passes,
-        const VkDevice logi_device
+        const VkPipelineCache pipeline_cache,
+        const VkDevice logi_device,
+        dal::TaskManager& task_man
     ) {
         this->destroy(logi_device);
 
-        const auto macros = [&config, need_gamma_correction]() {
+        // ShaderConfig toggles are specialization constants so they don't make another set of SPIR-V
+        const auto macros = [need_gamma_correction]() {
             std::vector<std::string> output;
 
-            if (config.m_volumetric_atmos)
-                output.push_back("DAL_VOLUMETRIC_ATMOS");
-
-            if (config.m_atmos_dithering)
-                output.push_back("DAL_ATMOS_DITHERING");
-
             if (need_gamma_correction)
                 output.push_back("DAL_GAMMA_CORRECT");
 
@@ -1654,113 +1904,137 @@ namespace dal {
         }();
 
         ::ShaderSrcManager shader_mgr{ macros, filesys };
+        std::vector<std::function<void()>> jobs;
+
+        jobs.push_back([&]() {
+            this->m_gbuf = ::make_pipeline_gbuf(
+                shader_mgr,
+                render_passes.rp_gbuf(), 0,
+                need_gamma_correction,
+                desc_layouts.layout_per_global(),
+                desc_layouts.layout_per_material(),
+                desc_layouts.layout_per_actor(),
+                pipeline_cache,
+                logi_device
+            );
+        });
+
+        jobs.push_back([&]() {
+            this->m_gbuf_animated = ::make_pipeline_gbuf_animated(
+                shader_mgr,
+                render_passes.rp_gbuf(), 0,
+                need_gamma_correction,
+                desc_layouts.layout_per_global(),
+                desc_layouts.layout_per_material(),
+                desc_layouts.layout_actor_animated(),
+                pipeline_cache,
+                logi_device
+            );
+        });
+
+        jobs.push_back([&]() {
+            this->m_composition_vert_src = shader_mgr.load("_asset/glsl/composition.vert", ::ShaderKind::vert);
+            this->m_composition_frag_src = shader_mgr.load("_asset/glsl/composition.frag", ::ShaderKind::frag);
+            this->apply_shader_config(config, desc_layouts, render_passes, pipeline_cache, logi_device);
+        });
+
+        jobs.push_back([&]() {
+            this->m_mirror = ::make_pipeline_mirror(
+                shader_mgr,
+                render_passes.rp_gbuf(), 2,
+                desc_layouts.layout_mirror(),
+                pipeline_cache,
+                logi_device
+            );
+        });
+
+        jobs.push_back([&]() {
+            this->m_final = ::make_pipeline_final(
+                shader_mgr,
+                render_passes.rp_final(),
+                need_gamma_correction,
+                desc_layouts.layout_final(),
+                pipeline_cache,
+                logi_device
+            );
+        });
+
+        jobs.push_back([&]() {
+            this->m_alpha = ::make_pipeline_alpha(
+                shader_mgr,
+                render_passes.rp_alpha(),
+                need_gamma_correction,
+                desc_layouts.layout_alpha(),
+                desc_layouts.layout_per_material(),
+                desc_layouts.layout_per_actor(),
+                pipeline_cache,
+                logi_device
+            );
+        });
+
+        jobs.push_back([&]() {
+            this->m_alpha_animated = ::make_pipeline_alpha_animated(
+                shader_mgr,
+                render_passes.rp_alpha(),
+                need_gamma_correction,
+                desc_layouts.layout_alpha(),
+                desc_layouts.layout_per_material(),
+                desc_layouts.layout_actor_animated(),
+                pipeline_cache,
+                logi_device
+            );
+        });
+
+        jobs.push_back([&]() {
+            this->m_shadow = ::make_pipeline_shadow(
+                shader_mgr,
+                render_passes.rp_shadow(),
+                does_support_depth_clamp,
+                pipeline_cache,
+                logi_device
+            );
+        });
+
+        jobs.push_back([&]() {
+            this->m_shadow_animated = ::make_pipeline_shadow_animated(
+                shader_mgr,
+                render_passes.rp_shadow(),
+                does_support_depth_clamp,
+                desc_layouts.layout_actor_animated(),
+                pipeline_cache,
+                logi_device
+            );
+        });
+
+        jobs.push_back([&]() {
+            this->m_on_mirror = ::make_pipeline_on_mirror(
+                shader_mgr,
+                desc_layouts.layout_per_material(),
+                desc_layouts.layout_per_actor(),
+                render_passes.rp_simple(),
+                pipeline_cache,
+                logi_device
+            );
+        });
+
+        jobs.push_back([&]() {
+            this->m_on_mirror_animated = ::make_pipeline_on_mirror_animated(
+                shader_mgr,
+                desc_layouts.layout_per_material(),
+                desc_layouts.layout_actor_animated(),
+                render_passes.rp_simple(),
+                pipeline_cache,
+                logi_device
+            );
+        });
 
-        this->m_gbuf = ::make_pipeline_gbuf(
-            shader_mgr,
-            render_passes.rp_gbuf(), 0,
-            need_gamma_correction,
-            gbuf_extent,
-            desc_layouts.layout_per_global(),
-            desc_layouts.layout_per_material(),
-            desc_layouts.layout_per_actor(),
-            logi_device
-        );
-
-        this->m_gbuf_animated = ::make_pipeline_gbuf_animated(
-            shader_mgr,
-            render_passes.rp_gbuf(), 0,
-            need_gamma_correction,
-            gbuf_extent,
-            desc_layouts.layout_per_global(),
-            desc_layouts.layout_per_material(),
-            desc_layouts.layout_actor_animated(),
-            logi_device
-        );
-
-        this->m_composition = ::make_pipeline_composition(
-            shader_mgr,
-            render_passes.rp_gbuf(), 1,
-            need_gamma_correction,
-            gbuf_extent,
-            desc_layouts.layout_composition(),
-            logi_device
-        );
-
-        this->m_mirror = ::make_pipeline_mirror(
-            shader_mgr,
-            render_passes.rp_gbuf(), 2,
-            gbuf_extent,
-            desc_layouts.layout_mirror(),
-            logi_device
-        );
-
-        this->m_final = ::make_pipeline_final(
-            shader_mgr,
-            render_passes.rp_final(),
-            need_gamma_correction,
-            swapchain_extent,
-            desc_layouts.layout_final(),
-            logi_device
-        );
-
-        this->m_alpha = ::make_pipeline_alpha(
-            shader_mgr,
-            render_passes.rp_alpha(),
-            need_gamma_correction,
-            gbuf_extent,
-            desc_layouts.layout_alpha(),
-            desc_layouts.layout_per_material(),
-            desc_layouts.layout_per_actor(),
-            logi_device
-        );
-
-        this->m_alpha_animated = ::make_pipeline_alpha_animated(
-            shader_mgr,
-            render_passes.rp_alpha(),
-            need_gamma_correction,
-            gbuf_extent,
-            desc_layouts.layout_alpha(),
-            desc_layouts.layout_per_material(),
-            desc_layouts.layout_actor_animated(),
-            logi_device
-        );
-
-        this->m_shadow = ::make_pipeline_shadow(
-            shader_mgr,
-            render_passes.rp_shadow(),
-            does_support_depth_clamp,
-            logi_device
-        );
-
-        this->m_shadow_animated = ::make_pipeline_shadow_animated(
-            shader_mgr,
-            render_passes.rp_shadow(),
-            does_support_depth_clamp,
-            desc_layouts.layout_actor_animated(),
-            logi_device
-        );
-
-        this->m_on_mirror = ::make_pipeline_on_mirror(
-            shader_mgr,
-            desc_layouts.layout_per_material(),
-            desc_layouts.layout_per_actor(),
-            render_passes.rp_simple(),
-            logi_device
-        );
-
-        this->m_on_mirror_animated = ::make_pipeline_on_mirror_animated(
-            shader_mgr,
-            desc_layouts.layout_per_material(),
-            desc_layouts.layout_actor_animated(),
-            render_passes.rp_simple(),
-            logi_device
-        );
+        // Shader stages are compiled as each pipeline requests them, so compilation runs in parallel too
+        task_man.run_parallel(jobs);
     }
 
     void PipelineManager::destroy(const VkDevice logi_device) {
         this->m_gbuf.destroy(logi_device);
         this->m_gbuf_animated.destroy(logi_device);
-        this->m_composition.destroy(logi_device);
         this->m_final.destroy(logi_device);
         this->m_alpha.destroy(logi_device);
         this->m_alpha_animated.destroy(logi_device);
@@ -1769,6 +2043,40 @@ namespace dal {
         this->m_on_mirror.destroy(logi_device);
         this->m_on_mirror_animated.destroy(logi_device);
         this->m_mirror.destroy(logi_device);
+
+        for (auto& [key, pipeline] : this->m_composition_variants)
+            pipeline.destroy(logi_device);
+        this->m_composition_variants.clear();
+        this->m_composition = nullptr;
+    }
+
+    void PipelineManager::apply_shader_config(
+        const dal::ShaderConfig& config,
+        const dal::DescSetLayoutManager& desc_layouts,
+        const dal::RenderPassManager& render_passes,
+        const VkPipelineCache pipeline_cache,
+        const VkDevice logi_device
+    ) {
+        const auto key = ::make_composition_variant_key(config);
+
+        auto iter = this->m_composition_variants.find(key);
+        if (this->m_composition_variants.end() == iter) {
+            dalAssert(!this->m_composition_vert_src.empty() && !this->m_composition_frag_src.empty());
+
+            auto pipeline = ::make_pipeline_composition(
+                this->m_composition_vert_src,
+                this->m_composition_frag_src,
+                config,
+                render_passes.rp_gbuf(), 1,
+                desc_layouts.layout_composition(),
+                pipeline_cache,
+                logi_device
+            );
+
+            iter = this->m_composition_variants.emplace(key, std::move(pipeline)).first;
+        }
+
+        this->m_composition = &iter->second;
     }
 
 }
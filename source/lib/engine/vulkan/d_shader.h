@@ -1,8 +1,11 @@
 #pragma once
 
+#include <vector>
 #include <utility>
+#include <unordered_map>
 
 #include "dal/util/filesystem.h"
+#include "dal/util/task_thread.h"
 #include "d_vk_device.h"
 #include "d_uniform.h"
 #include "d_render_pass.h"
@@ -49,12 +52,43 @@ namespace dal {
     };
 
 
+    // Driver pipeline cache which survives app restarts through _internal storage
+    class PipelineCache {
+
+    private:
+        VkPipelineCache m_handle = VK_NULL_HANDLE;
+        size_t m_loaded_size = 0;
+
+    public:
+        PipelineCache() = default;
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+    public:
+        ~PipelineCache();
+
+        void init(dal::Filesystem& filesys, const VkPhysicalDevice phys_device, const VkDevice logi_device);
+
+        void destroy(const VkDevice logi_device);
+
+        bool save(dal::Filesystem& filesys, const VkPhysicalDevice phys_device, const VkDevice logi_device) const;
+
+        VkPipelineCache get() const {
+            return this->m_handle;
+        }
+
+        auto loaded_size() const {
+            return this->m_loaded_size;
+        }
+
+    };
+
+
     class PipelineManager {
 
     private:
         ShaderPipeline m_gbuf;
         ShaderPipeline m_gbuf_animated;
-        ShaderPipeline m_composition;
         ShaderPipeline m_final;
         ShaderPipeline m_alpha;
         ShaderPipeline m_alpha_animated;
@@ -64,21 +98,36 @@ namespace dal {
         ShaderPipeline m_on_mirror_animated;
         ShaderPipeline m_mirror;
 
+        // Composition pipelines per ShaderConfig. They are created on first use and kept until destroy.
+        std::unordered_map<uint32_t, ShaderPipeline> m_composition_variants;
+        const ShaderPipeline* m_composition = nullptr;
+        std::vector<uint8_t> m_composition_vert_src;
+        std::vector<uint8_t> m_composition_frag_src;
+
     public:
         void init(
             dal::Filesystem& filesys,
             const dal::ShaderConfig& config,
             const bool need_gamma_correction,
             const bool does_support_depth_clamp,
-            const VkExtent2D& swapchain_extent,
-            const VkExtent2D& gbuf_extent,
             const dal::DescSetLayoutManager& desc_layouts,
             const dal::RenderPassManager& render_passes,
-            const VkDevice logi_device
+            const VkPipelineCache pipeline_cache,
+            const VkDevice logi_device,
+            dal::TaskManager& task_man
         );
 
         void destroy(const VkDevice logi_device);
 
+        // Selects composition pipeline for the config. It doesn't recompile GLSL since toggles are specialization constants.
+        void apply_shader_config(
+            const dal::ShaderConfig& config,
+            const dal::DescSetLayoutManager& desc_layouts,
+            const dal::RenderPassManager& render_passes,
+            const VkPipelineCache pipeline_cache,
+            const VkDevice logi_device
+        );
+
         auto& gbuf() const {
             return this->m_gbuf;
         }
@@ -88,7 +137,7 @@ namespace dal {
         }
 
         auto& composition() const {
-            return this->m_composition;
+            return *this->m_composition;
         }
 
         auto& final() const {
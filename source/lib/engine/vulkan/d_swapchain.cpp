@@ -193,6 +193,15 @@ namespace dal {
             if (this->is_complete())
                 break;
         }
+
+        for (uint32_t i = 0; i < queue_families.size(); ++i) {
+            const auto flags = queue_families[i].queueFlags;
+
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT)) {
+                this->m_transfer_family = i;
+                break;
+            }
+        }
     }
 
     bool QueueFamilyIndices::is_complete(void) const noexcept {
@@ -234,6 +243,7 @@ namespace dal {
 
         this->m_semaph_img_available.init(MAX_FRAMES_IN_FLIGHT, logi_device);
 
+        this->m_semaph_cmd_done_offscreen.init(MAX_FRAMES_IN_FLIGHT, logi_device);
         this->m_semaph_cmd_done_gbuf.init(MAX_FRAMES_IN_FLIGHT, logi_device);
         this->m_semaph_cmd_done_final.init(MAX_FRAMES_IN_FLIGHT, logi_device);
         this->m_semaph_cmd_done_alpha.init(MAX_FRAMES_IN_FLIGHT, logi_device);
@@ -245,6 +255,7 @@ namespace dal {
     void SwapchainSyncManager::destroy(const VkDevice logi_device) {
         this->m_semaph_img_available.destroy(logi_device);
 
+        this->m_semaph_cmd_done_offscreen.destroy(logi_device);
         this->m_semaph_cmd_done_gbuf.destroy(logi_device);
         this->m_semaph_cmd_done_final.destroy(logi_device);
         this->m_semaph_cmd_done_alpha.destroy(logi_device);
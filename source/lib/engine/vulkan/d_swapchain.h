@@ -24,6 +24,7 @@ namespace dal {
     private:
         uint32_t m_graphics_family = NULL_VAL;
         uint32_t m_present_family = NULL_VAL;
+        uint32_t m_transfer_family = NULL_VAL;  // Only if there is a transfer-only family
 
     public:
         QueueFamilyIndices() = default;
@@ -44,6 +45,15 @@ namespace dal {
             return this->m_present_family;
         }
 
+        bool has_dedicated_transfer(void) const noexcept {
+            return this->NULL_VAL != this->m_transfer_family;
+        }
+
+        // Falls back to graphics family
+        uint32_t transfer_family(void) const noexcept {
+            return this->has_dedicated_transfer() ? this->m_transfer_family : this->m_graphics_family;
+        }
+
     };
 
 
@@ -100,6 +110,7 @@ namespace dal {
     public:
         FenceSemaphList<Semaphore, FrameInFlightIndex> m_semaph_img_available;
 
+        FenceSemaphList<Semaphore, FrameInFlightIndex> m_semaph_cmd_done_offscreen;
         FenceSemaphList<Semaphore, FrameInFlightIndex> m_semaph_cmd_done_gbuf;
         FenceSemaphList<Semaphore, FrameInFlightIndex> m_semaph_cmd_done_final;
         FenceSemaphList<Semaphore, FrameInFlightIndex> m_semaph_cmd_done_alpha;
@@ -75,4 +75,8 @@ namespace dal {
         vkResetFences(logi_device, 1, &this->m_handle);
     }
 
+    bool Fence::is_signaled(const VkDevice logi_device) const {
+        return VK_SUCCESS == vkGetFenceStatus(logi_device, this->m_handle);
+    }
+
 }
@@ -59,6 +59,9 @@ namespace dal {
 
         void reset(const VkDevice logi_device) const;
 
+        // Does not block
+        bool is_signaled(const VkDevice logi_device) const;
+
         void wait_reset(const VkDevice logi_device) const {
             this->wait(logi_device);
             this->reset(logi_device);
@@ -0,0 +1,181 @@
+#include "d_texture_stream.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "dal/util/logger.h"
+
+
+namespace {
+
+    // Textures not seen for this many frames go down to their coarsest mip
+    constexpr uint64_t UNSEEN_FRAMES_TO_DROP = 120;
+    // Finer mips are kept until wanted one is coarser by more than this, so that moving camera doesn't thrash uploads
+    constexpr uint32_t MIP_DROP_HYSTERESIS = 1;
+    // Limits staging memory and transfer spent on streaming in a frame
+    constexpr size_t MAX_STREAM_STARTS_PER_FRAME = 4;
+
+
+    struct StreamTarget {
+        std::shared_ptr<dal::TextureProxy> m_texture;
+        uint32_t m_wanted_mip = 0;
+        uint32_t m_target_mip = 0;
+
+        int mip_diff() const {
+            return static_cast<int>(this->m_target_mip) - static_cast<int>(this->m_texture->resident_mip());
+        }
+    };
+
+
+    // Mip level at which a texel covers about a pixel on screen, at the point of bounding sphere closest to camera
+    uint32_t calc_wanted_mip(
+        const dal::RenderUnit& unit,
+        const dal::TextureProxy& texture,
+        const glm::mat4& model_mat,
+        const float scale,
+        const glm::vec3& view_pos,
+        const float pixels_per_unit_at_unit_dist
+    ) {
+        const auto pixels_per_unit = dal::project_bounds(unit, model_mat, scale, view_pos, pixels_per_unit_at_unit_dist).m_pixels_per_unit;
+        const auto texels_per_unit = static_cast<float>(texture.full_size()) * unit.m_uv_density / scale;
+
+        if (texels_per_unit <= pixels_per_unit)
+            return 0;
+
+        return static_cast<uint32_t>(std::log2(texels_per_unit / pixels_per_unit));
+    }
+
+    template <typename _RenderPairs>
+    void request_mips(
+        const _RenderPairs& render_pairs,
+        const glm::vec3& view_pos,
+        const float pixels_per_unit_at_unit_dist,
+        const uint64_t frame_count
+    ) {
+        for (const auto& pair : render_pairs) {
+            for (const auto actor : pair.m_actors) {
+                const auto model_mat = actor->m_transform.make_mat4();
+                const auto scale = actor->m_transform.m_scale;
+
+                for (const auto units : { &pair.m_model->render_units(), &pair.m_model->render_units_alpha() }) {
+                    for (const auto& unit : *units) {
+                        auto& texture = dal::handle_cast(*unit.m_material.m_albedo_map);
+
+                        // Zero UV density means texture is not stretched over any area
+                        if (!texture.is_streamable() || unit.m_uv_density <= 0)
+                            continue;
+
+                        const auto mip = ::calc_wanted_mip(unit, texture, model_mat, scale, view_pos, pixels_per_unit_at_unit_dist);
+                        texture.request_mip(mip, frame_count);
+                    }
+                }
+            }
+        }
+    }
+
+    size_t calc_total_size(const std::vector<::StreamTarget>& targets, const uint32_t mip_bias) {
+        size_t output = 0;
+
+        for (const auto& x : targets) {
+            const auto mip = std::min(x.m_wanted_mip + mip_bias, x.m_texture->coarsest_mip());
+            output += x.m_texture->mip_chain_size(mip);
+        }
+
+        return output;
+    }
+
+}
+
+
+// TextureStreamer
+namespace dal {
+
+    void TextureStreamer::update(
+        const std::vector<std::weak_ptr<TextureProxy>>& textures,
+        const RenderListVK& render_list,
+        const glm::vec3& view_pos,
+        const float pixels_per_unit_at_unit_dist,
+        const uint64_t frame_count
+    ) {
+        ::request_mips(render_list.m_static_models, view_pos, pixels_per_unit_at_unit_dist, frame_count);
+        ::request_mips(render_list.m_skinned_models, view_pos, pixels_per_unit_at_unit_dist, frame_count);
+
+        std::vector<::StreamTarget> targets;
+        size_t fixed_size = 0;
+        size_t resident_size = 0;
+
+        for (auto& x : textures) {
+            auto texture = x.lock();
+            if (!texture)
+                continue;
+
+            texture->update_streaming(frame_count);
+
+            if (!texture->is_streamable()) {
+                fixed_size += texture->resident_bytes();
+                continue;
+            }
+
+            auto wanted_mip = texture->take_requested_mip();
+            if (TextureProxy::NO_MIP_REQUEST == wanted_mip) {
+                if (frame_count - texture->last_request_frame() > ::UNSEEN_FRAMES_TO_DROP)
+                    wanted_mip = texture->coarsest_mip();
+                else
+                    wanted_mip = texture->resident_mip();
+            }
+
+            resident_size += texture->mip_chain_size(texture->resident_mip());
+
+            auto& target = targets.emplace_back();
+            target.m_texture = std::move(texture);
+            target.m_wanted_mip = std::min(wanted_mip, target.m_texture->coarsest_mip());
+        }
+
+        // Smallest bias that fits, or the one that makes every texture coarsest
+        uint32_t mip_bias = 0;
+        while (fixed_size + ::calc_total_size(targets, mip_bias) > this->m_budget_bytes) {
+            const auto all_coarsest = std::all_of(targets.begin(), targets.end(), [mip_bias](const auto& x) {
+                return x.m_wanted_mip + mip_bias >= x.m_texture->coarsest_mip();
+            });
+
+            if (all_coarsest)
+                break;
+
+            ++mip_bias;
+        }
+
+        if (mip_bias != this->m_mip_bias) {
+            dalInfo(fmt::format("Texture streaming mip bias changed to {} to fit in budget", mip_bias).c_str());
+            this->m_mip_bias = mip_bias;
+        }
+
+        for (auto& x : targets)
+            x.m_target_mip = std::min(x.m_wanted_mip + mip_bias, x.m_texture->coarsest_mip());
+
+        // Over budget, dropping finer mips comes first. Otherwise ones missing the most levels do.
+        const bool over_budget = fixed_size + resident_size > this->m_budget_bytes;
+        std::sort(targets.begin(), targets.end(), [over_budget](const auto& a, const auto& b) {
+            return over_budget ? (a.mip_diff() > b.mip_diff()) : (a.mip_diff() < b.mip_diff());
+        });
+
+        size_t started_count = 0;
+
+        for (auto& x : targets) {
+            if (started_count >= ::MAX_STREAM_STARTS_PER_FRAME)
+                break;
+
+            const auto diff = x.mip_diff();
+            const bool needs_finer = diff < 0;
+            const bool needs_coarser = diff > 0 && (over_budget || diff > static_cast<int>(::MIP_DROP_HYSTERESIS));
+
+            if (!needs_finer && !needs_coarser)
+                continue;
+
+            if (x.m_texture->stream_to(x.m_target_mip))
+                ++started_count;
+        }
+    }
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "d_image_obj.h"
+#include "d_vk_managers.h"
+
+
+namespace dal {
+
+    // Decides which mips of each texture stay on GPU from how large render units using it appear on screen.
+    // When they don't fit in budget, every texture goes coarser by the same number of levels.
+    class TextureStreamer {
+
+    private:
+        size_t m_budget_bytes = 512 * 1024 * 1024;
+        // Levels added to every texture to fit in budget
+        uint32_t m_mip_bias = 0;
+
+    public:
+        void set_budget(const size_t budget_bytes) {
+            this->m_budget_bytes = budget_bytes;
+        }
+
+        // Call once a frame after fence of frame in flight is waited on, before command buffers are recorded
+        void update(
+            const std::vector<std::weak_ptr<TextureProxy>>& textures,
+            const RenderListVK& render_list,
+            const glm::vec3& view_pos,
+            const float pixels_per_unit_at_unit_dist,
+            const uint64_t frame_count
+        );
+
+        auto mip_bias() const {
+            return this->m_mip_bias;
+        }
+
+    };
+
+}
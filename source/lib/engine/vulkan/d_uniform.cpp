@@ -53,6 +53,10 @@ namespace {
             this->add(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, stage_flags, desc_count);
         }
 
+        void add_ubuf_dynamic(const VkShaderStageFlags stage_flags, const uint32_t desc_count = 1) {
+            this->add(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, stage_flags, desc_count);
+        }
+
         void add_attach(const VkShaderStageFlags stage_flags, const uint32_t desc_count = 1) {
             this->add(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, stage_flags, desc_count);
         }
@@ -78,6 +82,83 @@ namespace {
 }
 
 
+// UniformRingBuffer
+namespace dal {
+
+    bool UniformRingBuffer::init(
+        const uint32_t frame_count,
+        const VkDeviceSize capacity_per_frame,
+        const VkPhysicalDevice phys_device,
+        const VkDevice logi_device
+    ) {
+        this->destroy(logi_device);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(phys_device, &properties);
+        this->m_alignment = std::max<VkDeviceSize>(1, properties.limits.minUniformBufferOffsetAlignment);
+        this->m_capacity = capacity_per_frame;
+
+        for (uint32_t i = 0; i < frame_count; ++i) {
+            const auto result = this->m_buffers.emplace_back().init(
+                capacity_per_frame,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                phys_device,
+                logi_device
+            );
+
+            if (!result)
+                return false;
+        }
+
+        this->m_cursors.resize(frame_count, 0);
+        return true;
+    }
+
+    void UniformRingBuffer::destroy(const VkDevice logi_device) {
+        for (auto& x : this->m_buffers)
+            x.destroy(logi_device);
+
+        this->m_buffers.clear();
+        this->m_cursors.clear();
+        this->m_capacity = 0;
+    }
+
+    bool UniformRingBuffer::is_ready() const {
+        if (this->m_buffers.empty())
+            return false;
+
+        for (auto& x : this->m_buffers) {
+            if (!x.is_ready())
+                return false;
+        }
+
+        return true;
+    }
+
+    void UniformRingBuffer::reset(const FrameInFlightIndex& index) {
+        this->m_cursors.at(index.get()) = 0;
+    }
+
+    std::optional<uint32_t> UniformRingBuffer::push(const FrameInFlightIndex& index, const void* data, const size_t size) {
+        auto& cursor = this->m_cursors.at(index.get());
+        const auto offset = cursor;
+        cursor += this->aligned_size(size);
+
+        if (offset + size > this->m_capacity)
+            return std::nullopt;
+
+        this->m_buffers.at(index.get()).copy_from_mem_at(offset, data, size);
+        return static_cast<uint32_t>(offset);
+    }
+
+    VkDeviceSize UniformRingBuffer::aligned_size(const VkDeviceSize size) const {
+        return (size + this->m_alignment - 1) / this->m_alignment * this->m_alignment;
+    }
+
+}
+
+
 // Descriptor set layouts
 namespace dal {
 
@@ -111,9 +192,9 @@ namespace dal {
         ::DescLayoutBuilder bindings;
 
         // U_CameraTransform
-        bindings.add_ubuf(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+        bindings.add_ubuf_dynamic(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
         // U_GlobalLight
-        bindings.add_ubuf(VK_SHADER_STAGE_FRAGMENT_BIT);
+        bindings.add_ubuf_dynamic(VK_SHADER_STAGE_FRAGMENT_BIT);
 
         this->build(bindings.make_create_info(), logi_device);
     }
@@ -133,7 +214,7 @@ namespace dal {
         ::DescLayoutBuilder bindings;
 
         // U_PerActor
-        bindings.add_ubuf(VK_SHADER_STAGE_VERTEX_BIT);
+        bindings.add_ubuf_dynamic(VK_SHADER_STAGE_VERTEX_BIT);
 
         this->build(bindings.make_create_info(), logi_device);
     }
@@ -142,9 +223,9 @@ namespace dal {
         ::DescLayoutBuilder bindings;
 
         // U_PerActor
-        bindings.add_ubuf(VK_SHADER_STAGE_VERTEX_BIT);
+        bindings.add_ubuf_dynamic(VK_SHADER_STAGE_VERTEX_BIT);
         // U_AnimTransform
-        bindings.add_ubuf(VK_SHADER_STAGE_VERTEX_BIT);
+        bindings.add_ubuf_dynamic(VK_SHADER_STAGE_VERTEX_BIT);
 
         this->build(bindings.make_create_info(), logi_device);
     }
@@ -158,9 +239,9 @@ namespace dal {
         bindings.add_attach(VK_SHADER_STAGE_FRAGMENT_BIT);
 
         // Ubuf U_GlobalLight
-        bindings.add_ubuf(VK_SHADER_STAGE_FRAGMENT_BIT);
+        bindings.add_ubuf_dynamic(VK_SHADER_STAGE_FRAGMENT_BIT);
         // Ubuf U_CameraTransform
-        bindings.add_ubuf(VK_SHADER_STAGE_FRAGMENT_BIT);
+        bindings.add_ubuf_dynamic(VK_SHADER_STAGE_FRAGMENT_BIT);
         // directional light shadow maps
         bindings.add_combined_img_sampler(VK_SHADER_STAGE_FRAGMENT_BIT, dal::MAX_DLIGHT_COUNT);
         // spot light shadow maps
@@ -173,9 +254,9 @@ namespace dal {
         ::DescLayoutBuilder bindings;
 
         // U_CameraTransform
-        bindings.add_ubuf(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+        bindings.add_ubuf_dynamic(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
         // U_GlobalLight
-        bindings.add_ubuf(VK_SHADER_STAGE_FRAGMENT_BIT);
+        bindings.add_ubuf_dynamic(VK_SHADER_STAGE_FRAGMENT_BIT);
         // directional light shadow maps
         bindings.add_combined_img_sampler(VK_SHADER_STAGE_FRAGMENT_BIT, dal::MAX_DLIGHT_COUNT);
         // spot light shadow maps
@@ -279,6 +360,30 @@ namespace {
             return index;
         }
 
+        // Offset is always 0, actual position is given by dynamic offset when binding
+        template <typename T>
+        size_t add_buffer_dynamic(const VkBuffer buffer) {
+            auto& info = this->m_buffer_info.emplace_back();
+            info.buffer = buffer;
+            info.range = sizeof(T);
+            info.offset = 0;
+
+            const auto index = this->m_desc_writes.size();
+
+            auto& write = this->m_desc_writes.emplace_back();
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = this->m_desc_set;
+            write.dstBinding = index;
+            write.dstArrayElement = 0;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            write.descriptorCount = 1;
+            write.pBufferInfo = &info;
+            write.pImageInfo = nullptr;
+            write.pTexelBufferView = nullptr;
+
+            return index;
+        }
+
         size_t add_img_sampler(const VkImageView img_view, const VkSampler sampler) {
             auto& info = this->m_image_info.emplace_back();
             info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -390,14 +495,14 @@ namespace dal {
     }
 
     void DescSet::record_per_global(
-        const UniformBuffer<U_CameraTransform>& ubuf_per_frame,
-        const UniformBuffer<U_GlobalLight>& ubuf_global_light,
+        const UniformRingBuffer& ubuf_ring,
+        const uint32_t frame_index,
         const VkDevice logi_device
     ) {
         ::WriteDescBuilder desc_writes{ this->m_handle };
 
-        desc_writes.add_buffer(ubuf_per_frame);
-        desc_writes.add_buffer(ubuf_global_light);
+        desc_writes.add_buffer_dynamic<U_CameraTransform>(ubuf_ring.buffer_at(frame_index));
+        desc_writes.add_buffer_dynamic<U_GlobalLight>(ubuf_ring.buffer_at(frame_index));
 
         vkUpdateDescriptorSets(logi_device, desc_writes.size(), desc_writes.data(), 0, nullptr);
     }
@@ -417,33 +522,34 @@ namespace dal {
     }
 
     void DescSet::record_per_actor(
-        const UniformBuffer<U_PerActor>& ubuf_per_actor,
+        const UniformRingBuffer& ubuf_ring,
+        const uint32_t frame_index,
         const VkDevice logi_device
     ) {
         ::WriteDescBuilder desc_writes{ this->m_handle };
 
-        desc_writes.add_buffer(ubuf_per_actor);
+        desc_writes.add_buffer_dynamic<U_PerActor>(ubuf_ring.buffer_at(frame_index));
 
         vkUpdateDescriptorSets(logi_device, desc_writes.size(), desc_writes.data(), 0, nullptr);
     }
 
     void DescSet::record_actor_animated(
-        const UniformBuffer<U_PerActor>& ubuf_per_actor,
-        const UniformBuffer<U_AnimTransform>& ubuf_animation,
+        const UniformRingBuffer& ubuf_ring,
+        const uint32_t frame_index,
         const VkDevice logi_device
     ) {
         ::WriteDescBuilder desc_writes{ this->m_handle };
 
-        desc_writes.add_buffer(ubuf_per_actor);
-        desc_writes.add_buffer(ubuf_animation);
+        desc_writes.add_buffer_dynamic<U_PerActor>(ubuf_ring.buffer_at(frame_index));
+        desc_writes.add_buffer_dynamic<U_AnimTransform>(ubuf_ring.buffer_at(frame_index));
 
         vkUpdateDescriptorSets(logi_device, desc_writes.size(), desc_writes.data(), 0, nullptr);
     }
 
     void DescSet::record_composition(
         const std::vector<VkImageView>& attachment_views,
-        const UniformBuffer<U_GlobalLight>& ubuf_global_light,
-        const UniformBuffer<U_CameraTransform>& ubuf_per_frame,
+        const UniformRingBuffer& ubuf_ring,
+        const uint32_t frame_index,
         const std::array<VkImageView, dal::MAX_DLIGHT_COUNT>& dlight_shadow_maps,
         const std::array<VkImageView, dal::MAX_SLIGHT_COUNT>& slight_shadow_maps,
         const SamplerDepth& sampler,
@@ -454,10 +560,10 @@ namespace dal {
         for (size_t i = 0; i < attachment_views.size(); ++i)
             desc_writes.add_input_attachment(attachment_views.at(i));
 
-        const auto global_light_index = desc_writes.add_buffer(ubuf_global_light);
+        const auto global_light_index = desc_writes.add_buffer_dynamic<U_GlobalLight>(ubuf_ring.buffer_at(frame_index));
         dalAssert(4 == global_light_index);
 
-        desc_writes.add_buffer(ubuf_per_frame);
+        desc_writes.add_buffer_dynamic<U_CameraTransform>(ubuf_ring.buffer_at(frame_index));
         desc_writes.add_img_samplers(dlight_shadow_maps.begin(), dlight_shadow_maps.end(), sampler.get());
         desc_writes.add_img_samplers(slight_shadow_maps.begin(), slight_shadow_maps.end(), sampler.get());
 
@@ -465,8 +571,8 @@ namespace dal {
     }
 
     void DescSet::record_alpha(
-        const UniformBuffer<U_CameraTransform>& ubuf_per_frame,
-        const UniformBuffer<U_GlobalLight>& ubuf_global_light,
+        const UniformRingBuffer& ubuf_ring,
+        const uint32_t frame_index,
         const std::array<VkImageView, dal::MAX_DLIGHT_COUNT>& dlight_shadow_maps,
         const std::array<VkImageView, dal::MAX_SLIGHT_COUNT>& slight_shadow_maps,
         const SamplerDepth& sampler,
@@ -474,8 +580,8 @@ namespace dal {
     ) {
         ::WriteDescBuilder desc_writes{ this->m_handle };
 
-        desc_writes.add_buffer(ubuf_per_frame);
-        desc_writes.add_buffer(ubuf_global_light);
+        desc_writes.add_buffer_dynamic<U_CameraTransform>(ubuf_ring.buffer_at(frame_index));
+        desc_writes.add_buffer_dynamic<U_GlobalLight>(ubuf_ring.buffer_at(frame_index));
         desc_writes.add_img_samplers(dlight_shadow_maps.begin(), dlight_shadow_maps.end(), sampler.get());
         desc_writes.add_img_samplers(slight_shadow_maps.begin(), slight_shadow_maps.end(), sampler.get());
 
@@ -509,13 +615,16 @@ namespace dal {
     ) {
         this->destroy(logi_device);
 
-        std::array<VkDescriptorPoolSize, 3> poolSizes{};
+        // Dynamic uniform buffers share the budget of plain ones
+        std::array<VkDescriptorPoolSize, 4> poolSizes{};
         poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         poolSizes[0].descriptorCount = uniform_buf_count;
         poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         poolSizes[1].descriptorCount = image_sampler_count;
         poolSizes[2].type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
         poolSizes[2].descriptorCount = input_attachment_count;
+        poolSizes[3].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        poolSizes[3].descriptorCount = uniform_buf_count;
 
         VkDescriptorPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -666,6 +775,8 @@ namespace dal {
         this->m_descset_final.clear();
         this->m_descset_composition.clear();
         this->m_descset_alpha.clear();
+        this->m_descset_per_actor.clear();
+        this->m_descset_actor_animated.clear();
     }
 
     DescSet& DescriptorManager::add_descset_per_global(const dal::DescLayout_PerGlobal& desc_layout_per_global, const VkDevice logi_device) {
@@ -692,4 +803,16 @@ namespace dal {
         return new_desc;
     }
 
+    DescSet& DescriptorManager::add_descset_per_actor(const dal::DescLayout_PerActor& desc_layout_per_actor, const VkDevice logi_device) {
+        auto& new_desc = this->m_descset_per_actor.emplace_back();
+        new_desc = this->m_pool.allocate(desc_layout_per_actor, logi_device);
+        return new_desc;
+    }
+
+    DescSet& DescriptorManager::add_descset_actor_animated(const dal::DescLayout_ActorAnimated& desc_layout_actor_animated, const VkDevice logi_device) {
+        auto& new_desc = this->m_descset_actor_animated.emplace_back();
+        new_desc = this->m_pool.allocate(desc_layout_actor_animated, logi_device);
+        return new_desc;
+    }
+
 }
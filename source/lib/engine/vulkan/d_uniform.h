@@ -2,6 +2,7 @@
 
 #include <deque>
 #include <vector>
+#include <optional>
 #include <unordered_map>
 
 #define GLM_FORCE_RADIANS
@@ -9,6 +10,7 @@
 #include <glm/glm.hpp>
 
 #include "dal/util/konsts.h"
+#include "dal/util/indices.h"
 #include "d_image_obj.h"
 #include "d_vulkan_header.h"
 #include "d_buffer_memory.h"
@@ -186,6 +188,64 @@ namespace dal {
 
     };
 
+
+    // One host visible buffer per frame in flight. Each frame rewinds its own buffer and hands out
+    // aligned ranges which are bound with dynamic uniform offsets.
+    class UniformRingBuffer {
+
+    private:
+        std::vector<BufferMemory> m_buffers;
+        std::vector<VkDeviceSize> m_cursors;
+        VkDeviceSize m_capacity = 0;
+        VkDeviceSize m_alignment = 1;
+
+    public:
+        [[nodiscard]]
+        bool init(
+            const uint32_t frame_count,
+            const VkDeviceSize capacity_per_frame,
+            const VkPhysicalDevice phys_device,
+            const VkDevice logi_device
+        );
+
+        void destroy(const VkDevice logi_device);
+
+        bool is_ready() const;
+
+        // Must be called only after GPU finished reading previous contents of the frame
+        void reset(const FrameInFlightIndex& index);
+
+        // Returns nothing without writing when the frame's buffer is full. Cursor advances anyway,
+        // so used_at() becomes larger than capacity() and tells how much the frame needed.
+        std::optional<uint32_t> push(const FrameInFlightIndex& index, const void* data, const size_t size);
+
+        template <typename _DataStruct>
+        std::optional<uint32_t> push(const FrameInFlightIndex& index, const _DataStruct& data) {
+            return this->push(index, &data, sizeof(_DataStruct));
+        }
+
+        VkDeviceSize aligned_size(const VkDeviceSize size) const;
+
+        VkBuffer buffer_at(const uint32_t index) const {
+            return this->m_buffers.at(index).buffer();
+        }
+
+        auto capacity() const {
+            return this->m_capacity;
+        }
+
+        auto used_at(const FrameInFlightIndex& index) const {
+            return this->m_cursors.at(index.get());
+        }
+
+    };
+
+
+    struct UbufOffsetsPerGlobal {
+        uint32_t m_camera = 0;
+        uint32_t m_global_light = 0;
+    };
+
 }
 
 
@@ -356,8 +416,8 @@ namespace dal {
         );
 
         void record_per_global(
-            const UniformBuffer<U_CameraTransform>& ubuf_per_frame,
-            const UniformBuffer<U_GlobalLight>& ubuf_global_light,
+            const UniformRingBuffer& ubuf_ring,
+            const uint32_t frame_index,
             const VkDevice logi_device
         );
 
@@ -369,20 +429,21 @@ namespace dal {
         );
 
         void record_per_actor(
-            const UniformBuffer<U_PerActor>& ubuf_per_actor,
+            const UniformRingBuffer& ubuf_ring,
+            const uint32_t frame_index,
             const VkDevice logi_device
         );
 
         void record_actor_animated(
-            const UniformBuffer<U_PerActor>& ubuf_per_actor,
-            const UniformBuffer<U_AnimTransform>& ubuf_animation,
+            const UniformRingBuffer& ubuf_ring,
+            const uint32_t frame_index,
             const VkDevice logi_device
         );
 
         void record_composition(
             const std::vector<VkImageView>& attachment_views,
-            const UniformBuffer<U_GlobalLight>& ubuf_global_light,
-            const UniformBuffer<U_CameraTransform>& ubuf_per_frame,
+            const UniformRingBuffer& ubuf_ring,
+            const uint32_t frame_index,
             const std::array<VkImageView, dal::MAX_DLIGHT_COUNT>& dlight_shadow_maps,
             const std::array<VkImageView, dal::MAX_SLIGHT_COUNT>& slight_shadow_maps,
             const SamplerDepth& sampler,
@@ -390,8 +451,8 @@ namespace dal {
         );
 
         void record_alpha(
-            const UniformBuffer<U_CameraTransform>& ubuf_per_frame,
-            const UniformBuffer<U_GlobalLight>& ubuf_global_light,
+            const UniformRingBuffer& ubuf_ring,
+            const uint32_t frame_index,
             const std::array<VkImageView, dal::MAX_DLIGHT_COUNT>& dlight_shadow_maps,
             const std::array<VkImageView, dal::MAX_SLIGHT_COUNT>& slight_shadow_maps,
             const SamplerDepth& sampler,
@@ -479,6 +540,8 @@ namespace dal {
         std::vector<DescSet> m_descset_final;
         std::vector<DescSet> m_descset_composition;
         std::vector<DescSet> m_descset_alpha;
+        std::vector<DescSet> m_descset_per_actor;
+        std::vector<DescSet> m_descset_actor_animated;
 
     public:
         void init(const uint32_t swapchain_count, const VkDevice logi_device);
@@ -497,6 +560,10 @@ namespace dal {
 
         DescSet& add_descset_alpha(const dal::DescLayout_Alpha& desc_layout_alpha, const VkDevice logi_device);
 
+        DescSet& add_descset_per_actor(const dal::DescLayout_PerActor& desc_layout_per_actor, const VkDevice logi_device);
+
+        DescSet& add_descset_actor_animated(const dal::DescLayout_ActorAnimated& desc_layout_actor_animated, const VkDevice logi_device);
+
         auto& desc_set_per_global_at(const size_t index) const {
             return this->m_descset_per_global.at(index).get();
         }
@@ -513,6 +580,36 @@ namespace dal {
             return this->m_descset_alpha.at(index).get();
         }
 
+        auto& desc_set_per_actor_at(const size_t index) const {
+            return this->m_descset_per_actor.at(index).get();
+        }
+
+        auto& desc_set_actor_animated_at(const size_t index) const {
+            return this->m_descset_actor_animated.at(index).get();
+        }
+
+        // Ones pointing at buffers of UniformRingBuffer, to be recorded again when it is replaced
+
+        DescSet& descset_per_global(const size_t index) {
+            return this->m_descset_per_global.at(index);
+        }
+
+        DescSet& descset_composition(const size_t index) {
+            return this->m_descset_composition.at(index);
+        }
+
+        DescSet& descset_alpha(const size_t index) {
+            return this->m_descset_alpha.at(index);
+        }
+
+        DescSet& descset_per_actor(const size_t index) {
+            return this->m_descset_per_actor.at(index);
+        }
+
+        DescSet& descset_actor_animated(const size_t index) {
+            return this->m_descset_actor_animated.at(index);
+        }
+
     };
 
 }
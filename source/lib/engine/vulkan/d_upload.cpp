@@ -0,0 +1,410 @@
+#include "d_upload.h"
+
+#include <fmt/format.h>
+
+#include "dal/util/logger.h"
+
+
+namespace {
+
+    // Satisfies bufferOffset requirement of vkCmdCopyBufferToImage for every format in use
+    constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+    VkDeviceSize align_up(const VkDeviceSize value, const VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+}
+
+
+// StagingRing
+namespace dal {
+
+    bool StagingRing::init(const VkDeviceSize capacity, const VkPhysicalDevice phys_device, const VkDevice logi_device) {
+        this->destroy(logi_device);
+
+        return this->m_buffer.init(
+            capacity,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            phys_device,
+            logi_device
+        );
+    }
+
+    void StagingRing::destroy(const VkDevice logi_device) {
+        this->m_buffer.destroy(logi_device);
+        this->m_regions.clear();
+        this->m_head = 0;
+    }
+
+    std::optional<VkDeviceSize> StagingRing::allocate(const VkDeviceSize size, const UploadTicket& ticket) {
+        const auto capacity = this->capacity();
+        if (size > capacity)
+            return std::nullopt;
+
+        VkDeviceSize begin = 0;
+
+        if (this->m_regions.empty()) {
+            begin = 0;
+        }
+        else {
+            const auto tail = this->m_regions.front().m_begin;
+            const auto head = ::align_up(this->m_head, ::STAGING_ALIGNMENT);
+
+            if (this->m_head == tail) {
+                // Wrapped allocations reached the oldest region, so nothing is free until it is released
+                return std::nullopt;
+            }
+            else if (this->m_head > tail) {
+                // Free space is [head, capacity) and [0, tail)
+                if (head + size <= capacity)
+                    begin = head;
+                else if (size <= tail)
+                    begin = 0;
+                else
+                    return std::nullopt;
+            }
+            else {
+                // Free space is [head, tail)
+                if (head + size <= tail)
+                    begin = head;
+                else
+                    return std::nullopt;
+            }
+        }
+
+        auto& region = this->m_regions.emplace_back();
+        region.m_begin = begin;
+        region.m_end = begin + size;
+        region.m_ticket = ticket;
+
+        this->m_head = region.m_end;
+        return begin;
+    }
+
+    void StagingRing::write(const VkDeviceSize offset, const void* const data, const VkDeviceSize size) {
+        this->m_buffer.copy_from_mem_at(offset, data, size);
+    }
+
+    void StagingRing::pop_oldest() {
+        this->m_regions.pop_front();
+
+        if (this->m_regions.empty())
+            this->m_head = 0;
+    }
+
+}
+
+
+// UploadStream
+namespace dal {
+
+    void UploadStream::init(const uint32_t queue_family_index, const VkQueue queue, const VkDevice logi_device) {
+        this->destroy(logi_device);
+
+        this->m_cmd_pool.init(queue_family_index, logi_device);
+        this->m_queue = queue;
+    }
+
+    void UploadStream::destroy(const VkDevice logi_device) {
+        if (VK_NULL_HANDLE == this->m_queue)
+            return;
+
+        this->flush(logi_device);
+        this->wait(this->m_last_submitted, logi_device);
+
+        for (auto& x : this->m_fence_pool)
+            x.destory(logi_device);
+        this->m_fence_pool.clear();
+
+        this->m_cmd_pool.destroy(logi_device);
+        this->m_queue = VK_NULL_HANDLE;
+    }
+
+    VkCommandBuffer UploadStream::cmd_buf(const VkDevice logi_device) {
+        if (VK_NULL_HANDLE != this->m_recording.m_cmd_buf)
+            return this->m_recording.m_cmd_buf;
+
+        this->m_cmd_pool.allocate(&this->m_recording.m_cmd_buf, 1, logi_device);
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (VK_SUCCESS != vkBeginCommandBuffer(this->m_recording.m_cmd_buf, &begin_info))
+            dalAbort("failed to begin recording upload command buffer");
+
+        return this->m_recording.m_cmd_buf;
+    }
+
+    uint64_t UploadStream::keep_alive(BufferMemory&& staging_buffer) {
+        this->m_recording.m_staging_buffers.push_back(std::move(staging_buffer));
+        return this->recording_number();
+    }
+
+    void UploadStream::flush(const VkDevice logi_device) {
+        if (VK_NULL_HANDLE == this->m_recording.m_cmd_buf)
+            return;
+
+        if (VK_SUCCESS != vkEndCommandBuffer(this->m_recording.m_cmd_buf))
+            dalAbort("failed to record upload command buffer");
+
+        if (this->m_fence_pool.empty()) {
+            this->m_recording.m_fence.init(logi_device);
+        }
+        else {
+            this->m_recording.m_fence = std::move(this->m_fence_pool.back());
+            this->m_fence_pool.pop_back();
+        }
+        this->m_recording.m_fence.reset(logi_device);
+
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &this->m_recording.m_cmd_buf;
+
+        const auto submit_result = vkQueueSubmit(this->m_queue, 1, &submit_info, this->m_recording.m_fence.get());
+        dalAssert(VK_SUCCESS == submit_result);
+
+        this->m_recording.m_number = ++this->m_last_submitted;
+        this->m_pending.push_back(std::move(this->m_recording));
+        this->m_recording = Batch{};
+    }
+
+    void UploadStream::poll(const VkDevice logi_device) {
+        while (!this->m_pending.empty()) {
+            auto& batch = this->m_pending.front();
+            if (!batch.m_fence.is_signaled(logi_device))
+                break;
+
+            this->m_last_completed = batch.m_number;
+            this->release(batch, logi_device);
+            this->m_pending.pop_front();
+        }
+    }
+
+    void UploadStream::wait(const uint64_t number, const VkDevice logi_device) {
+        if (this->is_done(number))
+            return;
+
+        if (number > this->m_last_submitted)
+            this->flush(logi_device);
+
+        while (!this->m_pending.empty()) {
+            auto& batch = this->m_pending.front();
+            if (batch.m_number > number)
+                break;
+
+            batch.m_fence.wait(logi_device);
+            this->m_last_completed = batch.m_number;
+            this->release(batch, logi_device);
+            this->m_pending.pop_front();
+        }
+    }
+
+    // Private
+
+    void UploadStream::release(Batch& batch, const VkDevice logi_device) {
+        for (auto& x : batch.m_staging_buffers)
+            x.destroy(logi_device);
+        batch.m_staging_buffers.clear();
+
+        this->m_cmd_pool.free(batch.m_cmd_buf, logi_device);
+        batch.m_cmd_buf = VK_NULL_HANDLE;
+
+        this->m_fence_pool.push_back(std::move(batch.m_fence));
+    }
+
+}
+
+
+// UploadManager
+namespace dal {
+
+    void UploadManager::init(
+        const VkDeviceSize staging_capacity,
+        const uint32_t graphics_family,
+        const VkQueue graphics_queue,
+        const uint32_t transfer_family,
+        const VkQueue transfer_queue,
+        const VkPhysicalDevice phys_device,
+        const VkDevice logi_device
+    ) {
+        this->destroy();
+
+        this->m_phys_device = phys_device;
+        this->m_logi_device = logi_device;
+        this->m_has_transfer_queue = (graphics_family != transfer_family) && (VK_NULL_HANDLE != transfer_queue);
+
+        if (!this->m_staging.init(staging_capacity, phys_device, logi_device))
+            dalAbort(fmt::format("failed to create staging ring of {} bytes", staging_capacity).c_str());
+
+        this->m_graphics.init(graphics_family, graphics_queue, logi_device);
+        this->m_buffer_queue_families = { graphics_family };
+
+        if (this->m_has_transfer_queue) {
+            this->m_transfer.init(transfer_family, transfer_queue, logi_device);
+            this->m_buffer_queue_families.push_back(transfer_family);
+        }
+
+        dalInfo(fmt::format("Buffer uploads go to {} queue", this->m_has_transfer_queue ? "dedicated transfer" : "graphics").c_str());
+    }
+
+    void UploadManager::destroy() {
+        if (VK_NULL_HANDLE == this->m_logi_device)
+            return;
+
+        this->m_transfer.destroy(this->m_logi_device);
+        this->m_graphics.destroy(this->m_logi_device);
+        this->m_staging.destroy(this->m_logi_device);
+        this->m_buffer_queue_families.clear();
+
+        if (0 != this->m_stall_count)
+            dalInfo(fmt::format("Uploads stalled {} times on full staging ring", this->m_stall_count).c_str());
+        this->m_stall_count = 0;
+
+        this->m_phys_device = VK_NULL_HANDLE;
+        this->m_logi_device = VK_NULL_HANDLE;
+        this->m_has_transfer_queue = false;
+    }
+
+    UploadTicket UploadManager::copy_to_buffer(const VkBuffer dst_buffer, const void* const data, const VkDeviceSize size) {
+        auto& stream = this->buffer_stream();
+
+        // Might flush the stream so command buffer must be fetched after this
+        const auto staging = this->acquire_staging(stream, data, size);
+        const auto cmd_buf = stream.cmd_buf(this->m_logi_device);
+
+        VkBufferCopy copy_region{};
+        copy_region.srcOffset = staging.m_offset;
+        copy_region.size = size;
+        vkCmdCopyBuffer(cmd_buf, staging.m_buffer, dst_buffer, 1, &copy_region);
+
+        return this->make_ticket(stream);
+    }
+
+    std::pair<VkCommandBuffer, StagingSpan> UploadManager::begin_image_upload(const void* const data, const VkDeviceSize size) {
+        const auto staging = this->acquire_staging(this->m_graphics, data, size);
+        const auto cmd_buf = this->m_graphics.cmd_buf(this->m_logi_device);
+
+        return std::make_pair(cmd_buf, staging);
+    }
+
+    UploadTicket UploadManager::end_image_upload() {
+        UploadTicket output;
+        output.m_graphics = this->m_graphics.recording_number();
+        return output;
+    }
+
+    void UploadManager::flush() {
+        if (this->m_has_transfer_queue)
+            this->m_transfer.flush(this->m_logi_device);
+
+        this->m_graphics.flush(this->m_logi_device);
+    }
+
+    void UploadManager::poll() {
+        if (this->m_has_transfer_queue)
+            this->m_transfer.poll(this->m_logi_device);
+
+        this->m_graphics.poll(this->m_logi_device);
+        this->release_staging();
+    }
+
+    bool UploadManager::is_done(const UploadTicket& ticket) const {
+        return this->m_transfer.is_done(ticket.m_transfer) && this->m_graphics.is_done(ticket.m_graphics);
+    }
+
+    void UploadManager::wait(const UploadTicket& ticket) {
+        if (this->m_has_transfer_queue)
+            this->m_transfer.wait(ticket.m_transfer, this->m_logi_device);
+
+        this->m_graphics.wait(ticket.m_graphics, this->m_logi_device);
+        this->release_staging();
+    }
+
+    void UploadManager::wait_all() {
+        this->flush();
+
+        UploadTicket ticket;
+        ticket.m_transfer = this->m_transfer.recording_number() - 1;
+        ticket.m_graphics = this->m_graphics.recording_number() - 1;
+        this->wait(ticket);
+    }
+
+    // Private
+
+    UploadTicket UploadManager::make_ticket(const UploadStream& stream) const {
+        UploadTicket output;
+
+        if (&stream == &this->m_transfer)
+            output.m_transfer = stream.recording_number();
+        else
+            output.m_graphics = stream.recording_number();
+
+        return output;
+    }
+
+    StagingSpan UploadManager::acquire_staging(UploadStream& stream, const void* const data, const VkDeviceSize size) {
+        StagingSpan output;
+
+        if (size > this->m_staging.capacity()) {
+            dalWarn(fmt::format(
+                "Upload of {} bytes does not fit in staging ring of {} bytes", size, this->m_staging.capacity()
+            ).c_str());
+
+            BufferMemory staging_buffer;
+            if (!this->create_staging_buffer(staging_buffer, data, size))
+                dalAbort("failed to create staging buffer");
+
+            output.m_buffer = staging_buffer.buffer();
+            stream.keep_alive(std::move(staging_buffer));
+            return output;
+        }
+
+        while (true) {
+            // Ticket must be made after any flush below because flush starts a new batch
+            const auto offset = this->m_staging.allocate(size, this->make_ticket(stream));
+
+            if (offset.has_value()) {
+                this->m_staging.write(*offset, data, size);
+                output.m_buffer = this->m_staging.buffer();
+                output.m_offset = *offset;
+                return output;
+            }
+
+            // Back-pressure: submit what has been recorded and wait until the oldest region is free
+            dalAssert(!this->m_staging.is_empty());
+            ++this->m_stall_count;
+            this->flush();
+            this->wait(this->m_staging.oldest_ticket());
+        }
+    }
+
+    void UploadManager::release_staging() {
+        while (!this->m_staging.is_empty()) {
+            if (!this->is_done(this->m_staging.oldest_ticket()))
+                break;
+
+            this->m_staging.pop_oldest();
+        }
+    }
+
+    bool UploadManager::create_staging_buffer(BufferMemory& output, const void* const data, const VkDeviceSize size) {
+        const auto result = output.init(
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            this->m_phys_device,
+            this->m_logi_device
+        );
+
+        if (!result)
+            return false;
+
+        output.copy_from_mem(data, size, this->m_logi_device);
+        return true;
+    }
+
+}
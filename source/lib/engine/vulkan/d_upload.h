@@ -0,0 +1,227 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <optional>
+#include <algorithm>
+
+#include "d_vulkan_header.h"
+#include "d_command.h"
+#include "d_sync_primitives.h"
+#include "d_buffer_memory.h"
+
+
+namespace dal {
+
+    // Both values are batch numbers. A resource is uploaded once each stream has completed its batch.
+    struct UploadTicket {
+        uint64_t m_transfer = 0;
+        uint64_t m_graphics = 0;
+
+        void merge(const UploadTicket& other) {
+            this->m_transfer = std::max(this->m_transfer, other.m_transfer);
+            this->m_graphics = std::max(this->m_graphics, other.m_graphics);
+        }
+    };
+
+
+    struct StagingSpan {
+        VkBuffer m_buffer = VK_NULL_HANDLE;
+        VkDeviceSize m_offset = 0;
+    };
+
+
+    // One persistently mapped host visible buffer which staging data are carved out of.
+    // Regions are released in the order they were allocated, once their ticket is done.
+    class StagingRing {
+
+    private:
+        struct Region {
+            VkDeviceSize m_begin = 0;
+            VkDeviceSize m_end = 0;
+            UploadTicket m_ticket;
+        };
+
+    private:
+        BufferMemory m_buffer;
+        std::deque<Region> m_regions;
+        VkDeviceSize m_head = 0;
+
+    public:
+        [[nodiscard]]
+        bool init(const VkDeviceSize capacity, const VkPhysicalDevice phys_device, const VkDevice logi_device);
+
+        void destroy(const VkDevice logi_device);
+
+        // Returns offset into buffer(), or nothing if there is not enough contiguous space right now
+        std::optional<VkDeviceSize> allocate(const VkDeviceSize size, const UploadTicket& ticket);
+
+        void write(const VkDeviceSize offset, const void* const data, const VkDeviceSize size);
+
+        bool is_ready() const {
+            return this->m_buffer.is_ready();
+        }
+
+        bool is_empty() const {
+            return this->m_regions.empty();
+        }
+
+        auto& oldest_ticket() const {
+            return this->m_regions.front().m_ticket;
+        }
+
+        void pop_oldest();
+
+        auto buffer() const {
+            return this->m_buffer.buffer();
+        }
+
+        auto capacity() const {
+            return this->m_buffer.size();
+        }
+
+    };
+
+
+    // Commands recorded into one command buffer until flushed, then tracked with a fence.
+    // Staging buffers are kept alive until the fence of their batch is signaled.
+    class UploadStream {
+
+    private:
+        struct Batch {
+            std::vector<BufferMemory> m_staging_buffers;
+            VkCommandBuffer m_cmd_buf = VK_NULL_HANDLE;
+            Fence m_fence;
+            uint64_t m_number = 0;
+        };
+
+    private:
+        CommandPool m_cmd_pool;
+        std::deque<Batch> m_pending;
+        std::vector<Fence> m_fence_pool;
+        Batch m_recording;
+        VkQueue m_queue = VK_NULL_HANDLE;
+        uint64_t m_last_submitted = 0;
+        uint64_t m_last_completed = 0;
+
+    public:
+        void init(const uint32_t queue_family_index, const VkQueue queue, const VkDevice logi_device);
+
+        void destroy(const VkDevice logi_device);
+
+        // Begins a new batch if nothing is being recorded
+        VkCommandBuffer cmd_buf(const VkDevice logi_device);
+
+        // Returns batch number which the staging buffer, and any command recorded so far, belongs to
+        uint64_t keep_alive(BufferMemory&& staging_buffer);
+
+        uint64_t recording_number() const {
+            return this->m_last_submitted + 1;
+        }
+
+        void flush(const VkDevice logi_device);
+
+        void poll(const VkDevice logi_device);
+
+        void wait(const uint64_t number, const VkDevice logi_device);
+
+        bool is_done(const uint64_t number) const {
+            return number <= this->m_last_completed;
+        }
+
+        size_t pending_count() const {
+            return this->m_pending.size();
+        }
+
+    private:
+        void release(Batch& batch, const VkDevice logi_device);
+
+    };
+
+
+    // Every vertex, index and texture upload goes through here instead of a blocking single time command.
+    // Buffer copies go to a dedicated transfer queue if there is one. Image uploads need blit for mipmaps
+    // so they always go to graphics queue.
+    // Staging data are written into StagingRing. When it is full, pending batches are submitted and the oldest
+    // one is waited for. Only uploads bigger than the whole ring get a staging buffer of their own.
+    // Not thread safe. Everything must be called on the thread which owns VulkanState.
+    class UploadManager {
+
+    private:
+        UploadStream m_transfer;
+        UploadStream m_graphics;
+        StagingRing m_staging;
+        std::vector<uint32_t> m_buffer_queue_families;
+        VkPhysicalDevice m_phys_device = VK_NULL_HANDLE;
+        VkDevice m_logi_device = VK_NULL_HANDLE;
+        bool m_has_transfer_queue = false;
+        size_t m_stall_count = 0;
+
+    public:
+        void init(
+            const VkDeviceSize staging_capacity,
+            const uint32_t graphics_family,
+            const VkQueue graphics_queue,
+            const uint32_t transfer_family,
+            const VkQueue transfer_queue,
+            const VkPhysicalDevice phys_device,
+            const VkDevice logi_device
+        );
+
+        void destroy();
+
+        auto phys_device() const {
+            return this->m_phys_device;
+        }
+
+        auto logi_device() const {
+            return this->m_logi_device;
+        }
+
+        // Buffers which are written by transfer queue and read by graphics queue must be shared by both
+        auto& buffer_queue_families() const {
+            return this->m_buffer_queue_families;
+        }
+
+        UploadTicket copy_to_buffer(const VkBuffer dst_buffer, const void* const data, const VkDeviceSize size);
+
+        // Returns a command buffer on graphics queue, and a staging range filled with data, which will be kept alive.
+        // Caller records image commands into the command buffer.
+        std::pair<VkCommandBuffer, StagingSpan> begin_image_upload(const void* const data, const VkDeviceSize size);
+
+        UploadTicket end_image_upload();
+
+        // Called once a frame before recording
+        void flush();
+
+        // Called once a frame, updates what is_done returns
+        void poll();
+
+        bool is_done(const UploadTicket& ticket) const;
+
+        // For destroying a resource which might still be written by GPU
+        void wait(const UploadTicket& ticket);
+
+        void wait_all();
+
+        // How many times an upload had to wait for GPU because staging ring was full
+        auto stall_count() const {
+            return this->m_stall_count;
+        }
+
+    private:
+        UploadStream& buffer_stream() {
+            return this->m_has_transfer_queue ? this->m_transfer : this->m_graphics;
+        }
+
+        UploadTicket make_ticket(const UploadStream& stream) const;
+
+        StagingSpan acquire_staging(UploadStream& stream, const void* const data, const VkDeviceSize size);
+
+        void release_staging();
+
+        bool create_staging_buffer(BufferMemory& output, const void* const data, const VkDeviceSize size);
+
+    };
+
+}
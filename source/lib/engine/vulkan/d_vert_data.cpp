@@ -1,78 +1,60 @@
 #include "d_vert_data.h"
 
+#include <tuple>
+
 #include "dal/util/logger.h"
 
 
 namespace {
 
+    dal::BufferMemory build_device_buffer(
+        const void* const data,
+        const VkDeviceSize buffer_size,
+        const VkBufferUsageFlags usage,
+        dal::UploadTicket& ticket,
+        dal::UploadManager& upload_man
+    ) {
+        dal::BufferMemory output;
+
+        const auto result = output.init(
+            buffer_size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            upload_man.buffer_queue_families(),
+            upload_man.phys_device(),
+            upload_man.logi_device()
+        );
+        dalAssert(result);
+
+        ticket.merge(upload_man.copy_to_buffer(output.buffer(), data, buffer_size));
+        return output;
+    }
+
     template <typename _VertType>
-    std::pair<dal::BufferMemory, dal::BufferMemory> build_vertex_buffer(
+    std::tuple<dal::BufferMemory, dal::BufferMemory, dal::UploadTicket> build_vertex_buffer(
         const std::vector<_VertType>& vertices,
         const std::vector<dal::index_data_t>& indices,
-        dal::CommandPool& cmd_pool,
-        const VkQueue graphics_queue,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
+        dal::UploadManager& upload_man
     ) {
-        dal::BufferMemory vert_buffer, indices_buffer;
-
-        // Build vertex buffer
-        {
-            const VkDeviceSize buffer_size = sizeof(vertices[0]) * vertices.size();
-
-            dal::BufferMemory staging_buffer;
-            const auto result_staging = staging_buffer.init(
-                buffer_size,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                phys_device,
-                logi_device
-            );
-            dalAssert(result_staging);
-            staging_buffer.copy_from_mem(vertices.data(), buffer_size, logi_device);
-
-            const auto result_this = vert_buffer.init(
-                buffer_size,
-                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                phys_device,
-                logi_device
-            );
-            dalAssert(result_this);
-
-            vert_buffer.copy_from_buf(staging_buffer, buffer_size, cmd_pool, graphics_queue, logi_device);
-            staging_buffer.destroy(logi_device);
-        }
-
-        // Build index buffer
-        {
-            const VkDeviceSize buffer_size = sizeof(indices[0]) * indices.size();
-
-            dal::BufferMemory staging_buffer;
-            const auto result_staging = staging_buffer.init(
-                buffer_size,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                phys_device,
-                logi_device
-            );
-            dalAssert(result_staging);
-            staging_buffer.copy_from_mem(indices.data(), buffer_size, logi_device);
-
-            const auto result_this = indices_buffer.init(
-                buffer_size,
-                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                phys_device,
-                logi_device
-            );
-            dalAssert(result_this);
-
-            indices_buffer.copy_from_buf(staging_buffer, buffer_size, cmd_pool, graphics_queue, logi_device);
-            staging_buffer.destroy(logi_device);
-        }
-
-        return std::make_pair(std::move(vert_buffer), std::move(indices_buffer));
+        dal::UploadTicket ticket;
+
+        auto vert_buffer = ::build_device_buffer(
+            vertices.data(),
+            sizeof(vertices[0]) * vertices.size(),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            ticket,
+            upload_man
+        );
+
+        auto indices_buffer = ::build_device_buffer(
+            indices.data(),
+            sizeof(indices[0]) * indices.size(),
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            ticket,
+            upload_man
+        );
+
+        return std::make_tuple(std::move(vert_buffer), std::move(indices_buffer), ticket);
     }
 
 }
@@ -161,48 +143,40 @@ namespace dal {
     void VertexBuffer::init_static(
         const std::vector<VertexStatic>& vertices,
         const std::vector<index_data_t>& indices,
-        dal::CommandPool& cmd_pool,
-        const VkQueue graphics_queue,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
+        dal::UploadManager& upload_man
     ) {
-        this->destroy(logi_device);
+        this->destroy(upload_man);
         this->m_index_size = indices.size();
 
-        std::tie(this->m_vertices, this->m_indices) = ::build_vertex_buffer(
+        std::tie(this->m_vertices, this->m_indices, this->m_upload_ticket) = ::build_vertex_buffer(
             vertices,
             indices,
-            cmd_pool,
-            graphics_queue,
-            phys_device,
-            logi_device
+            upload_man
         );
     }
 
     void VertexBuffer::init_skinned(
         const std::vector<VertexSkinned>& vertices,
         const std::vector<index_data_t>& indices,
-        dal::CommandPool& cmd_pool,
-        const VkQueue graphics_queue,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
+        dal::UploadManager& upload_man
     ) {
-        this->destroy(logi_device);
+        this->destroy(upload_man);
         this->m_index_size = indices.size();
 
-        std::tie(this->m_vertices, this->m_indices) = ::build_vertex_buffer(
+        std::tie(this->m_vertices, this->m_indices, this->m_upload_ticket) = ::build_vertex_buffer(
             vertices,
             indices,
-            cmd_pool,
-            graphics_queue,
-            phys_device,
-            logi_device
+            upload_man
         );
     }
 
-    void VertexBuffer::destroy(const VkDevice logi_device) {
-        this->m_vertices.destroy(logi_device);
-        this->m_indices.destroy(logi_device);
+    void VertexBuffer::destroy(dal::UploadManager& upload_man) {
+        if (this->is_ready())
+            upload_man.wait(this->m_upload_ticket);
+
+        this->m_vertices.destroy(upload_man.logi_device());
+        this->m_indices.destroy(upload_man.logi_device());
+        this->m_upload_ticket = UploadTicket{};
         this->m_index_size = 0;
     }
 
@@ -4,7 +4,7 @@
 
 #include "dal/util/model_data.h"
 #include "d_vulkan_header.h"
-#include "d_command.h"
+#include "d_upload.h"
 #include "d_buffer_memory.h"
 
 
@@ -20,37 +20,50 @@ namespace dal {
     using index_data_t = uint32_t;
 
 
+    // Part of a VertexBuffer which is shared by several meshes. Indices are relative to m_vertex_offset.
+    struct MeshRange {
+        uint32_t m_index_count = 0;
+        uint32_t m_first_index = 0;
+        int32_t m_vertex_offset = 0;
+    };
+
+
     class VertexBuffer {
 
     private:
         BufferMemory m_vertices, m_indices;
+        UploadTicket m_upload_ticket;
         uint32_t m_index_size = 0;
 
     public:
         void init_static(
             const std::vector<VertexStatic>& vertices,
             const std::vector<index_data_t>& indices,
-            dal::CommandPool& cmd_pool,
-            const VkQueue graphics_queue,
-            const VkPhysicalDevice phys_device,
-            const VkDevice logi_device
+            dal::UploadManager& upload_man
         );
 
         void init_skinned(
             const std::vector<VertexSkinned>& vertices,
             const std::vector<index_data_t>& indices,
-            dal::CommandPool& cmd_pool,
-            const VkQueue graphics_queue,
-            const VkPhysicalDevice phys_device,
-            const VkDevice logi_device
+            dal::UploadManager& upload_man
         );
 
-        void destroy(const VkDevice logi_device);
+        // Waits if upload is still in progress
+        void destroy(dal::UploadManager& upload_man);
 
+        // Buffers are created but GPU might still be copying into them. Check upload_ticket too.
         bool is_ready() const {
             return this->m_vertices.is_ready() && this->m_indices.is_ready();
         }
 
+        auto& upload_ticket() const {
+            return this->m_upload_ticket;
+        }
+
+        size_t memory_size() const {
+            return static_cast<size_t>(this->m_vertices.size() + this->m_indices.size());
+        }
+
         auto index_size() const {
             return this->m_index_size;
         }
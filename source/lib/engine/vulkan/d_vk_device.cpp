@@ -75,6 +75,22 @@ namespace dal {
         return this->m_features.depthClamp;
     }
 
+    bool PhysDeviceInfo::does_support_multi_draw_indirect() const {
+        return this->m_features.multiDrawIndirect;
+    }
+
+    bool PhysDeviceInfo::does_support_texture_compression_bc() const {
+        return this->m_features.textureCompressionBC;
+    }
+
+    bool PhysDeviceInfo::does_support_texture_compression_etc2() const {
+        return this->m_features.textureCompressionETC2;
+    }
+
+    bool PhysDeviceInfo::does_support_texture_compression_astc() const {
+        return this->m_features.textureCompressionASTC_LDR;
+    }
+
     bool PhysDeviceInfo::is_usable() const {
         if (!this->does_support_all_extensions( dal::PHYS_DEVICE_EXTENSIONS.begin(), dal::PHYS_DEVICE_EXTENSIONS.end() ))
             return false;
@@ -181,6 +197,10 @@ namespace dal {
                 dalInfo(fmt::format(" * {} ({}): {}", info.name(), info.device_type_str(), this_score).c_str());
                 dalInfo(fmt::format(" * Depth clamp: {}", info.does_support_depth_clamp()).c_str());
                 dalInfo(fmt::format(" * Anisotropic sampling: {}", info.does_support_anisotropic_sampling()).c_str());
+                dalInfo(fmt::format(" * Multi draw indirect: {}", info.does_support_multi_draw_indirect()).c_str());
+                dalInfo(fmt::format(" * Texture compression BC: {}", info.does_support_texture_compression_bc()).c_str());
+                dalInfo(fmt::format(" * Texture compression ETC2: {}", info.does_support_texture_compression_etc2()).c_str());
+                dalInfo(fmt::format(" * Texture compression ASTC: {}", info.does_support_texture_compression_astc()).c_str());
             }
         }
 
@@ -197,12 +217,14 @@ namespace dal {
         std::swap(this->m_handle, other.m_handle);
         std::swap(this->m_graphics_queue, other.m_graphics_queue);
         std::swap(this->m_present_queue, other.m_present_queue);
+        std::swap(this->m_transfer_queue, other.m_transfer_queue);
     }
 
     LogicalDevice& LogicalDevice::operator=(LogicalDevice&& other) noexcept {
         std::swap(this->m_handle, other.m_handle);
         std::swap(this->m_graphics_queue, other.m_graphics_queue);
         std::swap(this->m_present_queue, other.m_present_queue);
+        std::swap(this->m_transfer_queue, other.m_transfer_queue);
         return *this;
     }
 
@@ -216,7 +238,11 @@ namespace dal {
         // Create vulkan device
         {
             std::vector<VkDeviceQueueCreateInfo> create_info_queues;
-            std::set<uint32_t> unique_queue_families{ this->indices().graphics_family(), this->indices().present_family() };
+            std::set<uint32_t> unique_queue_families{
+                this->indices().graphics_family(),
+                this->indices().present_family(),
+                this->indices().transfer_family(),
+            };
             const float queuePriority = 1;
 
             for ( const auto queue_family : unique_queue_families ) {
@@ -231,6 +257,10 @@ namespace dal {
             VkPhysicalDeviceFeatures device_features{};
             device_features.samplerAnisotropy = phys_info.does_support_anisotropic_sampling();
             device_features.depthClamp = phys_info.does_support_depth_clamp();
+            device_features.multiDrawIndirect = phys_info.does_support_multi_draw_indirect();
+            device_features.textureCompressionBC = phys_info.does_support_texture_compression_bc();
+            device_features.textureCompressionETC2 = phys_info.does_support_texture_compression_etc2();
+            device_features.textureCompressionASTC_LDR = phys_info.does_support_texture_compression_astc();
 
             VkDeviceCreateInfo create_info_device{};
             create_info_device.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -250,6 +280,7 @@ namespace dal {
 
         vkGetDeviceQueue(this->m_handle, this->indices().graphics_family(), 0, &this->m_graphics_queue);
         vkGetDeviceQueue(this->m_handle, this->indices().present_family(), 0, &this->m_present_queue);
+        vkGetDeviceQueue(this->m_handle, this->indices().transfer_family(), 0, &this->m_transfer_queue);
     }
 
     void LogicalDevice::destroy() {
@@ -42,6 +42,14 @@ namespace dal {
 
         bool does_support_depth_clamp() const;
 
+        bool does_support_multi_draw_indirect() const;
+
+        bool does_support_texture_compression_bc() const;
+
+        bool does_support_texture_compression_etc2() const;
+
+        bool does_support_texture_compression_astc() const;
+
         bool is_usable() const;
 
         unsigned calc_score() const;
@@ -101,6 +109,7 @@ namespace dal {
         VkDevice m_handle = VK_NULL_HANDLE;
         VkQueue m_graphics_queue = VK_NULL_HANDLE;
         VkQueue m_present_queue = VK_NULL_HANDLE;
+        VkQueue m_transfer_queue = VK_NULL_HANDLE;
 
     public:
         LogicalDevice() = default;
@@ -136,6 +145,11 @@ namespace dal {
             return this->m_present_queue;
         }
 
+        // Same as graphics queue if there is no dedicated transfer queue family
+        auto& queue_transfer() const {
+            return this->m_transfer_queue;
+        }
+
     };
 
 }
@@ -1,5 +1,8 @@
 #include "d_vk_managers.h"
 
+#include <cmath>
+#include <algorithm>
+
 #include <fmt/format.h>
 
 #include "dal/util/logger.h"
@@ -23,6 +26,121 @@ namespace {
         return std::make_pair(viewport, scissor);
     }
 
+    // For pipelines which take viewport and scissor as dynamic states
+    void set_viewport_scissor(const VkCommandBuffer cmd_buf, const VkExtent2D& extent) {
+        const auto [viewport, scissor] = ::create_info_viewport_scissor(extent);
+        vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
+        vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+    }
+
+    void bind_vert_buffer(const VkCommandBuffer cmd_buf, const dal::VertexBuffer& vert_buffer) {
+        const std::array<VkBuffer, 1> vert_bufs{ vert_buffer.vertex_buffer() };
+        const std::array<VkDeviceSize, 1> vert_offsets{ 0 };
+        vkCmdBindVertexBuffers(cmd_buf, 0, vert_bufs.size(), vert_bufs.data(), vert_offsets.data());
+        vkCmdBindIndexBuffer(cmd_buf, vert_buffer.index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    void draw_mesh(const VkCommandBuffer cmd_buf, const dal::MeshRange& mesh) {
+        vkCmdDrawIndexed(cmd_buf, mesh.m_index_count, 1, mesh.m_first_index, mesh.m_vertex_offset, 0);
+    }
+
+    static_assert(sizeof(dal::DrawIndexedCmd) == sizeof(VkDrawIndexedIndirectCommand));
+
+    void draw_indirect(
+        const VkCommandBuffer cmd_buf,
+        const VkBuffer indirect_cmd_buffer,
+        const dal::IndirectBatch& batch,
+        const bool multi_draw_indirect
+    ) {
+        constexpr uint32_t STRIDE = sizeof(dal::DrawIndexedCmd);
+        const VkDeviceSize first_offset = static_cast<VkDeviceSize>(batch.m_first_cmd) * STRIDE;
+
+        if (multi_draw_indirect) {
+            vkCmdDrawIndexedIndirect(cmd_buf, indirect_cmd_buffer, first_offset, batch.m_cmd_count, STRIDE);
+        }
+        else {
+            // drawCount must be 0 or 1 without the feature
+            for (uint32_t i = 0; i < batch.m_cmd_count; ++i)
+                vkCmdDrawIndexedIndirect(cmd_buf, indirect_cmd_buffer, first_offset + i * STRIDE, 1, STRIDE);
+        }
+    }
+
+    template <typename T>
+    void remove_expired(std::vector<std::weak_ptr<T>>& handles) {
+        handles.erase(
+            std::remove_if(handles.begin(), handles.end(), [](const auto& x) { return x.expired(); }),
+            handles.end()
+        );
+    }
+
+}
+
+
+// Levels of detail
+namespace {
+
+    // Geometric error of a level may cover this many pixels on screen with zero bias
+    constexpr float MAX_LOD_ERROR_PIXELS = 1;
+
+    // Coarsest level whose error stays within allowed pixels
+    uint32_t select_lod(const dal::RenderUnit& unit, const float radius_in_pixels, const float bias) {
+        const auto allowed_pixels = ::MAX_LOD_ERROR_PIXELS * std::exp2(bias);
+        uint32_t output = 0;
+
+        for (uint32_t i = 1; i < unit.lod_count(); ++i) {
+            if (unit.error_at_lod(i) * radius_in_pixels > allowed_pixels)
+                break;
+
+            output = i;
+        }
+
+        return output;
+    }
+
+    template <typename _RenderPair>
+    void select_lods(_RenderPair& pair, const glm::vec3& view_pos, const dal::LodParams& params) {
+        const auto& units = pair.m_model->render_units();
+        pair.m_lods.resize(pair.m_actors.size() * units.size());
+        pair.m_shadow_lods.resize(pair.m_actors.size() * units.size());
+
+        for (size_t i = 0; i < pair.m_actors.size(); ++i) {
+            const auto& transform = pair.m_actors[i]->m_transform;
+            const auto model_mat = transform.make_mat4();
+
+            for (size_t j = 0; j < units.size(); ++j) {
+                const auto radius_in_pixels = dal::project_bounds(units[j], model_mat, transform.m_scale, view_pos, params.m_pixels_per_unit_at_unit_dist).radius_in_pixels();
+                pair.m_lods[i * units.size() + j] = ::select_lod(units[j], radius_in_pixels, params.m_bias);
+                pair.m_shadow_lods[i * units.size() + j] = ::select_lod(units[j], radius_in_pixels, params.m_shadow_bias);
+            }
+        }
+    }
+
+    // Shadow passes draw every opaque unit of an actor with the same states, so an actor is one batch.
+    // An actor whose levels are same as the previous one's reuses its batch.
+    template <typename _RenderPair>
+    void build_shadow_batches(dal::IndirectDrawBuilder& builder, _RenderPair& pair) {
+        const auto& units = pair.m_model->render_units();
+        pair.m_shadow_batches.clear();
+
+        for (size_t i = 0; i < pair.m_actors.size(); ++i) {
+            const auto lods = pair.m_shadow_lods.begin() + i * units.size();
+
+            if (i > 0 && std::equal(lods, lods + units.size(), lods - units.size())) {
+                pair.m_shadow_batches.push_back(pair.m_shadow_batches.back());
+                continue;
+            }
+
+            builder.begin_batch();
+
+            for (size_t j = 0; j < units.size(); ++j) {
+                const auto& mesh = units[j].mesh_at_lod(lods[j]);
+                builder.push(mesh.m_index_count, mesh.m_first_index, mesh.m_vertex_offset);
+            }
+
+            pair.m_shadow_batches.push_back(builder.end_batch());
+        }
+    }
+
 }
 
 
@@ -39,143 +157,190 @@ namespace dal {
 
     void VulkanResourceManager::destroy() {
         for (auto& x : this->m_textures) {
-            x->destroy();
-            x->clear_dependencies();
+            if (auto tex = x.lock()) {
+                tex->destroy();
+                tex->clear_dependencies();
+            }
         }
         this->m_textures.clear();
 
         for (auto& x : this->m_models) {
-            x->destroy();
-            x->clear_dependencies();
+            if (auto model = x.lock()) {
+                model->destroy();
+                model->clear_dependencies();
+            }
         }
         this->m_models.clear();
 
         for (auto& x : this->m_skinned_models) {
-            x->destroy();
+            if (auto model = x.lock())
+                model->destroy();
         }
         this->m_skinned_models.clear();
 
         for (auto& x : this->m_actors) {
-            x->destroy();
-            x->clear_dependencies();
+            if (auto actor = x.lock()) {
+                actor->destroy();
+                actor->clear_dependencies();
+            }
         }
         this->m_actors.clear();
 
         for (auto& x : this->m_skinned_actors) {
-            x->destroy();
-            x->clear_dependencies();
+            if (auto actor = x.lock()) {
+                actor->destroy();
+                actor->clear_dependencies();
+            }
         }
         this->m_skinned_actors.clear();
     }
 
     HTexture VulkanResourceManager::create_texture(
-        dal::CommandPool& cmd_pool,
-        const VkQueue graphics_queue,
-        const VkPhysicalDevice phys_device,
-        const VkDevice logi_device
+        dal::UploadManager& upload_man
     ) {
-        this->m_textures.push_back(std::make_shared<TextureProxy>());
-        auto& tex = this->m_textures.back();
-        tex->give_dependencies(cmd_pool, graphics_queue, phys_device, logi_device);
+        auto tex = std::make_shared<TextureProxy>();
+        tex->give_dependencies(upload_man);
+
+        ::remove_expired(this->m_textures);
+        this->m_textures.push_back(tex);
         return tex;
     }
 
     HMesh VulkanResourceManager::create_mesh(
-        dal::CommandPool& cmd_pool,
+        dal::UploadManager& upload_man,
         const VkPhysicalDevice phys_device,
         const dal::LogicalDevice& logi_device
     ) {
-        this->m_meshes.push_back(std::make_shared<MeshProxy>());
-        auto& mesh = this->m_meshes.back();
-        mesh->give_dependencies(cmd_pool, phys_device, logi_device);
+        auto mesh = std::make_shared<MeshProxy>();
+        mesh->give_dependencies(upload_man, phys_device, logi_device);
+
+        ::remove_expired(this->m_meshes);
+        this->m_meshes.push_back(mesh);
         return mesh;
     }
 
     HRenModel VulkanResourceManager::create_model(
-        CommandPool&                  cmd_pool,
+        UploadManager&                upload_man,
         ITextureManager&              tex_man,
         DescLayout_PerActor const&    layout_per_actor,
         DescLayout_PerMaterial const& layout_per_material,
         SamplerTexture const&         sampler,
-        VkQueue                       graphics_queue,
         VkPhysicalDevice              phys_device,
         VkDevice                      logi_device
     ) {
-        this->m_models.push_back(std::make_shared<ModelProxy>());
-        auto& model = this->m_models.back();
+        auto model = std::make_shared<ModelProxy>();
 
         model->give_dependencies(
-            cmd_pool,
+            upload_man,
             tex_man,
             layout_per_actor,
             layout_per_material,
             sampler,
-            graphics_queue,
             phys_device,
             logi_device
         );
 
+        ::remove_expired(this->m_models);
+        this->m_models.push_back(model);
         return model;
     }
 
     HRenModelSkinned VulkanResourceManager::create_model_skinned(
-        CommandPool&                  cmd_pool,
+        UploadManager&                upload_man,
         ITextureManager&              tex_man,
         DescLayout_PerActor const&    layout_per_actor,
         DescLayout_PerMaterial const& layout_per_material,
         SamplerTexture const&         sampler,
-        VkQueue                       graphics_queue,
         VkPhysicalDevice              phys_device,
         VkDevice                      logi_device
     ) {
-        this->m_skinned_models.push_back(std::make_shared<ModelSkinnedProxy>());
-        auto& model = this->m_skinned_models.back();
+        auto model = std::make_shared<ModelSkinnedProxy>();
 
         model->give_dependencies(
-            cmd_pool,
+            upload_man,
             tex_man,
             layout_per_actor,
             layout_per_material,
             sampler,
-            graphics_queue,
             phys_device,
             logi_device
         );
 
+        ::remove_expired(this->m_skinned_models);
+        this->m_skinned_models.push_back(model);
         return model;
     }
 
-    HActor VulkanResourceManager::create_actor(
-        DescAllocator& desc_allocator,
-        const DescLayout_PerActor& desc_layout,
-        VkPhysicalDevice phys_device,
-        VkDevice logi_device
-    ) {
-        this->m_actors.push_back(std::make_shared<ActorProxy>());
-        auto& actor = this->m_actors.back();
-        actor->give_dependencies(desc_allocator, desc_layout, phys_device, logi_device);
+    HActor VulkanResourceManager::create_actor(UniformRingBuffer& ubuf_ring) {
+        auto actor = std::make_shared<ActorProxy>();
+        actor->give_dependencies(ubuf_ring);
+
+        ::remove_expired(this->m_actors);
+        this->m_actors.push_back(actor);
         return actor;
     }
 
-    HActorSkinned VulkanResourceManager::create_actor_skinned(
-        DescAllocator& desc_allocator,
-        const DescLayout_ActorAnimated& desc_layout,
-        VkPhysicalDevice phys_device,
-        VkDevice logi_device
-    ) {
-        this->m_skinned_actors.push_back(std::make_shared<ActorSkinnedProxy>());
-        auto& actor = this->m_skinned_actors.back();
-        actor->give_dependencies(desc_allocator, desc_layout, phys_device, logi_device);
+    HActorSkinned VulkanResourceManager::create_actor_skinned(UniformRingBuffer& ubuf_ring) {
+        auto actor = std::make_shared<ActorSkinnedProxy>();
+        actor->give_dependencies(ubuf_ring);
+
+        ::remove_expired(this->m_skinned_actors);
+        this->m_skinned_actors.push_back(actor);
         return actor;
     }
 
+    void VulkanResourceManager::register_texture(const HTexture& texture) {
+        auto proxy = std::dynamic_pointer_cast<TextureProxy>(texture);
+        dalAssert(nullptr != proxy);
+
+        for (auto& x : this->m_textures) {
+            if (x.lock() == proxy)
+                return;
+        }
+
+        ::remove_expired(this->m_textures);
+        this->m_textures.push_back(proxy);
+    }
+
+}
+
+
+// Screen projection
+namespace dal {
+
+    float calc_pixels_per_unit_at_unit_dist(const float fov, const uint32_t screen_height) {
+        return static_cast<float>(screen_height) / (2 * std::tan(fov * 0.5f));
+    }
+
+    ProjectedBounds project_bounds(
+        const RenderUnit& unit,
+        const glm::mat4& model_mat,
+        const float scale,
+        const glm::vec3& view_pos,
+        const float pixels_per_unit_at_unit_dist
+    ) {
+        // Camera inside bounding sphere would get infinite size
+        constexpr float MIN_DISTANCE = 0.1f;
+
+        const auto aabb_center = (unit.m_aabb_min + unit.m_aabb_max) * 0.5f;
+        const auto world_center = glm::vec3{ model_mat * glm::vec4{ aabb_center, 1 } };
+
+        ProjectedBounds output;
+        output.m_radius = glm::length(unit.m_aabb_max - unit.m_aabb_min) * 0.5f * scale;
+
+        const auto distance = std::max(glm::distance(view_pos, world_center) - output.m_radius, MIN_DISTANCE);
+        output.m_pixels_per_unit = pixels_per_unit_at_unit_dist / distance;
+
+        return output;
+    }
+
 }
 
 
 // RenderListVK
 namespace dal {
 
-    void RenderListVK::apply(dal::Scene& scene, const glm::vec3& view_pos) {
+    void RenderListVK::apply(dal::Scene& scene, const glm::vec3& view_pos, const LodParams& lod_params) {
         {
             auto view = scene.m_registry.view<cpnt::ActorStatic>();
 
@@ -204,34 +369,42 @@ namespace dal {
             });
         }
 
-        for (const auto& pair : this->m_static_models) {
+        for (auto& pair : this->m_static_models) {
+            ::select_lods(pair, view_pos, lod_params);
+
             for (const auto actor : pair.m_actors) {
                 const auto actor_transform = actor->m_transform.make_mat4();
 
                 for (const auto& unit : pair.m_model->render_units_alpha()) {
                     const auto unit_world_pos = actor_transform * glm::vec4(unit.m_weight_center, 1);
                     const auto to_view = view_pos - glm::vec3(unit_world_pos);
+                    const auto radius_in_pixels = dal::project_bounds(unit, actor_transform, actor->m_transform.m_scale, view_pos, lod_params.m_pixels_per_unit_at_unit_dist).radius_in_pixels();
 
                     auto& dst = this->m_static_alpha_models.emplace_back();
                     dst.m_unit = &unit;
                     dst.m_actor = actor;
                     dst.m_distance_sqr = glm::dot(to_view, to_view);
+                    dst.m_lod = ::select_lod(unit, radius_in_pixels, lod_params.m_bias);
                 }
             }
         }
 
-        for (const auto& pair : this->m_skinned_models) {
+        for (auto& pair : this->m_skinned_models) {
+            ::select_lods(pair, view_pos, lod_params);
+
             for (const auto actor : pair.m_actors) {
                 const auto actor_transform = actor->m_transform.make_mat4();
 
                 for (const auto& unit : pair.m_model->render_units_alpha()) {
                     const auto unit_world_pos = actor_transform * glm::vec4(unit.m_weight_center, 1);
                     const auto to_view = view_pos - glm::vec3(unit_world_pos);
+                    const auto radius_in_pixels = dal::project_bounds(unit, actor_transform, actor->m_transform.m_scale, view_pos, lod_params.m_pixels_per_unit_at_unit_dist).radius_in_pixels();
 
                     auto& dst = this->m_skinned_alpha_models.emplace_back();
                     dst.m_unit = &unit;
                     dst.m_actor = actor;
                     dst.m_distance_sqr = glm::dot(to_view, to_view);
+                    dst.m_lod = ::select_lod(unit, radius_in_pixels, lod_params.m_bias);
                 }
             }
         }
@@ -239,6 +412,14 @@ namespace dal {
         std::sort(this->m_static_alpha_models.begin(), this->m_static_alpha_models.end());
         std::sort(this->m_skinned_alpha_models.begin(), this->m_skinned_alpha_models.end());
 
+        this->m_indirect_cmds.clear();
+
+        for (auto& pair : this->m_static_models)
+            ::build_shadow_batches(this->m_indirect_cmds, pair);
+
+        for (auto& pair : this->m_skinned_models)
+            ::build_shadow_batches(this->m_indirect_cmds, pair);
+
         this->m_plights = scene.m_plights;
         this->m_slights = scene.m_slights;
         this->m_dlight = scene.m_selected_dlight;
@@ -342,7 +523,10 @@ namespace dal {
         const dal::PlanarReflectionManager& reflection_mgr,
 
         const VkExtent2D& swapchain_extent,
+        const dal::UbufOffsetsPerGlobal& ubuf_offsets_global,
         const VkDescriptorSet desc_set_per_frame,
+        const VkDescriptorSet desc_set_per_actor,
+        const VkDescriptorSet desc_set_actor_animated,
         const VkDescriptorSet desc_set_composition,
         const dal::ShaderPipeline& pipeline_gbuf,
         const dal::ShaderPipeline& pipeline_gbuf_animated,
@@ -376,6 +560,11 @@ namespace dal {
         render_pass_info.pClearValues = clear_colors.data();
 
         vkCmdBeginRenderPass(cmd_buf, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+        ::set_viewport_scissor(cmd_buf, swapchain_extent);
+
+        // Dynamic offsets are in binding order
+        const std::array<uint32_t, 2> global_offsets{ ubuf_offsets_global.m_camera, ubuf_offsets_global.m_global_light };
+        const std::array<uint32_t, 2> composition_offsets{ ubuf_offsets_global.m_global_light, ubuf_offsets_global.m_camera };
 
         // Gbuf of static models
         {
@@ -383,45 +572,46 @@ namespace dal {
 
             vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline());
 
-            std::array<VkDeviceSize, 1> vert_offsets{ 0 };
-
             vkCmdBindDescriptorSets(
                 cmd_buf,
                 VK_PIPELINE_BIND_POINT_GRAPHICS,
                 pipeline.layout(),
                 0,
                 1, &desc_set_per_frame,
-                0, nullptr
+                global_offsets.size(), global_offsets.data()
             );
 
             for (auto& render_pair : render_list.m_static_models) {
-                for (auto& unit : render_pair.m_model->render_units()) {
-                    dalAssert(!unit.m_material.m_alpha_blend);
+                ::bind_vert_buffer(cmd_buf, render_pair.m_model->vertex_buffer());
+
+                const auto& units = render_pair.m_model->render_units();
 
-                    std::array<VkBuffer, 1> vert_bufs{ unit.m_vert_buffer.vertex_buffer() };
-                    vkCmdBindVertexBuffers(cmd_buf, 0, vert_bufs.size(), vert_bufs.data(), vert_offsets.data());
-                    vkCmdBindIndexBuffer(cmd_buf, unit.m_vert_buffer.index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+                for (size_t i = 0; i < units.size(); ++i) {
+                    auto& unit = units[i];
+                    dalAssert(!unit.m_material.m_alpha_blend);
 
                     vkCmdBindDescriptorSets(
                         cmd_buf,
                         VK_PIPELINE_BIND_POINT_GRAPHICS,
                         pipeline.layout(),
                         1,
-                        1, &unit.m_material.m_descset.get(),
+                        1, &unit.m_material.descset_at(flight_frame_index).get(),
                         0, nullptr
                     );
 
-                    for (auto& actor : render_pair.m_actors) {
+                    for (size_t j = 0; j < render_pair.m_actors.size(); ++j) {
+                        auto& actor = render_pair.m_actors[j];
+                        const uint32_t offset = actor->ubuf_offset_at(flight_frame_index);
                         vkCmdBindDescriptorSets(
                             cmd_buf,
                             VK_PIPELINE_BIND_POINT_GRAPHICS,
                             pipeline.layout(),
                             2,
-                            1, &actor->desc_set_at(flight_frame_index),
-                            0, nullptr
+                            1, &desc_set_per_actor,
+                            1, &offset
                         );
 
-                        vkCmdDrawIndexed(cmd_buf, unit.m_vert_buffer.index_size(), 1, 0, 0, 0);
+                        ::draw_mesh(cmd_buf, unit.mesh_at_lod(render_pair.lod_at(j, i)));
                     }
                 }
             }
@@ -433,45 +623,46 @@ namespace dal {
 
             vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline());
 
-            std::array<VkDeviceSize, 1> vert_offsets{ 0 };
-
             vkCmdBindDescriptorSets(
                 cmd_buf,
                 VK_PIPELINE_BIND_POINT_GRAPHICS,
                 pipeline.layout(),
                 0,
                 1, &desc_set_per_frame,
-                0, nullptr
+                global_offsets.size(), global_offsets.data()
             );
 
             for (auto& render_pair : render_list.m_skinned_models) {
-                for (auto& unit : render_pair.m_model->render_units()) {
-                    dalAssert(!unit.m_material.m_alpha_blend);
+                ::bind_vert_buffer(cmd_buf, render_pair.m_model->vertex_buffer());
+
+                const auto& units = render_pair.m_model->render_units();
 
-                    std::array<VkBuffer, 1> vert_bufs{ unit.m_vert_buffer.vertex_buffer() };
-                    vkCmdBindVertexBuffers(cmd_buf, 0, vert_bufs.size(), vert_bufs.data(), vert_offsets.data());
-                    vkCmdBindIndexBuffer(cmd_buf, unit.m_vert_buffer.index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+                for (size_t i = 0; i < units.size(); ++i) {
+                    auto& unit = units[i];
+                    dalAssert(!unit.m_material.m_alpha_blend);
 
                     vkCmdBindDescriptorSets(
                         cmd_buf,
                         VK_PIPELINE_BIND_POINT_GRAPHICS,
                         pipeline.layout(),
                         1,
-                        1, &unit.m_material.m_descset.get(),
+                        1, &unit.m_material.descset_at(flight_frame_index).get(),
                         0, nullptr
                     );
 
-                    for (auto& actor : render_pair.m_actors) {
+                    for (size_t j = 0; j < render_pair.m_actors.size(); ++j) {
+                        auto& actor = render_pair.m_actors[j];
+                        auto& offsets = actor->ubuf_offsets_at(flight_frame_index);
                         vkCmdBindDescriptorSets(
                             cmd_buf,
                             VK_PIPELINE_BIND_POINT_GRAPHICS,
                             pipeline.layout(),
                             2,
-                            1, &actor->desc_set_at(flight_frame_index),
-                            0, nullptr
+                            1, &desc_set_actor_animated,
+                            offsets.size(), offsets.data()
                         );
 
-                        vkCmdDrawIndexed(cmd_buf, unit.m_vert_buffer.index_size(), 1, 0, 0, 0);
+                        ::draw_mesh(cmd_buf, unit.mesh_at_lod(render_pair.lod_at(j, i)));
                     }
                 }
             }
@@ -490,7 +681,7 @@ namespace dal {
                 pipeline.layout(),
                 0,
                 1, &desc_set_composition,
-                0, nullptr
+                composition_offsets.size(), composition_offsets.data()
             );
 
             vkCmdDraw(cmd_buf, 6, 1, 0, 0);
@@ -602,6 +793,7 @@ namespace dal {
         render_pass_info.pClearValues = clear_colors.data();
 
         vkCmdBeginRenderPass(cmd_buf, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+        ::set_viewport_scissor(cmd_buf, extent);
         {
             vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_final.pipeline());
 
@@ -632,7 +824,10 @@ namespace dal {
         const glm::vec3& view_pos,
 
         const VkExtent2D& swapchain_extent,
+        const dal::UbufOffsetsPerGlobal& ubuf_offsets_global,
         const VkDescriptorSet desc_set_per_global,
+        const VkDescriptorSet desc_set_per_actor,
+        const VkDescriptorSet desc_set_actor_animated,
         const VkDescriptorSet desc_set_composition,
         const dal::ShaderPipeline& pipeline_alpha,
         const dal::ShaderPipeline& pipeline_alpha_animated,
@@ -665,47 +860,53 @@ namespace dal {
         render_pass_info.pClearValues = clear_colors.data();
 
         vkCmdBeginRenderPass(cmd_buf, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+        ::set_viewport_scissor(cmd_buf, swapchain_extent);
+
+        const std::array<uint32_t, 2> global_offsets{ ubuf_offsets_global.m_camera, ubuf_offsets_global.m_global_light };
 
         {
             auto& pipeline = pipeline_alpha;
 
             vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline());
 
-            std::array<VkDeviceSize, 1> vert_offsets{ 0 };
-
             vkCmdBindDescriptorSets(
                 cmd_buf,
                 VK_PIPELINE_BIND_POINT_GRAPHICS,
                 pipeline.layout(),
                 0,
                 1, &desc_set_per_global,
-                0, nullptr
+                global_offsets.size(), global_offsets.data()
             );
 
+            // Sorted by distance so units of the same model are often adjacent
+            const VertexBuffer* bound_vert_buffer = nullptr;
+
             for (auto& render_tuple : render_list.m_static_alpha_models) {
-                std::array<VkBuffer, 1> vert_bufs{ render_tuple.m_unit->m_vert_buffer.vertex_buffer() };
-                vkCmdBindVertexBuffers(cmd_buf, 0, vert_bufs.size(), vert_bufs.data(), vert_offsets.data());
-                vkCmdBindIndexBuffer(cmd_buf, render_tuple.m_unit->m_vert_buffer.index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+                if (bound_vert_buffer != render_tuple.m_unit->m_vert_buffer) {
+                    bound_vert_buffer = render_tuple.m_unit->m_vert_buffer;
+                    ::bind_vert_buffer(cmd_buf, *bound_vert_buffer);
+                }
 
                 vkCmdBindDescriptorSets(
                     cmd_buf,
                     VK_PIPELINE_BIND_POINT_GRAPHICS,
                     pipeline.layout(),
                     1,
-                    1, &render_tuple.m_unit->m_material.m_descset.get(),
+                    1, &render_tuple.m_unit->m_material.descset_at(flight_frame_index).get(),
                     0, nullptr
                 );
 
+                const uint32_t offset = render_tuple.m_actor->ubuf_offset_at(flight_frame_index);
                 vkCmdBindDescriptorSets(
                     cmd_buf,
                     VK_PIPELINE_BIND_POINT_GRAPHICS,
                     pipeline.layout(),
                     2,
-                    1, &render_tuple.m_actor->desc_set_at(flight_frame_index),
-                    0, nullptr
+                    1, &desc_set_per_actor,
+                    1, &offset
                 );
 
-                vkCmdDrawIndexed(cmd_buf, render_tuple.m_unit->m_vert_buffer.index_size(), 1, 0, 0, 0);
+                ::draw_mesh(cmd_buf, render_tuple.m_unit->mesh_at_lod(render_tuple.m_lod));
             }
         }
 
@@ -714,41 +915,44 @@ namespace dal {
 
             vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline());
 
-            std::array<VkDeviceSize, 1> vert_offsets{ 0 };
-
             vkCmdBindDescriptorSets(
                 cmd_buf,
                 VK_PIPELINE_BIND_POINT_GRAPHICS,
                 pipeline.layout(),
                 0,
                 1, &desc_set_per_global,
-                0, nullptr
+                global_offsets.size(), global_offsets.data()
             );
 
+            // Sorted by distance so units of the same model are often adjacent
+            const VertexBuffer* bound_vert_buffer = nullptr;
+
             for (auto& render_tuple : render_list.m_skinned_alpha_models) {
-                std::array<VkBuffer, 1> vert_bufs{ render_tuple.m_unit->m_vert_buffer.vertex_buffer() };
-                vkCmdBindVertexBuffers(cmd_buf, 0, vert_bufs.size(), vert_bufs.data(), vert_offsets.data());
-                vkCmdBindIndexBuffer(cmd_buf, render_tuple.m_unit->m_vert_buffer.index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+                if (bound_vert_buffer != render_tuple.m_unit->m_vert_buffer) {
+                    bound_vert_buffer = render_tuple.m_unit->m_vert_buffer;
+                    ::bind_vert_buffer(cmd_buf, *bound_vert_buffer);
+                }
 
                 vkCmdBindDescriptorSets(
                     cmd_buf,
                     VK_PIPELINE_BIND_POINT_GRAPHICS,
                     pipeline.layout(),
                     1,
-                    1, &render_tuple.m_unit->m_material.m_descset.get(),
+                    1, &render_tuple.m_unit->m_material.descset_at(flight_frame_index).get(),
                     0, nullptr
                 );
 
+                auto& offsets = render_tuple.m_actor->ubuf_offsets_at(flight_frame_index);
                 vkCmdBindDescriptorSets(
                     cmd_buf,
                     VK_PIPELINE_BIND_POINT_GRAPHICS,
                     pipeline.layout(),
                     2,
-                    1, &render_tuple.m_actor->desc_set_at(flight_frame_index),
-                    0, nullptr
+                    1, &desc_set_actor_animated,
+                    offsets.size(), offsets.data()
                 );
 
-                vkCmdDrawIndexed(cmd_buf, render_tuple.m_unit->m_vert_buffer.index_size(), 1, 0, 0, 0);
+                ::draw_mesh(cmd_buf, render_tuple.m_unit->mesh_at_lod(render_tuple.m_lod));
             }
         }
 
@@ -767,6 +971,9 @@ namespace dal {
         const glm::mat4& light_mat,
 
         const VkExtent2D& shadow_map_extent,
+        const VkDescriptorSet desc_set_actor_animated,
+        const VkBuffer indirect_cmd_buffer,
+        const bool multi_draw_indirect,
         const dal::ShaderPipeline& pipeline_shadow,
         const dal::ShaderPipeline& pipeline_shadow_animated,
         const dal::Fbuf_Shadow& fbuf,
@@ -798,28 +1005,24 @@ namespace dal {
             auto& pipeline = pipeline_shadow;
             vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline());
 
-            const auto [viewport, scissor] = ::create_info_viewport_scissor(shadow_map_extent);
-            vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
-            vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
-
-            std::array<VkDeviceSize, 1> vert_offsets{ 0 };
+            ::set_viewport_scissor(cmd_buf, shadow_map_extent);
 
             for (auto& render_tuple : render_list.m_static_models) {
-                auto& model = *render_tuple.m_model;
+                if (render_tuple.m_model->render_units().empty())
+                    continue;
 
-                for (auto& unit : model.render_units()) {
-                    std::array<VkBuffer, 1> vert_bufs{ unit.m_vert_buffer.vertex_buffer() };
-                    vkCmdBindVertexBuffers(cmd_buf, 0, vert_bufs.size(), vert_bufs.data(), vert_offsets.data());
-                    vkCmdBindIndexBuffer(cmd_buf, unit.m_vert_buffer.index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+                ::bind_vert_buffer(cmd_buf, render_tuple.m_model->vertex_buffer());
 
-                    for (auto& actor : render_tuple.m_actors) {
-                        U_PC_Shadow pc_data;
-                        pc_data.m_model_mat = actor->m_transform.make_mat4();
-                        pc_data.m_light_mat = light_mat;
-                        vkCmdPushConstants(cmd_buf, pipeline.layout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(U_PC_Shadow), &pc_data);
+                for (size_t i = 0; i < render_tuple.m_actors.size(); ++i) {
+                    auto& actor = render_tuple.m_actors[i];
+                    auto& batch = render_tuple.m_shadow_batches[i];
 
-                        vkCmdDrawIndexed(cmd_buf, unit.m_vert_buffer.index_size(), 1, 0, 0, 0);
-                    }
+                    U_PC_Shadow pc_data;
+                    pc_data.m_model_mat = actor->m_transform.make_mat4();
+                    pc_data.m_light_mat = light_mat;
+                    vkCmdPushConstants(cmd_buf, pipeline.layout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(U_PC_Shadow), &pc_data);
+
+                    ::draw_indirect(cmd_buf, indirect_cmd_buffer, batch, multi_draw_indirect);
                 }
             }
         }
@@ -828,37 +1031,34 @@ namespace dal {
             auto& pipeline = pipeline_shadow_animated;
             vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline());
 
-            const auto [viewport, scissor] = ::create_info_viewport_scissor(shadow_map_extent);
-            vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
-            vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
-
-            std::array<VkDeviceSize, 1> vert_offsets{ 0 };
+            ::set_viewport_scissor(cmd_buf, shadow_map_extent);
 
             for (auto& render_tuple : render_list.m_skinned_models) {
-                auto& model = *render_tuple.m_model;
+                if (render_tuple.m_model->render_units().empty())
+                    continue;
 
-                for (auto& unit : model.render_units()) {
-                    std::array<VkBuffer, 1> vert_bufs{ unit.m_vert_buffer.vertex_buffer() };
-                    vkCmdBindVertexBuffers(cmd_buf, 0, vert_bufs.size(), vert_bufs.data(), vert_offsets.data());
-                    vkCmdBindIndexBuffer(cmd_buf, unit.m_vert_buffer.index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+                ::bind_vert_buffer(cmd_buf, render_tuple.m_model->vertex_buffer());
 
-                    for (auto& actor : render_tuple.m_actors) {
-                        U_PC_Shadow pc_data;
-                        pc_data.m_model_mat = actor->m_transform.make_mat4();
-                        pc_data.m_light_mat = light_mat;
-                        vkCmdPushConstants(cmd_buf, pipeline.layout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(U_PC_Shadow), &pc_data);
+                for (size_t i = 0; i < render_tuple.m_actors.size(); ++i) {
+                    auto& actor = render_tuple.m_actors[i];
+                    auto& batch = render_tuple.m_shadow_batches[i];
 
-                        vkCmdBindDescriptorSets(
-                            cmd_buf,
-                            VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            pipeline.layout(),
-                            0,
-                            1, &actor->desc_set_at(flight_frame_index),
-                            0, nullptr
-                        );
+                    U_PC_Shadow pc_data;
+                    pc_data.m_model_mat = actor->m_transform.make_mat4();
+                    pc_data.m_light_mat = light_mat;
+                    vkCmdPushConstants(cmd_buf, pipeline.layout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(U_PC_Shadow), &pc_data);
 
-                        vkCmdDrawIndexed(cmd_buf, unit.m_vert_buffer.index_size(), 1, 0, 0, 0);
-                    }
+                    auto& offsets = actor->ubuf_offsets_at(flight_frame_index);
+                    vkCmdBindDescriptorSets(
+                        cmd_buf,
+                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                        pipeline.layout(),
+                        0,
+                        1, &desc_set_actor_animated,
+                        offsets.size(), offsets.data()
+                    );
+
+                    ::draw_indirect(cmd_buf, indirect_cmd_buffer, batch, multi_draw_indirect);
                 }
             }
         }
@@ -877,6 +1077,8 @@ namespace dal {
 
         dal::U_PC_OnMirror push_constant,
         const VkExtent2D& extent,
+        const VkDescriptorSet desc_set_per_actor,
+        const VkDescriptorSet desc_set_actor_animated,
         const dal::ShaderPipeline& pipeline_on_mirror,
         const dal::ShaderPipeline& pipeline_on_mirror_animated,
         const dal::Fbuf_Simple& fbuf,
@@ -909,42 +1111,41 @@ namespace dal {
             auto& pipeline = pipeline_on_mirror;
             vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline());
 
-            const auto [viewport, scissor] = ::create_info_viewport_scissor(extent);
-            vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
-            vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+            ::set_viewport_scissor(cmd_buf, extent);
 
             vkCmdPushConstants(cmd_buf, pipeline.layout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(U_PC_OnMirror), &push_constant);
 
-            std::array<VkDeviceSize, 1> vert_offsets{ 0 };
-
             for (auto& render_tuple : render_list.m_static_models) {
                 auto& model = *render_tuple.m_model;
+                ::bind_vert_buffer(cmd_buf, model.vertex_buffer());
 
-                for (auto& unit : model.render_units()) {
-                    std::array<VkBuffer, 1> vert_bufs{ unit.m_vert_buffer.vertex_buffer() };
-                    vkCmdBindVertexBuffers(cmd_buf, 0, vert_bufs.size(), vert_bufs.data(), vert_offsets.data());
-                    vkCmdBindIndexBuffer(cmd_buf, unit.m_vert_buffer.index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+                const auto& units = model.render_units();
+
+                for (size_t i = 0; i < units.size(); ++i) {
+                    auto& unit = units[i];
 
                     vkCmdBindDescriptorSets(
                         cmd_buf,
                         VK_PIPELINE_BIND_POINT_GRAPHICS,
                         pipeline.layout(),
                         0,
-                        1, &unit.m_material.m_descset.get(),
+                        1, &unit.m_material.descset_at(flight_frame_index).get(),
                         0, nullptr
                     );
 
-                    for (auto& actor : render_tuple.m_actors) {
+                    for (size_t j = 0; j < render_tuple.m_actors.size(); ++j) {
+                        auto& actor = render_tuple.m_actors[j];
+                        const uint32_t offset = actor->ubuf_offset_at(flight_frame_index);
                         vkCmdBindDescriptorSets(
                             cmd_buf,
                             VK_PIPELINE_BIND_POINT_GRAPHICS,
                             pipeline.layout(),
                             1,
-                            1, &actor->desc_set_at(flight_frame_index),
-                            0, nullptr
+                            1, &desc_set_per_actor,
+                            1, &offset
                         );
 
-                        vkCmdDrawIndexed(cmd_buf, unit.m_vert_buffer.index_size(), 1, 0, 0, 0);
+                        ::draw_mesh(cmd_buf, unit.mesh_at_lod(render_tuple.lod_at(j, i)));
                     }
                 }
             }
@@ -954,42 +1155,41 @@ namespace dal {
             auto& pipeline = pipeline_on_mirror_animated;
             vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline());
 
-            const auto [viewport, scissor] = ::create_info_viewport_scissor(extent);
-            vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
-            vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+            ::set_viewport_scissor(cmd_buf, extent);
 
             vkCmdPushConstants(cmd_buf, pipeline.layout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(U_PC_OnMirror), &push_constant);
 
-            std::array<VkDeviceSize, 1> vert_offsets{ 0 };
-
             for (auto& render_tuple : render_list.m_skinned_models) {
                 auto& model = *render_tuple.m_model;
+                ::bind_vert_buffer(cmd_buf, model.vertex_buffer());
 
-                for (auto& unit : model.render_units()) {
-                    std::array<VkBuffer, 1> vert_bufs{ unit.m_vert_buffer.vertex_buffer() };
-                    vkCmdBindVertexBuffers(cmd_buf, 0, vert_bufs.size(), vert_bufs.data(), vert_offsets.data());
-                    vkCmdBindIndexBuffer(cmd_buf, unit.m_vert_buffer.index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+                const auto& units = model.render_units();
+
+                for (size_t i = 0; i < units.size(); ++i) {
+                    auto& unit = units[i];
 
                     vkCmdBindDescriptorSets(
                         cmd_buf,
                         VK_PIPELINE_BIND_POINT_GRAPHICS,
                         pipeline.layout(),
                         0,
-                        1, &unit.m_material.m_descset.get(),
+                        1, &unit.m_material.descset_at(flight_frame_index).get(),
                         0, nullptr
                     );
 
-                    for (auto& actor : render_tuple.m_actors) {
+                    for (size_t j = 0; j < render_tuple.m_actors.size(); ++j) {
+                        auto& actor = render_tuple.m_actors[j];
+                        auto& offsets = actor->ubuf_offsets_at(flight_frame_index);
                         vkCmdBindDescriptorSets(
                             cmd_buf,
                             VK_PIPELINE_BIND_POINT_GRAPHICS,
                             pipeline.layout(),
                             1,
-                            1, &actor->desc_set_at(flight_frame_index),
-                            0, nullptr
+                            1, &desc_set_actor_animated,
+                            offsets.size(), offsets.data()
                         );
 
-                        vkCmdDrawIndexed(cmd_buf, unit.m_vert_buffer.index_size(), 1, 0, 0, 0);
+                        ::draw_mesh(cmd_buf, unit.mesh_at_lod(render_tuple.lod_at(j, i)));
                     }
                 }
             }
@@ -1105,34 +1305,80 @@ namespace dal {
 // UbufManager
 namespace dal {
 
-    void UbufManager::init(
+    bool UbufManager::init(
+        const VkDeviceSize ring_capacity_per_frame,
         const VkPhysicalDevice phys_device,
         const VkDevice logi_device
     ) {
-        this->m_ub_glights.init(
-            MAX_FRAMES_IN_FLIGHT,
-            phys_device,
-            logi_device
-        );
-
-        this->m_u_camera_transform.init(
-            MAX_FRAMES_IN_FLIGHT,
-            phys_device,
-            logi_device
-        );
+        if (!this->m_ring.init(MAX_FRAMES_IN_FLIGHT, ring_capacity_per_frame, phys_device, logi_device))
+            return false;
 
         this->m_ub_final.init(phys_device, logi_device);
+        return true;
     }
 
     void UbufManager::destroy(const VkDevice logi_device) {
-        this->m_ub_glights.destroy(logi_device);
-        this->m_u_camera_transform.destroy(logi_device);
+        this->m_ring.destroy(logi_device);
         this->m_ub_final.destroy(logi_device);
     }
 
 }
 
 
+// IndirectCmdBuffer
+namespace dal {
+
+    void IndirectCmdBuffer::init(const uint32_t frame_count, const bool multi_draw_indirect) {
+        this->m_buffers.resize(frame_count);
+        this->m_multi_draw = multi_draw_indirect;
+    }
+
+    void IndirectCmdBuffer::destroy(const VkDevice logi_device) {
+        for (auto& x : this->m_buffers)
+            x.destroy(logi_device);
+
+        this->m_buffers.clear();
+    }
+
+    void IndirectCmdBuffer::upload(
+        const FrameInFlightIndex& index,
+        const IndirectDrawBuilder& builder,
+        const VkPhysicalDevice phys_device,
+        const VkDevice logi_device
+    ) {
+        const auto data_size = builder.data_size();
+        if (0 == data_size)
+            return;
+
+        auto& buffer = this->m_buffers.at(index.get());
+
+        // GPU is done with this frame's buffer so it can be recreated
+        if (buffer.size() < data_size) {
+            const auto new_size = std::max<VkDeviceSize>(data_size, buffer.size() * 2);
+
+            const auto result = buffer.init(
+                new_size,
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                phys_device,
+                logi_device
+            );
+
+            if (!result)
+                dalAbort(fmt::format("failed to create indirect command buffer of {} bytes", new_size).c_str());
+        }
+
+        buffer.copy_from_mem(builder.commands().data(), data_size, logi_device);
+    }
+
+    VkBuffer IndirectCmdBuffer::buffer_at(const FrameInFlightIndex& index) const {
+        auto& buffer = this->m_buffers.at(index.get());
+        return buffer.is_ready() ? buffer.buffer() : VK_NULL_HANDLE;
+    }
+
+}
+
+
 // ShadowMap
 namespace dal {
 
@@ -1235,6 +1481,9 @@ namespace dal {
                 index0,
                 glm::mat4{1},
                 shadow_map.extent(),
+                VK_NULL_HANDLE,  // Render list is empty so never bound
+                VK_NULL_HANDLE,
+                false,
                 pipelines.shadow(),
                 pipelines.shadow_animated(),
                 shadow_map.fbuf(),
@@ -1271,6 +1520,9 @@ namespace dal {
                 index0,
                 glm::mat4{1},
                 shadow_map.extent(),
+                VK_NULL_HANDLE,  // Render list is empty so never bound
+                VK_NULL_HANDLE,
+                false,
                 pipelines.shadow(),
                 pipelines.shadow_animated(),
                 shadow_map.fbuf(),
@@ -1482,3 +1734,46 @@ namespace dal {
     }
 
 }
+
+
+// CpuTimeCounter
+namespace dal {
+
+    CpuTimeCounter::CpuTimeCounter(const char* const name, const double report_interval_sec)
+        : m_name(name)
+        , m_report_interval(report_interval_sec)
+    {
+
+    }
+
+    void CpuTimeCounter::add_sample(const double elapsed_sec) {
+        this->m_last = elapsed_sec;
+        this->m_sum += elapsed_sec;
+        this->m_max = std::max(this->m_max, elapsed_sec);
+        ++this->m_count;
+
+        if (this->m_report_timer.get_elapsed() > this->m_report_interval) {
+            dalVerbose(fmt::format(
+                "{}: avg {:.3f} ms, max {:.3f} ms over {} samples",
+                this->m_name, this->average() * 1000.0, this->m_max * 1000.0, this->m_count
+            ).c_str());
+
+            this->reset();
+            this->m_report_timer.check();
+        }
+    }
+
+    double CpuTimeCounter::average() const {
+        if (0 == this->m_count)
+            return 0;
+        else
+            return this->m_sum / static_cast<double>(this->m_count);
+    }
+
+    void CpuTimeCounter::reset() {
+        this->m_sum = 0;
+        this->m_max = 0;
+        this->m_count = 0;
+    }
+
+}
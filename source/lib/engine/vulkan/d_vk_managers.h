@@ -12,6 +12,7 @@
 #include "d_render_pass.h"
 #include "d_framebuffer.h"
 #include "d_model_renderer.h"
+#include "d_indirect_draw.h"
 
 
 namespace dal {
@@ -22,12 +23,13 @@ namespace dal {
     class VulkanResourceManager {
 
     private:
-        std::vector< std::shared_ptr<TextureProxy>         > m_textures;
-        std::vector< std::shared_ptr<MeshProxy>            > m_meshes;
-        std::vector< std::shared_ptr<ModelProxy>           > m_models;
-        std::vector< std::shared_ptr<ModelSkinnedProxy>    > m_skinned_models;
-        std::vector< std::shared_ptr<ActorProxy>           > m_actors;
-        std::vector< std::shared_ptr<ActorSkinnedProxy>    > m_skinned_actors;
+        // Weak so that owners can tell a resource is unused by its use count
+        std::vector< std::weak_ptr<TextureProxy>         > m_textures;
+        std::vector< std::weak_ptr<MeshProxy>            > m_meshes;
+        std::vector< std::weak_ptr<ModelProxy>           > m_models;
+        std::vector< std::weak_ptr<ModelSkinnedProxy>    > m_skinned_models;
+        std::vector< std::weak_ptr<ActorProxy>           > m_actors;
+        std::vector< std::weak_ptr<ActorSkinnedProxy>    > m_skinned_actors;
 
     public:
         ~VulkanResourceManager();
@@ -35,64 +37,97 @@ namespace dal {
         void destroy();
 
         HTexture create_texture(
-            dal::CommandPool& cmd_pool,
-            const VkQueue graphics_queue,
-            const VkPhysicalDevice phys_device,
-            const VkDevice logi_device
+            dal::UploadManager& upload_man
         );
 
         HMesh create_mesh(
-            dal::CommandPool& cmd_pool,
+            dal::UploadManager& upload_man,
             const VkPhysicalDevice phys_device,
             const dal::LogicalDevice& logi_device
         );
 
         HRenModel create_model(
-            CommandPool&                  cmd_pool,
+            UploadManager&                upload_man,
             ITextureManager&              tex_man,
             DescLayout_PerActor const&    layout_per_actor,
             DescLayout_PerMaterial const& layout_per_material,
             SamplerTexture const&         sampler,
-            VkQueue                       graphics_queue,
             VkPhysicalDevice              phys_device,
             VkDevice                      logi_device
         );
 
         HRenModelSkinned create_model_skinned(
-            CommandPool&                  cmd_pool,
+            UploadManager&                upload_man,
             ITextureManager&              tex_man,
             DescLayout_PerActor const&    layout_per_actor,
             DescLayout_PerMaterial const& layout_per_material,
             SamplerTexture const&         sampler,
-            VkQueue                       graphics_queue,
             VkPhysicalDevice              phys_device,
             VkDevice                      logi_device
         );
 
-        HActor create_actor(
-            DescAllocator& desc_allocator,
-            const DescLayout_PerActor& desc_layout,
-            VkPhysicalDevice phys_device,
-            VkDevice logi_device
-        );
+        HActor create_actor(UniformRingBuffer& ubuf_ring);
 
-        HActorSkinned create_actor_skinned(
-            DescAllocator& desc_allocator,
-            const DescLayout_ActorAnimated& desc_layout,
-            VkPhysicalDevice phys_device,
-            VkDevice logi_device
-        );
+        HActorSkinned create_actor_skinned(UniformRingBuffer& ubuf_ring);
+
+        // For ones created by another renderer
+        void register_texture(const HTexture& texture);
+
+        auto& textures() const {
+            return this->m_textures;
+        }
 
     };
 
 
+    // Pixels a unit long object covers at distance of one
+    float calc_pixels_per_unit_at_unit_dist(const float fov, const uint32_t screen_height);
+
+
+    // How large bounding sphere of a render unit appears, at the point of the sphere closest to camera
+    struct ProjectedBounds {
+        float m_radius = 0;
+        float m_pixels_per_unit = 0;
+
+        float radius_in_pixels() const {
+            return this->m_radius * this->m_pixels_per_unit;
+        }
+    };
+
+    ProjectedBounds project_bounds(
+        const RenderUnit& unit,
+        const glm::mat4& model_mat,
+        const float scale,
+        const glm::vec3& view_pos,
+        const float pixels_per_unit_at_unit_dist
+    );
+
+
+    // Levels of detail are picked by how many pixels their geometric error covers on screen
+    struct LodParams {
+        float m_pixels_per_unit_at_unit_dist = 1;
+        // Each step doubles the error allowed
+        float m_bias = 0;
+        float m_shadow_bias = 0;
+    };
+
+
     class RenderListVK {
 
     private:
         template <typename _Model, typename _Actor>
         struct RenderPairOpaqueVK {
             std::vector<const _Actor*> m_actors;
+            // Level of detail of every opaque render unit for each actor. Units of an actor are consecutive.
+            std::vector<uint32_t> m_lods;
+            std::vector<uint32_t> m_shadow_lods;
+            // Parallel to m_actors. Commands are in m_indirect_cmds of the list.
+            std::vector<IndirectBatch> m_shadow_batches;
             const _Model* m_model = nullptr;
+
+            uint32_t lod_at(const size_t actor_index, const size_t unit_index) const {
+                return this->m_lods[actor_index * this->m_model->render_units().size() + unit_index];
+            }
         };
 
         template <typename _Actor>
@@ -100,6 +135,7 @@ namespace dal {
             const _Actor* m_actor = nullptr;
             const RenderUnit* m_unit = nullptr;
             float m_distance_sqr = 0;
+            uint32_t m_lod = 0;
 
             bool operator<(const RenderPairTranspVK& other) const {
                 return this->m_distance_sqr > other.m_distance_sqr;
@@ -138,6 +174,9 @@ namespace dal {
         std::vector<RenderPair_O_A> m_skinned_models;
         std::vector<RenderPair_A_A> m_skinned_alpha_models;
 
+        // Shadow pass commands of every render pair
+        IndirectDrawBuilder m_indirect_cmds;
+
         std::vector<PlaneRender> m_render_planes;
         std::vector<WaterRender> m_render_waters;
 
@@ -147,7 +186,7 @@ namespace dal {
         glm::vec3 m_ambient_light;
 
     public:
-        void apply(dal::Scene& scene, const glm::vec3& view_pos);
+        void apply(dal::Scene& scene, const glm::vec3& view_pos, const LodParams& lod_params);
 
     private:
         RenderPair_O_S& get_render_pair(HRenModel& model);
@@ -166,7 +205,10 @@ namespace dal {
         const dal::PlanarReflectionManager& reflection_mgr,
 
         const VkExtent2D& swapchain_extent,
+        const dal::UbufOffsetsPerGlobal& ubuf_offsets_global,
         const VkDescriptorSet desc_set_per_frame,
+        const VkDescriptorSet desc_set_per_actor,
+        const VkDescriptorSet desc_set_actor_animated,
         const VkDescriptorSet desc_set_composition,
         const dal::ShaderPipeline& pipeline_gbuf,
         const dal::ShaderPipeline& pipeline_gbuf_animated,
@@ -194,7 +236,10 @@ namespace dal {
         const glm::vec3& view_pos,
 
         const VkExtent2D& swapchain_extent,
+        const dal::UbufOffsetsPerGlobal& ubuf_offsets_global,
         const VkDescriptorSet desc_set_per_global,
+        const VkDescriptorSet desc_set_per_actor,
+        const VkDescriptorSet desc_set_actor_animated,
         const VkDescriptorSet desc_set_composition,
         const dal::ShaderPipeline& pipeline_alpha,
         const dal::ShaderPipeline& pipeline_alpha_animated,
@@ -210,6 +255,9 @@ namespace dal {
         const glm::mat4& light_mat,
 
         const VkExtent2D& shadow_map_extent,
+        const VkDescriptorSet desc_set_actor_animated,
+        const VkBuffer indirect_cmd_buffer,
+        const bool multi_draw_indirect,
         const dal::ShaderPipeline& pipeline_shadow,
         const dal::ShaderPipeline& pipeline_shadow_animated,
         const dal::Fbuf_Shadow& fbuf,
@@ -224,6 +272,8 @@ namespace dal {
 
         dal::U_PC_OnMirror push_constant,
         const VkExtent2D& extent,
+        const VkDescriptorSet desc_set_per_actor,
+        const VkDescriptorSet desc_set_actor_animated,
         const dal::ShaderPipeline& pipeline_on_mirror,
         const dal::ShaderPipeline& pipeline_on_mirror_animated,
         const dal::Fbuf_Simple& fbuf,
@@ -300,15 +350,46 @@ namespace dal {
     };
 
 
+    // Host visible buffer per frame in flight which holds indirect draw commands of RenderListVK
+    class IndirectCmdBuffer {
+
+    private:
+        std::vector<BufferMemory> m_buffers;
+        bool m_multi_draw = false;
+
+    public:
+        void init(const uint32_t frame_count, const bool multi_draw_indirect);
+
+        void destroy(const VkDevice logi_device);
+
+        // Must be called after the fence of this frame is waited
+        void upload(
+            const FrameInFlightIndex& index,
+            const IndirectDrawBuilder& builder,
+            const VkPhysicalDevice phys_device,
+            const VkDevice logi_device
+        );
+
+        VkBuffer buffer_at(const FrameInFlightIndex& index) const;
+
+        bool multi_draw() const {
+            return this->m_multi_draw;
+        }
+
+    };
+
+
     class UbufManager {
 
     public:
-        UniformBufferArray<U_GlobalLight> m_ub_glights;
-        UniformBufferArray<U_CameraTransform> m_u_camera_transform;
+        // U_CameraTransform, U_GlobalLight and every U_PerActor, U_AnimTransform of a frame
+        UniformRingBuffer m_ring;
         UniformBuffer<U_Shader_Final> m_ub_final;
 
     public:
-        void init(
+        [[nodiscard]]
+        bool init(
+            const VkDeviceSize ring_capacity_per_frame,
             const VkPhysicalDevice phys_device,
             const VkDevice logi_device
         );
@@ -485,4 +566,35 @@ namespace dal {
 
     };
 
+
+
+    // Accumulates CPU time samples and periodically logs average and worst values.
+    class CpuTimeCounter {
+
+    private:
+        const char* m_name;
+        dal::Timer m_report_timer;
+        double m_report_interval;
+
+        double m_last = 0;
+        double m_sum = 0;
+        double m_max = 0;
+        uint32_t m_count = 0;
+
+    public:
+        CpuTimeCounter(const char* const name, const double report_interval_sec);
+
+        void add_sample(const double elapsed_sec);
+
+        auto last() const {
+            return this->m_last;
+        }
+
+        double average() const;
+
+    private:
+        void reset();
+
+    };
+
 }
@@ -21,6 +21,8 @@ namespace {
     constexpr float PROJ_NEAR = 0.1;
     constexpr float PROJ_FAR = 1000;
 
+    constexpr VkDeviceSize INIT_UBUF_RING_CAPACITY = 2 * 1024 * 1024;
+
 
     VkExtent2D calc_smaller_extent(const VkExtent2D& extent, const float scale) {
         return VkExtent2D{
@@ -225,9 +227,11 @@ namespace dal {
         surface_create_func_t surface_create_func
     )
         : m_filesys(filesys)
+        , m_task_man(task_man)
         , m_texture_man(texture_man)
         , m_config(config)
         , m_new_extent(VkExtent2D{ init_width, init_height })
+        , m_ubuf_ring_capacity(::INIT_UBUF_RING_CAPACITY)
     {
 #ifdef DAL_OS_ANDROID
         dalAssert(1 == InitVulkan());
@@ -250,13 +254,26 @@ namespace dal {
 
         std::tie(this->m_phys_device, this->m_phys_info) = dal::get_best_phys_device(this->m_instance, this->m_surface, true);
         this->m_logi_device.init(this->m_surface, this->m_phys_device, this->m_phys_info);
+        MemoryAllocatorSingleton::inst().init(this->m_phys_device.get(), this->m_logi_device.get());
+        this->m_upload_man.init(
+            static_cast<VkDeviceSize>(this->m_config.m_staging_buffer_mb) * 1024 * 1024,
+            this->m_logi_device.indices().graphics_family(),
+            this->m_logi_device.queue_graphics(),
+            this->m_logi_device.indices().transfer_family(),
+            this->m_logi_device.queue_transfer(),
+            this->m_phys_device.get(),
+            this->m_logi_device.get()
+        );
+        this->m_pipeline_cache.init(this->m_filesys, this->m_phys_device.get(), this->m_logi_device.get());
         this->m_desc_layout_man.init(this->m_logi_device.get());
+        this->m_indirect_cmds.init(MAX_FRAMES_IN_FLIGHT, this->m_phys_info.does_support_multi_draw_indirect());
 
         this->m_sampler_man.init(
             this->m_phys_info.does_support_anisotropic_sampling(),
             this->m_phys_device.get(),
             this->m_logi_device.get()
         );
+        this->m_tex_streamer.set_budget(static_cast<size_t>(this->m_config.m_texture_budget_mb) * 1024 * 1024);
 
         const auto result_init_swapchain = this->init_swapchain_and_dependers();
         dalAssert(result_init_swapchain);
@@ -268,6 +285,7 @@ namespace dal {
         this->wait_idle();
 
         this->m_vk_res_man.destroy();
+        this->m_upload_man.destroy();
 
         this->m_ref_planes.destroy(this->m_logi_device.get());
         this->m_shadow_maps.destroy(this->m_logi_device.get());
@@ -275,13 +293,18 @@ namespace dal {
         this->m_sampler_man.destroy(this->m_logi_device.get());
         this->m_desc_man.destroy(this->m_logi_device.get());
         this->m_ubuf_man.destroy(this->m_logi_device.get());
+        this->m_indirect_cmds.destroy(this->m_logi_device.get());
         this->m_cmd_man.destroy(this->m_logi_device.get());
         this->m_pipelines.destroy(this->m_logi_device.get());
+        this->m_pipeline_cache.save(this->m_filesys, this->m_phys_device.get(), this->m_logi_device.get());
+        this->m_pipeline_cache.destroy(this->m_logi_device.get());
         this->m_fbuf_man.destroy(this->m_logi_device.get());
         this->m_renderpasses.destroy(this->m_logi_device.get());
         this->m_attach_man.destroy(this->m_logi_device.get());
         this->m_swapchain.destroy(this->m_logi_device.get());
         this->m_desc_layout_man.destroy(this->m_logi_device.get());
+        MemoryAllocatorSingleton::inst().dump_stats();
+        MemoryAllocatorSingleton::inst().destroy();
         this->m_logi_device.destroy();
 
 #ifdef DAL_VK_DEBUG
@@ -308,6 +331,41 @@ namespace dal {
             return;
         }
 
+        // Resources whose upload finished since last frame become ready here
+        this->m_upload_man.poll();
+
+        // Update render list
+        //-----------------------------------------------------------------------------------------------------
+
+        const auto fov = glm::radians<float>(80);
+        // Shared by level of detail selection and texture streaming
+        const auto pixels_per_unit_at_unit_dist = dal::calc_pixels_per_unit_at_unit_dist(fov, this->m_swapchain.screen_extent().height);
+
+        dal::LodParams lod_params;
+        lod_params.m_pixels_per_unit_at_unit_dist = pixels_per_unit_at_unit_dist;
+        lod_params.m_bias = this->m_config.m_lod_bias;
+        lod_params.m_shadow_bias = this->m_config.m_shadow_lod_bias;
+
+        dal::RenderListVK render_list;
+        render_list.apply(scene, camera.view_pos(), lod_params);
+
+        // Grow uniform ring before anything is written into it
+        {
+            auto& ring = this->m_ubuf_man.m_ring;
+            const auto size_per_actor = ring.aligned_size(sizeof(U_PerActor));
+            const auto size_per_skin_actor = size_per_actor + ring.aligned_size(sizeof(U_AnimTransform));
+
+            const auto required_size = std::max<VkDeviceSize>(this->m_ubuf_ring_overflow_size, (
+                ring.aligned_size(sizeof(U_CameraTransform)) +
+                ring.aligned_size(sizeof(U_GlobalLight)) +
+                size_per_actor * render_list.m_used_actors.size() +
+                size_per_skin_actor * render_list.m_used_skin_actors.size()
+            ));
+
+            if (required_size > ring.capacity())
+                this->grow_ubuf_ring(required_size);
+        }
+
         auto& sync_man = this->m_swapchain.sync_man();
 
         sync_man.m_fence_frame_in_flight.at(this->m_flight_frame_index).wait(this->m_logi_device.get());
@@ -330,19 +388,15 @@ namespace dal {
             img_fences = &sync_man.m_fence_frame_in_flight.at(this->m_flight_frame_index);
         }
 
-        // Update render list
+        // Upload actor uniforms
         //-----------------------------------------------------------------------------------------------------
 
-        dal::RenderListVK render_list;
-        render_list.apply(scene, camera.view_pos());
+        // GPU is done with this frame's range of the ring since the fence above was signaled
+        this->m_ubuf_man.m_ring.reset(this->m_flight_frame_index);
 
         for (auto x : render_list.m_used_actors) {
             auto& actor = dal::handle_cast(x);
-
-            if (actor.get().m_transform_update_needed > 0) {
-                --actor.get().m_transform_update_needed;
-                actor.apply_transform(this->in_flight_index());
-            }
+            actor.apply_transform(this->in_flight_index());
         }
 
         for (auto x : render_list.m_used_skin_actors) {
@@ -352,13 +406,38 @@ namespace dal {
             actor.apply_transform(this->in_flight_index());
         }
 
+        this->m_indirect_cmds.upload(
+            this->m_flight_frame_index,
+            render_list.m_indirect_cmds,
+            this->m_phys_device.get(),
+            this->m_logi_device.get()
+        );
+
+        // Stream textures
+        //-----------------------------------------------------------------------------------------------------
+
+        // Old images of streamed textures are freed in here, so it must come after the fence above
+        this->m_tex_streamer.update(
+            this->m_vk_res_man.textures(),
+            render_list,
+            camera.view_pos(),
+            pixels_per_unit_at_unit_dist,
+            this->m_frame_count
+        );
+
+        for (auto& x : render_list.m_used_models)
+            dal::handle_cast(*x).update_descsets(this->m_flight_frame_index);
+
+        for (auto& x : render_list.m_used_skin_models)
+            dal::handle_cast(*x).update_descsets(this->m_flight_frame_index);
+
         // Prepare needed data
         //-----------------------------------------------------------------------------------------------------
 
         const auto cur_sec = dal::get_cur_sec();
 
         const auto cam_view_mat = camera.make_view_mat();
-        const auto cam_proj_mat = make_perspective_proj_mat(glm::radians<float>(80), this->m_swapchain.perspective_ratio(), ::PROJ_NEAR, ::PROJ_FAR);
+        const auto cam_proj_mat = make_perspective_proj_mat(fov, this->m_swapchain.perspective_ratio(), ::PROJ_NEAR, ::PROJ_FAR);
         const auto cam_proj_view_mat = cam_proj_mat * cam_view_mat;
 
         const auto dlight_update_flags = this->m_shadow_maps.create_dlight_update_flags();
@@ -375,7 +454,7 @@ namespace dal {
 
                 if (dlight_update_flags[index]) {
                     frustum_vertices[index] = camera.make_frustum_vertices(
-                        glm::radians<float>(80),
+                        fov,
                         this->m_swapchain.perspective_ratio(),
                         ::PROJ_NEAR + near_dist,
                         ::PROJ_NEAR + far_dist
@@ -393,7 +472,7 @@ namespace dal {
             }
 
             frustum_vertices[0] = camera.make_frustum_vertices(
-                glm::radians<float>(80),
+                fov,
                 this->m_swapchain.perspective_ratio(),
                 ::PROJ_NEAR,
                 ::PROJ_NEAR + far_dist
@@ -441,6 +520,8 @@ namespace dal {
         // Set up uniform variables
         //-----------------------------------------------------------------------------------------------------
 
+        UbufOffsetsPerGlobal ubuf_offsets_global;
+
         // U_CameraTransform
         {
             U_CameraTransform ubuf_data_composition{};
@@ -451,7 +532,7 @@ namespace dal {
             ubuf_data_composition.m_view_pos = glm::vec4{ camera.view_pos(), 1 };
             ubuf_data_composition.m_near = ::PROJ_NEAR;
             ubuf_data_composition.m_far = ::PROJ_FAR;
-            this->m_ubuf_man.m_u_camera_transform.at(this->m_flight_frame_index.get()).copy_to_buffer(ubuf_data_composition, this->m_logi_device.get());
+            ubuf_offsets_global.m_camera = this->m_ubuf_man.m_ring.push(this->m_flight_frame_index, ubuf_data_composition).value_or(0);
         }
 
         // U_GlobalLight
@@ -491,18 +572,29 @@ namespace dal {
             data_glight.m_atmos_intensity = render_list.m_dlight.m_atmos_intensity;
             data_glight.m_mie_scattering_coeff = 221e-6;
 
-            this->m_ubuf_man.m_ub_glights.at(this->m_flight_frame_index.get()).copy_to_buffer(data_glight, this->m_logi_device.get());
+            ubuf_offsets_global.m_global_light = this->m_ubuf_man.m_ring.push(this->m_flight_frame_index, data_glight).value_or(0);
         }
 
-        // Submit command buffers to GPU
+        // Size estimated above fell short. This frame reads wrong uniforms for what didn't fit, and next one gets a bigger ring.
+        {
+            auto& ring = this->m_ubuf_man.m_ring;
+            const auto used_size = ring.used_at(this->m_flight_frame_index);
+
+            if (used_size > ring.capacity()) {
+                dalWarn(fmt::format("Uniform ring buffer overflowed: capacity {}, used {}", ring.capacity(), used_size).c_str());
+                this->m_ubuf_ring_overflow_size = used_size;
+            }
+        }
+
+        // Record command buffers
         //-----------------------------------------------------------------------------------------------------
 
+        // Shadow maps and reflection planes are recorded into one batch because none of them depend on each other.
+        // Gbuf samples all of them so it waits on a semaphore signaled once the whole batch is done.
+        std::vector<VkCommandBuffer> offscreen_cmd_bufs;
+
         // Reflection planes
         {
-            std::array<VkPipelineStageFlags, 0> wait_stages{};
-            std::array<VkSemaphore, 0> wait_semaphores{};
-            std::array<VkSemaphore, 0> signal_semaphores{};
-
             for (auto& plane : this->m_ref_planes.reflection_planes()) {
                 const auto& cmd_buf = plane.m_cmd_buf.at(this->m_flight_frame_index.get());
 
@@ -516,39 +608,20 @@ namespace dal {
                     this->m_flight_frame_index,
                     pc_data,
                     plane.m_attachments.extent(),
+                    this->m_desc_man.desc_set_per_actor_at(this->m_flight_frame_index.get()),
+                    this->m_desc_man.desc_set_actor_animated_at(this->m_flight_frame_index.get()),
                     this->m_pipelines.on_mirror(),
                     this->m_pipelines.on_mirror_animated(),
                     plane.m_fbuf,
                     this->m_renderpasses.rp_simple()
                 );
 
-                VkSubmitInfo submit_info{};
-                submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-                submit_info.pCommandBuffers = &cmd_buf;
-                submit_info.commandBufferCount = 1;
-                submit_info.waitSemaphoreCount = wait_semaphores.size();
-                submit_info.pWaitSemaphores = wait_semaphores.data();
-                submit_info.pWaitDstStageMask = wait_stages.data();
-                submit_info.signalSemaphoreCount = signal_semaphores.size();
-                submit_info.pSignalSemaphores = signal_semaphores.data();
-
-                const auto submit_result = vkQueueSubmit(
-                    this->m_logi_device.queue_graphics(),
-                    1,
-                    &submit_info,
-                    VK_NULL_HANDLE
-                );
-
-                dalAssert(VK_SUCCESS == submit_result);
+                offscreen_cmd_bufs.push_back(cmd_buf);
             }
         }
 
         // Shadow maps
         {
-            std::array<VkPipelineStageFlags, 0> wait_stages{};
-            std::array<VkSemaphore, 0> wait_semaphores{};
-            std::array<VkSemaphore, 0> signal_semaphores{};
-
             for (size_t i = 0; i < dal::MAX_DLIGHT_COUNT; ++i) {
                 if (!dlight_update_flags[i])
                     continue;
@@ -561,30 +634,16 @@ namespace dal {
                     this->m_flight_frame_index,
                     this->m_shadow_maps.m_dlight_matrices[i],
                     shadow_map.extent(),
+                    this->m_desc_man.desc_set_actor_animated_at(this->m_flight_frame_index.get()),
+                    this->m_indirect_cmds.buffer_at(this->m_flight_frame_index),
+                    this->m_indirect_cmds.multi_draw(),
                     this->m_pipelines.shadow(),
                     this->m_pipelines.shadow_animated(),
                     shadow_map.fbuf(),
                     this->m_renderpasses.rp_shadow()
                 );
 
-                VkSubmitInfo submit_info{};
-                submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-                submit_info.pCommandBuffers = &this->m_shadow_maps.m_dlights[i].cmd_buf_at(this->m_flight_frame_index.get());
-                submit_info.commandBufferCount = 1;
-                submit_info.waitSemaphoreCount = wait_semaphores.size();
-                submit_info.pWaitSemaphores = wait_semaphores.data();
-                submit_info.pWaitDstStageMask = wait_stages.data();
-                submit_info.signalSemaphoreCount = signal_semaphores.size();
-                submit_info.pSignalSemaphores = signal_semaphores.data();
-
-                const auto submit_result = vkQueueSubmit(
-                    this->m_logi_device.queue_graphics(),
-                    1,
-                    &submit_info,
-                    VK_NULL_HANDLE
-                );
-
-                dalAssert(VK_SUCCESS == submit_result);
+                offscreen_cmd_bufs.push_back(shadow_map.cmd_buf_at(this->m_flight_frame_index.get()));
             }
 
             for (size_t i = 0; i < render_list.m_slights.size(); ++i) {
@@ -596,151 +655,151 @@ namespace dal {
                     this->m_flight_frame_index,
                     render_list.m_slights[i].make_light_mat(),
                     shadow_map.extent(),
+                    this->m_desc_man.desc_set_actor_animated_at(this->m_flight_frame_index.get()),
+                    this->m_indirect_cmds.buffer_at(this->m_flight_frame_index),
+                    this->m_indirect_cmds.multi_draw(),
                     this->m_pipelines.shadow(),
                     this->m_pipelines.shadow_animated(),
                     shadow_map.fbuf(),
                     this->m_renderpasses.rp_shadow()
                 );
 
-                VkSubmitInfo submit_info{};
-                submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-                submit_info.pCommandBuffers = &shadow_map.cmd_buf_at(this->m_flight_frame_index.get());
-                submit_info.commandBufferCount = 1;
-                submit_info.waitSemaphoreCount = wait_semaphores.size();
-                submit_info.pWaitSemaphores = wait_semaphores.data();
-                submit_info.pWaitDstStageMask = wait_stages.data();
-                submit_info.signalSemaphoreCount = signal_semaphores.size();
-                submit_info.pSignalSemaphores = signal_semaphores.data();
-
-                const auto submit_result = vkQueueSubmit(
-                    this->m_logi_device.queue_graphics(),
-                    1,
-                    &submit_info,
-                    VK_NULL_HANDLE
-                );
-
-                dalAssert(VK_SUCCESS == submit_result);
+                offscreen_cmd_bufs.push_back(shadow_map.cmd_buf_at(this->m_flight_frame_index.get()));
             }
         }
 
         // Gbuf
-        {
-            std::array<VkPipelineStageFlags, 1> wait_stages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-            std::array<VkSemaphore, 1> wait_semaphores{ sync_man.m_semaph_img_available.at(this->m_flight_frame_index).get() };
-            std::array<VkSemaphore, 1> signal_semaphores{ sync_man.m_semaph_cmd_done_gbuf.at(this->m_flight_frame_index).get() };
-
-            record_cmd_gbuf(
-                this->m_cmd_man.cmd_simple_at(this->m_flight_frame_index.get()),
-                render_list,
-                this->m_flight_frame_index,
-                cam_proj_mat * cam_view_mat,
-                this->m_ref_planes,
-                this->m_attach_man.color().extent(),
-                this->m_desc_man.desc_set_per_global_at(this->m_flight_frame_index.get()),
-                this->m_desc_man.desc_set_composition_at(this->m_flight_frame_index.get()).get(),
-                this->m_pipelines.gbuf(),
-                this->m_pipelines.gbuf_animated(),
-                this->m_pipelines.composition(),
-                this->m_pipelines.mirror(),
-                this->m_fbuf_man.fbuf_gbuf_at(swapchain_index),
-                this->m_renderpasses.rp_gbuf()
-            );
+        record_cmd_gbuf(
+            this->m_cmd_man.cmd_simple_at(this->m_flight_frame_index.get()),
+            render_list,
+            this->m_flight_frame_index,
+            cam_proj_mat * cam_view_mat,
+            this->m_ref_planes,
+            this->m_attach_man.color().extent(),
+            ubuf_offsets_global,
+            this->m_desc_man.desc_set_per_global_at(this->m_flight_frame_index.get()),
+            this->m_desc_man.desc_set_per_actor_at(this->m_flight_frame_index.get()),
+            this->m_desc_man.desc_set_actor_animated_at(this->m_flight_frame_index.get()),
+            this->m_desc_man.desc_set_composition_at(this->m_flight_frame_index.get()).get(),
+            this->m_pipelines.gbuf(),
+            this->m_pipelines.gbuf_animated(),
+            this->m_pipelines.composition(),
+            this->m_pipelines.mirror(),
+            this->m_fbuf_man.fbuf_gbuf_at(swapchain_index),
+            this->m_renderpasses.rp_gbuf()
+        );
 
-            VkSubmitInfo submit_info{};
-            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            submit_info.pCommandBuffers = &this->m_cmd_man.cmd_simple_at(this->m_flight_frame_index.get());
-            submit_info.commandBufferCount = 1;
-            submit_info.waitSemaphoreCount = wait_semaphores.size();
-            submit_info.pWaitSemaphores = wait_semaphores.data();
-            submit_info.pWaitDstStageMask = wait_stages.data();
-            submit_info.signalSemaphoreCount = signal_semaphores.size();
-            submit_info.pSignalSemaphores = signal_semaphores.data();
+        // Alpha
+        record_cmd_alpha(
+            this->m_cmd_man.cmd_alpha_at(this->m_flight_frame_index.get()),
+            render_list,
+            this->m_flight_frame_index,
+            camera.view_pos(),
+            this->m_attach_man.color().extent(),
+            ubuf_offsets_global,
+            this->m_desc_man.desc_set_alpha_at(this->m_flight_frame_index.get()),
+            this->m_desc_man.desc_set_per_actor_at(this->m_flight_frame_index.get()),
+            this->m_desc_man.desc_set_actor_animated_at(this->m_flight_frame_index.get()),
+            this->m_desc_man.desc_set_composition_at(this->m_flight_frame_index.get()).get(),
+            this->m_pipelines.alpha(),
+            this->m_pipelines.alpha_animated(),
+            this->m_fbuf_man.fbuf_alpha_at(swapchain_index),
+            this->m_renderpasses.rp_alpha()
+        );
 
-            const auto submit_result = vkQueueSubmit(
-                this->m_logi_device.queue_graphics(),
-                1,
-                &submit_info,
-                VK_NULL_HANDLE
-            );
+        // Final
+        record_cmd_final(
+            this->m_cmd_man.cmd_final_at(this->m_flight_frame_index.get()),
+            this->m_swapchain.identity_extent(),
+            this->m_desc_man.desc_set_final_at(this->m_flight_frame_index.get()),
+            this->m_pipelines.final(),
+            this->m_fbuf_man.fbuf_final_at(swapchain_index),
+            this->m_renderpasses.rp_final()
+        );
 
-            dalAssert(VK_SUCCESS == submit_result);
-        }
+        // Submit command buffers to GPU
+        //-----------------------------------------------------------------------------------------------------
+
+        // Everything requested during this frame goes in a single batch per queue
+        this->m_upload_man.flush();
 
-        // Alpha
         {
-            std::array<VkPipelineStageFlags, 1> wait_stages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-            std::array<VkSemaphore, 1> wait_semaphores{ sync_man.m_semaph_cmd_done_gbuf.at(this->m_flight_frame_index).get() };
-            std::array<VkSemaphore, 1> signal_semaphores{ sync_man.m_semaph_cmd_done_alpha.at(this->m_flight_frame_index).get() };
-
-            record_cmd_alpha(
-                this->m_cmd_man.cmd_alpha_at(this->m_flight_frame_index.get()),
-                render_list,
-                this->m_flight_frame_index,
-                camera.view_pos(),
-                this->m_attach_man.color().extent(),
-                this->m_desc_man.desc_set_alpha_at(this->m_flight_frame_index.get()),
-                this->m_desc_man.desc_set_composition_at(this->m_flight_frame_index.get()).get(),
-                this->m_pipelines.alpha(),
-                this->m_pipelines.alpha_animated(),
-                this->m_fbuf_man.fbuf_alpha_at(swapchain_index),
-                this->m_renderpasses.rp_alpha()
-            );
+            const auto semaph_offscreen = sync_man.m_semaph_cmd_done_offscreen.at(this->m_flight_frame_index).get();
+            const auto semaph_img_available = sync_man.m_semaph_img_available.at(this->m_flight_frame_index).get();
+            const auto semaph_gbuf = sync_man.m_semaph_cmd_done_gbuf.at(this->m_flight_frame_index).get();
+            const auto semaph_alpha = sync_man.m_semaph_cmd_done_alpha.at(this->m_flight_frame_index).get();
+            const auto semaph_final = sync_man.m_semaph_cmd_done_final.at(this->m_flight_frame_index).get();
+
+            const bool has_offscreen = !offscreen_cmd_bufs.empty();
+
+            std::array<VkSemaphore, 2> gbuf_wait_semaphores{ semaph_img_available, semaph_offscreen };
+            std::array<VkPipelineStageFlags, 2> gbuf_wait_stages{
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            };
+            std::array<VkPipelineStageFlags, 1> color_wait_stages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+
+            std::array<VkSubmitInfo, 4> submit_infos{};
+            uint32_t submit_count = 0;
+
+            if (has_offscreen) {
+                auto& info = submit_infos[submit_count++];
+                info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                info.commandBufferCount = offscreen_cmd_bufs.size();
+                info.pCommandBuffers = offscreen_cmd_bufs.data();
+                info.signalSemaphoreCount = 1;
+                info.pSignalSemaphores = &semaph_offscreen;
+            }
 
-            VkSubmitInfo submit_info{};
-            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            submit_info.pCommandBuffers = &this->m_cmd_man.cmd_alpha_at(this->m_flight_frame_index.get());
-            submit_info.commandBufferCount = 1;
-            submit_info.waitSemaphoreCount = wait_semaphores.size();
-            submit_info.pWaitSemaphores = wait_semaphores.data();
-            submit_info.pWaitDstStageMask = wait_stages.data();
-            submit_info.signalSemaphoreCount = signal_semaphores.size();
-            submit_info.pSignalSemaphores = signal_semaphores.data();
+            {
+                auto& info = submit_infos[submit_count++];
+                info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                info.commandBufferCount = 1;
+                info.pCommandBuffers = &this->m_cmd_man.cmd_simple_at(this->m_flight_frame_index.get());
+                info.waitSemaphoreCount = has_offscreen ? 2 : 1;
+                info.pWaitSemaphores = gbuf_wait_semaphores.data();
+                info.pWaitDstStageMask = gbuf_wait_stages.data();
+                info.signalSemaphoreCount = 1;
+                info.pSignalSemaphores = &semaph_gbuf;
+            }
 
-            const auto submit_result = vkQueueSubmit(
-                this->m_logi_device.queue_graphics(),
-                1,
-                &submit_info,
-                VK_NULL_HANDLE
-            );
+            {
+                auto& info = submit_infos[submit_count++];
+                info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                info.commandBufferCount = 1;
+                info.pCommandBuffers = &this->m_cmd_man.cmd_alpha_at(this->m_flight_frame_index.get());
+                info.waitSemaphoreCount = 1;
+                info.pWaitSemaphores = &semaph_gbuf;
+                info.pWaitDstStageMask = color_wait_stages.data();
+                info.signalSemaphoreCount = 1;
+                info.pSignalSemaphores = &semaph_alpha;
+            }
 
-            dalAssert(VK_SUCCESS == submit_result);
-        }
+            {
+                auto& info = submit_infos[submit_count++];
+                info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                info.commandBufferCount = 1;
+                info.pCommandBuffers = &this->m_cmd_man.cmd_final_at(this->m_flight_frame_index.get());
+                info.waitSemaphoreCount = 1;
+                info.pWaitSemaphores = &semaph_alpha;
+                info.pWaitDstStageMask = color_wait_stages.data();
+                info.signalSemaphoreCount = 1;
+                info.pSignalSemaphores = &semaph_final;
+            }
 
-        // Final
-        {
-            std::array<VkPipelineStageFlags, 1> wait_stages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-            std::array<VkSemaphore, 1> wait_semaphores{ sync_man.m_semaph_cmd_done_alpha.at(this->m_flight_frame_index).get() };
-            std::array<VkSemaphore, 1> signal_semaphores{ sync_man.m_semaph_cmd_done_final.at(this->m_flight_frame_index).get() };
             auto& fence = sync_man.m_fence_frame_in_flight.at(this->m_flight_frame_index);
-
             fence.wait_reset(this->m_logi_device.get());
 
-            record_cmd_final(
-                this->m_cmd_man.cmd_final_at(this->m_flight_frame_index.get()),
-                this->m_swapchain.identity_extent(),
-                this->m_desc_man.desc_set_final_at(this->m_flight_frame_index.get()),
-                this->m_pipelines.final(),
-                this->m_fbuf_man.fbuf_final_at(swapchain_index),
-                this->m_renderpasses.rp_final()
-            );
-
-            VkSubmitInfo submit_info{};
-            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            submit_info.pCommandBuffers = &this->m_cmd_man.cmd_final_at(this->m_flight_frame_index.get());
-            submit_info.commandBufferCount = 1;
-            submit_info.waitSemaphoreCount = wait_semaphores.size();
-            submit_info.pWaitSemaphores = wait_semaphores.data();
-            submit_info.pWaitDstStageMask = wait_stages.data();
-            submit_info.signalSemaphoreCount = signal_semaphores.size();
-            submit_info.pSignalSemaphores = signal_semaphores.data();
+            const auto submit_start_sec = dal::get_cur_sec();
 
             const auto submit_result = vkQueueSubmit(
                 this->m_logi_device.queue_graphics(),
-                1,
-                &submit_info,
+                submit_count,
+                submit_infos.data(),
                 fence.get()
             );
 
+            this->m_submit_time_counter.add_sample(dal::get_cur_sec() - submit_start_sec);
             dalAssert(VK_SUCCESS == submit_result);
         }
 
@@ -781,21 +840,41 @@ namespace dal {
     }
 
     void VulkanState::apply_config(const RendererConfig& config) {
-        dalAbort("Not implemented");
+        // Other options only take effect on next launch
+        this->m_config.m_shader = config.m_shader;
+        this->m_config.m_texture_budget_mb = config.m_texture_budget_mb;
+        this->m_tex_streamer.set_budget(static_cast<size_t>(this->m_config.m_texture_budget_mb) * 1024 * 1024);
+        this->m_config.m_lod_bias = config.m_lod_bias;
+        this->m_config.m_shadow_lod_bias = config.m_shadow_lod_bias;
+
+        // Previous variant stays alive in PipelineManager so frames in flight are not affected
+        this->m_pipelines.apply_shader_config(
+            this->m_config.m_shader,
+            this->m_desc_layout_man,
+            this->m_renderpasses,
+            this->m_pipeline_cache.get(),
+            this->m_logi_device.get()
+        );
+    }
+
+    ImageFormat VulkanState::texture_cook_format() const {
+        if (this->m_phys_info.does_support_texture_compression_bc())
+            return ImageFormat::bc7_srgb;
+        else if (this->m_phys_info.does_support_texture_compression_etc2())
+            return ImageFormat::etc2_rgba8_srgb;
+        else
+            return ImageFormat::r8g8b8a8_srgb;
     }
 
     HTexture VulkanState::create_texture() {
         return this->m_vk_res_man.create_texture(
-            this->m_cmd_man.general_pool(),
-            this->m_logi_device.queue_graphics(),
-            this->m_phys_device.get(),
-            this->m_logi_device.get()
+            this->m_upload_man
         );
     }
 
     HMesh VulkanState::create_mesh() {
         return this->m_vk_res_man.create_mesh(
-            this->m_cmd_man.general_pool(),
+            this->m_upload_man,
             this->m_phys_device.get(),
             this->m_logi_device
         );
@@ -803,12 +882,11 @@ namespace dal {
 
     HRenModel VulkanState::create_model() {
         return this->m_vk_res_man.create_model(
-            this->m_cmd_man.general_pool(),
+            this->m_upload_man,
             this->m_texture_man,
             this->m_desc_layout_man.layout_per_actor(),
             this->m_desc_layout_man.layout_per_material(),
             this->m_sampler_man.sampler_tex(),
-            this->m_logi_device.queue_graphics(),
             this->m_phys_device.get(),
             this->m_logi_device.get()
         );
@@ -816,47 +894,34 @@ namespace dal {
 
     HRenModelSkinned VulkanState::create_model_skinned() {
         return this->m_vk_res_man.create_model_skinned(
-            this->m_cmd_man.general_pool(),
+            this->m_upload_man,
             this->m_texture_man,
             this->m_desc_layout_man.layout_per_actor(),
             this->m_desc_layout_man.layout_per_material(),
             this->m_sampler_man.sampler_tex(),
-            this->m_logi_device.queue_graphics(),
             this->m_phys_device.get(),
             this->m_logi_device.get()
         );
     }
 
     HActor VulkanState::create_actor() {
-        return this->m_vk_res_man.create_actor(
-            this->m_desc_allocator,
-            this->m_desc_layout_man.layout_per_actor(),
-            this->m_phys_device.get(),
-            this->m_logi_device.get()
-        );
+        return this->m_vk_res_man.create_actor(this->m_ubuf_man.m_ring);
     }
 
     HActorSkinned VulkanState::create_actor_skinned() {
-        return this->m_vk_res_man.create_actor_skinned(
-            this->m_desc_allocator,
-            this->m_desc_layout_man.layout_actor_animated(),
-            this->m_phys_device.get(),
-            this->m_logi_device.get()
-        );
+        return this->m_vk_res_man.create_actor_skinned(this->m_ubuf_man.m_ring);
     }
 
     void VulkanState::register_handle(HTexture& handle) {
         handle_cast(handle).give_dependencies(
-            this->m_cmd_man.general_pool(),
-            this->m_logi_device.queue_graphics(),
-            this->m_phys_device.get(),
-            this->m_logi_device.get()
+            this->m_upload_man
         );
+        this->m_vk_res_man.register_texture(handle);
     }
 
     void VulkanState::register_handle(HMesh& handle) {
         handle_cast(handle).give_dependencies(
-            this->m_cmd_man.general_pool(),
+            this->m_upload_man,
             this->m_phys_device.get(),
             this->m_logi_device
         );
@@ -864,12 +929,11 @@ namespace dal {
 
     void VulkanState::register_handle(HRenModel& handle) {
         handle_cast(handle).give_dependencies(
-            this->m_cmd_man.general_pool(),
+            this->m_upload_man,
             this->m_texture_man,
             this->m_desc_layout_man.layout_per_actor(),
             this->m_desc_layout_man.layout_per_material(),
             this->m_sampler_man.sampler_tex(),
-            this->m_logi_device.queue_graphics(),
             this->m_phys_device.get(),
             this->m_logi_device.get()
         );
@@ -877,33 +941,22 @@ namespace dal {
 
     void VulkanState::register_handle(HRenModelSkinned& handle) {
         handle_cast(handle).give_dependencies(
-            this->m_cmd_man.general_pool(),
+            this->m_upload_man,
             this->m_texture_man,
             this->m_desc_layout_man.layout_per_actor(),
             this->m_desc_layout_man.layout_per_material(),
             this->m_sampler_man.sampler_tex(),
-            this->m_logi_device.queue_graphics(),
             this->m_phys_device.get(),
             this->m_logi_device.get()
         );
     }
 
     void VulkanState::register_handle(HActor& handle) {
-        handle_cast(handle).give_dependencies(
-            this->m_desc_allocator,
-            this->m_desc_layout_man.layout_per_actor(),
-            this->m_phys_device.get(),
-            this->m_logi_device.get()
-        );
+        handle_cast(handle).give_dependencies(this->m_ubuf_man.m_ring);
     }
 
     void VulkanState::register_handle(HActorSkinned& handle) {
-        handle_cast(handle).give_dependencies(
-            this->m_desc_allocator,
-            this->m_desc_layout_man.layout_actor_animated(),
-            this->m_phys_device.get(),
-            this->m_logi_device.get()
-        );
+        handle_cast(handle).give_dependencies(this->m_ubuf_man.m_ring);
     }
 
     // Private
@@ -932,11 +985,16 @@ namespace dal {
         if (!result_swapchain)
             return false;
 
-        this->m_renderpasses.init(
-            this->m_swapchain.format(),
-            this->m_phys_device.find_depth_format(),
-            this->m_logi_device.get()
-        );
+        // Render passes and pipelines only depend on swapchain format, which rarely changes on resize or rotation
+        const bool need_rebuild_pipelines = this->m_renderpass_format != this->m_swapchain.format();
+
+        if (need_rebuild_pipelines) {
+            this->m_renderpasses.init(
+                this->m_swapchain.format(),
+                this->m_phys_device.find_depth_format(),
+                this->m_logi_device.get()
+            );
+        }
 
         const auto extent_gbuf = ::calc_smaller_extent(this->m_new_extent, 0.9);
 
@@ -947,12 +1005,14 @@ namespace dal {
             this->m_logi_device.get()
         );
 
-        this->m_shadow_maps.init(this->m_renderpasses.rp_shadow(), this->m_phys_device, this->m_logi_device);
+        if (need_rebuild_pipelines) {
+            this->m_shadow_maps.init(this->m_renderpasses.rp_shadow(), this->m_phys_device, this->m_logi_device);
 
-        this->m_ref_planes.init(
-            this->m_phys_device.get(),
-            this->m_logi_device
-        );
+            this->m_ref_planes.init(
+                this->m_phys_device.get(),
+                this->m_logi_device
+            );
+        }
 
         this->m_fbuf_man.init(
             this->m_swapchain.views(),
@@ -965,17 +1025,30 @@ namespace dal {
             this->m_logi_device.get()
         );
 
-        this->m_pipelines.init(
-            this->m_filesys,
-            this->m_config.m_shader,
-            !this->m_swapchain.is_format_srgb(),
-            this->m_phys_info.does_support_depth_clamp(),
-            this->m_swapchain.identity_extent(),
-            this->m_attach_man.color().extent(),
-            this->m_desc_layout_man,
-            this->m_renderpasses,
-            this->m_logi_device.get()
-        );
+        if (need_rebuild_pipelines) {
+            const auto pipeline_start_sec = dal::get_cur_sec();
+            this->m_pipelines.init(
+                this->m_filesys,
+                this->m_config.m_shader,
+                !this->m_swapchain.is_format_srgb(),
+                this->m_phys_info.does_support_depth_clamp(),
+                this->m_desc_layout_man,
+                this->m_renderpasses,
+                this->m_pipeline_cache.get(),
+                this->m_logi_device.get(),
+                this->m_task_man
+            );
+            dalInfo(fmt::format(
+                "Pipelines built in {:.3f} sec (pipeline cache had {} bytes on launch)",
+                dal::get_cur_sec() - pipeline_start_sec,
+                this->m_pipeline_cache.loaded_size()
+            ).c_str());
+
+            if (!this->m_pipeline_cache.save(this->m_filesys, this->m_phys_device.get(), this->m_logi_device.get()))
+                dalWarn("Failed to save pipeline cache");
+
+            this->m_renderpass_format = this->m_swapchain.format();
+        }
 
         this->m_cmd_man.init(
             MAX_FRAMES_IN_FLIGHT,
@@ -983,7 +1056,14 @@ namespace dal {
             this->m_logi_device.get()
         );
 
-        this->m_ubuf_man.init(this->m_phys_device.get(), this->m_logi_device.get());
+        const auto result_ubuf = this->m_ubuf_man.init(
+            this->m_ubuf_ring_capacity,
+            this->m_phys_device.get(),
+            this->m_logi_device.get()
+        );
+
+        if (!result_ubuf)
+            return false;
 
         U_Shader_Final data;
         data.m_rotation = this->m_swapchain.pre_ratation_mat();
@@ -992,73 +1072,106 @@ namespace dal {
         this->m_desc_man.init(MAX_FRAMES_IN_FLIGHT, this->m_logi_device.get());
 
         for (int i = 0; i < dal::MAX_FRAMES_IN_FLIGHT; ++i) {
-            auto& desc_per_global = this->m_desc_man.add_descset_per_global(
-                this->m_desc_layout_man.layout_per_global(),
+            this->m_desc_man.add_descset_per_global(this->m_desc_layout_man.layout_per_global(), this->m_logi_device.get());
+            this->m_desc_man.add_descset_per_actor(this->m_desc_layout_man.layout_per_actor(), this->m_logi_device.get());
+            this->m_desc_man.add_descset_actor_animated(this->m_desc_layout_man.layout_actor_animated(), this->m_logi_device.get());
+            this->m_desc_man.add_descset_composition(this->m_desc_layout_man.layout_composition(), this->m_logi_device.get());
+            this->m_desc_man.add_descset_alpha(this->m_desc_layout_man.layout_alpha(), this->m_logi_device.get());
+
+            auto& desc_final = this->m_desc_man.add_descset_final(
+                this->m_desc_layout_man.layout_final(),
                 this->m_logi_device.get()
             );
 
-            desc_per_global.record_per_global(
-                this->m_ubuf_man.m_u_camera_transform.at(i),
-                this->m_ubuf_man.m_ub_glights.at(i),
+            desc_final.record_final(
+                this->m_attach_man.color().view().get(),
+                this->m_sampler_man.sampler_tex(),
+                this->m_ubuf_man.m_ub_final,
                 this->m_logi_device.get()
             );
+        }
 
-            auto& desc_composition = this->m_desc_man.add_descset_composition(
-                this->m_desc_layout_man.layout_composition(),
-                this->m_logi_device.get()
+        this->record_ring_descsets();
+
+        if (need_rebuild_pipelines) {
+            this->m_shadow_maps.render_empty_for_all(
+                this->m_pipelines,
+                this->m_renderpasses.rp_shadow(),
+                this->m_logi_device
             );
+        }
 
-            const std::vector<VkImageView> color_attachments{
-                this->m_attach_man.depth().view().get(),
-                this->m_attach_man.albedo().view().get(),
-                this->m_attach_man.materials().view().get(),
-                this->m_attach_man.normal().view().get(),
-            };
+        return true;
+    }
 
-            desc_composition.record_composition(
-                color_attachments,
-                this->m_ubuf_man.m_ub_glights.at(i),
-                this->m_ubuf_man.m_u_camera_transform.at(i),
-                this->m_shadow_maps.dlight_views(),
-                this->m_shadow_maps.slight_views(),
-                this->m_sampler_man.sampler_depth(),
+    void VulkanState::record_ring_descsets() {
+        const std::vector<VkImageView> color_attachments{
+            this->m_attach_man.depth().view().get(),
+            this->m_attach_man.albedo().view().get(),
+            this->m_attach_man.materials().view().get(),
+            this->m_attach_man.normal().view().get(),
+        };
+
+        for (uint32_t i = 0; i < dal::MAX_FRAMES_IN_FLIGHT; ++i) {
+            this->m_desc_man.descset_per_global(i).record_per_global(
+                this->m_ubuf_man.m_ring,
+                i,
                 this->m_logi_device.get()
             );
 
-            auto& desc_final = this->m_desc_man.add_descset_final(
-                this->m_desc_layout_man.layout_final(),
+            this->m_desc_man.descset_per_actor(i).record_per_actor(
+                this->m_ubuf_man.m_ring,
+                i,
                 this->m_logi_device.get()
             );
 
-            desc_final.record_final(
-                this->m_attach_man.color().view().get(),
-                this->m_sampler_man.sampler_tex(),
-                this->m_ubuf_man.m_ub_final,
+            this->m_desc_man.descset_actor_animated(i).record_actor_animated(
+                this->m_ubuf_man.m_ring,
+                i,
                 this->m_logi_device.get()
             );
 
-            auto& desc_alpha = this->m_desc_man.add_descset_alpha(
-                this->m_desc_layout_man.layout_alpha(),
+            this->m_desc_man.descset_composition(i).record_composition(
+                color_attachments,
+                this->m_ubuf_man.m_ring,
+                i,
+                this->m_shadow_maps.dlight_views(),
+                this->m_shadow_maps.slight_views(),
+                this->m_sampler_man.sampler_depth(),
                 this->m_logi_device.get()
             );
 
-            desc_alpha.record_alpha(
-                this->m_ubuf_man.m_u_camera_transform.at(i),
-                this->m_ubuf_man.m_ub_glights.at(i),
+            this->m_desc_man.descset_alpha(i).record_alpha(
+                this->m_ubuf_man.m_ring,
+                i,
                 this->m_shadow_maps.dlight_views(),
                 this->m_shadow_maps.slight_views(),
                 this->m_sampler_man.sampler_depth(),
                 this->m_logi_device.get()
             );
         }
+    }
 
-        this->m_shadow_maps.render_empty_for_all(
-            this->m_pipelines,
-            this->m_renderpasses.rp_shadow(),
-            this->m_logi_device
+    void VulkanState::grow_ubuf_ring(const VkDeviceSize required_size) {
+        while (this->m_ubuf_ring_capacity < required_size)
+            this->m_ubuf_ring_capacity *= 2;
+
+        dalInfo(fmt::format("Uniform ring buffer grows to {} bytes", this->m_ubuf_ring_capacity).c_str());
+
+        // Frames in flight may still read the old buffers
+        this->wait_idle();
+
+        const auto result = this->m_ubuf_man.m_ring.init(
+            dal::MAX_FRAMES_IN_FLIGHT,
+            this->m_ubuf_ring_capacity,
+            this->m_phys_device.get(),
+            this->m_logi_device.get()
         );
 
-        return true;
+        if (!result)
+            dalAbort("Failed to grow uniform ring buffer");
+
+        this->record_ring_descsets();
     }
 
 }
@@ -8,6 +8,7 @@
 #include "dal/util/task_thread.h"
 #include "d_renderer.h"
 #include "d_vk_managers.h"
+#include "d_texture_stream.h"
 
 
 #define DAL_VK_DEBUG
@@ -20,6 +21,7 @@ namespace dal {
     private:
         // Non-vulkan members
         dal::Filesystem& m_filesys;
+        dal::TaskManager& m_task_man;
         ITextureManager& m_texture_man;
 
         RendererConfig m_config;
@@ -30,6 +32,8 @@ namespace dal {
         PhysicalDevice m_phys_device;
         PhysDeviceInfo m_phys_info;
         LogicalDevice m_logi_device;
+        UploadManager m_upload_man;
+        PipelineCache m_pipeline_cache;
 
         SwapchainManager m_swapchain;
         PipelineManager m_pipelines;
@@ -39,9 +43,11 @@ namespace dal {
         CmdPoolManager m_cmd_man;
         DescSetLayoutManager m_desc_layout_man;
         UbufManager m_ubuf_man;
+        IndirectCmdBuffer m_indirect_cmds;
         DescriptorManager m_desc_man;
 
         SamplerManager m_sampler_man;
+        TextureStreamer m_tex_streamer;
         DescAllocator m_desc_allocator;
         ShadowMapManager m_shadow_maps;
         PlanarReflectionManager m_ref_planes;
@@ -53,7 +59,12 @@ namespace dal {
         FrameInFlightIndex m_flight_frame_index;
         bool m_screen_resize_notified = false;
         VkExtent2D m_new_extent;
+        VkFormat m_renderpass_format = VK_FORMAT_UNDEFINED;
         uint64_t m_frame_count = 0;
+        VkDeviceSize m_ubuf_ring_capacity;
+        // Largest size a frame needed but didn't fit in the ring
+        VkDeviceSize m_ubuf_ring_overflow_size = 0;
+        CpuTimeCounter m_submit_time_counter{ "Queue submit", 10 };
 
     public:
         VulkanState(
@@ -82,6 +93,8 @@ namespace dal {
 
         void apply_config(const RendererConfig& config) override;
 
+        ImageFormat texture_cook_format() const override;
+
         HTexture create_texture() override;
 
         HMesh create_mesh() override;
@@ -113,6 +126,12 @@ namespace dal {
         [[nodiscard]]
         bool init_swapchain_and_dependers();
 
+        // Descriptor sets which point at buffers of uniform ring
+        void record_ring_descsets();
+
+        // Waits for device idle, so call it only before anything of the frame is submitted
+        void grow_ubuf_ring(const VkDeviceSize required_size);
+
     };
 
 }
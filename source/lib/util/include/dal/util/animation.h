@@ -111,6 +111,9 @@ namespace dal {
             this->m_joints.clear();
         }
 
+        // Call after every joint is set
+        void update_parent_mats();
+
     private:
         jointID_t upsize_and_get_index(void);
 
@@ -165,6 +168,10 @@ namespace dal {
             return this->m_joints.emplace_back();
         }
 
+        auto& joints() const {
+            return this->m_joints;
+        }
+
         auto& name() const {
             return this->m_name;
         }
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+#include "dal/util/filesystem.h"
+
+
+namespace dal {
+
+    // Must match script/pack_assets.py
+    constexpr uint32_t ASSET_PACK_VERSION = 1;
+
+    enum class AssetPackCompression : uint8_t {
+        none = 0,
+        lz4 = 1,  // LZ4 block format, without frame
+    };
+
+
+    // Read-only archive of whole asset folder, built by script/pack_assets.py.
+    // Paths are relative to asset folder and separated by '/'.
+    class AssetPack {
+
+    private:
+        struct Entry {
+            std::string m_path;
+            uint64_t m_path_hash = 0;
+            uint64_t m_data_offset = 0;
+            uint64_t m_stored_size = 0;
+            uint64_t m_size = 0;
+            AssetPackCompression m_compression = AssetPackCompression::none;
+        };
+
+        struct Folder {
+            std::vector<std::string> m_files;
+            std::vector<std::string> m_folders;
+        };
+
+    private:
+        std::shared_ptr<IFileMapping> m_file;
+        // Sorted by path hash so that lookups are binary search
+        std::vector<Entry> m_entries;
+        // Root folder has empty string as its path
+        std::unordered_map<std::string, Folder> m_folders;
+        // Entry name to paths of every file and folder having it, for '?' and '*' in ResPath
+        std::unordered_map<std::string, std::vector<std::string>> m_names;
+
+    public:
+        // Whole pack must be kept mapped because uncompressed entries are served out of it
+        bool open(std::unique_ptr<IFileMapping>&& file);
+
+        bool is_ready() const {
+            return nullptr != this->m_file;
+        }
+
+        bool is_file(const std::string& path) const;
+
+        bool is_folder(const std::string& path) const;
+
+        size_t list_files(const std::string& path, std::vector<std::string>& output) const;
+
+        size_t list_folders(const std::string& path, std::vector<std::string>& output) const;
+
+        // Same rules as dal::resolve_path. Output is relative to asset folder.
+        std::optional<std::string> resolve(const ResPath& respath, const size_t start_index) const;
+
+        // Uncompressed entries are not copied
+        std::unique_ptr<IFileMapping> map(const std::string& path) const;
+
+    private:
+        const Entry* find_entry(const std::string& path) const;
+
+        std::optional<std::string> find_under(const std::string& dir, const std::string& name) const;
+
+        std::optional<std::string> find_in_children(const std::string& dir, const std::string& name) const;
+
+    };
+
+
+    class AssetManagerPack : public IAssetManager {
+
+    private:
+        AssetPack m_pack;
+
+    public:
+        // Check is_ready after construction since pack file may be invalid
+        AssetManagerPack(std::unique_ptr<IFileMapping>&& pack_file);
+
+        bool is_ready() const {
+            return this->m_pack.is_ready();
+        }
+
+        bool is_file(const dal::ResPath& path) override;
+
+        bool is_folder(const dal::ResPath& path) override;
+
+        size_t list_files(const dal::ResPath& path, std::vector<std::string>& output) override;
+
+        size_t list_folders(const dal::ResPath& path, std::vector<std::string>& output) override;
+
+        std::optional<ResPath> resolve(const ResPath& path) override;
+
+        std::unique_ptr<FileReadOnly> open(const dal::ResPath& path) override;
+
+        std::unique_ptr<IFileMapping> map(const dal::ResPath& path) override;
+
+    };
+
+
+    bool decompress_lz4_block(const uint8_t* const src, const size_t src_size, uint8_t* const dst, const size_t dst_size);
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <filesystem>
+
+#include "dal/util/filesystem.h"
+
+
+namespace dal {
+
+    // Filled by AsyncFileIO on its own thread, polled by whoever asked for it
+    class AsyncReadResult {
+
+    private:
+        std::unique_ptr<IFileMapping> m_data;
+        std::atomic_bool m_done = false;
+
+    public:
+        bool is_done() const {
+            return this->m_done.load(std::memory_order_acquire);
+        }
+
+        // Must be called only after is_done. Null mapping if read failed.
+        std::unique_ptr<IFileMapping> take();
+
+        // For backends only
+        void set(std::unique_ptr<IFileMapping>&& data);
+
+    };
+
+    using HAsyncRead = std::shared_ptr<AsyncReadResult>;
+
+
+    // Reads whole files in background. Uses io_uring on Linux if kernel allows it, and thread pool otherwise.
+    class AsyncFileIO {
+
+    private:
+        class IoUring;
+        class ThreadPool;
+
+        // Null if io_uring is not available
+        std::unique_ptr<IoUring> m_uring;
+        std::unique_ptr<ThreadPool> m_pool;
+
+    public:
+        AsyncFileIO();
+
+        ~AsyncFileIO();
+
+        AsyncFileIO(const AsyncFileIO&) = delete;
+        AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+        void read(const std::filesystem::path& path, const HAsyncRead& result);
+
+        // For files without native path, like the ones in asset pack or APK
+        void run(std::function<std::unique_ptr<IFileMapping>()> job, const HAsyncRead& result);
+
+    };
+
+}
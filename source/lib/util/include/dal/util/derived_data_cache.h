@@ -0,0 +1,100 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "dal/util/filesystem.h"
+
+
+namespace dal {
+
+    // Same key always means same output, so entries never need to be invalidated
+    struct DerivedDataKey {
+        // Hash of source content
+        uint64_t m_content_hash = 0;
+        // Bump it whenever code making the output changes
+        uint32_t m_version = 0;
+        // Hash of everything else output depends on, like target format
+        uint64_t m_options_hash = 0;
+
+        uint64_t hash_value() const;
+    };
+
+
+    // Blobs made out of source files, like SPIR-V, cooked textures and cooked models.
+    // Least recently used entries are removed when total size exceeds limit. Thread safe.
+    class DerivedDataCache {
+
+    public:
+        static constexpr size_t DEFAULT_SIZE_LIMIT = 512 * 1024 * 1024;
+
+    private:
+        struct Entry {
+            // Category and key hash, like "tex/0123456789abcdef"
+            std::string m_name;
+            size_t m_size = 0;
+        };
+
+        Filesystem& m_filesys;
+        const size_t m_size_limit;
+        size_t m_total_size = 0;
+
+        // Front is least recently used
+        std::list<Entry> m_lru;
+        std::unordered_map<std::string, std::list<Entry>::iterator> m_entries;
+        // Entries being written are neither read nor written by other threads
+        std::unordered_set<std::string> m_writing;
+        mutable std::mutex m_mut;
+        std::mutex m_index_file_mut;
+        // Bumped under m_mut for each index snapshot, so that a snapshot older than what is on disk is never written
+        uint64_t m_index_generation = 0;
+        // Guarded by m_index_file_mut
+        uint64_t m_saved_index_generation = 0;
+
+    public:
+        DerivedDataCache(Filesystem& filesys, const size_t size_limit = DEFAULT_SIZE_LIMIT);
+
+        ~DerivedDataCache();
+
+        DerivedDataCache(const DerivedDataCache&) = delete;
+        DerivedDataCache& operator=(const DerivedDataCache&) = delete;
+
+        // Null mapping on miss
+        std::unique_ptr<IFileMapping> get(const char* const category, const DerivedDataKey& key);
+
+        // False if it could not be stored, which is not an error for callers since they have the data anyway
+        bool put(const char* const category, const DerivedDataKey& key, const void* const data, const size_t data_size);
+
+        template <typename T>
+        bool put(const char* const category, const DerivedDataKey& key, const std::vector<T>& data) {
+            return this->put(category, key, data.data(), data.size() * sizeof(T));
+        }
+
+        size_t total_size() const;
+
+        void save_index();
+
+    private:
+        void load_index();
+
+        // For when index file is lost, like when app was killed before saving it
+        void rebuild_index();
+
+        // Must be called with m_mut locked
+        void add_entry(const std::string& name, const size_t size);
+
+        // Must be called with m_mut locked
+        void remove_entry(const std::string& name);
+
+        // Must be called with m_mut locked. Returns names of evicted entries, files of which are not removed yet.
+        std::vector<std::string> evict_over_limit();
+
+    };
+
+}
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <mutex>
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <memory>
 #include <fstream>
 #include <optional>
 #include <filesystem>
+#include <unordered_map>
 
 
 namespace dal {
@@ -128,9 +131,28 @@ namespace dal {
     };
 
 
+    // Read-only view of whole file content, which stays valid as long as this object lives
+    class IFileMapping {
+
+    public:
+        virtual ~IFileMapping() = default;
+
+        virtual const uint8_t* data() const = 0;
+
+        virtual size_t size() const = 0;
+
+        bool is_ready() const {
+            return nullptr != this->data();
+        }
+
+    };
+
+
     class IFileManager {
 
     public:
+        virtual ~IFileManager() = default;
+
         virtual bool is_file(const ResPath& path) = 0;
 
         virtual bool is_folder(const ResPath& path) = 0;
@@ -141,6 +163,14 @@ namespace dal {
 
         virtual std::optional<ResPath> resolve(const ResPath& path) = 0;
 
+        // Path OS can open directly. Null for files that are not on disk as they are, like the ones in APK.
+        virtual std::optional<std::filesystem::path> native_path(const ResPath& path) {
+            return std::nullopt;
+        }
+
+        // Forgets whatever was cached about the storage, in case it changed outside
+        virtual void refresh() {}
+
     };
 
 
@@ -149,6 +179,9 @@ namespace dal {
     public:
         virtual std::unique_ptr<FileReadOnly> open(const ResPath& path) = 0;
 
+        // Default implementation reads whole file into heap. Override it where OS can map files.
+        virtual std::unique_ptr<IFileMapping> map(const ResPath& path);
+
     };
 
 
@@ -159,6 +192,12 @@ namespace dal {
 
         virtual std::unique_ptr<IFileWriteOnly> open_write(const ResPath& path) = 0;
 
+        // False if there was no such file
+        virtual bool remove(const ResPath& path) = 0;
+
+        // Default implementation reads whole file into heap. Override it where OS can map files.
+        virtual std::unique_ptr<IFileMapping> map(const ResPath& path);
+
     };
 
 
@@ -177,23 +216,32 @@ namespace dal {
     };
 
 
+    class AsyncFileIO;
+    class AsyncReadResult;
+    class DerivedDataCache;
+
+
     class Filesystem {
 
     private:
         std::unique_ptr<IAssetManager> m_asset_mgr;
         std::unique_ptr<IUserDataManager> m_userdata_mgr;
         std::unique_ptr<IInternalManager> m_internal_mgr;
+        // Declared after managers so that its threads stop before managers they use are gone
+        std::unique_ptr<AsyncFileIO> m_async_io;
+        // Declared last so that it saves its index while managers are still alive
+        std::unique_ptr<DerivedDataCache> m_derived_data;
 
     public:
+        Filesystem();
+
+        ~Filesystem();
+
         void init(
             std::unique_ptr<IAssetManager>&& asset_mgr,
             std::unique_ptr<IUserDataManager>&& userdata_mgr,
             std::unique_ptr<IInternalManager>&& internal_mgr
-        ) {
-            this->m_asset_mgr = std::move(asset_mgr);
-            this->m_userdata_mgr = std::move(userdata_mgr);
-            this->m_internal_mgr = std::move(internal_mgr);
-        }
+        );
 
         bool is_file(const ResPath& path);
 
@@ -221,6 +269,19 @@ namespace dal {
 
         std::unique_ptr<IFileWriteOnly> open_write(const ResPath& path);
 
+        // Only files in _internal can be removed
+        bool remove(const ResPath& path);
+
+        std::unique_ptr<IFileMapping> map(const ResPath& path);
+
+        // Whole file is read in background. Poll is_done of the result, which never blocks.
+        std::shared_ptr<AsyncReadResult> read_async(const ResPath& path);
+
+        void refresh();
+
+        // Valid after init
+        DerivedDataCache& derived_data();
+
     };
 
 
@@ -262,8 +323,60 @@ namespace dal {
 
     std::unique_ptr<IFileWriteOnly> make_file_write_only_null();
 
+    std::unique_ptr<IFileMapping> make_file_mapping_null();
+
+    std::unique_ptr<IFileMapping> make_file_mapping_heap(std::vector<uint8_t>&& data);
+
+    // Reads whole file into a heap mapping. Null mapping on failure.
+    std::unique_ptr<IFileMapping> make_file_mapping_heap(FileReadOnly& file);
+
+    // Uses mmap where available and falls back to reading into heap
+    std::unique_ptr<IFileMapping> map_file(const std::filesystem::path& path);
+
+    // Maps every entry name under a folder to where it is, so that wildcards need no directory scan.
+    // Built on first query and kept until reset, so entries created after that are not found.
+    class FilenameIndex {
+
+    private:
+        // Paths are in the order recursive_directory_iterator found them
+        std::unordered_map<std::string, std::vector<std::filesystem::path>> m_entries;
+        std::filesystem::path m_root;
+        std::mutex m_mut;
+        bool m_built = false;
+
+    public:
+        void reset();
+
+        // For '?', which matches entry anywhere under dir
+        std::optional<std::filesystem::path> find_under(
+            const std::filesystem::path& root,
+            const std::filesystem::path& dir,
+            const std::string& name
+        );
+
+        // For '*', which matches entry in any direct child folder of dir
+        std::optional<std::filesystem::path> find_in_children(
+            const std::filesystem::path& root,
+            const std::filesystem::path& dir,
+            const std::string& name
+        );
+
+    private:
+        void build_if_needed(const std::filesystem::path& root);
+
+    };
+
+
     std::optional<std::string> resolve_path(const dal::ResPath& respath, const std::filesystem::path& start_dir, const size_t start_index);
 
+    // Miss in index is final and nothing is scanned. Reset index to see entries created after it was built.
+    std::optional<std::string> resolve_path(
+        const dal::ResPath& respath,
+        const std::filesystem::path& start_dir,
+        const size_t start_index,
+        FilenameIndex& index
+    );
+
     void create_folders_of_path(const std::filesystem::path& path, const size_t exclude_last_n);
 
 }
@@ -4,14 +4,46 @@
 
 #if defined(DAL_OS_WINDOWS) || defined(DAL_OS_LINUX)
 
+#include <mutex>
+
 #include "dal/util/filesystem.h"
 
 
 namespace dal {
 
+    // Finding a domain folder takes many filesystem calls so it is done once, until refreshed
+    class DomainRootCache {
+
+    public:
+        using finder_t = std::optional<std::filesystem::path>(*)();
+
+    private:
+        std::optional<std::filesystem::path> m_root;
+        std::mutex m_mut;
+        const finder_t m_finder;
+        bool m_searched = false;
+
+    public:
+        DomainRootCache(const finder_t finder);
+
+        std::optional<std::filesystem::path> get();
+
+        void refresh();
+
+    };
+
+
     class AssetManagerSTD : public IAssetManager {
 
+    private:
+        DomainRootCache m_root;
+        FilenameIndex m_name_index;
+
     public:
+        AssetManagerSTD();
+
+        void refresh() override;
+
         bool is_file(const dal::ResPath& path) override;
 
         bool is_folder(const dal::ResPath& path) override;
@@ -22,14 +54,26 @@ namespace dal {
 
         std::optional<ResPath> resolve(const ResPath& path) override;
 
+        std::optional<std::filesystem::path> native_path(const ResPath& path) override;
+
         std::unique_ptr<FileReadOnly> open(const dal::ResPath& path) override;
 
+        std::unique_ptr<IFileMapping> map(const dal::ResPath& path) override;
+
     };
 
 
     class UserDataManagerSTD : public IUserDataManager {
 
+    private:
+        DomainRootCache m_root;
+        FilenameIndex m_name_index;
+
     public:
+        UserDataManagerSTD();
+
+        void refresh() override;
+
         bool is_file(const dal::ResPath& path) override;
 
         bool is_folder(const dal::ResPath& path) override;
@@ -40,14 +84,26 @@ namespace dal {
 
         std::optional<ResPath> resolve(const ResPath& path) override;
 
+        std::optional<std::filesystem::path> native_path(const ResPath& path) override;
+
         std::unique_ptr<FileReadOnly> open(const dal::ResPath& path) override;
 
+        std::unique_ptr<IFileMapping> map(const dal::ResPath& path) override;
+
     };
 
 
     class InternalManagerSTD : public IInternalManager {
 
+    private:
+        DomainRootCache m_root;
+        FilenameIndex m_name_index;
+
     public:
+        InternalManagerSTD();
+
+        void refresh() override;
+
         bool is_file(const dal::ResPath& path) override;
 
         bool is_folder(const dal::ResPath& path) override;
@@ -58,12 +114,26 @@ namespace dal {
 
         std::optional<ResPath> resolve(const ResPath& path) override;
 
+        std::optional<std::filesystem::path> native_path(const ResPath& path) override;
+
         std::unique_ptr<FileReadOnly> open_read(const ResPath& path) override;
 
         std::unique_ptr<IFileWriteOnly> open_write(const ResPath& path) override;
 
+        bool remove(const ResPath& path) override;
+
+        std::unique_ptr<IFileMapping> map(const ResPath& path) override;
+
     };
 
+
+    // True if "--asset-pack" is in arguments or DAL_ASSET_PACK environment variable is set to non-zero
+    bool is_asset_pack_requested(const int argc, const char* const* const argv);
+
+    // Serves assets out of asset pack only if requested and the pack is not older than asset folder.
+    // Falls back to asset folder otherwise.
+    std::unique_ptr<IAssetManager> make_asset_manager_std(const bool use_asset_pack);
+
 }
 
 #endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace dal {
+
+    // xxHash64. Fast and non-cryptographic, for detecting content changes only.
+    uint64_t hash_xx64(const void* const data, const size_t data_size, const uint64_t seed = 0);
+
+    inline uint64_t hash_xx64(const std::string& data, const uint64_t seed = 0) {
+        return hash_xx64(data.data(), data.size(), seed);
+    }
+
+    template <typename T>
+    uint64_t hash_xx64(const std::vector<T>& data, const uint64_t seed = 0) {
+        return hash_xx64(data.data(), data.size() * sizeof(T), seed);
+    }
+
+}
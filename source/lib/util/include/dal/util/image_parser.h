@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <cstdint>
 #include <optional>
@@ -7,18 +8,37 @@
 
 namespace dal {
 
+    // Values are stored in cooked texture files so only append new ones
     enum class ImageFormat {
         r8g8b8a8_srgb,
+        bc7_srgb,
+        etc2_rgba8_srgb,
+        astc_4x4_srgb,
     };
 
+    bool is_format_compressed(const ImageFormat format);
+
+    // Size in bytes of a single mip level
+    size_t calc_image_data_size(const ImageFormat format, const uint32_t width, const uint32_t height);
+
+
+    // Pixel memory is either owned, shared with whatever it was decoded or read into, or borrowed.
+    // Copying this class does not copy pixels.
     class ImageData {
 
     private:
-        std::vector<uint8_t> m_data;
-        uint32_t m_width, m_height, m_channels;
-        ImageFormat m_format;
+        // Null if memory is borrowed
+        std::shared_ptr<const uint8_t> m_storage;
+        const uint8_t* m_data = nullptr;
+        size_t m_data_size = 0;
+
+        uint32_t m_width = 0, m_height = 0, m_channels = 0;
+        uint32_t m_mip_levels = 1;
+        ImageFormat m_format = ImageFormat::r8g8b8a8_srgb;
 
     public:
+        ImageData() = default;
+
         ImageData(
             const void* const data,
             const uint32_t width,
@@ -27,6 +47,15 @@ namespace dal {
             const ImageFormat format
         );
 
+        // Mip levels are packed tightly one after another, from the largest
+        ImageData(
+            std::vector<uint8_t>&& data,
+            const uint32_t width,
+            const uint32_t height,
+            const uint32_t mip_levels,
+            const ImageFormat format
+        );
+
         void set(
             const void* const data,
             const uint32_t width,
@@ -35,6 +64,46 @@ namespace dal {
             const ImageFormat format
         );
 
+        void set_mip_chain(
+            std::vector<uint8_t>&& data,
+            const uint32_t width,
+            const uint32_t height,
+            const uint32_t mip_levels,
+            const ImageFormat format
+        );
+
+        // Storage keeps data alive. It may point to somewhere in the middle of a bigger allocation.
+        void set_shared(
+            std::shared_ptr<const uint8_t> storage,
+            const size_t data_size,
+            const uint32_t width,
+            const uint32_t height,
+            const uint32_t mip_levels,
+            const ImageFormat format
+        );
+
+        // Caller must keep data alive while this or any copy of this is in use
+        void set_borrowed(
+            const void* const data,
+            const size_t data_size,
+            const uint32_t width,
+            const uint32_t height,
+            const uint32_t mip_levels,
+            const ImageFormat format
+        );
+
+        bool is_borrowed() const {
+            return nullptr == this->m_storage && nullptr != this->m_data;
+        }
+
+        uint32_t mip_width(const uint32_t mip_level) const;
+
+        uint32_t mip_height(const uint32_t mip_level) const;
+
+        size_t mip_offset(const uint32_t mip_level) const;
+
+        size_t mip_size(const uint32_t mip_level) const;
+
         auto width() const {
             return this->m_width;
         }
@@ -51,17 +120,22 @@ namespace dal {
             return this->m_format;
         }
 
+        auto mip_levels() const {
+            return this->m_mip_levels;
+        }
+
         auto data_size() const {
-            return this->m_data.size();
+            return this->m_data_size;
         }
 
         auto data() const {
-            return this->m_data.data();
+            return this->m_data;
         }
 
     };
 
 
+    // Returned image takes the buffer stb decoded into, without copying it
     std::optional<ImageData> parse_image_stb(const uint8_t* const buf, const size_t buf_size);
 
 }
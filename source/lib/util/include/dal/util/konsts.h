@@ -16,6 +16,7 @@ namespace dal {
     const char* const FOLDER_NAME_ASSET = "asset";
     const char* const FOLDER_NAME_USERDATA = "userdata";
     const char* const FOLDER_NAME_INTERNAL = "internal";
+    const char* const FILE_NAME_ASSET_PACK = "asset.dpak";
     const char* const SPECIAL_NAMESPACE_ASSET = "_asset";
     const char* const SPECIAL_NAMESPACE_INTERNAL = "_internal";
 
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "dal/util/model_data.h"
+
+
+namespace dal {
+
+    // Collapses edges of a triangle list into one of their end vertices, so output indices draw from the same vertices.
+    // Stops once index count is at most target_index_count, or when next collapse would make error larger than max_error.
+    // Error is root mean square distance from planes of original triangles, in the unit of positions.
+    std::vector<uint32_t> simplify_mesh(
+        const std::vector<glm::vec3>& positions,
+        const std::vector<uint32_t>& indices,
+        const size_t target_index_count,
+        const float max_error,
+        float& out_error
+    );
+
+    // Fills m_lods with levels each having about half the triangles of previous one.
+    // Bounding box of the unit must be calculated beforehand.
+    void build_lods(RenderUnitStatic& unit);
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "dal/util/image_parser.h"
+
+
+namespace dal {
+
+    // floor(log2(max(width, height))) + 1, which goes all the way down to 1x1
+    uint32_t calc_mip_levels(const uint32_t width, const uint32_t height);
+
+    // Source must be single level r8g8b8a8_srgb. Output has every level down to 1x1.
+    // Colour is averaged in linear space and alpha as it is.
+    ImageData build_mip_chain(const ImageData& src);
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+#include "dal/util/model_data.h"
+
+
+namespace dal {
+
+    // Change this whenever cooked output or vertex layouts change so stale cache files are not used
+    constexpr uint32_t MODEL_COOK_VERSION = 2;
+
+    // Vertices and indices are stored exactly as render units hold them, so loading them is one copy per unit.
+    std::vector<uint8_t> serialize_cooked_model(const ModelStatic& model);
+
+    std::vector<uint8_t> serialize_cooked_model(const ModelSkinned& model);
+
+    std::optional<ModelStatic> parse_cooked_model_static(const uint8_t* const buf, const size_t buf_size);
+
+    std::optional<ModelSkinned> parse_cooked_model_skinned(const uint8_t* const buf, const size_t buf_size);
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cmath>
+
 #include "dal/util/animation.h"
 
 
@@ -32,12 +34,24 @@ namespace dal {
         std::vector<uint32_t> m_indices;
     };
 
+    // Coarser version of a render unit's mesh which draws from the same vertices
+    struct MeshLod {
+        std::vector<uint32_t> m_indices;
+        // How far simplified surface is from original, relative to bounding sphere radius
+        float m_error = 0;
+    };
+
     template <typename _Vertex>
     struct TRenderUnit {
         std::vector<_Vertex> m_vertices;
         std::vector<uint32_t> m_indices;
+        // From finer to coarser, all coarser than m_indices
+        std::vector<MeshLod> m_lods;
         Material m_material;
-        glm::vec3 m_weight_center;
+        glm::vec3 m_weight_center{ 0 };
+        // Bounding box in model space
+        glm::vec3 m_aabb_min{ 0 };
+        glm::vec3 m_aabb_max{ 0 };
     };
 
     using RenderUnitStatic = TRenderUnit<VertexStatic>;
@@ -55,6 +69,51 @@ namespace dal {
     };
 
 
+    // Sets weight center and bounding box from vertices
+    template <typename _Vertex>
+    void calc_unit_bounds(TRenderUnit<_Vertex>& unit) {
+        if (unit.m_vertices.empty())
+            return;
+
+        glm::dvec3 sum{ 0 };
+        unit.m_aabb_min = unit.m_vertices.front().m_pos;
+        unit.m_aabb_max = unit.m_vertices.front().m_pos;
+
+        for (const auto& v : unit.m_vertices) {
+            sum += glm::dvec3{ v.m_pos };
+            unit.m_aabb_min = glm::min(unit.m_aabb_min, v.m_pos);
+            unit.m_aabb_max = glm::max(unit.m_aabb_max, v.m_pos);
+        }
+
+        unit.m_weight_center = glm::vec3{ sum / static_cast<double>(unit.m_vertices.size()) };
+    }
+
+    // Texture coordinate units per model space unit, as square root of total UV area over total surface area.
+    // Zero if the unit has no surface area.
+    template <typename _Vertex>
+    float calc_uv_density(const TRenderUnit<_Vertex>& unit) {
+        double surface_area = 0;
+        double uv_area = 0;
+
+        for (size_t i = 0; i + 2 < unit.m_indices.size(); i += 3) {
+            const auto& v0 = unit.m_vertices[unit.m_indices[i + 0]];
+            const auto& v1 = unit.m_vertices[unit.m_indices[i + 1]];
+            const auto& v2 = unit.m_vertices[unit.m_indices[i + 2]];
+
+            // Both are twice the area, which cancels out
+            surface_area += glm::length(glm::cross(v1.m_pos - v0.m_pos, v2.m_pos - v0.m_pos));
+
+            const auto uv_edge_1 = v1.m_uv_coord - v0.m_uv_coord;
+            const auto uv_edge_2 = v2.m_uv_coord - v0.m_uv_coord;
+            uv_area += std::abs(uv_edge_1.x * uv_edge_2.y - uv_edge_1.y * uv_edge_2.x);
+        }
+
+        if (surface_area <= 0)
+            return 0;
+
+        return static_cast<float>(std::sqrt(uv_area / surface_area));
+    }
+
     bool make_static_mesh_aabb(RenderUnitStatic& output, const glm::vec3 min, const glm::vec3 max, const glm::vec2 uv_scale);
 
     RenderUnitStatic make_static_mesh_aabb(const glm::vec3 min, const glm::vec3 max, const glm::vec2 uv_scale);
@@ -5,6 +5,7 @@
 #include <memory>
 #include <vector>
 #include <thread>
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -34,6 +35,12 @@ namespace dal {
 
         virtual float evaluate_priority() const = 0;
 
+        // If this is true after work returned false, task is set aside until this turns false,
+        // so that no worker is spent on waiting for something like file read.
+        virtual bool is_waiting() const {
+            return false;
+        }
+
     };
 
     using HTask = std::shared_ptr<ITask>;
@@ -134,6 +141,22 @@ namespace dal {
         };
 
 
+        // Tasks which are waiting on something, not on workers
+        class ParkedTasks {
+
+        private:
+            std::vector<HTask> m_tasks;
+            std::mutex m_mut;
+
+        public:
+            void push(HTask& t);
+
+            // Moves tasks which stopped waiting into the queue
+            void release_ready(TaskQueue& dst);
+
+        };
+
+
     private:
 
 #if DAL_MULTITHREADING
@@ -145,6 +168,7 @@ namespace dal {
 #endif
         TaskRegistry m_registry;
         TaskQueue m_wait_queue;
+        ParkedTasks m_parked;
 
     public:
         TaskManager(const TaskManager&) = delete;
@@ -166,6 +190,10 @@ namespace dal {
         // If client is null, there will be no notification and ITask object will be deleted.
         void order_task(HTask task, ITaskListener* const client);
 
+        // Blocks until every job is done. Calling thread works on jobs too so it never waits on busy workers.
+        // Jobs must be thread safe against each other.
+        void run_parallel(const std::vector<std::function<void()>>& jobs);
+
     };
 
 }
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+#include "dal/util/image_parser.h"
+
+
+namespace dal {
+
+    // Change this whenever cooked output changes so stale cache files are not used
+    constexpr uint32_t TEXTURE_COOK_VERSION = 2;
+
+    // Formats which cook_texture can produce. Others may still be loaded if cooked by external tools.
+    bool can_cook_to(const ImageFormat format);
+
+    // Source must be single level r8g8b8a8_srgb. Output has full mip chain in target format.
+    std::optional<ImageData> cook_texture(const ImageData& src, const ImageFormat target_format);
+
+    std::vector<uint8_t> serialize_cooked_texture(const ImageData& image);
+
+    std::optional<ImageData> parse_cooked_texture(const uint8_t* const buf, const size_t buf_size);
+
+    // Output shares ownership of file content so that pixels are not copied out of it
+    std::optional<ImageData> parse_cooked_texture(const std::shared_ptr<const uint8_t>& file_storage, const size_t file_size);
+
+}
@@ -131,6 +131,20 @@ namespace dal {
         }
     }
 
+    void SkeletonInterface::update_parent_mats() {
+        if (this->m_joints.empty())
+            return;
+
+        // Character lies on ground without this line.
+        this->at(0).set_parent_mat(this->at(0).offset());
+
+        for (jointID_t i = 1; i < this->size(); ++i) {
+            auto& this_joint = this->at(i);
+            const auto& parent_joint = this->at(this_joint.parent_index());
+            this_joint.set_parent_mat(parent_joint);
+        }
+    }
+
     // Private
 
     jointID_t SkeletonInterface::upsize_and_get_index(void) {
@@ -0,0 +1,491 @@
+#include "dal/util/asset_pack.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "dal/util/hash.h"
+#include "dal/util/konsts.h"
+#include "dal/util/logger.h"
+
+
+namespace {
+
+    constexpr uint32_t ASSET_PACK_MAGIC = 0x4B415044;  // "DPAK" in little endian
+
+
+    // Layout must match script/pack_assets.py
+    struct AssetPackHeader {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_entry_count;
+        uint32_t m_names_size;
+        // Names blob follows right after entries
+        uint64_t m_toc_offset;
+        uint64_t m_reserved;
+    };
+    static_assert(32 == sizeof(AssetPackHeader));
+
+    struct AssetPackEntry {
+        uint64_t m_path_hash;
+        uint64_t m_data_offset;
+        uint64_t m_stored_size;
+        uint64_t m_size;
+        uint32_t m_name_offset;
+        uint16_t m_name_size;
+        uint8_t m_compression;
+        uint8_t m_reserved;
+    };
+    static_assert(40 == sizeof(AssetPackEntry));
+
+
+    class FileMapping_PackEntry : public dal::IFileMapping {
+
+    private:
+        std::shared_ptr<dal::IFileMapping> m_pack;
+        const uint8_t* m_data;
+        size_t m_size;
+
+    public:
+        FileMapping_PackEntry(const std::shared_ptr<dal::IFileMapping>& pack, const uint8_t* const data, const size_t size)
+            : m_pack(pack)
+            , m_data(data)
+            , m_size(size)
+        {
+
+        }
+
+        const uint8_t* data() const override {
+            return this->m_data;
+        }
+
+        size_t size() const override {
+            return this->m_size;
+        }
+
+    };
+
+
+    class FileReadOnly_Mapped : public dal::FileReadOnly {
+
+    private:
+        std::unique_ptr<dal::IFileMapping> m_mapping;
+        size_t m_pos = 0;
+
+    public:
+        FileReadOnly_Mapped(std::unique_ptr<dal::IFileMapping>&& mapping)
+            : m_mapping(std::move(mapping))
+        {
+
+        }
+
+        void close() override {
+            this->m_mapping = dal::make_file_mapping_null();
+            this->m_pos = 0;
+        }
+
+        bool is_ready() override {
+            return this->m_mapping->is_ready();
+        }
+
+        size_t size() override {
+            return this->m_mapping->size();
+        }
+
+        bool read(void* const dst, const size_t dst_size) override {
+            const auto remaining = this->m_mapping->size() - this->m_pos;
+            const auto size_to_read = std::min(dst_size, remaining);
+            if (0 == size_to_read)
+                return false;
+
+            std::memcpy(dst, this->m_mapping->data() + this->m_pos, size_to_read);
+            this->m_pos += size_to_read;
+            return true;
+        }
+
+    };
+
+
+    std::optional<std::string> make_pack_path(const dal::ResPath& path) {
+        if (!path.is_valid())
+            return std::nullopt;
+        if (path.dir_list().front() != dal::SPECIAL_NAMESPACE_ASSET)
+            return std::nullopt;
+
+        return dal::join_path(path.dir_list().begin() + 1, path.dir_list().end(), '/');
+    }
+
+    bool is_path_under(const std::string& path, const std::string& dir) {
+        if (dir.empty())
+            return true;
+        if (path.size() <= dir.size())
+            return false;
+
+        return '/' == path[dir.size()] && 0 == path.compare(0, dir.size(), dir);
+    }
+
+    // Length field of LZ4 sequence continues with bytes of 255 until a smaller one
+    bool read_lz4_length(const uint8_t* const src, const size_t src_size, size_t& pos, size_t& length) {
+        uint8_t byte = 255;
+
+        while (255 == byte) {
+            if (pos >= src_size)
+                return false;
+
+            byte = src[pos++];
+            length += byte;
+        }
+
+        return true;
+    }
+
+}
+
+
+// AssetPack
+namespace dal {
+
+    bool AssetPack::open(std::unique_ptr<IFileMapping>&& file) {
+        this->m_file.reset();
+        this->m_entries.clear();
+        this->m_folders.clear();
+        this->m_names.clear();
+
+        if (!file->is_ready() || file->size() < sizeof(::AssetPackHeader)) {
+            dalError("Asset pack is too small");
+            return false;
+        }
+
+        ::AssetPackHeader header;
+        std::memcpy(&header, file->data(), sizeof(header));
+
+        if (::ASSET_PACK_MAGIC != header.m_magic) {
+            dalError("Asset pack has invalid magic number");
+            return false;
+        }
+        if (dal::ASSET_PACK_VERSION != header.m_version) {
+            dalError(fmt::format("Asset pack version {} is not supported, expected {}", header.m_version, dal::ASSET_PACK_VERSION).c_str());
+            return false;
+        }
+
+        const uint64_t toc_size = static_cast<uint64_t>(header.m_entry_count) * sizeof(::AssetPackEntry);
+        const uint64_t names_offset = header.m_toc_offset + toc_size;
+        if (header.m_toc_offset > file->size() || names_offset + header.m_names_size > file->size()) {
+            dalError("Asset pack table of contents is out of range");
+            return false;
+        }
+
+        const auto names = reinterpret_cast<const char*>(file->data() + names_offset);
+        this->m_entries.resize(header.m_entry_count);
+
+        for (uint32_t i = 0; i < header.m_entry_count; ++i) {
+            ::AssetPackEntry src;
+            std::memcpy(&src, file->data() + header.m_toc_offset + i * sizeof(::AssetPackEntry), sizeof(src));
+
+            const bool name_in_range = static_cast<uint64_t>(src.m_name_offset) + src.m_name_size <= header.m_names_size;
+            const bool data_in_range = src.m_data_offset <= file->size() && src.m_stored_size <= file->size() - src.m_data_offset;
+            const bool compression_known = src.m_compression <= static_cast<uint8_t>(AssetPackCompression::lz4);
+            if (!name_in_range || !data_in_range || !compression_known) {
+                dalError(fmt::format("Asset pack entry {} is invalid", i).c_str());
+                this->m_entries.clear();
+                return false;
+            }
+
+            auto& dst = this->m_entries[i];
+            dst.m_path.assign(names + src.m_name_offset, src.m_name_size);
+            dst.m_path_hash = src.m_path_hash;
+            dst.m_data_offset = src.m_data_offset;
+            dst.m_stored_size = src.m_stored_size;
+            dst.m_size = src.m_size;
+            dst.m_compression = static_cast<AssetPackCompression>(src.m_compression);
+        }
+
+        // Built in path order so that wildcard lookups pick the same entry every run
+        std::vector<const Entry*> by_path;
+        by_path.reserve(this->m_entries.size());
+        for (const auto& x : this->m_entries)
+            by_path.push_back(&x);
+        std::sort(by_path.begin(), by_path.end(), [](auto a, auto b) { return a->m_path < b->m_path; });
+
+        this->m_folders[""];
+        for (const auto entry : by_path) {
+            const auto components = dal::split_path(entry->m_path.c_str());
+            if (components.empty())
+                continue;
+
+            std::string parent;
+            for (size_t i = 0; i + 1 < components.size(); ++i) {
+                const auto folder_path = parent.empty() ? components[i] : parent + '/' + components[i];
+
+                if (0 == this->m_folders.count(folder_path)) {
+                    this->m_folders[folder_path];
+                    this->m_folders[parent].m_folders.push_back(components[i]);
+                    this->m_names[components[i]].push_back(folder_path);
+                }
+
+                parent = folder_path;
+            }
+
+            this->m_folders[parent].m_files.push_back(components.back());
+            this->m_names[components.back()].push_back(entry->m_path);
+        }
+
+        std::sort(this->m_entries.begin(), this->m_entries.end(), [](const Entry& a, const Entry& b) {
+            return a.m_path_hash < b.m_path_hash;
+        });
+
+        this->m_file = std::move(file);
+        dalInfo(fmt::format("Asset pack opened with {} entries", this->m_entries.size()).c_str());
+        return true;
+    }
+
+    bool AssetPack::is_file(const std::string& path) const {
+        return nullptr != this->find_entry(path);
+    }
+
+    bool AssetPack::is_folder(const std::string& path) const {
+        return 0 != this->m_folders.count(path);
+    }
+
+    size_t AssetPack::list_files(const std::string& path, std::vector<std::string>& output) const {
+        output.clear();
+
+        const auto found = this->m_folders.find(path);
+        if (this->m_folders.end() == found)
+            return 0;
+
+        output = found->second.m_files;
+        return output.size();
+    }
+
+    size_t AssetPack::list_folders(const std::string& path, std::vector<std::string>& output) const {
+        output.clear();
+
+        const auto found = this->m_folders.find(path);
+        if (this->m_folders.end() == found)
+            return 0;
+
+        output = found->second.m_folders;
+        return output.size();
+    }
+
+    std::optional<std::string> AssetPack::resolve(const ResPath& respath, const size_t start_index) const {
+        const auto& dir_list = respath.dir_list();
+        std::string cur_path;
+
+        for (size_t i = start_index; i < dir_list.size(); ++i) {
+            const auto& dir_element = dir_list[i];
+
+            if ("?" == dir_element || "*" == dir_element) {
+                if (i + 1 >= dir_list.size())
+                    return std::nullopt;
+
+                const auto& name = dir_list[i + 1];
+                const auto found = ("?" == dir_element) ? this->find_under(cur_path, name) : this->find_in_children(cur_path, name);
+                if (!found.has_value())
+                    return std::nullopt;
+
+                cur_path = *found;
+                ++i;
+            }
+            else {
+                cur_path = cur_path.empty() ? dir_element : cur_path + '/' + dir_element;
+            }
+        }
+
+        if (!this->is_file(cur_path))
+            return std::nullopt;
+
+        return cur_path;
+    }
+
+    std::unique_ptr<IFileMapping> AssetPack::map(const std::string& path) const {
+        const auto entry = this->find_entry(path);
+        if (nullptr == entry)
+            return make_file_mapping_null();
+
+        const auto stored = this->m_file->data() + entry->m_data_offset;
+
+        switch (entry->m_compression) {
+            case AssetPackCompression::none:
+                return std::make_unique<::FileMapping_PackEntry>(this->m_file, stored, entry->m_stored_size);
+            case AssetPackCompression::lz4: {
+                std::vector<uint8_t> output(entry->m_size);
+                if (!dal::decompress_lz4_block(stored, entry->m_stored_size, output.data(), output.size())) {
+                    dalError(fmt::format("Failed to decompress asset pack entry: {}", path).c_str());
+                    return make_file_mapping_null();
+                }
+                return make_file_mapping_heap(std::move(output));
+            }
+            default:
+                return make_file_mapping_null();
+        }
+    }
+
+    const AssetPack::Entry* AssetPack::find_entry(const std::string& path) const {
+        const auto hash = dal::hash_xx64(path);
+
+        auto iter = std::lower_bound(this->m_entries.begin(), this->m_entries.end(), hash, [](const Entry& e, const uint64_t h) {
+            return e.m_path_hash < h;
+        });
+
+        for (; iter != this->m_entries.end() && iter->m_path_hash == hash; ++iter) {
+            if (iter->m_path == path)
+                return &*iter;
+        }
+
+        return nullptr;
+    }
+
+    std::optional<std::string> AssetPack::find_under(const std::string& dir, const std::string& name) const {
+        const auto found = this->m_names.find(name);
+        if (this->m_names.end() == found)
+            return std::nullopt;
+
+        for (const auto& path : found->second) {
+            if (::is_path_under(path, dir))
+                return path;
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<std::string> AssetPack::find_in_children(const std::string& dir, const std::string& name) const {
+        const auto found = this->m_names.find(name);
+        if (this->m_names.end() == found)
+            return std::nullopt;
+
+        for (const auto& path : found->second) {
+            if (!::is_path_under(path, dir))
+                continue;
+
+            const auto relative_start = dir.empty() ? 0 : dir.size() + 1;
+            if (1 == std::count(path.begin() + relative_start, path.end(), '/'))
+                return path;
+        }
+
+        return std::nullopt;
+    }
+
+}
+
+
+// AssetManagerPack
+namespace dal {
+
+    AssetManagerPack::AssetManagerPack(std::unique_ptr<IFileMapping>&& pack_file) {
+        this->m_pack.open(std::move(pack_file));
+    }
+
+    bool AssetManagerPack::is_file(const dal::ResPath& path) {
+        const auto pack_path = ::make_pack_path(path);
+        if (!pack_path.has_value())
+            return false;
+
+        return this->m_pack.is_file(*pack_path);
+    }
+
+    bool AssetManagerPack::is_folder(const dal::ResPath& path) {
+        const auto pack_path = ::make_pack_path(path);
+        if (!pack_path.has_value())
+            return false;
+
+        return this->m_pack.is_folder(*pack_path);
+    }
+
+    size_t AssetManagerPack::list_files(const dal::ResPath& path, std::vector<std::string>& output) {
+        const auto pack_path = ::make_pack_path(path);
+        if (!pack_path.has_value())
+            return 0;
+
+        return this->m_pack.list_files(*pack_path, output);
+    }
+
+    size_t AssetManagerPack::list_folders(const dal::ResPath& path, std::vector<std::string>& output) {
+        const auto pack_path = ::make_pack_path(path);
+        if (!pack_path.has_value())
+            return 0;
+
+        return this->m_pack.list_folders(*pack_path, output);
+    }
+
+    std::optional<ResPath> AssetManagerPack::resolve(const ResPath& path) {
+        if (!::make_pack_path(path).has_value())
+            return std::nullopt;
+
+        const auto result = this->m_pack.resolve(path, 1);
+        if (!result.has_value())
+            return std::nullopt;
+
+        return dal::ResPath{ fmt::format("{}/{}", dal::SPECIAL_NAMESPACE_ASSET, *result) };
+    }
+
+    std::unique_ptr<FileReadOnly> AssetManagerPack::open(const dal::ResPath& path) {
+        auto mapping = this->map(path);
+        if (!mapping->is_ready())
+            return make_file_read_only_null();
+
+        return std::make_unique<::FileReadOnly_Mapped>(std::move(mapping));
+    }
+
+    std::unique_ptr<IFileMapping> AssetManagerPack::map(const dal::ResPath& path) {
+        const auto pack_path = ::make_pack_path(path);
+        if (!pack_path.has_value())
+            return make_file_mapping_null();
+
+        return this->m_pack.map(*pack_path);
+    }
+
+}
+
+
+// LZ4
+namespace dal {
+
+    // https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+    bool decompress_lz4_block(const uint8_t* const src, const size_t src_size, uint8_t* const dst, const size_t dst_size) {
+        size_t src_pos = 0;
+        size_t dst_pos = 0;
+
+        while (src_pos < src_size) {
+            const auto token = src[src_pos++];
+
+            size_t literal_length = token >> 4;
+            if (15 == literal_length && !::read_lz4_length(src, src_size, src_pos, literal_length))
+                return false;
+            if (literal_length > src_size - src_pos || literal_length > dst_size - dst_pos)
+                return false;
+
+            std::memcpy(dst + dst_pos, src + src_pos, literal_length);
+            src_pos += literal_length;
+            dst_pos += literal_length;
+
+            // Last sequence has literals only
+            if (src_pos == src_size)
+                break;
+            if (src_size - src_pos < 2)
+                return false;
+
+            const size_t offset = src[src_pos] | (static_cast<size_t>(src[src_pos + 1]) << 8);
+            src_pos += 2;
+            if (0 == offset || offset > dst_pos)
+                return false;
+
+            size_t match_length = token & 15;
+            if (15 == match_length && !::read_lz4_length(src, src_size, src_pos, match_length))
+                return false;
+            match_length += 4;
+            if (match_length > dst_size - dst_pos)
+                return false;
+
+            // Byte by byte because source and destination overlap when offset is smaller than length
+            for (size_t i = 0; i < match_length; ++i)
+                dst[dst_pos + i] = dst[dst_pos + i - offset];
+            dst_pos += match_length;
+        }
+
+        return dst_pos == dst_size;
+    }
+
+}
@@ -0,0 +1,447 @@
+#include "dal/util/async_file_io.h"
+
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+
+#include <fmt/format.h>
+
+#include "dal/util/defines.h"
+#include "dal/util/logger.h"
+
+// Android forbids io_uring with seccomp, so thread pool is used there
+#if defined(DAL_OS_LINUX)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/uio.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <linux/io_uring.h>
+    #define DAL_ASYNC_IO_URING
+#endif
+
+
+namespace {
+
+    namespace fs = std::filesystem;
+
+    constexpr size_t THREAD_POOL_SIZE = 4;
+    constexpr unsigned IO_URING_QUEUE_DEPTH = 64;
+
+
+    std::unique_ptr<dal::IFileMapping> read_whole_file(const fs::path& path) {
+        dal::FileReadOnly_STL file;
+        if (!file.open(path))
+            return dal::make_file_mapping_null();
+
+        return dal::make_file_mapping_heap(file);
+    }
+
+}
+
+
+// AsyncReadResult
+namespace dal {
+
+    std::unique_ptr<IFileMapping> AsyncReadResult::take() {
+        dalAssert(this->is_done());
+
+        if (!this->m_data)
+            return make_file_mapping_null();
+
+        return std::move(this->m_data);
+    }
+
+    void AsyncReadResult::set(std::unique_ptr<IFileMapping>&& data) {
+        this->m_data = std::move(data);
+        this->m_done.store(true, std::memory_order_release);
+    }
+
+}
+
+
+// AsyncFileIO :: ThreadPool
+namespace dal {
+
+    class AsyncFileIO::ThreadPool {
+
+    private:
+        std::deque<std::function<void()>> m_jobs;
+        std::vector<std::thread> m_threads;
+        std::mutex m_mut;
+        std::condition_variable m_cv;
+        bool m_exit = false;
+
+    public:
+        ThreadPool(const size_t thread_count) {
+            for (size_t i = 0; i < thread_count; ++i)
+                this->m_threads.emplace_back([this]() { this->loop(); });
+        }
+
+        // Jobs already pushed are still done, so no result is left unfinished
+        ~ThreadPool() {
+            {
+                std::unique_lock lck{ this->m_mut };
+                this->m_exit = true;
+            }
+            this->m_cv.notify_all();
+
+            for (auto& thread : this->m_threads)
+                thread.join();
+        }
+
+        void push(std::function<void()>&& job) {
+            {
+                std::unique_lock lck{ this->m_mut };
+                this->m_jobs.push_back(std::move(job));
+            }
+            this->m_cv.notify_one();
+        }
+
+    private:
+        void loop() {
+            while (true) {
+                std::function<void()> job;
+
+                {
+                    std::unique_lock lck{ this->m_mut };
+                    this->m_cv.wait(lck, [this]() { return this->m_exit || !this->m_jobs.empty(); });
+                    if (this->m_jobs.empty())
+                        return;
+
+                    job = std::move(this->m_jobs.front());
+                    this->m_jobs.pop_front();
+                }
+
+                job();
+            }
+        }
+
+    };
+
+}
+
+
+#ifdef DAL_ASYNC_IO_URING
+
+// AsyncFileIO :: IoUring
+namespace dal {
+
+    // liburing is not used to avoid another dependency, so rings are driven with raw syscalls
+    class AsyncFileIO::IoUring {
+
+    private:
+        struct Request {
+            HAsyncRead m_result;
+            fs::path m_path;
+            std::vector<uint8_t> m_buffer;
+            iovec m_iovec{};
+            size_t m_read_size = 0;
+            int m_fd = -1;
+        };
+
+    private:
+        int m_ring_fd = -1;
+        void* m_sq_ptr = MAP_FAILED;
+        void* m_cq_ptr = MAP_FAILED;
+        size_t m_sq_map_size = 0;
+        size_t m_cq_map_size = 0;
+        size_t m_sqes_map_size = 0;
+
+        unsigned* m_sq_tail = nullptr;
+        unsigned* m_sq_mask = nullptr;
+        unsigned* m_sq_array = nullptr;
+        io_uring_sqe* m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        unsigned m_sq_entries = 0;
+
+        unsigned* m_cq_head = nullptr;
+        unsigned* m_cq_tail = nullptr;
+        unsigned* m_cq_mask = nullptr;
+        io_uring_cqe* m_cqes = nullptr;
+
+        std::deque<std::unique_ptr<Request>> m_pending;
+        std::mutex m_mut;
+        std::condition_variable m_cv;
+        bool m_exit = false;
+        std::thread m_thread;
+
+        // Only touched by I/O thread
+        unsigned m_in_flight = 0;
+        unsigned m_unsubmitted = 0;
+
+    public:
+        IoUring() = default;
+
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+
+        ~IoUring() {
+            if (this->m_thread.joinable()) {
+                {
+                    std::unique_lock lck{ this->m_mut };
+                    this->m_exit = true;
+                }
+                this->m_cv.notify_all();
+                this->m_thread.join();
+            }
+
+            this->release_ring();
+        }
+
+        // False if kernel does not support io_uring or it is not allowed
+        bool init(const unsigned queue_depth) {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+
+            this->m_ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, queue_depth, &params));
+            if (this->m_ring_fd < 0)
+                return false;
+
+            this->m_sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            this->m_cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool single_mmap = 0 != (params.features & IORING_FEAT_SINGLE_MMAP);
+            if (single_mmap)
+                this->m_sq_map_size = this->m_cq_map_size = std::max(this->m_sq_map_size, this->m_cq_map_size);
+
+            this->m_sq_ptr = ::mmap(nullptr, this->m_sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->m_ring_fd, IORING_OFF_SQ_RING);
+            if (MAP_FAILED == this->m_sq_ptr)
+                return this->release_ring();
+
+            if (single_mmap)
+                this->m_cq_ptr = this->m_sq_ptr;
+            else
+                this->m_cq_ptr = ::mmap(nullptr, this->m_cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->m_ring_fd, IORING_OFF_CQ_RING);
+            if (MAP_FAILED == this->m_cq_ptr)
+                return this->release_ring();
+
+            this->m_sqes_map_size = params.sq_entries * sizeof(io_uring_sqe);
+            this->m_sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, this->m_sqes_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->m_ring_fd, IORING_OFF_SQES));
+            if (MAP_FAILED == static_cast<void*>(this->m_sqes))
+                return this->release_ring();
+
+            const auto sq = static_cast<uint8_t*>(this->m_sq_ptr);
+            this->m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            this->m_sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            this->m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            this->m_sq_entries = params.sq_entries;
+
+            const auto cq = static_cast<uint8_t*>(this->m_cq_ptr);
+            this->m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            this->m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            this->m_cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            this->m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            this->m_thread = std::thread{ [this]() { this->loop(); } };
+            return true;
+        }
+
+        void push(const fs::path& path, const HAsyncRead& result) {
+            auto request = std::make_unique<Request>();
+            request->m_path = path;
+            request->m_result = result;
+
+            {
+                std::unique_lock lck{ this->m_mut };
+                this->m_pending.push_back(std::move(request));
+            }
+            this->m_cv.notify_one();
+        }
+
+    private:
+        bool release_ring() {
+            if (MAP_FAILED != static_cast<void*>(this->m_sqes))
+                ::munmap(this->m_sqes, this->m_sqes_map_size);
+            if (MAP_FAILED != this->m_cq_ptr && this->m_cq_ptr != this->m_sq_ptr)
+                ::munmap(this->m_cq_ptr, this->m_cq_map_size);
+            if (MAP_FAILED != this->m_sq_ptr)
+                ::munmap(this->m_sq_ptr, this->m_sq_map_size);
+            if (this->m_ring_fd >= 0)
+                ::close(this->m_ring_fd);
+
+            this->m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+            this->m_cq_ptr = MAP_FAILED;
+            this->m_sq_ptr = MAP_FAILED;
+            this->m_ring_fd = -1;
+            return false;
+        }
+
+        void loop() {
+            while (true) {
+                std::vector<std::unique_ptr<Request>> new_requests;
+
+                {
+                    std::unique_lock lck{ this->m_mut };
+
+                    // Kernel has nothing to complete, so sleep until asked for more
+                    if (0 == this->m_in_flight)
+                        this->m_cv.wait(lck, [this]() { return this->m_exit || !this->m_pending.empty(); });
+
+                    if (this->m_exit && this->m_pending.empty() && 0 == this->m_in_flight)
+                        return;
+
+                    while (!this->m_pending.empty() && this->m_in_flight + new_requests.size() < this->m_sq_entries) {
+                        new_requests.push_back(std::move(this->m_pending.front()));
+                        this->m_pending.pop_front();
+                    }
+                }
+
+                for (auto& request : new_requests)
+                    this->start(std::move(request));
+
+                if (0 == this->m_in_flight)
+                    continue;
+
+                // Everything queued so far goes in one syscall
+                const auto submitted = ::syscall(__NR_io_uring_enter, this->m_ring_fd, this->m_unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (submitted >= 0)
+                    this->m_unsubmitted -= static_cast<unsigned>(submitted);
+                else if (EINTR != errno && EAGAIN != errno && EBUSY != errno)
+                    dalError(fmt::format("io_uring_enter failed: {}", std::strerror(errno)).c_str());
+
+                this->reap();
+            }
+        }
+
+        void start(std::unique_ptr<Request>&& request) {
+            request->m_fd = ::open(request->m_path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (request->m_fd < 0)
+                return this->finish(std::move(request), false);
+
+            struct stat file_stat;
+            if (0 != ::fstat(request->m_fd, &file_stat) || file_stat.st_size < 0)
+                return this->finish(std::move(request), false);
+
+            request->m_buffer.resize(static_cast<size_t>(file_stat.st_size));
+            if (request->m_buffer.empty())
+                return this->finish(std::move(request), true);
+
+            this->queue_read(request.release());
+        }
+
+        // Ownership of request goes to the ring until its completion is reaped
+        void queue_read(Request* const request) {
+            // Only this thread writes tail
+            const auto tail = *this->m_sq_tail;
+            const auto index = tail & *this->m_sq_mask;
+
+            request->m_iovec.iov_base = request->m_buffer.data() + request->m_read_size;
+            request->m_iovec.iov_len = request->m_buffer.size() - request->m_read_size;
+
+            auto& sqe = this->m_sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READV;
+            sqe.fd = request->m_fd;
+            sqe.addr = reinterpret_cast<uint64_t>(&request->m_iovec);
+            sqe.len = 1;
+            sqe.off = request->m_read_size;
+            sqe.user_data = reinterpret_cast<uint64_t>(request);
+
+            this->m_sq_array[index] = index;
+            __atomic_store_n(this->m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+            ++this->m_unsubmitted;
+            ++this->m_in_flight;
+        }
+
+        void reap() {
+            auto head = *this->m_cq_head;
+            const auto tail = __atomic_load_n(this->m_cq_tail, __ATOMIC_ACQUIRE);
+
+            for (; head != tail; ++head) {
+                const auto& cqe = this->m_cqes[head & *this->m_cq_mask];
+                const auto request = reinterpret_cast<Request*>(cqe.user_data);
+                const auto result = cqe.res;
+                --this->m_in_flight;
+
+                if (-EINTR == result || -EAGAIN == result) {
+                    this->queue_read(request);
+                    continue;
+                }
+
+                if (result > 0) {
+                    request->m_read_size += static_cast<size_t>(result);
+                    // Short read, which happens on some file systems
+                    if (request->m_read_size < request->m_buffer.size()) {
+                        this->queue_read(request);
+                        continue;
+                    }
+                }
+
+                this->finish(std::unique_ptr<Request>{ request }, request->m_read_size == request->m_buffer.size());
+            }
+
+            __atomic_store_n(this->m_cq_head, head, __ATOMIC_RELEASE);
+        }
+
+        void finish(std::unique_ptr<Request>&& request, const bool success) {
+            if (request->m_fd >= 0)
+                ::close(request->m_fd);
+
+            if (success)
+                request->m_result->set(make_file_mapping_heap(std::move(request->m_buffer)));
+            else
+                request->m_result->set(make_file_mapping_null());
+        }
+
+    };
+
+}
+
+#else
+
+namespace dal {
+
+    class AsyncFileIO::IoUring {
+
+    public:
+        bool init(const unsigned queue_depth) {
+            return false;
+        }
+
+        void push(const fs::path& path, const HAsyncRead& result) {}
+
+    };
+
+}
+
+#endif
+
+
+// AsyncFileIO
+namespace dal {
+
+    AsyncFileIO::AsyncFileIO()
+        : m_pool(std::make_unique<ThreadPool>(::THREAD_POOL_SIZE))
+    {
+        auto uring = std::make_unique<IoUring>();
+        if (uring->init(::IO_URING_QUEUE_DEPTH))
+            this->m_uring = std::move(uring);
+        else
+            dalInfo("io_uring is not available, file reads use thread pool instead");
+    }
+
+    AsyncFileIO::~AsyncFileIO() = default;
+
+    void AsyncFileIO::read(const std::filesystem::path& path, const HAsyncRead& result) {
+        if (this->m_uring) {
+            this->m_uring->push(path, result);
+            return;
+        }
+
+        this->m_pool->push([path, result]() {
+            result->set(::read_whole_file(path));
+        });
+    }
+
+    void AsyncFileIO::run(std::function<std::unique_ptr<IFileMapping>()> job, const HAsyncRead& result) {
+        this->m_pool->push([job = std::move(job), result]() {
+            result->set(job());
+        });
+    }
+
+}
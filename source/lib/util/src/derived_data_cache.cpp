@@ -0,0 +1,267 @@
+#include "dal/util/derived_data_cache.h"
+
+#include <fmt/format.h>
+
+#include "dal/util/hash.h"
+#include "dal/util/logger.h"
+#include "dal/util/json_util.h"
+
+
+namespace {
+
+    const char* const CACHE_DIR = "_internal/ddc";
+    const char* const INDEX_FILE_PATH = "_internal/ddc/index.json";
+
+    const char* const KEY_VERSION = "version";
+    const char* const KEY_ENTRIES = "entries";
+
+    // Index with other version is thrown away and rebuilt from files
+    constexpr int INDEX_FORMAT_VERSION = 1;
+
+
+    std::string make_entry_name(const char* const category, const dal::DerivedDataKey& key) {
+        return fmt::format("{}/{:016x}", category, key.hash_value());
+    }
+
+    std::string make_entry_path(const std::string& entry_name) {
+        return fmt::format("{}/{}", ::CACHE_DIR, entry_name);
+    }
+
+}
+
+
+// DerivedDataKey
+namespace dal {
+
+    uint64_t DerivedDataKey::hash_value() const {
+        const uint64_t fields[] = { this->m_content_hash, this->m_version, this->m_options_hash };
+        return dal::hash_xx64(fields, sizeof(fields));
+    }
+
+}
+
+
+// DerivedDataCache
+namespace dal {
+
+    DerivedDataCache::DerivedDataCache(Filesystem& filesys, const size_t size_limit)
+        : m_filesys(filesys)
+        , m_size_limit(size_limit)
+    {
+        this->load_index();
+
+        std::vector<std::string> evicted;
+        {
+            std::unique_lock<std::mutex> lck{ this->m_mut };
+            evicted = this->evict_over_limit();
+        }
+
+        for (const auto& name : evicted)
+            this->m_filesys.remove(::make_entry_path(name));
+    }
+
+    DerivedDataCache::~DerivedDataCache() {
+        this->save_index();
+    }
+
+    std::unique_ptr<IFileMapping> DerivedDataCache::get(const char* const category, const DerivedDataKey& key) {
+        const auto name = ::make_entry_name(category, key);
+        size_t expected_size = 0;
+        {
+            std::unique_lock<std::mutex> lck{ this->m_mut };
+
+            const auto iter = this->m_entries.find(name);
+            if (this->m_entries.end() == iter || this->m_writing.count(name))
+                return make_file_mapping_null();
+
+            this->m_lru.splice(this->m_lru.end(), this->m_lru, iter->second);
+            expected_size = iter->second->m_size;
+        }
+
+        auto file = this->m_filesys.map(::make_entry_path(name));
+        if (file->is_ready() && file->size() == expected_size)
+            return file;
+
+        // Most likely the app was killed while writing it
+        dalWarn(fmt::format("Derived data cache entry is corrupted: {}", name).c_str());
+        {
+            std::unique_lock<std::mutex> lck{ this->m_mut };
+            this->remove_entry(name);
+        }
+        return make_file_mapping_null();
+    }
+
+    bool DerivedDataCache::put(const char* const category, const DerivedDataKey& key, const void* const data, const size_t data_size) {
+        const auto name = ::make_entry_name(category, key);
+        const auto path = ::make_entry_path(name);
+        {
+            std::unique_lock<std::mutex> lck{ this->m_mut };
+
+            if (this->m_writing.count(name))
+                return false;
+            // Someone else stored same output already. Rewriting it could truncate file under others' mappings.
+            if (this->m_entries.count(name))
+                return true;
+
+            this->m_writing.insert(name);
+        }
+
+        bool success = false;
+        {
+            auto file = this->m_filesys.open_write(path);
+            success = file->is_ready() && file->write(data, data_size);
+        }
+
+        std::vector<std::string> evicted;
+        {
+            std::unique_lock<std::mutex> lck{ this->m_mut };
+
+            this->m_writing.erase(name);
+            this->remove_entry(name);
+
+            if (success) {
+                this->add_entry(name, data_size);
+                evicted = this->evict_over_limit();
+            }
+        }
+
+        for (const auto& x : evicted)
+            this->m_filesys.remove(::make_entry_path(x));
+
+        if (!success) {
+            this->m_filesys.remove(path);
+            dalWarn(fmt::format("Failed to write derived data cache entry: {}", name).c_str());
+            return false;
+        }
+
+        // Saved every time because app might never get to call destructor, especially on Android
+        this->save_index();
+        return true;
+    }
+
+    size_t DerivedDataCache::total_size() const {
+        std::unique_lock<std::mutex> lck{ this->m_mut };
+        return this->m_total_size;
+    }
+
+    void DerivedDataCache::save_index() {
+        std::string output_str;
+        uint64_t generation = 0;
+        {
+            std::unique_lock<std::mutex> lck{ this->m_mut };
+            generation = ++this->m_index_generation;
+
+            nlohmann::json json_data;
+            json_data[::KEY_VERSION] = ::INDEX_FORMAT_VERSION;
+            auto& entries = json_data[::KEY_ENTRIES];
+            entries = nlohmann::json::array();
+
+            for (const auto& x : this->m_lru)
+                entries.push_back({ x.m_name, x.m_size });
+
+            output_str = json_data.dump();
+        }
+
+        std::unique_lock<std::mutex> lck{ this->m_index_file_mut };
+
+        // Another thread took its snapshot later but got here first, and what it wrote is newer
+        if (generation < this->m_saved_index_generation)
+            return;
+
+        auto file = this->m_filesys.open_write(::INDEX_FILE_PATH);
+        if (!file->is_ready() || !file->write(output_str.data(), output_str.size()))
+            dalWarn("Failed to save derived data cache index");
+        else
+            this->m_saved_index_generation = generation;
+    }
+
+    // Private
+
+    void DerivedDataCache::load_index() {
+        const auto file_content = this->m_filesys.open(::INDEX_FILE_PATH)->read_stl<std::string>();
+        if (!file_content.has_value()) {
+            this->rebuild_index();
+            return;
+        }
+
+        const auto json_data = dal::try_parse_json(*file_content);
+        if (!json_data.has_value() || ::INDEX_FORMAT_VERSION != dal::get_json_number_or<int>(::KEY_VERSION, 0, *json_data)) {
+            this->rebuild_index();
+            return;
+        }
+
+        const auto entries = json_data->find(::KEY_ENTRIES);
+        if (json_data->end() == entries || !entries->is_array()) {
+            this->rebuild_index();
+            return;
+        }
+
+        std::unique_lock<std::mutex> lck{ this->m_mut };
+
+        for (const auto& x : *entries) {
+            if (!x.is_array() || 2 != x.size() || !x[0].is_string() || !x[1].is_number_unsigned())
+                continue;
+
+            this->add_entry(x[0].get<std::string>(), x[1].get<size_t>());
+        }
+    }
+
+    void DerivedDataCache::rebuild_index() {
+        if (!this->m_filesys.is_folder(::CACHE_DIR))
+            return;
+
+        size_t found_count = 0;
+
+        for (const auto& category : this->m_filesys.list_folders(::CACHE_DIR)) {
+            const auto category_path = fmt::format("{}/{}", ::CACHE_DIR, category);
+
+            for (const auto& file_name : this->m_filesys.list_files(category_path)) {
+                const auto name = fmt::format("{}/{}", category, file_name);
+                const auto file = this->m_filesys.map(::make_entry_path(name));
+                if (!file->is_ready())
+                    continue;
+
+                std::unique_lock<std::mutex> lck{ this->m_mut };
+                this->add_entry(name, file->size());
+                ++found_count;
+            }
+        }
+
+        dalInfo(fmt::format("Derived data cache index rebuilt with {} entries", found_count).c_str());
+    }
+
+    void DerivedDataCache::add_entry(const std::string& name, const size_t size) {
+        if (this->m_entries.count(name))
+            return;
+
+        this->m_lru.push_back(Entry{ name, size });
+        this->m_entries.emplace(name, std::prev(this->m_lru.end()));
+        this->m_total_size += size;
+    }
+
+    void DerivedDataCache::remove_entry(const std::string& name) {
+        const auto iter = this->m_entries.find(name);
+        if (this->m_entries.end() == iter)
+            return;
+
+        this->m_total_size -= iter->second->m_size;
+        this->m_lru.erase(iter->second);
+        this->m_entries.erase(iter);
+    }
+
+    std::vector<std::string> DerivedDataCache::evict_over_limit() {
+        std::vector<std::string> output;
+
+        // Most recent one is kept even if it alone exceeds limit
+        while (this->m_total_size > this->m_size_limit && this->m_lru.size() > 1) {
+            const auto& victim = this->m_lru.front();
+            output.push_back(victim.m_name);
+            this->m_total_size -= victim.m_size;
+            this->m_entries.erase(victim.m_name);
+            this->m_lru.pop_front();
+        }
+
+        return output;
+    }
+
+}
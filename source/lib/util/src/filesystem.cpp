@@ -5,6 +5,18 @@
 #include <fmt/format.h>
 
 #include "dal/util/konsts.h"
+#include "dal/util/logger.h"
+#include "dal/util/defines.h"
+#include "dal/util/async_file_io.h"
+#include "dal/util/derived_data_cache.h"
+
+#if defined(DAL_OS_LINUX) || defined(DAL_OS_ANDROID)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define DAL_FILESYSTEM_HAS_MMAP
+#endif
 
 
 namespace {
@@ -48,6 +60,100 @@ namespace {
     };
 
 
+    class FileMapping_Null : public dal::IFileMapping {
+
+    public:
+        const uint8_t* data() const override {
+            return nullptr;
+        }
+
+        size_t size() const override {
+            return 0;
+        }
+
+    };
+
+
+    class FileMapping_Heap : public dal::IFileMapping {
+
+    private:
+        std::vector<uint8_t> m_data;
+
+    public:
+        FileMapping_Heap(std::vector<uint8_t>&& data)
+            : m_data(std::move(data))
+        {
+
+        }
+
+        const uint8_t* data() const override {
+            return this->m_data.data();
+        }
+
+        size_t size() const override {
+            return this->m_data.size();
+        }
+
+    };
+
+
+#ifdef DAL_FILESYSTEM_HAS_MMAP
+
+    class FileMapping_Posix : public dal::IFileMapping {
+
+    private:
+        void* m_ptr = nullptr;
+        size_t m_size = 0;
+
+    public:
+        FileMapping_Posix() = default;
+
+        FileMapping_Posix(const FileMapping_Posix&) = delete;
+        FileMapping_Posix& operator=(const FileMapping_Posix&) = delete;
+
+        ~FileMapping_Posix() override {
+            if (nullptr != this->m_ptr)
+                ::munmap(this->m_ptr, this->m_size);
+        }
+
+        // Zero sized files cannot be mapped so callers should fall back to heap for them
+        bool open(const fs::path& path) {
+            const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+
+            struct stat file_stat;
+            if (0 != ::fstat(fd, &file_stat) || file_stat.st_size <= 0) {
+                ::close(fd);
+                return false;
+            }
+
+            const auto size = static_cast<size_t>(file_stat.st_size);
+            const auto ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            // Mapping stays valid after the descriptor is closed
+            ::close(fd);
+
+            if (MAP_FAILED == ptr)
+                return false;
+
+            this->m_ptr = ptr;
+            this->m_size = size;
+            return true;
+        }
+
+        const uint8_t* data() const override {
+            return reinterpret_cast<const uint8_t*>(this->m_ptr);
+        }
+
+        size_t size() const override {
+            return this->m_size;
+        }
+
+    };
+
+#endif
+
+
     enum class FileType {
         asset,
         userdata,
@@ -85,6 +191,9 @@ namespace {
             return std::nullopt;
 
         for (auto& e0 : fs::directory_iterator(domain_dir)) {
+            if (!e0.is_directory())
+                continue;
+
             for (auto& e1 : fs::directory_iterator(e0.path())) {
                 if (e1.path().filename().u8string() == entry_to_find) {
                     return e1.path();
@@ -95,6 +204,50 @@ namespace {
         return std::nullopt;
     }
 
+    template <typename _FindQuestion, typename _FindAsterisk>
+    std::optional<std::string> resolve_path_with(
+        const dal::ResPath& respath,
+        const fs::path& start_dir,
+        const size_t start_index,
+        const _FindQuestion& find_question,
+        const _FindAsterisk& find_asterisk
+    ) {
+        auto cur_path = start_dir;
+
+        for (size_t i = start_index; i < respath.dir_list().size(); ++i) {
+            const auto dir_element = respath.dir_list().at(i);
+
+            if (dir_element == "?") {
+                const auto resolve_result = find_question(cur_path, respath.dir_list().at(i + 1));
+                if (!resolve_result.has_value()) {
+                    return std::nullopt;
+                }
+                else {
+                    cur_path = resolve_result.value();
+                    ++i;
+                }
+            }
+            else if (dir_element == "*") {
+                const auto resolve_result = find_asterisk(cur_path, respath.dir_list().at(i + 1));
+                if (!resolve_result.has_value()) {
+                    return std::nullopt;
+                }
+                else {
+                    cur_path = resolve_result.value();
+                    ++i;
+                }
+            }
+            else {
+                cur_path = cur_path / dir_element;
+            }
+        }
+
+        if (!fs::is_regular_file(cur_path))
+            return std::nullopt;
+
+        return cur_path.generic_u8string().substr(start_dir.generic_u8string().size() + 1);
+    }
+
     size_t calc_path_length(const fs::path& path) {
         size_t output = 0;
 
@@ -215,41 +368,54 @@ namespace dal {
         return std::make_unique<FileWriteOnly_Null>();
     }
 
-    std::optional<std::string> resolve_path(const dal::ResPath& respath, const std::filesystem::path& start_dir, const size_t start_index) {
-        auto cur_path = start_dir;
+    std::unique_ptr<IFileMapping> make_file_mapping_null() {
+        return std::make_unique<::FileMapping_Null>();
+    }
 
-        for (size_t i = start_index; i < respath.dir_list().size(); ++i) {
-            const auto dir_element = respath.dir_list().at(i);
+    std::unique_ptr<IFileMapping> make_file_mapping_heap(std::vector<uint8_t>&& data) {
+        return std::make_unique<::FileMapping_Heap>(std::move(data));
+    }
 
-            if (dir_element == "?") {
-                const auto resolve_result = resolve_question_path(cur_path, respath.dir_list().at(i + 1));
-                if (!resolve_result.has_value()) {
-                    return std::nullopt;
-                }
-                else {
-                    cur_path = resolve_result.value();
-                    ++i;
-                }
-            }
-            else if (dir_element == "*") {
-                const auto resolve_result = resolve_asterisk_path(cur_path, respath.dir_list().at(i + 1));
-                if (!resolve_result.has_value()) {
-                    return std::nullopt;
-                }
-                else {
-                    cur_path = resolve_result.value();
-                    ++i;
-                }
-            }
-            else {
-                cur_path = cur_path / dir_element;
-            }
-        }
+    std::unique_ptr<IFileMapping> make_file_mapping_heap(FileReadOnly& file) {
+        std::vector<uint8_t> data;
+        if (!file.read_stl(data))
+            return make_file_mapping_null();
 
-        if (!fs::is_regular_file(cur_path))
-            return std::nullopt;
+        return make_file_mapping_heap(std::move(data));
+    }
 
-        return cur_path.generic_u8string().substr(start_dir.generic_u8string().size() + 1);
+    std::unique_ptr<IFileMapping> map_file(const std::filesystem::path& path) {
+#ifdef DAL_FILESYSTEM_HAS_MMAP
+        auto mapping = std::make_unique<::FileMapping_Posix>();
+        if (mapping->open(path))
+            return mapping;
+#endif
+
+        dal::FileReadOnly_STL file;
+        if (!file.open(path))
+            return make_file_mapping_null();
+
+        return make_file_mapping_heap(file);
+    }
+
+    std::optional<std::string> resolve_path(const dal::ResPath& respath, const std::filesystem::path& start_dir, const size_t start_index) {
+        return ::resolve_path_with(respath, start_dir, start_index, ::resolve_question_path, ::resolve_asterisk_path);
+    }
+
+    std::optional<std::string> resolve_path(
+        const dal::ResPath& respath,
+        const std::filesystem::path& start_dir,
+        const size_t start_index,
+        FilenameIndex& index
+    ) {
+        const auto find_question = [&](const fs::path& dir, const std::string& name) {
+            return index.find_under(start_dir, dir, name);
+        };
+        const auto find_asterisk = [&](const fs::path& dir, const std::string& name) {
+            return index.find_in_children(start_dir, dir, name);
+        };
+
+        return ::resolve_path_with(respath, start_dir, start_index, find_question, find_asterisk);
     }
 
     void create_folders_of_path(const std::filesystem::path& path, const size_t exclude_last_n) {
@@ -271,6 +437,76 @@ namespace dal {
 }
 
 
+// FilenameIndex
+namespace dal {
+
+    void FilenameIndex::reset() {
+        std::unique_lock lck{ this->m_mut };
+        this->m_entries.clear();
+        this->m_built = false;
+    }
+
+    std::optional<std::filesystem::path> FilenameIndex::find_under(
+        const std::filesystem::path& root,
+        const std::filesystem::path& dir,
+        const std::string& name
+    ) {
+        std::unique_lock lck{ this->m_mut };
+        this->build_if_needed(root);
+
+        const auto found = this->m_entries.find(name);
+        if (this->m_entries.end() == found)
+            return std::nullopt;
+
+        for (const auto& x : found->second) {
+            const auto relative = x.lexically_relative(dir);
+            if (!relative.empty() && *relative.begin() != "..")
+                return x;
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<std::filesystem::path> FilenameIndex::find_in_children(
+        const std::filesystem::path& root,
+        const std::filesystem::path& dir,
+        const std::string& name
+    ) {
+        std::unique_lock lck{ this->m_mut };
+        this->build_if_needed(root);
+
+        const auto found = this->m_entries.find(name);
+        if (this->m_entries.end() == found)
+            return std::nullopt;
+
+        for (const auto& x : found->second) {
+            const auto relative = x.lexically_relative(dir);
+            if (2 == ::calc_path_length(relative) && *relative.begin() != "..")
+                return x;
+        }
+
+        return std::nullopt;
+    }
+
+    void FilenameIndex::build_if_needed(const std::filesystem::path& root) {
+        if (this->m_built && this->m_root == root)
+            return;
+
+        this->m_entries.clear();
+        this->m_root = root;
+        this->m_built = true;
+
+        if (!fs::is_directory(root))
+            return;
+
+        for (auto& e : fs::recursive_directory_iterator(root)) {
+            this->m_entries[e.path().filename().u8string()].push_back(e.path());
+        }
+    }
+
+}
+
+
 // ResPath
 namespace dal {
 
@@ -359,9 +595,51 @@ namespace dal {
 }
 
 
+// IFileManagerR, IFileManagerRW
+namespace dal {
+
+    std::unique_ptr<IFileMapping> IFileManagerR::map(const ResPath& path) {
+        auto file = this->open(path);
+        if (!file->is_ready())
+            return make_file_mapping_null();
+
+        return make_file_mapping_heap(*file);
+    }
+
+    std::unique_ptr<IFileMapping> IFileManagerRW::map(const ResPath& path) {
+        auto file = this->open_read(path);
+        if (!file->is_ready())
+            return make_file_mapping_null();
+
+        return make_file_mapping_heap(*file);
+    }
+
+}
+
+
 // Filesystem
 namespace dal {
 
+    Filesystem::Filesystem() = default;
+
+    Filesystem::~Filesystem() = default;
+
+    void Filesystem::init(
+        std::unique_ptr<IAssetManager>&& asset_mgr,
+        std::unique_ptr<IUserDataManager>&& userdata_mgr,
+        std::unique_ptr<IInternalManager>&& internal_mgr
+    ) {
+        this->m_derived_data.reset();
+        this->m_async_io.reset();
+
+        this->m_asset_mgr = std::move(asset_mgr);
+        this->m_userdata_mgr = std::move(userdata_mgr);
+        this->m_internal_mgr = std::move(internal_mgr);
+
+        this->m_async_io = std::make_unique<AsyncFileIO>();
+        this->m_derived_data = std::make_unique<DerivedDataCache>(*this);
+    }
+
     bool Filesystem::is_file(const ResPath& path) {
         switch (::dispatch_file_manager(path)) {
             case ::FileType::asset:
@@ -467,4 +745,65 @@ namespace dal {
         return make_file_write_only_null();
     }
 
+    bool Filesystem::remove(const ResPath& path) {
+        if (!path.is_valid())
+            return false;
+
+        if (dal::SPECIAL_NAMESPACE_INTERNAL == path.dir_list().front())
+            return this->m_internal_mgr->remove(path);
+
+        return false;
+    }
+
+    std::unique_ptr<IFileMapping> Filesystem::map(const ResPath& path) {
+        switch (::dispatch_file_manager(path)) {
+            case ::FileType::asset:
+                return this->m_asset_mgr->map(path);
+            case ::FileType::internal:
+                return this->m_internal_mgr->map(path);
+            case ::FileType::userdata:
+                return this->m_userdata_mgr->map(path);
+            default:
+                return make_file_mapping_null();
+        }
+    }
+
+    std::shared_ptr<AsyncReadResult> Filesystem::read_async(const ResPath& path) {
+        auto result = std::make_shared<AsyncReadResult>();
+
+        std::optional<std::filesystem::path> native_path;
+        switch (::dispatch_file_manager(path)) {
+            case ::FileType::asset:
+                native_path = this->m_asset_mgr->native_path(path);
+                break;
+            case ::FileType::internal:
+                native_path = this->m_internal_mgr->native_path(path);
+                break;
+            case ::FileType::userdata:
+                native_path = this->m_userdata_mgr->native_path(path);
+                break;
+            default:
+                result->set(make_file_mapping_null());
+                return result;
+        }
+
+        if (native_path.has_value())
+            this->m_async_io->read(*native_path, result);
+        else
+            this->m_async_io->run([this, path]() { return this->map(path); }, result);
+
+        return result;
+    }
+
+    void Filesystem::refresh() {
+        this->m_asset_mgr->refresh();
+        this->m_userdata_mgr->refresh();
+        this->m_internal_mgr->refresh();
+    }
+
+    DerivedDataCache& Filesystem::derived_data() {
+        dalAssert(nullptr != this->m_derived_data);
+        return *this->m_derived_data;
+    }
+
 }
@@ -2,7 +2,9 @@
 
 #if defined(DAL_OS_WINDOWS) || defined(DAL_OS_LINUX)
 
+#include <cstdlib>
 #include <codecvt>
+#include <string_view>
 
 #if defined(DAL_OS_WINDOWS)
     #include <Shlobj.h>
@@ -15,6 +17,8 @@
 #include <fmt/format.h>
 
 #include "dal/util/konsts.h"
+#include "dal/util/logger.h"
+#include "dal/util/asset_pack.h"
 
 
 namespace fs = std::filesystem;
@@ -51,7 +55,8 @@ namespace {
         for (int i = 0; i < 16; ++i) {
             for (const auto& entry : std::filesystem::directory_iterator(cur_dir)) {
                 if (entry.path().filename() == dal::FOLDER_NAME_ASSET) {
-                    return cur_dir / dal::FOLDER_NAME_ASSET;
+                    // Cached, so it must stay valid even if working directory changes
+                    return fs::absolute(cur_dir / dal::FOLDER_NAME_ASSET);
                 }
             }
 
@@ -61,6 +66,65 @@ namespace {
         return std::nullopt;
     }
 
+    // Searched the same way as asset folder
+    std::optional<fs::path> find_asset_pack() {
+        std::filesystem::path cur_dir = ".";
+
+        for (int i = 0; i < 16; ++i) {
+            const auto pack_path = cur_dir / dal::FILE_NAME_ASSET_PACK;
+            if (fs::is_regular_file(pack_path))
+                return fs::absolute(pack_path);
+
+            cur_dir /= "..";
+        }
+
+        return std::nullopt;
+    }
+
+    // Errors are skipped so that unreadable entries do not make the whole folder look older
+    std::optional<fs::file_time_type> find_newest_write_time(const fs::path& folder_path) {
+        std::optional<fs::file_time_type> output;
+        std::error_code ec;
+
+        fs::recursive_directory_iterator iter{ folder_path, ec };
+        if (ec)
+            return std::nullopt;
+
+        for (const fs::recursive_directory_iterator end; iter != end; iter.increment(ec)) {
+            if (ec)
+                break;
+            if (!iter->is_regular_file(ec))
+                continue;
+
+            const auto write_time = iter->last_write_time(ec);
+            if (ec)
+                continue;
+
+            if (!output.has_value() || write_time > *output)
+                output = write_time;
+        }
+
+        return output;
+    }
+
+    // Pack built before the latest edit in asset folder would serve outdated assets
+    bool is_asset_pack_stale(const fs::path& pack_path) {
+        const auto asset_dir = ::find_asset_dir();
+        if (!asset_dir.has_value())
+            return false;
+
+        const auto newest_asset_time = ::find_newest_write_time(*asset_dir);
+        if (!newest_asset_time.has_value())
+            return false;
+
+        std::error_code ec;
+        const auto pack_time = fs::last_write_time(pack_path, ec);
+        if (ec)
+            return true;
+
+        return pack_time < *newest_asset_time;
+    }
+
     std::optional<fs::path> find_document_dir() {
 
 #if defined(DAL_OS_WINDOWS)
@@ -106,8 +170,7 @@ namespace {
         return ::find_folder_in_document(dal::FOLDER_NAME_INTERNAL);
     }
 
-    std::optional<fs::path> convert_asset_respath(const dal::ResPath& path) {
-        const auto asset_dir = ::find_asset_dir();
+    std::optional<fs::path> convert_asset_respath(const dal::ResPath& path, const std::optional<fs::path>& asset_dir) {
         if (!asset_dir.has_value())
             return std::nullopt;
 
@@ -122,8 +185,7 @@ namespace {
         return file_path;
     }
 
-    std::optional<fs::path> convert_userdata_respath(const dal::ResPath& path) {
-        const auto domain_dir = ::find_userdata_dir();
+    std::optional<fs::path> convert_userdata_respath(const dal::ResPath& path, const std::optional<fs::path>& domain_dir) {
         if (!domain_dir.has_value())
             return std::nullopt;
 
@@ -137,11 +199,10 @@ namespace {
 
     }
 
-    std::optional<fs::path> convert_internal_respath(const dal::ResPath& path) {
+    std::optional<fs::path> convert_internal_respath(const dal::ResPath& path, const std::optional<fs::path>& domain_dir) {
         if (dal::SPECIAL_NAMESPACE_INTERNAL != path.dir_list().front())
             return std::nullopt;
 
-        const auto domain_dir = ::find_internal_dir();
         if (!domain_dir.has_value())
             return std::nullopt;
 
@@ -161,15 +222,18 @@ namespace {
 // Resolve functions
 namespace {
 
-    std::optional<dal::ResPath> resolve_asset_path(const dal::ResPath& respath) {
+    std::optional<dal::ResPath> resolve_asset_path(
+        const dal::ResPath& respath,
+        const std::optional<fs::path>& start_dir,
+        dal::FilenameIndex& name_index
+    ) {
         if (respath.dir_list().front() != dal::SPECIAL_NAMESPACE_ASSET)
             return std::nullopt;
 
-        const auto start_dir = ::find_asset_dir();
         if (!start_dir.has_value())
             return std::nullopt;
 
-        const auto result = dal::resolve_path(respath, *start_dir, 1);
+        const auto result = dal::resolve_path(respath, *start_dir, 1, name_index);
         if (!result.has_value())
             return std::nullopt;
 
@@ -177,27 +241,33 @@ namespace {
         return dal::ResPath{ res_path_str };
     }
 
-    std::optional<dal::ResPath> resolve_userdata_path(const dal::ResPath& respath) {
-        const auto start_dir = ::find_userdata_dir();
+    std::optional<dal::ResPath> resolve_userdata_path(
+        const dal::ResPath& respath,
+        const std::optional<fs::path>& start_dir,
+        dal::FilenameIndex& name_index
+    ) {
         if (!start_dir.has_value())
             return std::nullopt;
 
-        const auto result = dal::resolve_path(respath, *start_dir, 0);
+        const auto result = dal::resolve_path(respath, *start_dir, 0, name_index);
         if (!result.has_value())
             return std::nullopt;
 
         return dal::ResPath{ result.value() };
     }
 
-    std::optional<dal::ResPath> resolve_internal_path(const dal::ResPath& respath) {
+    std::optional<dal::ResPath> resolve_internal_path(
+        const dal::ResPath& respath,
+        const std::optional<fs::path>& start_dir,
+        dal::FilenameIndex& name_index
+    ) {
         if (respath.dir_list().front() != dal::SPECIAL_NAMESPACE_INTERNAL)
             return std::nullopt;
 
-        const auto start_dir = ::find_internal_dir();
         if (!start_dir.has_value())
             return std::nullopt;
 
-        const auto result = dal::resolve_path(respath, *start_dir, 1);
+        const auto result = dal::resolve_path(respath, *start_dir, 1, name_index);
         if (!result.has_value())
             return std::nullopt;
 
@@ -207,11 +277,50 @@ namespace {
 }
 
 
+// DomainRootCache
+namespace dal {
+
+    DomainRootCache::DomainRootCache(const finder_t finder)
+        : m_finder(finder)
+    {
+
+    }
+
+    std::optional<std::filesystem::path> DomainRootCache::get() {
+        std::unique_lock lck{ this->m_mut };
+
+        if (!this->m_searched) {
+            this->m_root = this->m_finder();
+            this->m_searched = true;
+        }
+
+        return this->m_root;
+    }
+
+    void DomainRootCache::refresh() {
+        std::unique_lock lck{ this->m_mut };
+        this->m_searched = false;
+    }
+
+}
+
+
 // AssetManagerSTD
 namespace dal {
 
+    AssetManagerSTD::AssetManagerSTD()
+        : m_root(::find_asset_dir)
+    {
+
+    }
+
+    void AssetManagerSTD::refresh() {
+        this->m_root.refresh();
+        this->m_name_index.reset();
+    }
+
     bool AssetManagerSTD::is_file(const ResPath& path) {
-        const auto normal_path = ::convert_asset_respath(path);
+        const auto normal_path = ::convert_asset_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -219,7 +328,7 @@ namespace dal {
     }
 
     bool AssetManagerSTD::is_folder(const ResPath& path) {
-        const auto normal_path = ::convert_asset_respath(path);
+        const auto normal_path = ::convert_asset_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -227,7 +336,7 @@ namespace dal {
     }
 
     size_t AssetManagerSTD::list_files(const ResPath& path, std::vector<std::string>& output) {
-        const auto normal_path = ::convert_asset_respath(path);
+        const auto normal_path = ::convert_asset_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -241,7 +350,7 @@ namespace dal {
     }
 
     size_t AssetManagerSTD::list_folders(const ResPath& path, std::vector<std::string>& output) {
-        const auto normal_path = ::convert_asset_respath(path);
+        const auto normal_path = ::convert_asset_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -255,7 +364,16 @@ namespace dal {
     }
 
     std::optional<ResPath> AssetManagerSTD::resolve(const ResPath& path) {
-        return ::resolve_asset_path(path);
+        return ::resolve_asset_path(path, this->m_root.get(), this->m_name_index);
+    }
+
+    std::optional<std::filesystem::path> AssetManagerSTD::native_path(const ResPath& path) {
+        if (path.dir_list().front() != dal::SPECIAL_NAMESPACE_ASSET)
+            return std::nullopt;
+        if (path.dir_list().size() < 2)
+            return std::nullopt;
+
+        return ::convert_asset_respath(path, this->m_root.get());
     }
 
     std::unique_ptr<FileReadOnly> AssetManagerSTD::open(const ResPath& path) {
@@ -264,7 +382,7 @@ namespace dal {
         if (path.dir_list().size() < 2)
             return make_file_read_only_null();
 
-        const auto file_path = ::convert_asset_respath(path);
+        const auto file_path = ::convert_asset_respath(path, this->m_root.get());
         if (!file_path.has_value())
             return make_file_read_only_null();
 
@@ -277,14 +395,38 @@ namespace dal {
             return file;
     }
 
+    std::unique_ptr<IFileMapping> AssetManagerSTD::map(const ResPath& path) {
+        if (path.dir_list().front() != dal::SPECIAL_NAMESPACE_ASSET)
+            return make_file_mapping_null();
+        if (path.dir_list().size() < 2)
+            return make_file_mapping_null();
+
+        const auto file_path = ::convert_asset_respath(path, this->m_root.get());
+        if (!file_path.has_value())
+            return make_file_mapping_null();
+
+        return dal::map_file(*file_path);
+    }
+
 }
 
 
 // UserDataManagerSTD
 namespace dal {
 
+    UserDataManagerSTD::UserDataManagerSTD()
+        : m_root(::find_userdata_dir)
+    {
+
+    }
+
+    void UserDataManagerSTD::refresh() {
+        this->m_root.refresh();
+        this->m_name_index.reset();
+    }
+
     bool UserDataManagerSTD::is_file(const dal::ResPath& path) {
-        const auto normal_path = ::convert_userdata_respath(path);
+        const auto normal_path = ::convert_userdata_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -292,7 +434,7 @@ namespace dal {
     }
 
     bool UserDataManagerSTD::is_folder(const dal::ResPath& path) {
-        const auto normal_path = ::convert_userdata_respath(path);
+        const auto normal_path = ::convert_userdata_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -300,7 +442,7 @@ namespace dal {
     }
 
     size_t UserDataManagerSTD::list_files(const dal::ResPath& path, std::vector<std::string>& output) {
-        const auto normal_path = ::convert_userdata_respath(path);
+        const auto normal_path = ::convert_userdata_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -314,7 +456,7 @@ namespace dal {
     }
 
     size_t UserDataManagerSTD::list_folders(const dal::ResPath& path, std::vector<std::string>& output) {
-        const auto normal_path = ::convert_userdata_respath(path);
+        const auto normal_path = ::convert_userdata_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -328,11 +470,15 @@ namespace dal {
     }
 
     std::optional<ResPath> UserDataManagerSTD::resolve(const ResPath& path) {
-        return ::resolve_userdata_path(path);
+        return ::resolve_userdata_path(path, this->m_root.get(), this->m_name_index);
+    }
+
+    std::optional<std::filesystem::path> UserDataManagerSTD::native_path(const ResPath& path) {
+        return ::convert_userdata_respath(path, this->m_root.get());
     }
 
     std::unique_ptr<FileReadOnly> UserDataManagerSTD::open(const dal::ResPath& path) {
-        const auto file_path = ::convert_userdata_respath(path);
+        const auto file_path = ::convert_userdata_respath(path, this->m_root.get());
         if (!file_path.has_value())
             return make_file_read_only_null();
 
@@ -345,14 +491,33 @@ namespace dal {
             return file;
     }
 
+    std::unique_ptr<IFileMapping> UserDataManagerSTD::map(const dal::ResPath& path) {
+        const auto file_path = ::convert_userdata_respath(path, this->m_root.get());
+        if (!file_path.has_value())
+            return make_file_mapping_null();
+
+        return dal::map_file(*file_path);
+    }
+
 }
 
 
 // InternalManagerSTD
 namespace dal {
 
+    InternalManagerSTD::InternalManagerSTD()
+        : m_root(::find_internal_dir)
+    {
+
+    }
+
+    void InternalManagerSTD::refresh() {
+        this->m_root.refresh();
+        this->m_name_index.reset();
+    }
+
     bool InternalManagerSTD::is_file(const dal::ResPath& path) {
-        const auto normal_path = ::convert_internal_respath(path);
+        const auto normal_path = ::convert_internal_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return false;
 
@@ -360,7 +525,7 @@ namespace dal {
     }
 
     bool InternalManagerSTD::is_folder(const dal::ResPath& path) {
-        const auto normal_path = ::convert_internal_respath(path);
+        const auto normal_path = ::convert_internal_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return false;
 
@@ -368,7 +533,7 @@ namespace dal {
     }
 
     size_t InternalManagerSTD::list_files(const dal::ResPath& path, std::vector<std::string>& output) {
-        const auto normal_path = ::convert_internal_respath(path);
+        const auto normal_path = ::convert_internal_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -382,7 +547,7 @@ namespace dal {
     }
 
     size_t InternalManagerSTD::list_folders(const dal::ResPath& path, std::vector<std::string>& output) {
-        const auto normal_path = ::convert_internal_respath(path);
+        const auto normal_path = ::convert_internal_respath(path, this->m_root.get());
         if (!normal_path.has_value())
             return 0;
 
@@ -396,11 +561,15 @@ namespace dal {
     }
 
     std::optional<ResPath> InternalManagerSTD::resolve(const ResPath& path) {
-        return ::resolve_internal_path(path);
+        return ::resolve_internal_path(path, this->m_root.get(), this->m_name_index);
+    }
+
+    std::optional<std::filesystem::path> InternalManagerSTD::native_path(const ResPath& path) {
+        return ::convert_internal_respath(path, this->m_root.get());
     }
 
     std::unique_ptr<FileReadOnly> InternalManagerSTD::open_read(const ResPath& path) {
-        const auto file_path = ::convert_internal_respath(path);
+        const auto file_path = ::convert_internal_respath(path, this->m_root.get());
         if (!file_path.has_value())
             return make_file_read_only_null();
 
@@ -414,7 +583,7 @@ namespace dal {
     }
 
     std::unique_ptr<IFileWriteOnly> InternalManagerSTD::open_write(const ResPath& path) {
-        const auto file_path = ::convert_internal_respath(path);
+        const auto file_path = ::convert_internal_respath(path, this->m_root.get());
         if (!file_path.has_value())
             return make_file_write_only_null();
 
@@ -429,6 +598,70 @@ namespace dal {
             return file;
     }
 
+    bool InternalManagerSTD::remove(const ResPath& path) {
+        const auto file_path = ::convert_internal_respath(path, this->m_root.get());
+        if (!file_path.has_value())
+            return false;
+
+        std::error_code err;
+        return fs::remove(*file_path, err);
+    }
+
+    std::unique_ptr<IFileMapping> InternalManagerSTD::map(const ResPath& path) {
+        const auto file_path = ::convert_internal_respath(path, this->m_root.get());
+        if (!file_path.has_value())
+            return make_file_mapping_null();
+
+        return dal::map_file(*file_path);
+    }
+
+}
+
+
+// Functions
+namespace dal {
+
+    bool is_asset_pack_requested(const int argc, const char* const* const argv) {
+        for (int i = 1; i < argc; ++i) {
+            if (std::string_view{ argv[i] } == "--asset-pack")
+                return true;
+        }
+
+        const auto env_value = std::getenv("DAL_ASSET_PACK");
+        if (nullptr == env_value)
+            return false;
+
+        const std::string_view env_str{ env_value };
+        return !env_str.empty() && env_str != "0";
+    }
+
+    std::unique_ptr<IAssetManager> make_asset_manager_std(const bool use_asset_pack) {
+        if (!use_asset_pack) {
+            dalInfo("Serving assets from asset folder");
+            return std::make_unique<AssetManagerSTD>();
+        }
+
+        const auto pack_path = ::find_asset_pack();
+        if (!pack_path.has_value()) {
+            dalWarn("Asset pack was requested but not found, using asset folder instead");
+            return std::make_unique<AssetManagerSTD>();
+        }
+
+        if (::is_asset_pack_stale(*pack_path)) {
+            dalWarn(fmt::format("Asset pack is older than asset folder, using asset folder instead: {}", pack_path->u8string()).c_str());
+            return std::make_unique<AssetManagerSTD>();
+        }
+
+        auto pack_mgr = std::make_unique<AssetManagerPack>(dal::map_file(*pack_path));
+        if (!pack_mgr->is_ready()) {
+            dalWarn(fmt::format("Asset pack is invalid, using asset folder instead: {}", pack_path->u8string()).c_str());
+            return std::make_unique<AssetManagerSTD>();
+        }
+
+        dalInfo(fmt::format("Serving assets from asset pack: {}", pack_path->u8string()).c_str());
+        return pack_mgr;
+    }
+
 }
 
 #endif
@@ -0,0 +1,108 @@
+#include "dal/util/hash.h"
+
+#include <cstring>
+
+
+namespace {
+
+    constexpr uint64_t PRIME64_1 = 11400714785074694791ULL;
+    constexpr uint64_t PRIME64_2 = 14029467366897019727ULL;
+    constexpr uint64_t PRIME64_3 =  1609587929392839161ULL;
+    constexpr uint64_t PRIME64_4 =  9650029242287828579ULL;
+    constexpr uint64_t PRIME64_5 =  2870177450012600261ULL;
+
+
+    inline uint64_t rotate_left(const uint64_t x, const int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    // Little endian is assumed, which is true for all supported platforms
+    inline uint64_t read_u64(const uint8_t* const ptr) {
+        uint64_t output;
+        std::memcpy(&output, ptr, sizeof(output));
+        return output;
+    }
+
+    inline uint32_t read_u32(const uint8_t* const ptr) {
+        uint32_t output;
+        std::memcpy(&output, ptr, sizeof(output));
+        return output;
+    }
+
+    inline uint64_t xx_round(uint64_t acc, const uint64_t input) {
+        acc += input * ::PRIME64_2;
+        acc = ::rotate_left(acc, 31);
+        acc *= ::PRIME64_1;
+        return acc;
+    }
+
+    inline uint64_t xx_merge_round(uint64_t acc, const uint64_t value) {
+        acc ^= ::xx_round(0, value);
+        acc = acc * ::PRIME64_1 + ::PRIME64_4;
+        return acc;
+    }
+
+}
+
+
+namespace dal {
+
+    uint64_t hash_xx64(const void* const data, const size_t data_size, const uint64_t seed) {
+        auto ptr = reinterpret_cast<const uint8_t*>(data);
+        const auto end = ptr + data_size;
+        uint64_t h;
+
+        if (data_size >= 32) {
+            const auto limit = end - 32;
+            uint64_t v1 = seed + ::PRIME64_1 + ::PRIME64_2;
+            uint64_t v2 = seed + ::PRIME64_2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - ::PRIME64_1;
+
+            do {
+                v1 = ::xx_round(v1, ::read_u64(ptr)); ptr += 8;
+                v2 = ::xx_round(v2, ::read_u64(ptr)); ptr += 8;
+                v3 = ::xx_round(v3, ::read_u64(ptr)); ptr += 8;
+                v4 = ::xx_round(v4, ::read_u64(ptr)); ptr += 8;
+            } while (ptr <= limit);
+
+            h = ::rotate_left(v1, 1) + ::rotate_left(v2, 7) + ::rotate_left(v3, 12) + ::rotate_left(v4, 18);
+            h = ::xx_merge_round(h, v1);
+            h = ::xx_merge_round(h, v2);
+            h = ::xx_merge_round(h, v3);
+            h = ::xx_merge_round(h, v4);
+        }
+        else {
+            h = seed + ::PRIME64_5;
+        }
+
+        h += static_cast<uint64_t>(data_size);
+
+        while (ptr + 8 <= end) {
+            h ^= ::xx_round(0, ::read_u64(ptr));
+            h = ::rotate_left(h, 27) * ::PRIME64_1 + ::PRIME64_4;
+            ptr += 8;
+        }
+
+        if (ptr + 4 <= end) {
+            h ^= static_cast<uint64_t>(::read_u32(ptr)) * ::PRIME64_1;
+            h = ::rotate_left(h, 23) * ::PRIME64_2 + ::PRIME64_3;
+            ptr += 4;
+        }
+
+        while (ptr < end) {
+            h ^= static_cast<uint64_t>(*ptr) * ::PRIME64_5;
+            h = ::rotate_left(h, 11) * ::PRIME64_1;
+            ++ptr;
+        }
+
+        h ^= h >> 33;
+        h *= ::PRIME64_2;
+        h ^= h >> 29;
+        h *= ::PRIME64_3;
+        h ^= h >> 32;
+
+        return h;
+    }
+
+}
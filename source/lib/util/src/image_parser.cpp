@@ -1,5 +1,6 @@
 #include "dal/util/image_parser.h"
 
+#include <algorithm>
 #include <type_traits>
 
 #define STBI_NO_PSD
@@ -13,6 +14,35 @@
 
 
 // ImageFormat
+namespace dal {
+
+    bool is_format_compressed(const ImageFormat format) {
+        switch (format) {
+            case ImageFormat::bc7_srgb:
+            case ImageFormat::etc2_rgba8_srgb:
+            case ImageFormat::astc_4x4_srgb:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    size_t calc_image_data_size(const ImageFormat format, const uint32_t width, const uint32_t height) {
+        // Every compressed format here stores a 4x4 block of texels in 16 bytes
+        if (is_format_compressed(format)) {
+            const size_t block_x = (width + 3) / 4;
+            const size_t block_y = (height + 3) / 4;
+            return block_x * block_y * 16;
+        }
+        else {
+            return static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+        }
+    }
+
+}
+
+
+// ImageData
 namespace dal {
 
     ImageData::ImageData(
@@ -25,6 +55,16 @@ namespace dal {
         this->set(data, width, height, channels, format);
     }
 
+    ImageData::ImageData(
+        std::vector<uint8_t>&& data,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t mip_levels,
+        const ImageFormat format
+    ) {
+        this->set_mip_chain(std::move(data), width, height, mip_levels, format);
+    }
+
     void ImageData::set(
         const void* const data,
         const uint32_t width,
@@ -32,14 +72,84 @@ namespace dal {
         const uint32_t channels,
         const ImageFormat format
     ) {
+        const auto image_data_size = calc_image_data_size(format, width, height);
+        const auto src = reinterpret_cast<const uint8_t*>(data);
+
+        this->set_mip_chain(std::vector<uint8_t>(src, src + image_data_size), width, height, 1, format);
+    }
+
+    void ImageData::set_mip_chain(
+        std::vector<uint8_t>&& data,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t mip_levels,
+        const ImageFormat format
+    ) {
+        const auto owned = std::make_shared<std::vector<uint8_t>>(std::move(data));
+        const auto data_size = owned->size();
+
+        this->set_shared(
+            std::shared_ptr<const uint8_t>(owned, owned->data()),
+            data_size,
+            width,
+            height,
+            mip_levels,
+            format
+        );
+    }
+
+    void ImageData::set_shared(
+        std::shared_ptr<const uint8_t> storage,
+        const size_t data_size,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t mip_levels,
+        const ImageFormat format
+    ) {
+        this->set_borrowed(storage.get(), data_size, width, height, mip_levels, format);
+        this->m_storage = std::move(storage);
+    }
+
+    void ImageData::set_borrowed(
+        const void* const data,
+        const size_t data_size,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t mip_levels,
+        const ImageFormat format
+    ) {
+        this->m_storage.reset();
+        this->m_data = reinterpret_cast<const uint8_t*>(data);
+        this->m_data_size = data_size;
+
         this->m_width = width;
         this->m_height = height;
         this->m_channels = 4;
-        this->m_format = ImageFormat::r8g8b8a8_srgb;
+        this->m_mip_levels = mip_levels;
+        this->m_format = format;
+
+        dalAssert(this->m_data_size == this->mip_offset(mip_levels));
+    }
+
+    uint32_t ImageData::mip_width(const uint32_t mip_level) const {
+        return std::max<uint32_t>(1, this->m_width >> mip_level);
+    }
+
+    uint32_t ImageData::mip_height(const uint32_t mip_level) const {
+        return std::max<uint32_t>(1, this->m_height >> mip_level);
+    }
+
+    size_t ImageData::mip_offset(const uint32_t mip_level) const {
+        size_t output = 0;
+
+        for (uint32_t i = 0; i < mip_level; ++i)
+            output += this->mip_size(i);
+
+        return output;
+    }
 
-        const auto image_data_size = static_cast<size_t>(width * height * 4);
-        this->m_data.resize(image_data_size);
-        memcpy(this->m_data.data(), data, image_data_size);
+    size_t ImageData::mip_size(const uint32_t mip_level) const {
+        return calc_image_data_size(this->m_format, this->mip_width(mip_level), this->mip_height(mip_level));
     }
 
 }
@@ -55,8 +165,17 @@ namespace dal {
         dalAssert(nullptr != pixels);
         static_assert(std::is_same<uint8_t, stbi_uc>::value);
 
-        ImageData output(pixels, width, height, 4, ImageFormat::r8g8b8a8_srgb);
-        stbi_image_free(pixels);
+        const std::shared_ptr<const uint8_t> storage{ pixels, [](const uint8_t* p) { stbi_image_free(const_cast<uint8_t*>(p)); } };
+
+        ImageData output;
+        output.set_shared(
+            storage,
+            dal::calc_image_data_size(ImageFormat::r8g8b8a8_srgb, width, height),
+            width,
+            height,
+            1,
+            ImageFormat::r8g8b8a8_srgb
+        );
 
         return output;
     }
@@ -0,0 +1,422 @@
+#include "dal/util/mesh_simplify.h"
+
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+
+
+namespace {
+
+    // Levels generated beside the original mesh
+    constexpr size_t MAX_LOD_COUNT = 3;
+    // Smaller meshes are cheap enough to be always drawn in full
+    constexpr size_t MIN_TRIANGLES_FOR_LOD = 64;
+    // A level with more triangles than this ratio of previous one is not worth its index range
+    constexpr double MAX_LOD_TRIANGLE_RATIO = 0.8;
+    // Relative to bounding sphere radius
+    constexpr float MAX_LOD_ERROR = 0.1f;
+    // Cosine of the largest angle a triangle may turn by a collapse
+    constexpr double MIN_NORMAL_COS_AFTER_COLLAPSE = 0.25;
+
+
+    // Sum of squared distances to planes, weighted by area of triangles they came from.
+    // Symmetric 4x4 matrix is stored as its upper triangle.
+    class Quadric {
+
+    private:
+        std::array<double, 10> m{};
+        double m_weight = 0;
+
+    public:
+        void add_plane(const glm::dvec3& normal, const double d, const double weight) {
+            this->m[0] += weight * normal.x * normal.x;
+            this->m[1] += weight * normal.x * normal.y;
+            this->m[2] += weight * normal.x * normal.z;
+            this->m[3] += weight * normal.x * d;
+            this->m[4] += weight * normal.y * normal.y;
+            this->m[5] += weight * normal.y * normal.z;
+            this->m[6] += weight * normal.y * d;
+            this->m[7] += weight * normal.z * normal.z;
+            this->m[8] += weight * normal.z * d;
+            this->m[9] += weight * d * d;
+            this->m_weight += weight;
+        }
+
+        Quadric& operator+=(const Quadric& other) {
+            for (size_t i = 0; i < this->m.size(); ++i)
+                this->m[i] += other.m[i];
+            this->m_weight += other.m_weight;
+            return *this;
+        }
+
+        Quadric operator+(const Quadric& other) const {
+            auto output = *this;
+            output += other;
+            return output;
+        }
+
+        // Root mean square distance of a point from the planes
+        float error_at(const glm::vec3& p) const {
+            if (this->m_weight <= 0)
+                return 0;
+
+            const double x = p.x;
+            const double y = p.y;
+            const double z = p.z;
+
+            const auto sum = (
+                this->m[0] * x * x + 2 * this->m[1] * x * y + 2 * this->m[2] * x * z + 2 * this->m[3] * x +
+                this->m[4] * y * y + 2 * this->m[5] * y * z + 2 * this->m[6] * y +
+                this->m[7] * z * z + 2 * this->m[8] * z +
+                this->m[9]
+            );
+
+            return static_cast<float>(std::sqrt(std::max(sum, 0.0) / this->m_weight));
+        }
+
+    };
+
+
+    glm::dvec3 calc_normal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+        return glm::cross(glm::dvec3{ p1 } - glm::dvec3{ p0 }, glm::dvec3{ p2 } - glm::dvec3{ p0 });
+    }
+
+    // Vertices at the same position get the same ID, so that UV and normal seams can be found
+    std::vector<uint32_t> make_position_ids(const std::vector<glm::vec3>& positions, uint32_t& out_id_count) {
+        const auto less = [&positions](const uint32_t a, const uint32_t b) {
+            const auto& pa = positions[a];
+            const auto& pb = positions[b];
+
+            if (pa.x != pb.x)
+                return pa.x < pb.x;
+            if (pa.y != pb.y)
+                return pa.y < pb.y;
+            return pa.z < pb.z;
+        };
+
+        std::vector<uint32_t> order(positions.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), less);
+
+        std::vector<uint32_t> output(positions.size());
+        uint32_t id = 0;
+
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (i > 0 && less(order[i - 1], order[i]))
+                ++id;
+            output[order[i]] = id;
+        }
+
+        out_id_count = positions.empty() ? 0 : id + 1;
+        return output;
+    }
+
+
+    // Collapses edges in passes. In a pass, collapses don't share any triangle, so adjacency built at start of it stays valid.
+    class EdgeCollapser {
+
+    private:
+        struct Collapse {
+            uint32_t m_from = 0;
+            uint32_t m_to = 0;
+            float m_error = 0;
+        };
+
+    private:
+        const std::vector<glm::vec3>& m_positions;
+        std::vector<uint32_t> m_pos_ids;
+        // Indexed by position ID from here on
+        std::vector<uint32_t> m_wedge_counts;
+        std::vector<::Quadric> m_quadrics;
+
+        std::vector<uint32_t> m_indices;
+        // Triangles around each vertex, as offsets into m_adjacent_tris
+        std::vector<uint32_t> m_adjacent_offsets;
+        std::vector<uint32_t> m_adjacent_tris;
+        float m_error = 0;
+
+    public:
+        EdgeCollapser(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+            : m_positions(positions)
+        {
+            uint32_t id_count = 0;
+            this->m_pos_ids = ::make_position_ids(positions, id_count);
+            this->m_wedge_counts.resize(id_count, 0);
+            this->m_quadrics.resize(id_count);
+
+            for (const auto id : this->m_pos_ids)
+                ++this->m_wedge_counts[id];
+
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                const auto i0 = indices[i + 0];
+                const auto i1 = indices[i + 1];
+                const auto i2 = indices[i + 2];
+
+                if (this->is_degenerate(i0, i1, i2))
+                    continue;
+
+                this->m_indices.insert(this->m_indices.end(), { i0, i1, i2 });
+
+                const auto normal = ::calc_normal(positions[i0], positions[i1], positions[i2]);
+                const auto length = glm::length(normal);
+                if (length <= 0)
+                    continue;
+
+                const auto unit_normal = normal / length;
+                const auto d = -glm::dot(unit_normal, glm::dvec3{ positions[i0] });
+                for (const auto index : { i0, i1, i2 })
+                    this->m_quadrics[this->m_pos_ids[index]].add_plane(unit_normal, d, length * 0.5);
+            }
+        }
+
+        size_t index_count() const {
+            return this->m_indices.size();
+        }
+
+        float error() const {
+            return this->m_error;
+        }
+
+        std::vector<uint32_t> release_indices() {
+            return std::move(this->m_indices);
+        }
+
+        // Returns false if nothing could be collapsed
+        bool run_pass(const size_t target_index_count, const float max_error) {
+            const auto locked = this->find_locked();
+            this->build_adjacency();
+
+            auto collapses = this->find_collapses(locked);
+            std::sort(collapses.begin(), collapses.end(), [](const auto& a, const auto& b) {
+                return a.m_error < b.m_error;
+            });
+
+            const auto target_tri_count = target_index_count / 3;
+            auto tri_count = this->m_indices.size() / 3;
+
+            std::vector<bool> touched(this->m_wedge_counts.size(), false);
+            std::vector<uint32_t> remap(this->m_positions.size());
+            std::iota(remap.begin(), remap.end(), 0);
+            bool collapsed_any = false;
+
+            for (const auto& x : collapses) {
+                if (tri_count <= target_tri_count || x.m_error > max_error)
+                    break;
+
+                const auto from_id = this->m_pos_ids[x.m_from];
+                const auto to_id = this->m_pos_ids[x.m_to];
+                if (touched[from_id] || touched[to_id])
+                    continue;
+                if (this->flips_triangle(x.m_from, x.m_to))
+                    continue;
+
+                for (auto i = this->m_adjacent_offsets[x.m_from]; i < this->m_adjacent_offsets[x.m_from + 1]; ++i) {
+                    const auto tri = this->m_adjacent_tris[i];
+                    bool has_to = false;
+
+                    for (size_t j = 0; j < 3; ++j) {
+                        const auto id = this->m_pos_ids[this->m_indices[tri * 3 + j]];
+                        touched[id] = true;
+                        has_to = has_to || id == to_id;
+                    }
+
+                    if (has_to)
+                        --tri_count;
+                }
+
+                remap[x.m_from] = x.m_to;
+                this->m_quadrics[to_id] += this->m_quadrics[from_id];
+                this->m_error = std::max(this->m_error, x.m_error);
+                collapsed_any = true;
+            }
+
+            if (!collapsed_any)
+                return false;
+
+            std::vector<uint32_t> new_indices;
+            new_indices.reserve(this->m_indices.size());
+
+            for (size_t i = 0; i < this->m_indices.size(); i += 3) {
+                const auto i0 = remap[this->m_indices[i + 0]];
+                const auto i1 = remap[this->m_indices[i + 1]];
+                const auto i2 = remap[this->m_indices[i + 2]];
+
+                if (!this->is_degenerate(i0, i1, i2))
+                    new_indices.insert(new_indices.end(), { i0, i1, i2 });
+            }
+
+            this->m_indices = std::move(new_indices);
+            return true;
+        }
+
+    private:
+        bool is_degenerate(const uint32_t i0, const uint32_t i1, const uint32_t i2) const {
+            const auto id0 = this->m_pos_ids[i0];
+            const auto id1 = this->m_pos_ids[i1];
+            const auto id2 = this->m_pos_ids[i2];
+            return id0 == id1 || id1 == id2 || id2 == id0;
+        }
+
+        // Seams, borders and non-manifold edges keep their vertices so that outline of the mesh and its UV charts stay
+        std::vector<bool> find_locked() const {
+            std::vector<bool> output(this->m_wedge_counts.size(), false);
+            for (size_t i = 0; i < output.size(); ++i)
+                output[i] = this->m_wedge_counts[i] > 1;
+
+            std::unordered_map<uint64_t, uint32_t> edge_uses;
+            edge_uses.reserve(this->m_indices.size());
+
+            for (size_t i = 0; i < this->m_indices.size(); i += 3) {
+                for (size_t j = 0; j < 3; ++j) {
+                    const uint64_t a = this->m_pos_ids[this->m_indices[i + j]];
+                    const uint64_t b = this->m_pos_ids[this->m_indices[i + (j + 1) % 3]];
+                    ++edge_uses[std::min(a, b) << 32 | std::max(a, b)];
+                }
+            }
+
+            for (const auto& [key, count] : edge_uses) {
+                if (2 != count) {
+                    output[key >> 32] = true;
+                    output[key & 0xFFFFFFFF] = true;
+                }
+            }
+
+            return output;
+        }
+
+        void build_adjacency() {
+            this->m_adjacent_offsets.assign(this->m_positions.size() + 1, 0);
+            for (const auto index : this->m_indices)
+                ++this->m_adjacent_offsets[index + 1];
+
+            std::partial_sum(this->m_adjacent_offsets.begin(), this->m_adjacent_offsets.end(), this->m_adjacent_offsets.begin());
+
+            auto fill_pos = this->m_adjacent_offsets;
+            this->m_adjacent_tris.resize(this->m_indices.size());
+            for (size_t i = 0; i < this->m_indices.size(); ++i)
+                this->m_adjacent_tris[fill_pos[this->m_indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        // Both directions of every edge whose start vertex is not locked
+        std::vector<Collapse> find_collapses(const std::vector<bool>& locked) const {
+            std::vector<Collapse> output;
+            output.reserve(this->m_indices.size() * 2);
+
+            for (size_t i = 0; i < this->m_indices.size(); i += 3) {
+                for (size_t j = 0; j < 3; ++j) {
+                    const auto a = this->m_indices[i + j];
+                    const auto b = this->m_indices[i + (j + 1) % 3];
+
+                    for (const auto& [from, to] : { std::make_pair(a, b), std::make_pair(b, a) }) {
+                        const auto from_id = this->m_pos_ids[from];
+                        if (locked[from_id])
+                            continue;
+
+                        auto& collapse = output.emplace_back();
+                        collapse.m_from = from;
+                        collapse.m_to = to;
+                        collapse.m_error = (this->m_quadrics[from_id] + this->m_quadrics[this->m_pos_ids[to]]).error_at(this->m_positions[to]);
+                    }
+                }
+            }
+
+            return output;
+        }
+
+        // Vertex collapsed from is never on a seam, so every triangle at its position uses its index
+        bool flips_triangle(const uint32_t from, const uint32_t to) const {
+            const auto to_id = this->m_pos_ids[to];
+
+            for (auto i = this->m_adjacent_offsets[from]; i < this->m_adjacent_offsets[from + 1]; ++i) {
+                const auto tri = this->m_adjacent_tris[i];
+                std::array<glm::vec3, 3> corners;
+                bool has_to = false;
+
+                for (size_t j = 0; j < 3; ++j) {
+                    const auto index = this->m_indices[tri * 3 + j];
+                    corners[j] = this->m_positions[index];
+                    has_to = has_to || this->m_pos_ids[index] == to_id;
+                }
+
+                // It disappears instead
+                if (has_to)
+                    continue;
+
+                const auto old_normal = ::calc_normal(corners[0], corners[1], corners[2]);
+                for (size_t j = 0; j < 3; ++j) {
+                    if (this->m_indices[tri * 3 + j] == from)
+                        corners[j] = this->m_positions[to];
+                }
+                const auto new_normal = ::calc_normal(corners[0], corners[1], corners[2]);
+
+                const auto length_product = glm::length(old_normal) * glm::length(new_normal);
+                if (length_product <= 0)
+                    return true;
+                if (glm::dot(old_normal, new_normal) < ::MIN_NORMAL_COS_AFTER_COLLAPSE * length_product)
+                    return true;
+            }
+
+            return false;
+        }
+
+    };
+
+}
+
+
+namespace dal {
+
+    std::vector<uint32_t> simplify_mesh(
+        const std::vector<glm::vec3>& positions,
+        const std::vector<uint32_t>& indices,
+        const size_t target_index_count,
+        const float max_error,
+        float& out_error
+    ) {
+        ::EdgeCollapser collapser{ positions, indices };
+
+        while (collapser.index_count() > target_index_count) {
+            if (!collapser.run_pass(target_index_count, max_error))
+                break;
+        }
+
+        out_error = collapser.error();
+        return collapser.release_indices();
+    }
+
+    void build_lods(RenderUnitStatic& unit) {
+        unit.m_lods.clear();
+
+        if (unit.m_indices.size() / 3 < ::MIN_TRIANGLES_FOR_LOD)
+            return;
+
+        const auto radius = glm::length(unit.m_aabb_max - unit.m_aabb_min) * 0.5f;
+        if (radius <= 0)
+            return;
+
+        std::vector<glm::vec3> positions;
+        positions.reserve(unit.m_vertices.size());
+        for (const auto& v : unit.m_vertices)
+            positions.push_back(v.m_pos);
+
+        // Every level is simplified from the original so that errors are measured against it
+        auto prev_index_count = unit.m_indices.size();
+
+        for (size_t i = 0; i < ::MAX_LOD_COUNT; ++i) {
+            float error = 0;
+            auto indices = dal::simplify_mesh(positions, unit.m_indices, prev_index_count / 2, ::MAX_LOD_ERROR * radius, error);
+
+            if (indices.empty() || indices.size() > prev_index_count * ::MAX_LOD_TRIANGLE_RATIO)
+                break;
+
+            prev_index_count = indices.size();
+
+            auto& lod = unit.m_lods.emplace_back();
+            lod.m_indices = std::move(indices);
+            lod.m_error = error / radius;
+        }
+    }
+
+}
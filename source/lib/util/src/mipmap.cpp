@@ -0,0 +1,145 @@
+#include "dal/util/mipmap.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "dal/util/logger.h"
+
+
+namespace {
+
+    constexpr size_t LINEAR_TO_SRGB_TABLE_SIZE = 1 << 14;
+
+
+    // Conversions are done with tables so that inner loop has no pow or branch
+    class SrgbTables {
+
+    private:
+        std::array<float, 256> m_to_linear;
+        std::array<uint8_t, LINEAR_TO_SRGB_TABLE_SIZE> m_to_srgb;
+
+    public:
+        SrgbTables() {
+            for (size_t i = 0; i < this->m_to_linear.size(); ++i) {
+                const auto c = static_cast<double>(i) / 255.0;
+                this->m_to_linear[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+            }
+
+            for (size_t i = 0; i < this->m_to_srgb.size(); ++i) {
+                const auto c = static_cast<double>(i) / static_cast<double>(LINEAR_TO_SRGB_TABLE_SIZE - 1);
+                const auto srgb = c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+                this->m_to_srgb[i] = static_cast<uint8_t>(std::clamp<long>(std::lround(srgb * 255.0), 0, 255));
+            }
+        }
+
+        float to_linear(const uint8_t value) const {
+            return this->m_to_linear[value];
+        }
+
+        uint8_t to_srgb(const float value) const {
+            const auto index = static_cast<size_t>(value * static_cast<float>(LINEAR_TO_SRGB_TABLE_SIZE - 1) + 0.5f);
+            return this->m_to_srgb[std::min(index, LINEAR_TO_SRGB_TABLE_SIZE - 1)];
+        }
+
+    };
+
+    const SrgbTables& get_srgb_tables() {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+
+    // 2x2 box filter. Edge texels are repeated when size is odd.
+    void downsample_half(
+        const uint8_t* const src,
+        const uint32_t src_width,
+        const uint32_t src_height,
+        uint8_t* const dst,
+        const uint32_t dst_width,
+        const uint32_t dst_height
+    ) {
+        const auto& tables = ::get_srgb_tables();
+
+        for (uint32_t y = 0; y < dst_height; ++y) {
+            const auto row0 = src + static_cast<size_t>(std::min(y * 2 + 0, src_height - 1)) * src_width * 4;
+            const auto row1 = src + static_cast<size_t>(std::min(y * 2 + 1, src_height - 1)) * src_width * 4;
+            const auto dst_row = dst + static_cast<size_t>(y) * dst_width * 4;
+
+            for (uint32_t x = 0; x < dst_width; ++x) {
+                const size_t x0 = std::min(x * 2 + 0, src_width - 1) * 4;
+                const size_t x1 = std::min(x * 2 + 1, src_width - 1) * 4;
+                const auto out = dst_row + static_cast<size_t>(x) * 4;
+
+                for (size_t c = 0; c < 3; ++c) {
+                    const float sum = (
+                        tables.to_linear(row0[x0 + c]) +
+                        tables.to_linear(row0[x1 + c]) +
+                        tables.to_linear(row1[x0 + c]) +
+                        tables.to_linear(row1[x1 + c])
+                    );
+                    out[c] = tables.to_srgb(sum * 0.25f);
+                }
+
+                const uint32_t alpha_sum = row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3];
+                out[3] = static_cast<uint8_t>((alpha_sum + 2) / 4);
+            }
+        }
+    }
+
+}
+
+
+namespace dal {
+
+    uint32_t calc_mip_levels(const uint32_t width, const uint32_t height) {
+        uint32_t output = 1;
+        auto size = std::max(width, height);
+
+        while (size > 1) {
+            size >>= 1;
+            ++output;
+        }
+
+        return output;
+    }
+
+    ImageData build_mip_chain(const ImageData& src) {
+        dalAssert(ImageFormat::r8g8b8a8_srgb == src.format());
+        dalAssert(1 == src.mip_levels());
+
+        const auto mip_levels = dal::calc_mip_levels(src.width(), src.height());
+
+        size_t total_size = 0;
+        for (uint32_t i = 0; i < mip_levels; ++i) {
+            const auto level_width = std::max<uint32_t>(1, src.width() >> i);
+            const auto level_height = std::max<uint32_t>(1, src.height() >> i);
+            total_size += dal::calc_image_data_size(src.format(), level_width, level_height);
+        }
+
+        std::vector<uint8_t> output(total_size);
+        std::memcpy(output.data(), src.data(), src.data_size());
+
+        size_t src_offset = 0;
+        size_t dst_offset = src.data_size();
+
+        for (uint32_t i = 1; i < mip_levels; ++i) {
+            const auto src_width = std::max<uint32_t>(1, src.width() >> (i - 1));
+            const auto src_height = std::max<uint32_t>(1, src.height() >> (i - 1));
+            const auto dst_width = std::max<uint32_t>(1, src.width() >> i);
+            const auto dst_height = std::max<uint32_t>(1, src.height() >> i);
+
+            ::downsample_half(
+                output.data() + src_offset, src_width, src_height,
+                output.data() + dst_offset, dst_width, dst_height
+            );
+
+            src_offset = dst_offset;
+            dst_offset += dal::calc_image_data_size(src.format(), dst_width, dst_height);
+        }
+
+        return ImageData{ std::move(output), src.width(), src.height(), mip_levels, src.format() };
+    }
+
+}
@@ -0,0 +1,536 @@
+#include "dal/util/model_cook.h"
+
+#include <cstring>
+#include <type_traits>
+
+
+namespace {
+
+    constexpr uint32_t COOKED_MODEL_MAGIC = 0x43444D44;  // "DMDC" in little endian
+    constexpr size_t BLOB_ALIGNMENT = 16;
+
+
+    enum class CookedModelKind : uint32_t {
+        static_model = 0,
+        skinned_model = 1,
+    };
+
+
+    struct CookedModelHeader {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_kind;
+        uint32_t m_unit_count;
+        uint32_t m_vertex_size;
+        uint32_t m_reserved;
+        uint64_t m_units_offset;
+        // Skeleton and animations. Zero sized for static models.
+        uint64_t m_skeleton_offset;
+        uint64_t m_skeleton_size;
+        uint64_t m_file_size;
+    };
+    static_assert(56 == sizeof(CookedModelHeader));
+
+    // Offsets are from the start of the file
+    struct CookedUnit {
+        uint64_t m_vertices_offset;
+        uint64_t m_indices_offset;
+        uint64_t m_albedo_map_offset;
+        // Array of CookedLod, followed by indices of each level in order
+        uint64_t m_lods_offset;
+        uint32_t m_vertex_count;
+        uint32_t m_index_count;
+        uint32_t m_albedo_map_size;
+        float m_roughness;
+        float m_metallic;
+        uint32_t m_alpha_blending;
+        float m_weight_center[3];
+        float m_aabb_min[3];
+        float m_aabb_max[3];
+        uint32_t m_lod_count;
+    };
+    static_assert(96 == sizeof(CookedUnit));
+
+    struct CookedLod {
+        uint32_t m_index_count;
+        float m_error;
+    };
+    static_assert(8 == sizeof(CookedLod));
+
+
+    class BinaryWriter {
+
+    private:
+        std::vector<uint8_t> m_data;
+
+    public:
+        size_t size() const {
+            return this->m_data.size();
+        }
+
+        void align(const size_t alignment) {
+            const auto remainder = this->m_data.size() % alignment;
+            if (0 != remainder)
+                this->m_data.resize(this->m_data.size() + alignment - remainder, 0);
+        }
+
+        void write_raw(const void* const data, const size_t size) {
+            const auto ptr = reinterpret_cast<const uint8_t*>(data);
+            this->m_data.insert(this->m_data.end(), ptr, ptr + size);
+        }
+
+        template <typename T>
+        void write(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            this->write_raw(&value, sizeof(T));
+        }
+
+        void write_str(const std::string& str) {
+            this->write(static_cast<uint32_t>(str.size()));
+            this->write_raw(str.data(), str.size());
+        }
+
+        void write_vec3(const glm::vec3& v) {
+            this->write(v.x);
+            this->write(v.y);
+            this->write(v.z);
+        }
+
+        void write_quat(const glm::quat& q) {
+            this->write(q.x);
+            this->write(q.y);
+            this->write(q.z);
+            this->write(q.w);
+        }
+
+        void write_mat4(const glm::mat4& m) {
+            for (int col = 0; col < 4; ++col)
+                for (int row = 0; row < 4; ++row)
+                    this->write(m[col][row]);
+        }
+
+        template <typename T>
+        void patch(const size_t offset, const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            std::memcpy(this->m_data.data() + offset, &value, sizeof(T));
+        }
+
+        std::vector<uint8_t> release() {
+            return std::move(this->m_data);
+        }
+
+    };
+
+
+    // Reads past the end are reported through is_failed, not by return values
+    class BinaryReader {
+
+    private:
+        const uint8_t* m_buf;
+        size_t m_size;
+        size_t m_pos = 0;
+        bool m_failed = false;
+
+    public:
+        BinaryReader(const uint8_t* const buf, const size_t size)
+            : m_buf(buf)
+            , m_size(size)
+        {
+
+        }
+
+        bool is_failed() const {
+            return this->m_failed;
+        }
+
+        bool is_end() const {
+            return this->m_pos == this->m_size;
+        }
+
+        void read_raw(void* const dst, const size_t size) {
+            if (this->m_failed || size > this->m_size - this->m_pos) {
+                this->m_failed = true;
+                std::memset(dst, 0, size);
+                return;
+            }
+
+            std::memcpy(dst, this->m_buf + this->m_pos, size);
+            this->m_pos += size;
+        }
+
+        template <typename T>
+        T read() {
+            static_assert(std::is_trivially_copyable_v<T>);
+            T output;
+            this->read_raw(&output, sizeof(T));
+            return output;
+        }
+
+        std::string read_str() {
+            const auto size = this->read<uint32_t>();
+            if (this->m_failed || size > this->m_size - this->m_pos) {
+                this->m_failed = true;
+                return std::string{};
+            }
+
+            std::string output(reinterpret_cast<const char*>(this->m_buf + this->m_pos), size);
+            this->m_pos += size;
+            return output;
+        }
+
+        glm::vec3 read_vec3() {
+            const auto x = this->read<float>();
+            const auto y = this->read<float>();
+            const auto z = this->read<float>();
+            return glm::vec3{ x, y, z };
+        }
+
+        glm::quat read_quat() {
+            const auto x = this->read<float>();
+            const auto y = this->read<float>();
+            const auto z = this->read<float>();
+            const auto w = this->read<float>();
+            return glm::quat{ w, x, y, z };
+        }
+
+        glm::mat4 read_mat4() {
+            glm::mat4 output;
+            for (int col = 0; col < 4; ++col)
+                for (int row = 0; row < 4; ++row)
+                    output[col][row] = this->read<float>();
+            return output;
+        }
+
+    };
+
+
+    bool is_range_valid(const uint64_t offset, const uint64_t size, const size_t buf_size) {
+        return offset <= buf_size && size <= buf_size - offset;
+    }
+
+    // Range checks alone let a corrupted index read past the vertex array on both CPU and GPU
+    bool are_indices_valid(const std::vector<uint32_t>& indices, const uint32_t vertex_count) {
+        for (const auto index : indices) {
+            if (index >= vertex_count)
+                return false;
+        }
+
+        return true;
+    }
+
+    void copy_vec3(float (&dst)[3], const glm::vec3& src) {
+        dst[0] = src.x;
+        dst[1] = src.y;
+        dst[2] = src.z;
+    }
+
+    glm::vec3 make_vec3(const float (&src)[3]) {
+        return glm::vec3{ src[0], src[1], src[2] };
+    }
+
+
+    template <typename _Vertex>
+    std::vector<uint8_t> serialize_model(
+        const std::vector<dal::TRenderUnit<_Vertex>>& units,
+        const CookedModelKind kind,
+        const dal::ModelSkinned* const skinned
+    ) {
+        BinaryWriter writer;
+        writer.write(CookedModelHeader{});
+
+        CookedModelHeader header{};
+        header.m_magic = ::COOKED_MODEL_MAGIC;
+        header.m_version = dal::MODEL_COOK_VERSION;
+        header.m_kind = static_cast<uint32_t>(kind);
+        header.m_unit_count = static_cast<uint32_t>(units.size());
+        header.m_vertex_size = sizeof(_Vertex);
+
+        writer.align(::BLOB_ALIGNMENT);
+        header.m_units_offset = writer.size();
+        for (size_t i = 0; i < units.size(); ++i)
+            writer.write(CookedUnit{});
+
+        for (size_t i = 0; i < units.size(); ++i) {
+            const auto& unit = units[i];
+            CookedUnit record{};
+
+            writer.align(::BLOB_ALIGNMENT);
+            record.m_vertices_offset = writer.size();
+            record.m_vertex_count = static_cast<uint32_t>(unit.m_vertices.size());
+            writer.write_raw(unit.m_vertices.data(), unit.m_vertices.size() * sizeof(_Vertex));
+
+            writer.align(::BLOB_ALIGNMENT);
+            record.m_indices_offset = writer.size();
+            record.m_index_count = static_cast<uint32_t>(unit.m_indices.size());
+            writer.write_raw(unit.m_indices.data(), unit.m_indices.size() * sizeof(uint32_t));
+
+            writer.align(::BLOB_ALIGNMENT);
+            record.m_lods_offset = writer.size();
+            record.m_lod_count = static_cast<uint32_t>(unit.m_lods.size());
+            for (const auto& lod : unit.m_lods)
+                writer.write(CookedLod{ static_cast<uint32_t>(lod.m_indices.size()), lod.m_error });
+            for (const auto& lod : unit.m_lods)
+                writer.write_raw(lod.m_indices.data(), lod.m_indices.size() * sizeof(uint32_t));
+
+            record.m_albedo_map_offset = writer.size();
+            record.m_albedo_map_size = static_cast<uint32_t>(unit.m_material.m_albedo_map.size());
+            writer.write_raw(unit.m_material.m_albedo_map.data(), unit.m_material.m_albedo_map.size());
+
+            record.m_roughness = unit.m_material.m_roughness;
+            record.m_metallic = unit.m_material.m_metallic;
+            record.m_alpha_blending = unit.m_material.m_alpha_blending ? 1 : 0;
+            ::copy_vec3(record.m_weight_center, unit.m_weight_center);
+            ::copy_vec3(record.m_aabb_min, unit.m_aabb_min);
+            ::copy_vec3(record.m_aabb_max, unit.m_aabb_max);
+
+            writer.patch(header.m_units_offset + i * sizeof(CookedUnit), record);
+        }
+
+        if (nullptr != skinned) {
+            writer.align(::BLOB_ALIGNMENT);
+            header.m_skeleton_offset = writer.size();
+
+            const auto& skeleton = skinned->m_skeleton;
+            writer.write_mat4(skeleton.m_root_mat);
+            writer.write(static_cast<uint32_t>(skeleton.size()));
+            for (dal::jointID_t i = 0; i < skeleton.size(); ++i) {
+                const auto& joint = skeleton.at(i);
+                writer.write_str(joint.name());
+                writer.write(static_cast<int32_t>(joint.parent_index()));
+                writer.write_mat4(joint.offset());
+                writer.write(static_cast<int32_t>(joint.join_type()));
+            }
+
+            writer.write(static_cast<uint32_t>(skinned->m_animations.size()));
+            for (const auto& anim : skinned->m_animations) {
+                writer.write_str(anim.name());
+                writer.write(anim.tick_per_sec());
+                writer.write(anim.duration_in_tick());
+                writer.write(static_cast<uint32_t>(anim.joints().size()));
+
+                for (const auto& joint : anim.joints()) {
+                    const auto& data = joint.m_data;
+                    writer.write_str(data.name_);
+
+                    writer.write(static_cast<uint32_t>(data.translations_.size()));
+                    for (const auto& [tick, value] : data.translations_) {
+                        writer.write(tick);
+                        writer.write_vec3(value);
+                    }
+
+                    writer.write(static_cast<uint32_t>(data.rotations_.size()));
+                    for (const auto& [tick, value] : data.rotations_) {
+                        writer.write(tick);
+                        writer.write_quat(value);
+                    }
+
+                    writer.write(static_cast<uint32_t>(data.scales_.size()));
+                    for (const auto& [tick, value] : data.scales_) {
+                        writer.write(tick);
+                        writer.write(static_cast<float>(value));
+                    }
+                }
+            }
+
+            header.m_skeleton_size = writer.size() - header.m_skeleton_offset;
+        }
+
+        header.m_file_size = writer.size();
+        writer.patch(0, header);
+        return writer.release();
+    }
+
+    std::optional<CookedModelHeader> parse_header(const uint8_t* const buf, const size_t buf_size, const CookedModelKind kind, const size_t vertex_size) {
+        if (buf_size < sizeof(CookedModelHeader))
+            return std::nullopt;
+
+        CookedModelHeader header;
+        std::memcpy(&header, buf, sizeof(header));
+
+        if (::COOKED_MODEL_MAGIC != header.m_magic)
+            return std::nullopt;
+        if (dal::MODEL_COOK_VERSION != header.m_version)
+            return std::nullopt;
+        if (static_cast<uint32_t>(kind) != header.m_kind)
+            return std::nullopt;
+        if (vertex_size != header.m_vertex_size)
+            return std::nullopt;
+        if (buf_size != header.m_file_size)
+            return std::nullopt;
+        if (!::is_range_valid(header.m_units_offset, static_cast<uint64_t>(header.m_unit_count) * sizeof(CookedUnit), buf_size))
+            return std::nullopt;
+        if (!::is_range_valid(header.m_skeleton_offset, header.m_skeleton_size, buf_size))
+            return std::nullopt;
+
+        return header;
+    }
+
+    template <typename _Vertex>
+    bool parse_units(const uint8_t* const buf, const size_t buf_size, const CookedModelHeader& header, std::vector<dal::TRenderUnit<_Vertex>>& output) {
+        output.resize(header.m_unit_count);
+
+        for (uint32_t i = 0; i < header.m_unit_count; ++i) {
+            CookedUnit record;
+            std::memcpy(&record, buf + header.m_units_offset + i * sizeof(CookedUnit), sizeof(record));
+
+            const uint64_t vertices_size = static_cast<uint64_t>(record.m_vertex_count) * sizeof(_Vertex);
+            const uint64_t indices_size = static_cast<uint64_t>(record.m_index_count) * sizeof(uint32_t);
+            if (!::is_range_valid(record.m_vertices_offset, vertices_size, buf_size))
+                return false;
+            if (!::is_range_valid(record.m_indices_offset, indices_size, buf_size))
+                return false;
+            if (!::is_range_valid(record.m_albedo_map_offset, record.m_albedo_map_size, buf_size))
+                return false;
+            if (!::is_range_valid(record.m_lods_offset, static_cast<uint64_t>(record.m_lod_count) * sizeof(CookedLod), buf_size))
+                return false;
+
+            auto& unit = output[i];
+
+            unit.m_vertices.resize(record.m_vertex_count);
+            std::memcpy(unit.m_vertices.data(), buf + record.m_vertices_offset, vertices_size);
+            unit.m_indices.resize(record.m_index_count);
+            std::memcpy(unit.m_indices.data(), buf + record.m_indices_offset, indices_size);
+            if (!::are_indices_valid(unit.m_indices, record.m_vertex_count))
+                return false;
+
+            uint64_t lod_indices_offset = record.m_lods_offset + static_cast<uint64_t>(record.m_lod_count) * sizeof(CookedLod);
+            unit.m_lods.resize(record.m_lod_count);
+            for (uint32_t j = 0; j < record.m_lod_count; ++j) {
+                CookedLod lod_record;
+                std::memcpy(&lod_record, buf + record.m_lods_offset + j * sizeof(CookedLod), sizeof(lod_record));
+
+                const uint64_t lod_indices_size = static_cast<uint64_t>(lod_record.m_index_count) * sizeof(uint32_t);
+                if (!::is_range_valid(lod_indices_offset, lod_indices_size, buf_size))
+                    return false;
+
+                auto& lod = unit.m_lods[j];
+                lod.m_indices.resize(lod_record.m_index_count);
+                std::memcpy(lod.m_indices.data(), buf + lod_indices_offset, lod_indices_size);
+                if (!::are_indices_valid(lod.m_indices, record.m_vertex_count))
+                    return false;
+                lod.m_error = lod_record.m_error;
+
+                lod_indices_offset += lod_indices_size;
+            }
+
+            unit.m_material.m_albedo_map.assign(reinterpret_cast<const char*>(buf + record.m_albedo_map_offset), record.m_albedo_map_size);
+            unit.m_material.m_roughness = record.m_roughness;
+            unit.m_material.m_metallic = record.m_metallic;
+            unit.m_material.m_alpha_blending = 0 != record.m_alpha_blending;
+
+            unit.m_weight_center = ::make_vec3(record.m_weight_center);
+            unit.m_aabb_min = ::make_vec3(record.m_aabb_min);
+            unit.m_aabb_max = ::make_vec3(record.m_aabb_max);
+        }
+
+        return true;
+    }
+
+    bool parse_skeleton_and_animations(BinaryReader& reader, dal::ModelSkinned& output) {
+        output.m_skeleton.m_root_mat = reader.read_mat4();
+
+        const auto joint_count = reader.read<uint32_t>();
+        for (uint32_t i = 0; i < joint_count; ++i) {
+            dal::parser::SkelJoint src_joint;
+            src_joint.name_ = reader.read_str();
+            src_joint.parent_index_ = reader.read<int32_t>();
+            src_joint.offset_mat_ = reader.read_mat4();
+            src_joint.joint_type_ = static_cast<dal::JointType>(reader.read<int32_t>());
+            if (reader.is_failed())
+                return false;
+            if (src_joint.parent_index_ < -1 || src_joint.parent_index_ >= static_cast<int64_t>(joint_count))
+                return false;
+
+            const auto jid = output.m_skeleton.get_or_make_index_of(src_joint.name_);
+            output.m_skeleton.at(jid).set(src_joint);
+        }
+
+        // Duplicate names would leave parent indices pointing past the end of skeleton
+        if (output.m_skeleton.size() != static_cast<dal::jointID_t>(joint_count))
+            return false;
+
+        output.m_skeleton.update_parent_mats();
+
+        const auto anim_count = reader.read<uint32_t>();
+        for (uint32_t i = 0; i < anim_count; ++i) {
+            const auto name = reader.read_str();
+            const auto tick_per_sec = reader.read<float>();
+            const auto duration_in_tick = reader.read<float>();
+            const auto anim_joint_count = reader.read<uint32_t>();
+            if (reader.is_failed())
+                return false;
+
+            auto& anim = output.m_animations.emplace_back(name, tick_per_sec, duration_in_tick);
+
+            for (uint32_t j = 0; j < anim_joint_count; ++j) {
+                auto& data = anim.new_joint().m_data;
+                data.name_ = reader.read_str();
+
+                const auto translation_count = reader.read<uint32_t>();
+                for (uint32_t k = 0; k < translation_count && !reader.is_failed(); ++k) {
+                    const auto tick = reader.read<float>();
+                    data.translations_.emplace_back(tick, reader.read_vec3());
+                }
+
+                const auto rotation_count = reader.read<uint32_t>();
+                for (uint32_t k = 0; k < rotation_count && !reader.is_failed(); ++k) {
+                    const auto tick = reader.read<float>();
+                    data.rotations_.emplace_back(tick, reader.read_quat());
+                }
+
+                const auto scale_count = reader.read<uint32_t>();
+                for (uint32_t k = 0; k < scale_count && !reader.is_failed(); ++k) {
+                    const auto tick = reader.read<float>();
+                    data.scales_.emplace_back(tick, reader.read<float>());
+                }
+
+                if (reader.is_failed())
+                    return false;
+            }
+        }
+
+        return !reader.is_failed() && reader.is_end();
+    }
+
+}
+
+
+namespace dal {
+
+    std::vector<uint8_t> serialize_cooked_model(const ModelStatic& model) {
+        return ::serialize_model(model.m_units, ::CookedModelKind::static_model, nullptr);
+    }
+
+    std::vector<uint8_t> serialize_cooked_model(const ModelSkinned& model) {
+        return ::serialize_model(model.m_units, ::CookedModelKind::skinned_model, &model);
+    }
+
+    std::optional<ModelStatic> parse_cooked_model_static(const uint8_t* const buf, const size_t buf_size) {
+        const auto header = ::parse_header(buf, buf_size, ::CookedModelKind::static_model, sizeof(VertexStatic));
+        if (!header.has_value())
+            return std::nullopt;
+
+        ModelStatic output;
+        if (!::parse_units(buf, buf_size, *header, output.m_units))
+            return std::nullopt;
+
+        return output;
+    }
+
+    std::optional<ModelSkinned> parse_cooked_model_skinned(const uint8_t* const buf, const size_t buf_size) {
+        const auto header = ::parse_header(buf, buf_size, ::CookedModelKind::skinned_model, sizeof(VertexSkinned));
+        if (!header.has_value())
+            return std::nullopt;
+
+        ModelSkinned output;
+        if (!::parse_units(buf, buf_size, *header, output.m_units))
+            return std::nullopt;
+
+        ::BinaryReader reader{ buf + header->m_skeleton_offset, header->m_skeleton_size };
+        if (!::parse_skeleton_and_animations(reader, output))
+            return std::nullopt;
+
+        return output;
+    }
+
+}
@@ -56,6 +56,7 @@ namespace dal {
 
         result.m_material.m_roughness = 0.2;
         result.m_material.m_metallic = 1;
+        dal::calc_unit_bounds(result);
 
         return true;
     }
@@ -1,10 +1,73 @@
 #include "dal/util/task_thread.h"
 
 #include <atomic>
+#include <algorithm>
 
 #include <daltools/common/util.h>
 
 
+// Parallel jobs
+namespace {
+
+    class ParallelJobBatch {
+
+    private:
+        // Only touched while some job is not done, so caller still owns it
+        const std::vector<std::function<void()>>& m_jobs;
+        const size_t m_job_count;
+        std::atomic_size_t m_next_index = 0;
+        std::atomic_size_t m_done_count = 0;
+
+    public:
+        ParallelJobBatch(const std::vector<std::function<void()>>& jobs)
+            : m_jobs(jobs)
+            , m_job_count(jobs.size())
+        {
+
+        }
+
+        // Returns when there is no job left to pick, even if others are still working
+        void work_until_empty() {
+            while (true) {
+                const auto index = this->m_next_index.fetch_add(1);
+                if (index >= this->m_job_count)
+                    return;
+
+                this->m_jobs[index]();
+                this->m_done_count.fetch_add(1);
+            }
+        }
+
+        bool is_all_done() const {
+            return this->m_done_count.load() >= this->m_job_count;
+        }
+
+    };
+
+
+    class Task_ParallelJobs : public dal::IPriorityTask {
+
+    private:
+        std::shared_ptr<::ParallelJobBatch> m_batch;
+
+    public:
+        Task_ParallelJobs(const std::shared_ptr<::ParallelJobBatch>& batch)
+            : dal::IPriorityTask(dal::PriorityClass::most_wanted)
+            , m_batch(batch)
+        {
+
+        }
+
+        bool work() override {
+            this->m_batch->work_until_empty();
+            return true;
+        }
+
+    };
+
+}
+
+
 // IPriorityTask
 namespace dal {
 
@@ -95,6 +158,37 @@ namespace dal {
 }
 
 
+// TaskManager :: ParkedTasks
+namespace dal {
+
+    void TaskManager::ParkedTasks::push(HTask& t) {
+#if DAL_MULTITHREADING
+        std::unique_lock<std::mutex> lck{ this->m_mut };
+#endif
+
+        this->m_tasks.push_back(t);
+    }
+
+    void TaskManager::ParkedTasks::release_ready(TaskQueue& dst) {
+#if DAL_MULTITHREADING
+        std::unique_lock<std::mutex> lck{ this->m_mut };
+#endif
+
+        for (size_t i = 0; i < this->m_tasks.size();) {
+            if (this->m_tasks[i]->is_waiting()) {
+                ++i;
+                continue;
+            }
+
+            dst.push(this->m_tasks[i]);
+            this->m_tasks[i] = std::move(this->m_tasks.back());
+            this->m_tasks.pop_back();
+        }
+    }
+
+}
+
+
 // TaskManager :: TaskRegistry
 namespace dal {
 
@@ -140,6 +234,7 @@ namespace dal {
         size_t m_id;
         TaskQueue* m_wait_queue = nullptr;
         TaskQueue* m_done_queue = nullptr;
+        ParkedTasks* m_parked = nullptr;
         std::atomic_bool m_flag_exit;
 
     public:
@@ -147,10 +242,11 @@ namespace dal {
         Worker& operator=(const Worker&) = delete;
 
     public:
-        Worker(const size_t id, TaskQueue& inQ, TaskQueue& outQ)
+        Worker(const size_t id, TaskQueue& inQ, TaskQueue& outQ, ParkedTasks& parked)
             : m_id(id)
             , m_wait_queue(&inQ)
             , m_done_queue(&outQ)
+            , m_parked(&parked)
             , m_flag_exit(ATOMIC_VAR_INIT(false))
         {
 
@@ -160,20 +256,24 @@ namespace dal {
             this->m_id = other.m_id;
             this->m_wait_queue = other.m_wait_queue;
             this->m_done_queue = other.m_done_queue;
+            this->m_parked = other.m_parked;
             this->m_flag_exit.store(other.m_flag_exit.load());
 
             other.m_wait_queue = nullptr;
             other.m_done_queue = nullptr;
+            other.m_parked = nullptr;
         }
 
         Worker& operator=(Worker&& other) noexcept {
             this->m_id = other.m_id;
             this->m_wait_queue = other.m_wait_queue;
             this->m_done_queue = other.m_done_queue;
+            this->m_parked = other.m_parked;
             this->m_flag_exit.store(other.m_flag_exit.load());
 
             other.m_wait_queue = nullptr;
             other.m_done_queue = nullptr;
+            other.m_parked = nullptr;
 
             return *this;
         }
@@ -187,6 +287,7 @@ namespace dal {
 
                 current_task = this->m_wait_queue->pick_higher_priority(current_task);
                 if (!current_task) {
+                    this->m_parked->release_ready(*this->m_wait_queue);
                     dal::sleep_for(0.1);
                     continue;
                 }
@@ -195,6 +296,10 @@ namespace dal {
                     this->m_done_queue->push(current_task);
                     current_task = nullptr;
                 }
+                else if (current_task->is_waiting()) {
+                    this->m_parked->push(current_task);
+                    current_task = nullptr;
+                }
             }
         }
 
@@ -225,7 +330,7 @@ namespace dal {
         this->m_threads.reserve(thread_count);
 
         for (size_t i = 0; i < thread_count; ++i) {
-            this->m_workers.push_back(Worker{ i, this->m_wait_queue, this->m_done_queue });
+            this->m_workers.push_back(Worker{ i, this->m_wait_queue, this->m_done_queue, this->m_parked });
         }
 
         for (auto& worker : this->m_workers) {
@@ -236,6 +341,7 @@ namespace dal {
     }
 
     void TaskManager::update() {
+        this->m_parked.release_ready(this->m_wait_queue);
 
 #if DAL_MULTITHREADING
         auto task = this->m_done_queue.pop();
@@ -260,6 +366,10 @@ namespace dal {
 
             this->m_current_task = nullptr;
         }
+        else if (this->m_current_task->is_waiting()) {
+            this->m_parked.push(this->m_current_task);
+            this->m_current_task = nullptr;
+        }
 #endif
 
     }
@@ -284,4 +394,25 @@ namespace dal {
         this->m_wait_queue.push(task);
     }
 
+    void TaskManager::run_parallel(const std::vector<std::function<void()>>& jobs) {
+        if (jobs.empty())
+            return;
+
+        // Batch is shared because a worker may pick up its task after this function returned
+        const auto batch = std::make_shared<::ParallelJobBatch>(jobs);
+
+#if DAL_MULTITHREADING
+        const auto helper_count = std::min(this->m_workers.size(), jobs.size() - 1);
+        for (size_t i = 0; i < helper_count; ++i) {
+            this->order_task(std::make_shared<::Task_ParallelJobs>(batch), nullptr);
+        }
+#endif
+
+        batch->work_until_empty();
+
+        while (!batch->is_all_done()) {
+            std::this_thread::yield();
+        }
+    }
+
 }
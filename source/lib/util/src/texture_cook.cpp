@@ -0,0 +1,638 @@
+#include "dal/util/texture_cook.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "dal/util/logger.h"
+#include "dal/util/mipmap.h"
+
+
+// BC7
+namespace {
+
+    constexpr std::array<int32_t, 16> BC7_WEIGHTS_4 = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+
+    class BitWriter {
+
+    private:
+        uint8_t* m_dst;
+        uint32_t m_pos = 0;
+
+    public:
+        BitWriter(uint8_t* const dst, const size_t dst_size)
+            : m_dst(dst)
+        {
+            std::memset(dst, 0, dst_size);
+        }
+
+        // Least significant bit first
+        void write(const uint32_t value, const uint32_t bit_count) {
+            for (uint32_t i = 0; i < bit_count; ++i) {
+                if ((value >> i) & 1)
+                    this->m_dst[this->m_pos >> 3] |= static_cast<uint8_t>(1 << (this->m_pos & 7));
+                ++this->m_pos;
+            }
+        }
+
+        auto pos() const {
+            return this->m_pos;
+        }
+
+    };
+
+
+    struct Bc7Endpoint {
+        std::array<int32_t, 4> m_quantized{};
+        int32_t m_pbit = 0;
+
+        int32_t channel(const size_t index) const {
+            return (this->m_quantized[index] << 1) | this->m_pbit;
+        }
+    };
+
+    // P-bit is shared by all channels so the one reconstructing the colour more closely is chosen
+    Bc7Endpoint quantize_endpoint(const std::array<float, 4>& color) {
+        Bc7Endpoint output;
+        float best_error = std::numeric_limits<float>::max();
+
+        for (int32_t p = 0; p < 2; ++p) {
+            Bc7Endpoint candidate;
+            candidate.m_pbit = p;
+            float error = 0;
+
+            for (size_t c = 0; c < 4; ++c) {
+                const auto q = static_cast<int32_t>(std::lround((color[c] - p) * 0.5f));
+                candidate.m_quantized[c] = std::clamp<int32_t>(q, 0, 127);
+
+                const auto diff = static_cast<float>(candidate.channel(c)) - color[c];
+                error += diff * diff;
+            }
+
+            if (error < best_error) {
+                best_error = error;
+                output = candidate;
+            }
+        }
+
+        return output;
+    }
+
+    std::array<float, 4> find_principal_axis(const uint8_t (&texels)[16][4], const std::array<float, 4>& mean) {
+        float cov[4][4]{};
+
+        for (auto& t : texels) {
+            float d[4];
+            for (size_t i = 0; i < 4; ++i)
+                d[i] = t[i] - mean[i];
+
+            for (size_t i = 0; i < 4; ++i) {
+                for (size_t j = 0; j < 4; ++j) {
+                    cov[i][j] += d[i] * d[j];
+                }
+            }
+        }
+
+        // Row of the largest variance is never orthogonal to the principal axis, unlike a fixed guess
+        size_t start_row = 0;
+        for (size_t i = 1; i < 4; ++i) {
+            if (cov[i][i] > cov[start_row][start_row])
+                start_row = i;
+        }
+
+        std::array<float, 4> axis{ cov[start_row][0], cov[start_row][1], cov[start_row][2], cov[start_row][3] };
+
+        // Power iteration
+        for (int iter = 0; iter < 8; ++iter) {
+            std::array<float, 4> next{};
+            for (size_t i = 0; i < 4; ++i) {
+                for (size_t j = 0; j < 4; ++j) {
+                    next[i] += cov[i][j] * axis[j];
+                }
+            }
+
+            float max_abs = 0;
+            for (const auto x : next)
+                max_abs = std::max(max_abs, std::abs(x));
+            if (max_abs <= 0)
+                break;
+
+            for (size_t i = 0; i < 4; ++i)
+                axis[i] = next[i] / max_abs;
+        }
+
+        float length_sqr = 0;
+        for (const auto x : axis)
+            length_sqr += x * x;
+
+        if (length_sqr < 1e-12f)
+            return std::array<float, 4>{};
+
+        const auto length_inv = 1.f / std::sqrt(length_sqr);
+        for (auto& x : axis)
+            x *= length_inv;
+
+        return axis;
+    }
+
+    // Mode 6 only, which is single subset RGBA with 7 bit endpoints, p-bits and 4 bit indices.
+    // Not as good as full mode search but fast and far better than BC1/BC3 for most textures.
+    void encode_bc7_block(const uint8_t (&texels)[16][4], uint8_t* const dst) {
+        std::array<float, 4> mean{};
+        for (auto& t : texels) {
+            for (size_t c = 0; c < 4; ++c)
+                mean[c] += t[c];
+        }
+        for (auto& x : mean)
+            x /= 16.f;
+
+        const auto axis = ::find_principal_axis(texels, mean);
+
+        float min_t = 0, max_t = 0;
+        for (auto& t : texels) {
+            float proj = 0;
+            for (size_t c = 0; c < 4; ++c)
+                proj += (t[c] - mean[c]) * axis[c];
+
+            min_t = std::min(min_t, proj);
+            max_t = std::max(max_t, proj);
+        }
+
+        std::array<float, 4> color0, color1;
+        for (size_t c = 0; c < 4; ++c) {
+            color0[c] = std::clamp(mean[c] + axis[c] * min_t, 0.f, 255.f);
+            color1[c] = std::clamp(mean[c] + axis[c] * max_t, 0.f, 255.f);
+        }
+
+        auto ep0 = ::quantize_endpoint(color0);
+        auto ep1 = ::quantize_endpoint(color1);
+
+        int32_t palette[16][4];
+        for (size_t i = 0; i < 16; ++i) {
+            const auto w = ::BC7_WEIGHTS_4[i];
+            for (size_t c = 0; c < 4; ++c)
+                palette[i][c] = ((64 - w) * ep0.channel(c) + w * ep1.channel(c) + 32) >> 6;
+        }
+
+        std::array<uint32_t, 16> indices{};
+        for (size_t t = 0; t < 16; ++t) {
+            int32_t best_error = std::numeric_limits<int32_t>::max();
+
+            for (uint32_t i = 0; i < 16; ++i) {
+                int32_t error = 0;
+                for (size_t c = 0; c < 4; ++c) {
+                    const auto diff = palette[i][c] - texels[t][c];
+                    error += diff * diff;
+                }
+
+                if (error < best_error) {
+                    best_error = error;
+                    indices[t] = i;
+                }
+            }
+        }
+
+        // Index of the first texel is stored without its top bit so it must be zero
+        if (indices[0] & 8) {
+            std::swap(ep0, ep1);
+            for (auto& x : indices)
+                x = 15 - x;
+        }
+
+        BitWriter writer{ dst, 16 };
+        writer.write(1 << 6, 7);
+        for (size_t c = 0; c < 4; ++c) {
+            writer.write(ep0.m_quantized[c], 7);
+            writer.write(ep1.m_quantized[c], 7);
+        }
+        writer.write(ep0.m_pbit, 1);
+        writer.write(ep1.m_pbit, 1);
+        writer.write(indices[0], 3);
+        for (size_t i = 1; i < 16; ++i)
+            writer.write(indices[i], 4);
+
+        dalAssert(128 == writer.pos());
+    }
+
+}
+
+
+// ETC2
+namespace {
+
+    // ETC1 compatible modifier pairs. Negated pairs are the other two modifiers of each table.
+    constexpr int32_t ETC_MODIFIERS[8][2] = {
+        { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+    };
+
+    constexpr int32_t EAC_MODIFIERS[16][8] = {
+        { -3, -6, -9, -15, 2, 5, 8, 14 },
+        { -3, -7, -10, -13, 2, 6, 9, 12 },
+        { -2, -5, -8, -13, 1, 4, 7, 12 },
+        { -2, -4, -6, -13, 1, 3, 5, 12 },
+        { -3, -6, -8, -12, 2, 5, 7, 11 },
+        { -3, -7, -9, -11, 2, 6, 8, 10 },
+        { -4, -7, -8, -11, 3, 6, 7, 10 },
+        { -3, -5, -8, -11, 2, 4, 7, 10 },
+        { -2, -6, -8, -10, 1, 5, 7, 9 },
+        { -2, -5, -8, -10, 1, 4, 7, 9 },
+        { -2, -4, -8, -10, 1, 3, 7, 9 },
+        { -2, -5, -7, -10, 1, 4, 6, 9 },
+        { -3, -4, -7, -10, 2, 3, 6, 9 },
+        { -1, -2, -3, -10, 0, 1, 2, 9 },
+        { -4, -6, -8, -9, 3, 5, 7, 8 },
+        { -3, -5, -7, -9, 2, 4, 6, 8 },
+    };
+
+    // Table 13 has zero modifier at this index so constant alpha is stored exactly
+    constexpr uint32_t EAC_ZERO_TABLE = 13;
+    constexpr uint32_t EAC_ZERO_INDEX = 4;
+
+
+    void write_big_endian(const uint64_t value, uint8_t* const dst) {
+        for (size_t i = 0; i < 8; ++i)
+            dst[i] = static_cast<uint8_t>(value >> (56 - i * 8));
+    }
+
+    // ETC2 decoders read a differential block whose base plus delta overflows 5 bits as T, H or planar mode
+    // so the delta is clamped rather than letting the second colour land outside [0, 31].
+    int32_t clamp_etc_delta(const int32_t base, const int32_t other) {
+        return std::clamp(other - base, -4, 3);
+    }
+
+
+    struct EtcSubblock {
+        int32_t m_error = std::numeric_limits<int32_t>::max();
+        uint32_t m_table = 0;
+        std::array<uint32_t, 8> m_indices{};
+    };
+
+    EtcSubblock fit_etc_subblock(const uint8_t (&texels)[16][4], const std::array<size_t, 8>& members, const std::array<int32_t, 3>& base) {
+        EtcSubblock best;
+
+        for (uint32_t table = 0; table < 8; ++table) {
+            EtcSubblock candidate;
+            candidate.m_error = 0;
+            candidate.m_table = table;
+
+            for (size_t i = 0; i < 8; ++i) {
+                const auto& t = texels[members[i]];
+                int32_t best_error = std::numeric_limits<int32_t>::max();
+
+                for (uint32_t index = 0; index < 4; ++index) {
+                    const auto magnitude = ::ETC_MODIFIERS[table][index & 1];
+                    const auto modifier = (index & 2) ? -magnitude : magnitude;
+
+                    int32_t error = 0;
+                    for (size_t c = 0; c < 3; ++c) {
+                        const auto diff = std::clamp(base[c] + modifier, 0, 255) - t[c];
+                        error += diff * diff;
+                    }
+
+                    if (error < best_error) {
+                        best_error = error;
+                        candidate.m_indices[i] = index;
+                    }
+                }
+
+                candidate.m_error += best_error;
+            }
+
+            if (candidate.m_error < best.m_error)
+                best = candidate;
+        }
+
+        return best;
+    }
+
+    // Individual and differential modes only, which is what ETC1 has. T, H and planar modes are left out.
+    uint64_t encode_etc2_rgb(const uint8_t (&texels)[16][4]) {
+        uint64_t best_block = 0;
+        int32_t best_error = std::numeric_limits<int32_t>::max();
+
+        for (uint32_t flip = 0; flip < 2; ++flip) {
+            // Texel (x, y) is at texels[y * 4 + x]. Flip splits the block into top and bottom halves instead of left and right.
+            std::array<std::array<size_t, 8>, 2> members;
+            std::array<size_t, 2> member_counts{};
+            std::array<std::array<float, 3>, 2> means{};
+
+            for (size_t y = 0; y < 4; ++y) {
+                for (size_t x = 0; x < 4; ++x) {
+                    const size_t sub = flip ? (y >> 1) : (x >> 1);
+                    const size_t texel = y * 4 + x;
+                    members[sub][member_counts[sub]++] = texel;
+                    for (size_t c = 0; c < 3; ++c)
+                        means[sub][c] += texels[texel][c] / 8.f;
+                }
+            }
+
+            for (uint32_t diff = 0; diff < 2; ++diff) {
+                std::array<std::array<int32_t, 3>, 2> quantized;
+                std::array<std::array<int32_t, 3>, 2> bases;
+
+                for (size_t c = 0; c < 3; ++c) {
+                    if (diff) {
+                        const auto q0 = static_cast<int32_t>(std::lround(means[0][c] * 31.f / 255.f));
+                        const auto q1 = static_cast<int32_t>(std::lround(means[1][c] * 31.f / 255.f));
+                        quantized[0][c] = q0;
+                        quantized[1][c] = q0 + ::clamp_etc_delta(q0, q1);
+                        for (size_t s = 0; s < 2; ++s)
+                            bases[s][c] = (quantized[s][c] << 3) | (quantized[s][c] >> 2);
+                    }
+                    else {
+                        for (size_t s = 0; s < 2; ++s) {
+                            quantized[s][c] = static_cast<int32_t>(std::lround(means[s][c] * 15.f / 255.f));
+                            bases[s][c] = quantized[s][c] * 17;
+                        }
+                    }
+                }
+
+                const auto sub0 = ::fit_etc_subblock(texels, members[0], bases[0]);
+                const auto sub1 = ::fit_etc_subblock(texels, members[1], bases[1]);
+                const auto error = sub0.m_error + sub1.m_error;
+                if (error >= best_error)
+                    continue;
+
+                uint64_t block = 0;
+                for (size_t c = 0; c < 3; ++c) {
+                    const auto shift = 56 - c * 8;
+                    if (diff) {
+                        const auto delta = static_cast<uint64_t>(quantized[1][c] - quantized[0][c]) & 7;
+                        block |= (static_cast<uint64_t>(quantized[0][c]) << 3 | delta) << shift;
+                    }
+                    else {
+                        block |= (static_cast<uint64_t>(quantized[0][c]) << 4 | quantized[1][c]) << shift;
+                    }
+                }
+                block |= static_cast<uint64_t>(sub0.m_table) << 37;
+                block |= static_cast<uint64_t>(sub1.m_table) << 34;
+                block |= static_cast<uint64_t>(diff) << 33;
+                block |= static_cast<uint64_t>(flip) << 32;
+
+                // Pixel indices are column major, most significant bits in the upper half
+                for (size_t s = 0; s < 2; ++s) {
+                    const auto& sub = s ? sub1 : sub0;
+                    for (size_t i = 0; i < 8; ++i) {
+                        const auto texel = members[s][i];
+                        const auto p = (texel % 4) * 4 + texel / 4;
+                        block |= static_cast<uint64_t>(sub.m_indices[i] >> 1) << (16 + p);
+                        block |= static_cast<uint64_t>(sub.m_indices[i] & 1) << p;
+                    }
+                }
+
+                best_error = error;
+                best_block = block;
+            }
+        }
+
+        return best_block;
+    }
+
+    uint64_t encode_eac_alpha(const uint8_t (&texels)[16][4]) {
+        int32_t min_alpha = 255, max_alpha = 0;
+        for (auto& t : texels) {
+            min_alpha = std::min<int32_t>(min_alpha, t[3]);
+            max_alpha = std::max<int32_t>(max_alpha, t[3]);
+        }
+
+        uint64_t best_block = 0;
+
+        if (min_alpha == max_alpha) {
+            best_block = static_cast<uint64_t>(min_alpha) << 56 | uint64_t{ 1 } << 52 | uint64_t{ ::EAC_ZERO_TABLE } << 48;
+            for (size_t p = 0; p < 16; ++p)
+                best_block |= uint64_t{ ::EAC_ZERO_INDEX } << (45 - p * 3);
+            return best_block;
+        }
+
+        int32_t best_error = std::numeric_limits<int32_t>::max();
+
+        for (uint32_t table = 0; table < 16; ++table) {
+            const auto& modifiers = ::EAC_MODIFIERS[table];
+            const auto mod_min = modifiers[3];
+            const auto mod_max = modifiers[7];
+            const auto guess = (max_alpha - min_alpha + (mod_max - mod_min) / 2) / (mod_max - mod_min);
+
+            for (int32_t multiplier = std::max(1, guess - 1); multiplier <= std::min(15, guess + 1); ++multiplier) {
+                const auto mid = (min_alpha + max_alpha) / 2.f;
+                const auto base = std::clamp<int32_t>(std::lround(mid - (mod_min + mod_max) * multiplier / 2.f), 0, 255);
+
+                uint64_t block = static_cast<uint64_t>(base) << 56 | static_cast<uint64_t>(multiplier) << 52 | uint64_t{ table } << 48;
+                int32_t error = 0;
+
+                for (size_t y = 0; y < 4; ++y) {
+                    for (size_t x = 0; x < 4; ++x) {
+                        const int32_t alpha = texels[y * 4 + x][3];
+                        int32_t texel_error = std::numeric_limits<int32_t>::max();
+                        uint32_t texel_index = 0;
+
+                        for (uint32_t i = 0; i < 8; ++i) {
+                            const auto diff = std::clamp(base + modifiers[i] * multiplier, 0, 255) - alpha;
+                            if (diff * diff < texel_error) {
+                                texel_error = diff * diff;
+                                texel_index = i;
+                            }
+                        }
+
+                        error += texel_error;
+                        block |= static_cast<uint64_t>(texel_index) << (45 - (x * 4 + y) * 3);
+                    }
+                }
+
+                if (error < best_error) {
+                    best_error = error;
+                    best_block = block;
+                }
+            }
+        }
+
+        return best_block;
+    }
+
+    // EAC alpha block followed by ETC2 colour block, each a big endian 64 bit word
+    void encode_etc2_rgba8_block(const uint8_t (&texels)[16][4], uint8_t* const dst) {
+        ::write_big_endian(::encode_eac_alpha(texels), dst);
+        ::write_big_endian(::encode_etc2_rgb(texels), dst + 8);
+    }
+
+}
+
+
+// Block compression
+namespace {
+
+    using block_encoder_t = void (*)(const uint8_t (&texels)[16][4], uint8_t* const dst);
+
+
+    // Every supported format has 16 bytes per 4x4 block. Texels outside of the image repeat the edge.
+    std::vector<uint8_t> encode_blocks(const uint8_t* const src, const uint32_t width, const uint32_t height, const block_encoder_t block_encoder) {
+        const size_t blocks_x = (width + 3) / 4;
+        const size_t blocks_y = (height + 3) / 4;
+        std::vector<uint8_t> output(blocks_x * blocks_y * 16);
+
+        uint8_t texels[16][4];
+
+        for (size_t by = 0; by < blocks_y; ++by) {
+            for (size_t bx = 0; bx < blocks_x; ++bx) {
+                for (size_t ty = 0; ty < 4; ++ty) {
+                    const auto y = std::min<size_t>(by * 4 + ty, height - 1);
+
+                    for (size_t tx = 0; tx < 4; ++tx) {
+                        const auto x = std::min<size_t>(bx * 4 + tx, width - 1);
+                        std::memcpy(texels[ty * 4 + tx], src + (y * width + x) * 4, 4);
+                    }
+                }
+
+                block_encoder(texels, output.data() + (by * blocks_x + bx) * 16);
+            }
+        }
+
+        return output;
+    }
+
+    block_encoder_t select_block_encoder(const dal::ImageFormat format) {
+        switch (format) {
+            case dal::ImageFormat::bc7_srgb:
+                return ::encode_bc7_block;
+            case dal::ImageFormat::etc2_rgba8_srgb:
+                return ::encode_etc2_rgba8_block;
+            default:
+                return nullptr;
+        }
+    }
+
+}
+
+
+// Cooked texture file
+namespace {
+
+    constexpr uint32_t COOKED_TEXTURE_MAGIC = 0x58455444;  // "DTEX"
+
+
+    struct CookedTextureHeader {
+        uint32_t m_magic = 0;
+        uint32_t m_version = 0;
+        uint32_t m_format = 0;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+        uint32_t m_mip_levels = 0;
+        uint64_t m_data_size = 0;
+    };
+
+
+    std::optional<CookedTextureHeader> parse_cooked_header(const uint8_t* const buf, const size_t buf_size) {
+        if (buf_size < sizeof(::CookedTextureHeader))
+            return std::nullopt;
+
+        ::CookedTextureHeader header;
+        std::memcpy(&header, buf, sizeof(::CookedTextureHeader));
+
+        if (::COOKED_TEXTURE_MAGIC != header.m_magic)
+            return std::nullopt;
+        if (dal::TEXTURE_COOK_VERSION != header.m_version)
+            return std::nullopt;
+        if (header.m_format > static_cast<uint32_t>(dal::ImageFormat::astc_4x4_srgb))
+            return std::nullopt;
+        if (0 == header.m_width || 0 == header.m_height)
+            return std::nullopt;
+        if (0 == header.m_mip_levels || header.m_mip_levels > dal::calc_mip_levels(header.m_width, header.m_height))
+            return std::nullopt;
+
+        const auto format = static_cast<dal::ImageFormat>(header.m_format);
+
+        size_t expected_size = 0;
+        for (uint32_t i = 0; i < header.m_mip_levels; ++i) {
+            const auto level_width = std::max<uint32_t>(1, header.m_width >> i);
+            const auto level_height = std::max<uint32_t>(1, header.m_height >> i);
+            expected_size += dal::calc_image_data_size(format, level_width, level_height);
+        }
+
+        if (header.m_data_size != expected_size || buf_size - sizeof(::CookedTextureHeader) != expected_size)
+            return std::nullopt;
+
+        return header;
+    }
+
+}
+
+
+namespace dal {
+
+    bool can_cook_to(const ImageFormat format) {
+        return nullptr != ::select_block_encoder(format);
+    }
+
+    std::optional<ImageData> cook_texture(const ImageData& src, const ImageFormat target_format) {
+        if (ImageFormat::r8g8b8a8_srgb != src.format() || 1 != src.mip_levels()) {
+            dalError("Only single level r8g8b8a8_srgb image can be cooked");
+            return std::nullopt;
+        }
+        if (!dal::can_cook_to(target_format)) {
+            dalError(fmt::format("Cannot cook texture into format: {}", static_cast<int>(target_format)).c_str());
+            return std::nullopt;
+        }
+
+        const auto block_encoder = ::select_block_encoder(target_format);
+        const auto chain = dal::build_mip_chain(src);
+
+        std::vector<uint8_t> output;
+        for (uint32_t i = 0; i < chain.mip_levels(); ++i) {
+            const auto encoded = ::encode_blocks(chain.data() + chain.mip_offset(i), chain.mip_width(i), chain.mip_height(i), block_encoder);
+            output.insert(output.end(), encoded.begin(), encoded.end());
+        }
+
+        return ImageData{ std::move(output), src.width(), src.height(), chain.mip_levels(), target_format };
+    }
+
+    std::vector<uint8_t> serialize_cooked_texture(const ImageData& image) {
+        ::CookedTextureHeader header;
+        header.m_magic = ::COOKED_TEXTURE_MAGIC;
+        header.m_version = dal::TEXTURE_COOK_VERSION;
+        header.m_format = static_cast<uint32_t>(image.format());
+        header.m_width = image.width();
+        header.m_height = image.height();
+        header.m_mip_levels = image.mip_levels();
+        header.m_data_size = image.data_size();
+
+        std::vector<uint8_t> output(sizeof(::CookedTextureHeader) + image.data_size());
+        std::memcpy(output.data(), &header, sizeof(::CookedTextureHeader));
+        std::memcpy(output.data() + sizeof(::CookedTextureHeader), image.data(), image.data_size());
+
+        return output;
+    }
+
+    std::optional<ImageData> parse_cooked_texture(const uint8_t* const buf, const size_t buf_size) {
+        const auto header = ::parse_cooked_header(buf, buf_size);
+        if (!header.has_value())
+            return std::nullopt;
+
+        std::vector<uint8_t> data(buf + sizeof(::CookedTextureHeader), buf + buf_size);
+        return ImageData{ std::move(data), header->m_width, header->m_height, header->m_mip_levels, static_cast<ImageFormat>(header->m_format) };
+    }
+
+    std::optional<ImageData> parse_cooked_texture(const std::shared_ptr<const uint8_t>& file_storage, const size_t file_size) {
+        const auto header = ::parse_cooked_header(file_storage.get(), file_size);
+        if (!header.has_value())
+            return std::nullopt;
+
+        // Pixels stay where they were read, right after the header
+        ImageData output;
+        output.set_shared(
+            std::shared_ptr<const uint8_t>(file_storage, file_storage.get() + sizeof(::CookedTextureHeader)),
+            header->m_data_size,
+            header->m_width,
+            header->m_height,
+            header->m_mip_levels,
+            static_cast<ImageFormat>(header->m_format)
+        );
+
+        return output;
+    }
+
+}
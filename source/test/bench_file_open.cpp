@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <filesystem>
+
+#include "dal/util/filesystem_std.h"
+
+
+// Opens asset files many times through AssetManagerSTD, with its asset folder cached and with the folder searched
+// again for every call, like every call did before DomainRootCache.
+// Usage: dal_bench_file_open [open count]
+namespace {
+
+    namespace fs = std::filesystem;
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int FILE_COUNT = 64;
+
+
+    // Asset folder a few levels above working directory, like when running out of a build folder
+    fs::path make_sandbox() {
+        const auto root = fs::temp_directory_path() / "dal_bench_file_open";
+        fs::remove_all(root);
+
+        const auto asset_dir = root / "asset" / "bench";
+        fs::create_directories(asset_dir);
+        for (int i = 0; i < FILE_COUNT; ++i) {
+            std::ofstream file{ asset_dir / ("file_" + std::to_string(i) + ".txt") };
+            file << "file " << i << '\n';
+        }
+
+        const auto work_dir = root / "build" / "source" / "app";
+        fs::create_directories(work_dir);
+        for (int i = 0; i < 16; ++i)
+            std::ofstream{ work_dir / ("sibling_" + std::to_string(i)) };
+
+        return root;
+    }
+
+    double measure_ms(dal::AssetManagerSTD& asset_mgr, const int open_count, const bool refresh_each_time) {
+        const auto start = Clock::now();
+
+        for (int i = 0; i < open_count; ++i) {
+            if (refresh_each_time)
+                asset_mgr.refresh();
+
+            const dal::ResPath path{ "_asset/bench/file_" + std::to_string(i % FILE_COUNT) + ".txt" };
+            if (!asset_mgr.open(path)) {
+                std::fprintf(stderr, "Failed to open %s\n", path.make_str().c_str());
+                std::exit(1);
+            }
+        }
+
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        return elapsed.count();
+    }
+
+}
+
+
+int main(int argc, char** argv) {
+    const int open_count = argc > 1 ? std::atoi(argv[1]) : 10000;
+
+    const auto root = ::make_sandbox();
+    fs::current_path(root / "build" / "source" / "app");
+
+    dal::AssetManagerSTD asset_mgr;
+    ::measure_ms(asset_mgr, FILE_COUNT, false);  // Warm up file system caches
+
+    const auto searching_ms = ::measure_ms(asset_mgr, open_count, true);
+    const auto cached_ms = ::measure_ms(asset_mgr, open_count, false);
+
+    std::printf("%d open() calls\n", open_count);
+    std::printf("  asset folder searched every call : %8.2f ms (%.2f us per call)\n", searching_ms, searching_ms * 1000 / open_count);
+    std::printf("  asset folder cached              : %8.2f ms (%.2f us per call)\n", cached_ms, cached_ms * 1000 / open_count);
+
+    fs::current_path(fs::temp_directory_path());
+    fs::remove_all(root);
+    return 0;
+}
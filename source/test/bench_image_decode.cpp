@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <stb_image.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include "dal/util/image_parser.h"
+
+
+// Decodes a batch of large PNGs into a staging-like buffer, through the copying path parse_image_stb used to have
+// and through the current one which keeps stb's buffer.
+// Usage: dal_bench_image_decode [image count] [image size] [rounds]
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+
+    void append_png(void* context, void* data, int size) {
+        auto& output = *reinterpret_cast<std::vector<uint8_t>*>(context);
+        const auto ptr = reinterpret_cast<const uint8_t*>(data);
+        output.insert(output.end(), ptr, ptr + size);
+    }
+
+    // Gradients with noise so that it compresses about as well as a real texture
+    std::vector<uint8_t> make_png(const int size, const unsigned seed) {
+        std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+        std::srand(seed);
+
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                const auto p = pixels.data() + (static_cast<size_t>(y) * size + x) * 4;
+                const auto noise = std::rand() % 16;
+                p[0] = static_cast<uint8_t>((x * 255 / size + noise) & 0xFF);
+                p[1] = static_cast<uint8_t>((y * 255 / size + noise) & 0xFF);
+                p[2] = static_cast<uint8_t>(((x ^ y) + seed * 37) & 0xFF);
+                p[3] = 255;
+            }
+        }
+
+        std::vector<uint8_t> output;
+        stbi_write_png_to_func(::append_png, &output, size, size, 4, pixels.data(), size * 4);
+        return output;
+    }
+
+    // What parse_image_stb did before: copy out of stb's buffer into ImageData, then free stb's buffer
+    bool decode_copying(const std::vector<uint8_t>& png, std::vector<uint8_t>& staging) {
+        int width, height, channels;
+        const auto pixels = stbi_load_from_memory(png.data(), static_cast<int>(png.size()), &width, &height, &channels, STBI_rgb_alpha);
+        if (nullptr == pixels)
+            return false;
+
+        const dal::ImageData image{ pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height), 4, dal::ImageFormat::r8g8b8a8_srgb };
+        stbi_image_free(pixels);
+
+        std::memcpy(staging.data(), image.data(), image.data_size());
+        return true;
+    }
+
+    bool decode_sharing(const std::vector<uint8_t>& png, std::vector<uint8_t>& staging) {
+        const auto image = dal::parse_image_stb(png.data(), png.size());
+        if (!image.has_value())
+            return false;
+
+        std::memcpy(staging.data(), image->data(), image->data_size());
+        return true;
+    }
+
+    template <typename _Func>
+    double measure_best_ms(const std::vector<std::vector<uint8_t>>& pngs, std::vector<uint8_t>& staging, const int rounds, _Func func) {
+        double best = 0;
+
+        for (int i = 0; i < rounds; ++i) {
+            const auto start = Clock::now();
+            for (const auto& png : pngs) {
+                if (!func(png, staging)) {
+                    std::fprintf(stderr, "Failed to decode PNG\n");
+                    std::exit(1);
+                }
+            }
+            const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+
+            if (0 == i || elapsed.count() < best)
+                best = elapsed.count();
+        }
+
+        return best;
+    }
+
+}
+
+
+int main(int argc, char** argv) {
+    const int image_count = argc > 1 ? std::atoi(argv[1]) : 8;
+    const int image_size = argc > 2 ? std::atoi(argv[2]) : 2048;
+    const int rounds = argc > 3 ? std::atoi(argv[3]) : 3;
+
+    std::vector<std::vector<uint8_t>> pngs;
+    size_t png_bytes = 0;
+    for (int i = 0; i < image_count; ++i) {
+        pngs.push_back(::make_png(image_size, static_cast<unsigned>(i + 1)));
+        png_bytes += pngs.back().size();
+    }
+
+    const auto pixel_bytes = static_cast<size_t>(image_size) * image_size * 4;
+    std::vector<uint8_t> staging(pixel_bytes);
+
+    std::printf("%d PNGs of %dx%d, %.1f MB encoded, %.1f MB decoded, best of %d rounds\n",
+        image_count, image_size, image_size,
+        static_cast<double>(png_bytes) / (1024.0 * 1024.0),
+        static_cast<double>(pixel_bytes * image_count) / (1024.0 * 1024.0),
+        rounds
+    );
+
+    const auto copying_ms = ::measure_best_ms(pngs, staging, rounds, ::decode_copying);
+    const auto sharing_ms = ::measure_best_ms(pngs, staging, rounds, ::decode_sharing);
+
+    std::printf("  copy out of stb buffer : %8.2f ms (%.2f ms per image)\n", copying_ms, copying_ms / image_count);
+    std::printf("  share stb buffer       : %8.2f ms (%.2f ms per image)\n", sharing_ms, sharing_ms / image_count);
+
+    return 0;
+}
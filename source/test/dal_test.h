@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdio>
+
+
+// assert() is gone in release builds, so failures are counted and reported by return value of main
+namespace dal::test {
+
+    inline int& failure_count() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void check(const bool condition, const char* const expr, const char* const file, const int line) {
+        if (condition)
+            return;
+
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+        ++failure_count();
+    }
+
+    inline int report(const char* const test_name) {
+        if (0 == failure_count())
+            std::printf("%s: passed\n", test_name);
+        else
+            std::fprintf(stderr, "%s: %d check(s) failed\n", test_name, failure_count());
+
+        return 0 == failure_count() ? 0 : 1;
+    }
+
+}
+
+
+#define DAL_CHECK(expr) ::dal::test::check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
@@ -0,0 +1,90 @@
+#include "d_indirect_draw.h"
+
+#include "dal_test.h"
+
+
+namespace {
+
+    void test_batches() {
+        dal::IndirectDrawBuilder builder;
+
+        builder.begin_batch();
+        builder.push(36, 0, 0);
+        builder.push(12, 36, 24);
+        const auto first = builder.end_batch();
+
+        DAL_CHECK(0 == first.m_first_cmd);
+        DAL_CHECK(2 == first.m_cmd_count);
+
+        // Nothing pushed in between still gives a well-formed empty batch
+        builder.begin_batch();
+        const auto empty = builder.end_batch();
+        DAL_CHECK(empty.is_empty());
+        DAL_CHECK(2 == empty.m_first_cmd);
+
+        builder.begin_batch();
+        builder.push(6, 48, -4);
+        const auto second = builder.end_batch();
+
+        DAL_CHECK(2 == second.m_first_cmd);
+        DAL_CHECK(1 == second.m_cmd_count);
+        DAL_CHECK(!second.is_empty());
+
+        const auto& cmds = builder.commands();
+        DAL_CHECK(3 == cmds.size());
+        DAL_CHECK(3 * sizeof(dal::DrawIndexedCmd) == builder.data_size());
+
+        DAL_CHECK(12 == cmds[1].m_index_count);
+        DAL_CHECK(1 == cmds[1].m_instance_count);
+        DAL_CHECK(36 == cmds[1].m_first_index);
+        DAL_CHECK(24 == cmds[1].m_vertex_offset);
+        DAL_CHECK(0 == cmds[1].m_first_instance);
+        DAL_CHECK(-4 == cmds[2].m_vertex_offset);
+    }
+
+    void test_end_without_begin() {
+        dal::IndirectDrawBuilder builder;
+
+        // Commands pushed since last end_batch() belong to the next batch
+        builder.push(3, 0, 0);
+        builder.push(3, 3, 0);
+        const auto first = builder.end_batch();
+        DAL_CHECK(0 == first.m_first_cmd);
+        DAL_CHECK(2 == first.m_cmd_count);
+
+        builder.push(3, 6, 0);
+        const auto second = builder.end_batch();
+        DAL_CHECK(2 == second.m_first_cmd);
+        DAL_CHECK(1 == second.m_cmd_count);
+    }
+
+    void test_clear() {
+        dal::IndirectDrawBuilder builder;
+
+        builder.begin_batch();
+        builder.push(36, 0, 0);
+        builder.push(36, 36, 0);
+        builder.end_batch();
+
+        builder.clear();
+        DAL_CHECK(builder.commands().empty());
+        DAL_CHECK(0 == builder.data_size());
+
+        // Batch offsets start over from zero after clear
+        builder.begin_batch();
+        builder.push(6, 0, 0);
+        const auto batch = builder.end_batch();
+        DAL_CHECK(0 == batch.m_first_cmd);
+        DAL_CHECK(1 == batch.m_cmd_count);
+    }
+
+}
+
+
+int main() {
+    ::test_batches();
+    ::test_end_without_begin();
+    ::test_clear();
+
+    return dal::test::report("indirect_draw");
+}
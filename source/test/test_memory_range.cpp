@@ -0,0 +1,107 @@
+#include "d_memory_range.h"
+
+#include "dal_test.h"
+
+
+namespace {
+
+    void test_alignment() {
+        dal::FreeRangeList ranges;
+        ranges.init(1024);
+
+        const auto a = ranges.allocate(10, 1);
+        DAL_CHECK(a.has_value() && 0 == *a);
+
+        // Padding [10, 64) stays free in front of the aligned allocation
+        const auto b = ranges.allocate(100, 64);
+        DAL_CHECK(b.has_value() && 64 == *b);
+        DAL_CHECK(2 == ranges.free_range_count());
+
+        // First-fit reuses the padding when it is big enough
+        const auto c = ranges.allocate(16, 16);
+        DAL_CHECK(c.has_value() && 16 == *c);
+
+        DAL_CHECK(!ranges.allocate(2048, 1).has_value());
+        DAL_CHECK(3 == ranges.alloc_count());
+        DAL_CHECK(126 == ranges.used());
+
+        ranges.free(*a, 10);
+        ranges.free(*b, 100);
+        ranges.free(*c, 16);
+    }
+
+    void test_merging() {
+        dal::FreeRangeList ranges;
+        ranges.init(300);
+
+        const auto a = ranges.allocate(100, 1);
+        const auto b = ranges.allocate(100, 1);
+        const auto c = ranges.allocate(100, 1);
+        DAL_CHECK(a.has_value() && b.has_value() && c.has_value());
+        DAL_CHECK(0 == ranges.free_range_count());
+        DAL_CHECK(0 == ranges.largest_free_range());
+
+        ranges.free(*a, 100);
+        ranges.free(*c, 100);
+        DAL_CHECK(2 == ranges.free_range_count());
+        DAL_CHECK(100 == ranges.largest_free_range());
+
+        // Freeing the middle one joins both neighbours into a single range
+        ranges.free(*b, 100);
+        DAL_CHECK(1 == ranges.free_range_count());
+        DAL_CHECK(300 == ranges.largest_free_range());
+        DAL_CHECK(0 == ranges.alloc_count());
+        DAL_CHECK(0 == ranges.used());
+
+        const auto whole = ranges.allocate(300, 1);
+        DAL_CHECK(whole.has_value() && 0 == *whole);
+        ranges.free(*whole, 300);
+    }
+
+    void test_stats() {
+        dal::FreeRangeList shared;
+        shared.init(1000);
+        const auto a = shared.allocate(100, 1);
+        const auto b = shared.allocate(200, 1);
+        shared.free(*a, 100);
+
+        dal::FreeRangeList dedicated;
+        dedicated.init(500);
+        const auto c = dedicated.allocate(500, 1);
+
+        dal::MemoryAllocStats stats;
+        stats.add_block(shared, false);
+        stats.add_block(dedicated, true);
+
+        DAL_CHECK(2 == stats.m_block_count);
+        DAL_CHECK(1 == stats.m_dedicated_block_count);
+        DAL_CHECK(2 == stats.m_allocation_count);
+        DAL_CHECK(2 == stats.m_free_range_count);
+        DAL_CHECK(1500 == stats.m_bytes_reserved);
+        DAL_CHECK(700 == stats.m_bytes_used);
+        DAL_CHECK(700 == stats.m_largest_free_range);
+
+        dal::MemoryAllocStats total;
+        total.add(stats);
+        total.add(stats);
+        DAL_CHECK(4 == total.m_block_count);
+        DAL_CHECK(1400 == total.m_bytes_used);
+        DAL_CHECK(700 == total.m_largest_free_range);
+
+        // 800 free bytes, 700 of which are contiguous
+        DAL_CHECK(stats.fragmentation() > 0.12 && stats.fragmentation() < 0.13);
+
+        shared.free(*b, 200);
+        dedicated.free(*c, 500);
+    }
+
+}
+
+
+int main() {
+    ::test_alignment();
+    ::test_merging();
+    ::test_stats();
+
+    return dal::test::report("memory_range");
+}
@@ -0,0 +1,144 @@
+#include "dal/util/mesh_simplify.h"
+
+#include <cmath>
+#include <set>
+#include <tuple>
+
+#include "dal_test.h"
+
+
+namespace {
+
+    constexpr uint32_t GRID_SIZE = 24;
+    // Column where left and right half have their own vertices with different UVs, like a UV chart boundary
+    constexpr uint32_t SEAM_COLUMN = GRID_SIZE / 2;
+
+
+    using PosKey = std::tuple<float, float, float>;
+
+    PosKey make_key(const glm::vec3& p) {
+        return PosKey{ p.x, p.y, p.z };
+    }
+
+
+    // Gently curved grid so that collapses have small but non-zero error
+    dal::RenderUnitStatic make_grid_unit() {
+        dal::RenderUnitStatic unit;
+
+        const auto add_vertex = [&unit](const uint32_t x, const uint32_t y, const float u_offset) {
+            const auto fx = static_cast<float>(x) / GRID_SIZE;
+            const auto fy = static_cast<float>(y) / GRID_SIZE;
+
+            auto& v = unit.m_vertices.emplace_back();
+            v.m_pos = glm::vec3{ fx, fy, 0.02f * std::sin(fx * 3.f) * std::cos(fy * 3.f) };
+            v.m_normal = glm::vec3{ 0, 0, 1 };
+            v.m_uv_coord = glm::vec2{ fx + u_offset, fy };
+            return static_cast<uint32_t>(unit.m_vertices.size() - 1);
+        };
+
+        // Vertices on seam column exist twice, once for each half
+        std::vector<uint32_t> left((GRID_SIZE + 1) * (GRID_SIZE + 1));
+        std::vector<uint32_t> right((GRID_SIZE + 1) * (GRID_SIZE + 1));
+
+        for (uint32_t y = 0; y <= GRID_SIZE; ++y) {
+            for (uint32_t x = 0; x <= GRID_SIZE; ++x) {
+                const auto i = y * (GRID_SIZE + 1) + x;
+
+                if (x <= SEAM_COLUMN)
+                    left[i] = add_vertex(x, y, 0);
+                if (x >= SEAM_COLUMN)
+                    right[i] = add_vertex(x, y, 0.5f);
+            }
+        }
+
+        for (uint32_t y = 0; y < GRID_SIZE; ++y) {
+            for (uint32_t x = 0; x < GRID_SIZE; ++x) {
+                const auto& ids = x < SEAM_COLUMN ? left : right;
+                const auto i00 = ids[y * (GRID_SIZE + 1) + x];
+                const auto i10 = ids[y * (GRID_SIZE + 1) + x + 1];
+                const auto i01 = ids[(y + 1) * (GRID_SIZE + 1) + x];
+                const auto i11 = ids[(y + 1) * (GRID_SIZE + 1) + x + 1];
+
+                unit.m_indices.insert(unit.m_indices.end(), { i00, i10, i11, i00, i11, i01 });
+            }
+        }
+
+        dal::calc_unit_bounds(unit);
+        return unit;
+    }
+
+    bool is_border_or_seam(const glm::vec3& p) {
+        const auto x = static_cast<uint32_t>(std::lround(p.x * GRID_SIZE));
+        const auto y = static_cast<uint32_t>(std::lround(p.y * GRID_SIZE));
+        return 0 == x || 0 == y || GRID_SIZE == x || GRID_SIZE == y || SEAM_COLUMN == x;
+    }
+
+    void check_indices(const dal::RenderUnitStatic& unit, const std::vector<uint32_t>& indices) {
+        DAL_CHECK(0 == indices.size() % 3);
+
+        std::set<PosKey> used_positions;
+        for (const auto index : indices) {
+            DAL_CHECK(index < unit.m_vertices.size());
+            if (index < unit.m_vertices.size())
+                used_positions.insert(::make_key(unit.m_vertices[index].m_pos));
+        }
+
+        size_t missing = 0;
+        for (const auto& v : unit.m_vertices) {
+            if (::is_border_or_seam(v.m_pos) && 0 == used_positions.count(::make_key(v.m_pos)))
+                ++missing;
+        }
+        DAL_CHECK(0 == missing);
+    }
+
+
+    void test_simplify_mesh() {
+        const auto unit = ::make_grid_unit();
+
+        std::vector<glm::vec3> positions;
+        for (const auto& v : unit.m_vertices)
+            positions.push_back(v.m_pos);
+
+        float error = -1;
+        const auto indices = dal::simplify_mesh(positions, unit.m_indices, unit.m_indices.size() / 4, 1, error);
+
+        DAL_CHECK(!indices.empty());
+        DAL_CHECK(indices.size() < unit.m_indices.size());
+        DAL_CHECK(error >= 0);
+        ::check_indices(unit, indices);
+
+        // Nothing may be collapsed when no error is allowed on a curved surface, except exactly flat spots
+        float strict_error = -1;
+        const auto strict = dal::simplify_mesh(positions, unit.m_indices, 0, 0, strict_error);
+        DAL_CHECK(0 == strict_error);
+        ::check_indices(unit, strict);
+    }
+
+    void test_build_lods() {
+        auto unit = ::make_grid_unit();
+        dal::build_lods(unit);
+
+        DAL_CHECK(!unit.m_lods.empty());
+
+        auto prev_index_count = unit.m_indices.size();
+        float prev_error = 0;
+
+        for (const auto& lod : unit.m_lods) {
+            DAL_CHECK(lod.m_indices.size() < prev_index_count);
+            DAL_CHECK(lod.m_error >= prev_error);
+            ::check_indices(unit, lod.m_indices);
+
+            prev_index_count = lod.m_indices.size();
+            prev_error = lod.m_error;
+        }
+    }
+
+}
+
+
+int main() {
+    ::test_simplify_mesh();
+    ::test_build_lods();
+
+    return dal::test::report("mesh_simplify");
+}
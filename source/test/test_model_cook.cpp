@@ -0,0 +1,162 @@
+#include "dal/util/model_cook.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "dal_test.h"
+
+
+namespace {
+
+    // Two triangles sharing an edge, plus a coarser level made of the first one
+    template <typename _Vertex>
+    dal::TRenderUnit<_Vertex> make_quad_unit() {
+        dal::TRenderUnit<_Vertex> unit;
+
+        const float positions[4][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+        for (const auto& p : positions) {
+            auto& v = unit.m_vertices.emplace_back();
+            v.m_pos = glm::vec3{ p[0], p[1], 0 };
+            v.m_normal = glm::vec3{ 0, 0, 1 };
+            v.m_uv_coord = glm::vec2{ p[0], p[1] };
+        }
+
+        unit.m_indices = { 0, 1, 2, 2, 1, 3 };
+
+        auto& lod = unit.m_lods.emplace_back();
+        lod.m_indices = { 0, 3, 2 };
+        lod.m_error = 0.25f;
+
+        unit.m_material.m_albedo_map = "quad.png";
+        unit.m_material.m_roughness = 0.5f;
+        unit.m_material.m_metallic = 0.25f;
+        unit.m_material.m_alpha_blending = false;
+        dal::calc_unit_bounds(unit);
+
+        return unit;
+    }
+
+    // Cooked format is private to the cooker, so blobs are found by their content
+    size_t find_bytes(const std::vector<uint8_t>& buf, const std::vector<uint32_t>& values, const bool from_back) {
+        const auto begin = reinterpret_cast<const uint8_t*>(values.data());
+        const auto end = begin + values.size() * sizeof(uint32_t);
+
+        if (from_back) {
+            const auto found = std::find_end(buf.begin(), buf.end(), begin, end);
+            return found == buf.end() ? buf.size() : static_cast<size_t>(found - buf.begin());
+        }
+        else {
+            const auto found = std::search(buf.begin(), buf.end(), begin, end);
+            return found == buf.end() ? buf.size() : static_cast<size_t>(found - buf.begin());
+        }
+    }
+
+    void write_u32(std::vector<uint8_t>& buf, const size_t offset, const uint32_t value) {
+        std::memcpy(buf.data() + offset, &value, sizeof(value));
+    }
+
+
+    void test_round_trip_static() {
+        dal::ModelStatic model;
+        model.m_units.push_back(::make_quad_unit<dal::VertexStatic>());
+
+        const auto cooked = dal::serialize_cooked_model(model);
+        const auto parsed = dal::parse_cooked_model_static(cooked.data(), cooked.size());
+        DAL_CHECK(parsed.has_value());
+        if (!parsed.has_value())
+            return;
+
+        DAL_CHECK(1 == parsed->m_units.size());
+        const auto& src = model.m_units[0];
+        const auto& dst = parsed->m_units[0];
+
+        DAL_CHECK(dst.m_vertices.size() == src.m_vertices.size());
+        DAL_CHECK(0 == std::memcmp(dst.m_vertices.data(), src.m_vertices.data(), src.m_vertices.size() * sizeof(dal::VertexStatic)));
+        DAL_CHECK(dst.m_indices == src.m_indices);
+        DAL_CHECK(1 == dst.m_lods.size());
+        DAL_CHECK(!dst.m_lods.empty() && dst.m_lods[0].m_indices == src.m_lods[0].m_indices);
+        DAL_CHECK(!dst.m_lods.empty() && dst.m_lods[0].m_error == src.m_lods[0].m_error);
+        DAL_CHECK(dst.m_material.m_albedo_map == "quad.png");
+        DAL_CHECK(dst.m_material.m_roughness == 0.5f);
+        DAL_CHECK(dst.m_aabb_max.x == 1 && dst.m_aabb_max.y == 1);
+
+        // Truncated or mismatched kind must never parse
+        DAL_CHECK(!dal::parse_cooked_model_static(cooked.data(), cooked.size() - 1).has_value());
+        DAL_CHECK(!dal::parse_cooked_model_skinned(cooked.data(), cooked.size()).has_value());
+    }
+
+    void test_corrupted_index() {
+        dal::ModelStatic model;
+        model.m_units.push_back(::make_quad_unit<dal::VertexStatic>());
+        const auto cooked = dal::serialize_cooked_model(model);
+
+        {
+            auto corrupted = cooked;
+            const auto offset = ::find_bytes(corrupted, model.m_units[0].m_indices, false);
+            DAL_CHECK(offset < corrupted.size());
+
+            // Equal to vertex count, so one past the last vertex
+            ::write_u32(corrupted, offset + 5 * sizeof(uint32_t), 4);
+            DAL_CHECK(!dal::parse_cooked_model_static(corrupted.data(), corrupted.size()).has_value());
+        }
+
+        {
+            auto corrupted = cooked;
+            const auto offset = ::find_bytes(corrupted, model.m_units[0].m_lods[0].m_indices, true);
+            DAL_CHECK(offset < corrupted.size());
+
+            ::write_u32(corrupted, offset, 0x00010000);
+            DAL_CHECK(!dal::parse_cooked_model_static(corrupted.data(), corrupted.size()).has_value());
+        }
+    }
+
+    void test_corrupted_parent_index() {
+        dal::ModelSkinned model;
+        model.m_units.push_back(::make_quad_unit<dal::VertexSkinned>());
+
+        const char* const names[] = { "root", "child" };
+        for (int i = 0; i < 2; ++i) {
+            dal::parser::SkelJoint joint;
+            joint.name_ = names[i];
+            joint.parent_index_ = i - 1;
+            joint.offset_mat_ = glm::mat4{ 1 };
+            joint.joint_type_ = dal::JointType::basic;
+
+            const auto jid = model.m_skeleton.get_or_make_index_of(joint.name_);
+            model.m_skeleton.at(jid).set(joint);
+        }
+        model.m_skeleton.update_parent_mats();
+
+        const auto cooked = dal::serialize_cooked_model(model);
+        const auto parsed = dal::parse_cooked_model_skinned(cooked.data(), cooked.size());
+        DAL_CHECK(parsed.has_value());
+        if (parsed.has_value()) {
+            DAL_CHECK(2 == parsed->m_skeleton.size());
+            DAL_CHECK(0 == parsed->m_skeleton.at(1).parent_index());
+        }
+
+        // Parent index is written right after the joint name
+        const std::string name = "child";
+        const auto name_pos = std::search(cooked.begin(), cooked.end(), name.begin(), name.end());
+        DAL_CHECK(name_pos != cooked.end());
+        if (name_pos == cooked.end())
+            return;
+
+        const auto parent_offset = static_cast<size_t>(name_pos - cooked.begin()) + name.size();
+        for (const auto bad_parent : { 2u, 0xFFFFFFFEu }) {
+            auto corrupted = cooked;
+            ::write_u32(corrupted, parent_offset, bad_parent);
+            DAL_CHECK(!dal::parse_cooked_model_skinned(corrupted.data(), corrupted.size()).has_value());
+        }
+    }
+
+}
+
+
+int main() {
+    ::test_round_trip_static();
+    ::test_corrupted_index();
+    ::test_corrupted_parent_index();
+
+    return dal::test::report("model_cook");
+}
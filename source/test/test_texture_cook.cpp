@@ -0,0 +1,249 @@
+#include "dal/util/texture_cook.h"
+
+#include <array>
+#include <cstdlib>
+#include <algorithm>
+
+#include "dal/util/mipmap.h"
+
+#include "dal_test.h"
+
+
+namespace {
+
+    constexpr int32_t ETC_MODIFIERS[8][2] = {
+        { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+    };
+
+    constexpr int32_t EAC_MODIFIERS[16][8] = {
+        { -3, -6, -9, -15, 2, 5, 8, 14 },
+        { -3, -7, -10, -13, 2, 6, 9, 12 },
+        { -2, -5, -8, -13, 1, 4, 7, 12 },
+        { -2, -4, -6, -13, 1, 3, 5, 12 },
+        { -3, -6, -8, -12, 2, 5, 7, 11 },
+        { -3, -7, -9, -11, 2, 6, 8, 10 },
+        { -4, -7, -8, -11, 3, 6, 7, 10 },
+        { -3, -5, -8, -11, 2, 4, 7, 10 },
+        { -2, -6, -8, -10, 1, 5, 7, 9 },
+        { -2, -5, -8, -10, 1, 4, 7, 9 },
+        { -2, -4, -8, -10, 1, 3, 7, 9 },
+        { -2, -5, -7, -10, 1, 4, 6, 9 },
+        { -3, -4, -7, -10, 2, 3, 6, 9 },
+        { -1, -2, -3, -10, 0, 1, 2, 9 },
+        { -4, -6, -8, -9, 3, 5, 7, 8 },
+        { -3, -5, -7, -9, 2, 4, 6, 8 },
+    };
+
+    using Texels = std::array<std::array<int32_t, 4>, 16>;
+
+
+    uint64_t read_big_endian(const uint8_t* const src) {
+        uint64_t output = 0;
+        for (size_t i = 0; i < 8; ++i)
+            output = (output << 8) | src[i];
+        return output;
+    }
+
+    // Three lowest bits as two's complement
+    int32_t sign_extend_3(const uint64_t bits) {
+        const auto x = static_cast<int32_t>(bits & 7);
+        return (x & 4) ? x - 8 : x;
+    }
+
+    // Independent decoder for individual and differential modes, written from the spec rather than from the encoder.
+    // Texel (x, y) goes to output[y * 4 + x].
+    Texels decode_etc2_rgba8_block(const uint8_t* const src) {
+        Texels output{};
+
+        const auto alpha = ::read_big_endian(src);
+        const auto alpha_base = static_cast<int32_t>(alpha >> 56);
+        const auto multiplier = static_cast<int32_t>((alpha >> 52) & 15);
+        const auto& alpha_modifiers = ::EAC_MODIFIERS[(alpha >> 48) & 15];
+
+        const auto rgb = ::read_big_endian(src + 8);
+        const bool diff = (rgb >> 33) & 1;
+        const bool flip = (rgb >> 32) & 1;
+        const uint32_t tables[2] = { static_cast<uint32_t>((rgb >> 37) & 7), static_cast<uint32_t>((rgb >> 34) & 7) };
+
+        int32_t bases[2][3];
+        for (size_t c = 0; c < 3; ++c) {
+            const auto shift = 56 - c * 8;
+            if (diff) {
+                const auto q0 = static_cast<int32_t>((rgb >> (shift + 3)) & 31);
+                const auto q1 = q0 + ::sign_extend_3(rgb >> shift);
+                bases[0][c] = (q0 << 3) | (q0 >> 2);
+                bases[1][c] = (q1 << 3) | (q1 >> 2);
+            }
+            else {
+                bases[0][c] = static_cast<int32_t>((rgb >> (shift + 4)) & 15) * 17;
+                bases[1][c] = static_cast<int32_t>((rgb >> shift) & 15) * 17;
+            }
+        }
+
+        for (size_t y = 0; y < 4; ++y) {
+            for (size_t x = 0; x < 4; ++x) {
+                const auto p = x * 4 + y;
+                const auto sub = flip ? (y >> 1) : (x >> 1);
+                const auto msb = (rgb >> (16 + p)) & 1;
+                const auto lsb = (rgb >> p) & 1;
+                const auto magnitude = ::ETC_MODIFIERS[tables[sub]][lsb];
+                const auto modifier = msb ? -magnitude : magnitude;
+
+                auto& texel = output[y * 4 + x];
+                for (size_t c = 0; c < 3; ++c)
+                    texel[c] = std::clamp(bases[sub][c] + modifier, 0, 255);
+
+                const auto alpha_index = (alpha >> (45 - p * 3)) & 7;
+                texel[3] = std::clamp(alpha_base + alpha_modifiers[alpha_index] * multiplier, 0, 255);
+            }
+        }
+
+        return output;
+    }
+
+    // Red component of second colour overflowing 5 bits turns a differential block into T mode and so on
+    bool is_etc1_compatible_block(const uint8_t* const src) {
+        const auto rgb = ::read_big_endian(src + 8);
+        if (0 == ((rgb >> 33) & 1))
+            return true;
+
+        for (size_t c = 0; c < 3; ++c) {
+            const auto shift = 56 - c * 8;
+            const auto q1 = static_cast<int32_t>((rgb >> (shift + 3)) & 31) + ::sign_extend_3(rgb >> shift);
+            if (q1 < 0 || q1 > 31)
+                return false;
+        }
+
+        return true;
+    }
+
+
+    struct DecodeError {
+        int32_t m_max_rgb = 0;
+        int32_t m_max_alpha = 0;
+        double m_mean_rgb = 0;
+    };
+
+    DecodeError compare_level_0(const std::vector<uint8_t>& pixels, const dal::ImageData& cooked) {
+        DecodeError output;
+        const auto width = cooked.width();
+        const auto height = cooked.height();
+        const auto blocks_x = (width + 3) / 4;
+        uint64_t error_sum = 0;
+
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const auto block = cooked.data() + ((y / 4) * blocks_x + x / 4) * 16;
+                const auto decoded = ::decode_etc2_rgba8_block(block)[(y % 4) * 4 + x % 4];
+                const auto original = pixels.data() + (y * width + x) * 4;
+
+                for (size_t c = 0; c < 3; ++c) {
+                    const auto diff = std::abs(decoded[c] - original[c]);
+                    output.m_max_rgb = std::max(output.m_max_rgb, diff);
+                    error_sum += diff;
+                }
+                output.m_max_alpha = std::max(output.m_max_alpha, std::abs(decoded[3] - original[3]));
+            }
+        }
+
+        output.m_mean_rgb = static_cast<double>(error_sum) / (width * height * 3);
+        return output;
+    }
+
+    std::vector<uint8_t> make_gradient(const uint32_t width, const uint32_t height, const bool constant_alpha) {
+        std::vector<uint8_t> output(width * height * 4);
+
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                auto p = output.data() + (y * width + x) * 4;
+                p[0] = static_cast<uint8_t>(x * 255 / (width - 1));
+                p[1] = static_cast<uint8_t>(y * 255 / (height - 1));
+                p[2] = static_cast<uint8_t>((x + y) * 255 / (width + height - 2));
+                p[3] = constant_alpha ? 200 : static_cast<uint8_t>(255 - x * 255 / (width - 1));
+            }
+        }
+
+        return output;
+    }
+
+
+    void test_can_cook_to() {
+        DAL_CHECK(dal::can_cook_to(dal::ImageFormat::bc7_srgb));
+        DAL_CHECK(dal::can_cook_to(dal::ImageFormat::etc2_rgba8_srgb));
+        DAL_CHECK(!dal::can_cook_to(dal::ImageFormat::r8g8b8a8_srgb));
+        DAL_CHECK(!dal::can_cook_to(dal::ImageFormat::astc_4x4_srgb));
+    }
+
+    void test_etc2_gradient() {
+        // Not a multiple of 4 so that edge blocks are covered
+        constexpr uint32_t WIDTH = 30, HEIGHT = 18;
+        const auto pixels = ::make_gradient(WIDTH, HEIGHT, false);
+
+        const dal::ImageData src{ pixels.data(), WIDTH, HEIGHT, 4, dal::ImageFormat::r8g8b8a8_srgb };
+        const auto cooked = dal::cook_texture(src, dal::ImageFormat::etc2_rgba8_srgb);
+        DAL_CHECK(cooked.has_value());
+        if (!cooked.has_value())
+            return;
+
+        DAL_CHECK(dal::ImageFormat::etc2_rgba8_srgb == cooked->format());
+        DAL_CHECK(dal::calc_mip_levels(WIDTH, HEIGHT) == cooked->mip_levels());
+        DAL_CHECK(8 * 5 * 16 == cooked->mip_size(0));
+
+        for (size_t i = 0; i < cooked->data_size(); i += 16)
+            DAL_CHECK(::is_etc1_compatible_block(cooked->data() + i));
+
+        // One modifier is shared by all channels so gradients running in different directions per channel are lossy
+        const auto error = ::compare_level_0(pixels, *cooked);
+        DAL_CHECK(error.m_max_rgb <= 24);
+        DAL_CHECK(error.m_mean_rgb <= 6.0);
+        DAL_CHECK(error.m_max_alpha <= 4);
+    }
+
+    void test_etc2_constant_alpha() {
+        constexpr uint32_t WIDTH = 8, HEIGHT = 8;
+        const auto pixels = ::make_gradient(WIDTH, HEIGHT, true);
+
+        const dal::ImageData src{ pixels.data(), WIDTH, HEIGHT, 4, dal::ImageFormat::r8g8b8a8_srgb };
+        const auto cooked = dal::cook_texture(src, dal::ImageFormat::etc2_rgba8_srgb);
+        DAL_CHECK(cooked.has_value());
+        if (!cooked.has_value())
+            return;
+
+        DAL_CHECK(0 == ::compare_level_0(pixels, *cooked).m_max_alpha);
+    }
+
+    void test_etc2_noise() {
+        constexpr uint32_t WIDTH = 16, HEIGHT = 16;
+        std::vector<uint8_t> pixels(WIDTH * HEIGHT * 4);
+
+        uint32_t state = 12345;
+        for (auto& x : pixels) {
+            state = state * 1664525 + 1013904223;
+            x = static_cast<uint8_t>(state >> 24);
+        }
+
+        const dal::ImageData src{ pixels.data(), WIDTH, HEIGHT, 4, dal::ImageFormat::r8g8b8a8_srgb };
+        const auto cooked = dal::cook_texture(src, dal::ImageFormat::etc2_rgba8_srgb);
+        DAL_CHECK(cooked.has_value());
+        if (!cooked.has_value())
+            return;
+
+        for (size_t i = 0; i < cooked->data_size(); i += 16)
+            DAL_CHECK(::is_etc1_compatible_block(cooked->data() + i));
+
+        // Noise cannot be represented well, but decoded texels must still be nowhere near random
+        const auto error = ::compare_level_0(pixels, *cooked);
+        DAL_CHECK(error.m_mean_rgb <= 60.0);
+    }
+
+}
+
+
+int main() {
+    ::test_can_cook_to();
+    ::test_etc2_gradient();
+    ::test_etc2_constant_alpha();
+    ::test_etc2_noise();
+
+    return dal::test::report("texture_cook");
+}